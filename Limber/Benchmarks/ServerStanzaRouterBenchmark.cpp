@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Swiften/Elements/Message.h>
+
+#include <Limber/Server/ServerSession.h>
+#include <Limber/Server/ServerStanzaRouter.h>
+
+using namespace Swift;
+
+/*
+ * Measures how many stanzas per second ServerStanzaRouter routes when many
+ * client sessions are connected. Sessions are spread over users with a few
+ * resources each, and stanzas alternate between full and bare JIDs.
+ */
+
+namespace {
+    class CountingServerSession : public ServerSession {
+        public:
+            CountingServerSession(const JID& jid, int priority) : jid(jid), priority(priority), sentStanzas(0) {}
+
+            virtual const JID& getJID() const { return jid; }
+            virtual int getPriority() const { return priority; }
+            virtual void sendStanza(std::shared_ptr<Stanza>) { sentStanzas++; }
+
+            JID jid;
+            int priority;
+            int sentStanzas;
+    };
+}
+
+int main(int argc, char* argv[]) {
+    int sessionCount = 100000;
+    int stanzaCount = 1000000;
+    if (argc > 1) {
+        sessionCount = std::atoi(argv[1]);
+    }
+    if (argc > 2) {
+        stanzaCount = std::atoi(argv[2]);
+    }
+    const int resourcesPerUser = 4;
+    const int userCount = (sessionCount + resourcesPerUser - 1) / resourcesPerUser;
+
+    ServerStanzaRouter router;
+    std::vector<std::unique_ptr<CountingServerSession> > sessions;
+    for (int i = 0; i < sessionCount; ++i) {
+        JID jid("user" + std::to_string(i / resourcesPerUser), "example.com", "resource" + std::to_string(i % resourcesPerUser));
+        sessions.push_back(std::unique_ptr<CountingServerSession>(new CountingServerSession(jid, i % resourcesPerUser)));
+        router.addClientSession(sessions.back().get());
+    }
+
+    // Build the stanzas up front, so only routing is measured
+    std::vector<std::shared_ptr<Stanza> > stanzas;
+    const int distinctStanzas = 10000;
+    for (int i = 0; i < distinctStanzas; ++i) {
+        std::shared_ptr<Message> message = std::make_shared<Message>();
+        int session = (i * 7919) % sessionCount;
+        if (i % 2 == 0) {
+            message->setTo(sessions[session]->getJID());
+        }
+        else {
+            message->setTo(JID("user" + std::to_string(session % userCount), "example.com"));
+        }
+        stanzas.push_back(message);
+    }
+
+    int routedStanzas = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < stanzaCount; ++i) {
+        if (router.routeStanza(stanzas[i % distinctStanzas])) {
+            routedStanzas++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Routed " << routedStanzas << " of " << stanzaCount << " stanzas across " << sessionCount << " sessions" << std::endl;
+    std::cout << static_cast<long long>(stanzaCount / seconds) << " stanzas/sec" << std::endl;
+    return 0;
+}
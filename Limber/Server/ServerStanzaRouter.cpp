@@ -1,76 +1,95 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Limber/Server/ServerStanzaRouter.h>
 
-#include <algorithm>
 #include <cassert>
 
-#include <Swiften/Base/Algorithm.h>
-
 #include <Limber/Server/ServerSession.h>
 
 namespace Swift {
 
-namespace {
-    struct PriorityLessThan {
-        bool operator()(const ServerSession* s1, const ServerSession* s2) const {
-            return s1->getPriority() < s2->getPriority();
-        }
-    };
-
-    struct HasJID {
-        HasJID(const JID& jid) : jid(jid) {}
-        bool operator()(const ServerSession* session) const {
-            return session->getJID().equals(jid, JID::WithResource);
-        }
-        JID jid;
-    };
-}
-
 ServerStanzaRouter::ServerStanzaRouter() {
 }
 
 bool ServerStanzaRouter::routeStanza(std::shared_ptr<Stanza> stanza) {
-    JID to = stanza->getTo();
+    const JID& to = stanza->getTo();
     assert(to.isValid());
 
+    auto bareJIDSessions = bareJIDSessions_.find(to.toBare().toString());
+    if (bareJIDSessions == bareJIDSessions_.end()) {
+        return false;
+    }
+
     // For a full JID, first try to route to a session with the full JID
     if (!to.isBare()) {
-        std::vector<ServerSession*>::const_iterator i = std::find_if(clientSessions_.begin(), clientSessions_.end(), HasJID(to));
-        if (i != clientSessions_.end()) {
-            (*i)->sendStanza(stanza);
+        auto i = bareJIDSessions->second.sessionsByResource.find(to.getResource());
+        if (i != bareJIDSessions->second.sessionsByResource.end()) {
+            i->second->sendStanza(stanza);
             return true;
         }
     }
 
-    // Look for candidate sessions
-    to = to.toBare();
-    std::vector<ServerSession*> candidateSessions;
-    for (std::vector<ServerSession*>::const_iterator i = clientSessions_.begin(); i != clientSessions_.end(); ++i) {
-        if ((*i)->getJID().equals(to, JID::WithoutResource) && (*i)->getPriority() >= 0) {
-            candidateSessions.push_back(*i);
-        }
-    }
-    if (candidateSessions.empty()) {
+    // Route to the session with the highest non-negative priority
+    const PrioritySessions& sessionsByPriority = bareJIDSessions->second.sessionsByPriority;
+    if (sessionsByPriority.empty() || sessionsByPriority.begin()->first < 0) {
         return false;
     }
-
-    // Find the session with the highest priority
-    std::vector<ServerSession*>::const_iterator i = std::max_element(clientSessions_.begin(), clientSessions_.end(), PriorityLessThan());
-    (*i)->sendStanza(stanza);
+    sessionsByPriority.begin()->second->sendStanza(stanza);
     return true;
 }
 
 void ServerStanzaRouter::addClientSession(ServerSession* clientSession) {
-    clientSessions_.push_back(clientSession);
+    const JID& jid = clientSession->getJID();
+    SessionEntry entry;
+    entry.bareJID = jid.toBare().toString();
+    BareJIDSessions& bareJIDSessions = bareJIDSessions_[entry.bareJID];
+    entry.priorityPosition = bareJIDSessions.sessionsByPriority.insert(std::make_pair(clientSession->getPriority(), clientSession));
+    // If another session already has the same full JID, it keeps receiving the full JID stanzas
+    bareJIDSessions.sessionsByResource.insert(std::make_pair(jid.getResource(), clientSession));
+    sessions_[clientSession] = entry;
 }
 
 void ServerStanzaRouter::removeClientSession(ServerSession* clientSession) {
-    erase(clientSessions_, clientSession);
+    auto entry = sessions_.find(clientSession);
+    if (entry == sessions_.end()) {
+        return;
+    }
+    auto bareJIDSessions = bareJIDSessions_.find(entry->second.bareJID);
+    assert(bareJIDSessions != bareJIDSessions_.end());
+    PrioritySessions& sessionsByPriority = bareJIDSessions->second.sessionsByPriority;
+    sessionsByPriority.erase(entry->second.priorityPosition);
+    sessions_.erase(entry);
+
+    const std::string& resource = clientSession->getJID().getResource();
+    auto i = bareJIDSessions->second.sessionsByResource.find(resource);
+    if (i != bareJIDSessions->second.sessionsByResource.end() && i->second == clientSession) {
+        bareJIDSessions->second.sessionsByResource.erase(i);
+        // Hand the full JID over to a remaining session with the same resource, if any
+        for (const auto& session : sessionsByPriority) {
+            if (session.second->getJID().getResource() == resource) {
+                bareJIDSessions->second.sessionsByResource.insert(std::make_pair(resource, session.second));
+                break;
+            }
+        }
+    }
+
+    if (sessionsByPriority.empty()) {
+        bareJIDSessions_.erase(bareJIDSessions);
+    }
+}
+
+void ServerStanzaRouter::updateClientSessionPriority(ServerSession* clientSession) {
+    auto entry = sessions_.find(clientSession);
+    if (entry == sessions_.end() || entry->second.priorityPosition->first == clientSession->getPriority()) {
+        return;
+    }
+    PrioritySessions& sessionsByPriority = bareJIDSessions_[entry->second.bareJID].sessionsByPriority;
+    sessionsByPriority.erase(entry->second.priorityPosition);
+    entry->second.priorityPosition = sessionsByPriority.insert(std::make_pair(clientSession->getPriority(), clientSession));
 }
 
 }
@@ -1,13 +1,16 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include <Swiften/Elements/Stanza.h>
 #include <Swiften/JID/JID.h>
@@ -15,6 +18,14 @@
 namespace Swift {
     class ServerSession;
 
+    /**
+     * Routes stanzas to local client sessions.
+     *
+     * Sessions are indexed by bare JID, and per bare JID by resource and by
+     * priority. The priority of a session is read when it is added; when the
+     * presence priority of a session changes, call
+     * \ref updateClientSessionPriority so that bare JID routing picks it up.
+     */
     class ServerStanzaRouter {
         public:
             ServerStanzaRouter();
@@ -23,8 +34,28 @@ namespace Swift {
 
             void addClientSession(ServerSession*);
             void removeClientSession(ServerSession*);
+            void updateClientSessionPriority(ServerSession*);
+
+            size_t getClientSessionCount() const {
+                return sessions_.size();
+            }
+
+        private:
+            // Highest priority first; sessions with equal priority stay in the order they were added.
+            typedef std::multimap<int, ServerSession*, std::greater<int> > PrioritySessions;
+
+            struct BareJIDSessions {
+                std::unordered_map<std::string, ServerSession*> sessionsByResource;
+                PrioritySessions sessionsByPriority;
+            };
+
+            struct SessionEntry {
+                std::string bareJID;
+                PrioritySessions::iterator priorityPosition;
+            };
 
         private:
-            std::vector<ServerSession*> clientSessions_;
+            std::unordered_map<std::string, BareJIDSessions> bareJIDSessions_;
+            std::unordered_map<ServerSession*, SessionEntry> sessions_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,6 +23,12 @@ class ServerStanzaRouterTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testRouteStanza_BareJIDWithMultipleSessions);
         CPPUNIT_TEST(testRouteStanza_BareJIDWithOnlyNegativePriorities);
         CPPUNIT_TEST(testRouteStanza_BareJIDWithChangingPresence);
+        CPPUNIT_TEST(testRouteStanza_BareJIDWithChangingPresenceToNegativePriority);
+        CPPUNIT_TEST(testRouteStanza_BareJIDWithSessionsOfOtherJIDs);
+        CPPUNIT_TEST(testRouteStanza_BareJIDWithEqualPriorities);
+        CPPUNIT_TEST(testRouteStanza_AfterRemovingSession);
+        CPPUNIT_TEST(testRouteStanza_AfterRemovingLastSession);
+        CPPUNIT_TEST(testRouteStanza_FullJIDWithDuplicateSessionRemoved);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -116,7 +122,9 @@ class ServerStanzaRouterTest : public CppUnit::TestFixture {
             testling.addClientSession(&session2);
 
             session1.priority = 3;
+            testling.updateClientSessionPriority(&session1);
             session2.priority = 4;
+            testling.updateClientSessionPriority(&session2);
             bool result = testling.routeStanza(createMessageTo("foo@bar.com"));
 
             CPPUNIT_ASSERT(result);
@@ -124,6 +132,93 @@ class ServerStanzaRouterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(session2.sentStanzas.size()));
         }
 
+        void testRouteStanza_BareJIDWithChangingPresenceToNegativePriority() {
+            ServerStanzaRouter testling;
+            MockServerSession session(JID("foo@bar.com/Baz"), 8);
+            testling.addClientSession(&session);
+
+            session.priority = -1;
+            testling.updateClientSessionPriority(&session);
+            bool result = testling.routeStanza(createMessageTo("foo@bar.com"));
+
+            CPPUNIT_ASSERT(!result);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session.sentStanzas.size()));
+        }
+
+        void testRouteStanza_BareJIDWithSessionsOfOtherJIDs() {
+            ServerStanzaRouter testling;
+            MockServerSession session1(JID("foo@bar.com/Bla"), 1);
+            testling.addClientSession(&session1);
+            MockServerSession session2(JID("baz@bar.com/Bla"), 8);
+            testling.addClientSession(&session2);
+
+            bool result = testling.routeStanza(createMessageTo("foo@bar.com"));
+
+            CPPUNIT_ASSERT(result);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(session1.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session2.sentStanzas.size()));
+        }
+
+        void testRouteStanza_BareJIDWithEqualPriorities() {
+            ServerStanzaRouter testling;
+            MockServerSession session1(JID("foo@bar.com/Bla"), 5);
+            testling.addClientSession(&session1);
+            MockServerSession session2(JID("foo@bar.com/Baz"), 5);
+            testling.addClientSession(&session2);
+
+            bool result = testling.routeStanza(createMessageTo("foo@bar.com"));
+
+            CPPUNIT_ASSERT(result);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(session1.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session2.sentStanzas.size()));
+        }
+
+        void testRouteStanza_AfterRemovingSession() {
+            ServerStanzaRouter testling;
+            MockServerSession session1(JID("foo@bar.com/Bla"), 1);
+            testling.addClientSession(&session1);
+            MockServerSession session2(JID("foo@bar.com/Baz"), 8);
+            testling.addClientSession(&session2);
+
+            testling.removeClientSession(&session2);
+            bool result1 = testling.routeStanza(createMessageTo("foo@bar.com"));
+            bool result2 = testling.routeStanza(createMessageTo("foo@bar.com/Baz"));
+
+            CPPUNIT_ASSERT(result1);
+            CPPUNIT_ASSERT(result2);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(session1.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session2.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getClientSessionCount());
+        }
+
+        void testRouteStanza_AfterRemovingLastSession() {
+            ServerStanzaRouter testling;
+            MockServerSession session(JID("foo@bar.com/Bla"), 1);
+            testling.addClientSession(&session);
+
+            testling.removeClientSession(&session);
+            bool result = testling.routeStanza(createMessageTo("foo@bar.com/Bla"));
+
+            CPPUNIT_ASSERT(!result);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling.getClientSessionCount());
+        }
+
+        void testRouteStanza_FullJIDWithDuplicateSessionRemoved() {
+            ServerStanzaRouter testling;
+            MockServerSession session1(JID("foo@bar.com/Bla"), -1);
+            testling.addClientSession(&session1);
+            MockServerSession session2(JID("foo@bar.com/Bla"), -1);
+            testling.addClientSession(&session2);
+
+            testling.removeClientSession(&session1);
+            bool result = testling.routeStanza(createMessageTo("foo@bar.com/Bla"));
+
+            CPPUNIT_ASSERT(result);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(session1.sentStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(session2.sentStanzas.size()));
+        }
+
     private:
         std::shared_ptr<Message> createMessageTo(const std::string& recipient) {
             std::shared_ptr<Message> message(new Message());
@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include <boost/bind.hpp>
 
@@ -19,7 +21,7 @@
 #include <Swiften/EventLoop/SimpleEventLoop.h>
 #include <Swiften/Network/BoostConnection.h>
 #include <Swiften/Network/BoostConnectionServer.h>
-#include <Swiften/Network/BoostIOServiceThread.h>
+#include <Swiften/Network/BoostIOServicePool.h>
 #include <Swiften/Network/ConnectionServer.h>
 #include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
 #include <Swiften/Parser/PlatformXMLParserFactory.h>
@@ -32,8 +34,8 @@ using namespace Swift;
 
 class Server {
     public:
-        Server(UserRegistry* userRegistry, EventLoop* eventLoop) : userRegistry_(userRegistry) {
-            serverFromClientConnectionServer_ = BoostConnectionServer::create(5222, boostIOServiceThread_.getIOService(), eventLoop);
+        Server(UserRegistry* userRegistry, EventLoop* eventLoop) : userRegistry_(userRegistry), ioServicePool_(std::make_shared<BoostIOServicePool>(std::max(1U, std::thread::hardware_concurrency()))) {
+            serverFromClientConnectionServer_ = BoostConnectionServer::create(5222, ioServicePool_, eventLoop);
             serverFromClientConnectionServer_->onNewConnection.connect(boost::bind(&Server::handleNewConnection, this, _1));
             serverFromClientConnectionServer_->start();
         }
@@ -86,7 +88,7 @@ class Server {
         IDGenerator idGenerator_;
         PlatformXMLParserFactory xmlParserFactory;
         UserRegistry* userRegistry_;
-        BoostIOServiceThread boostIOServiceThread_;
+        std::shared_ptr<BoostIOServicePool> ioServicePool_;
         std::shared_ptr<BoostConnectionServer> serverFromClientConnectionServer_;
         std::vector< std::shared_ptr<ServerFromClientSession> > serverFromClientSessions_;
         FullPayloadParserFactoryCollection payloadParserFactories_;
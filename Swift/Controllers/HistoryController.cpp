@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2014-2015 Isode Limited.
+ * Copyright (c) 2014-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -59,6 +59,10 @@ ContactsMap HistoryController::getContacts(const JID& selfJID, HistoryMessage::T
     return localHistory_->getContacts(selfJID, type, keyword);
 }
 
+std::vector<HistoryMessage> HistoryController::searchMessages(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const std::string& keyword, const boost::posix_time::ptime& before, int maxResults) const {
+    return localHistory_->searchMessages(selfJID, contactJID, type, keyword, before, maxResults);
+}
+
 boost::posix_time::ptime HistoryController::getLastTimeStampFromMUC(const JID& selfJID, const JID& mucJID) {
     return localHistory_->getLastTimeStampFromMUC(selfJID, mucJID);
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * Licensed under the GNU General Public License.
  * See the COPYING file for more information.
  */
@@ -118,6 +118,13 @@ void HistoryViewController::handleSelectedContactChanged(RosterItem* newContact)
 
         if (contacts_[type].count(contactJID)) {
             currentResultDate_ = *contacts_[type][contactJID].rbegin();
+            if (!keyword_.empty()) {
+                // Show the day of the best match among the recent ones
+                std::vector<HistoryMessage> matches = historyController_->searchMessages(selfJID_, contactJID, type, keyword_, boost::posix_time::ptime(boost::posix_time::not_a_date_time), maxSearchResults);
+                if (!matches.empty()) {
+                    currentResultDate_ = matches.front().getTime().date();
+                }
+            }
             selectedItemType_ = type;
             messages = historyController_->getMessagesFromDate(selfJID_, contactJID, type, currentResultDate_);
         }
@@ -171,6 +178,7 @@ void HistoryViewController::addNewMessage(const HistoryMessage& message, bool ad
 
 void HistoryViewController::handleReturnPressed(const std::string& keyword) {
     reset();
+    keyword_ = keyword;
 
     for (int it = HistoryMessage::Chat; it <= HistoryMessage::PrivateMessage; it++) {
         HistoryMessage::Type type = static_cast<HistoryMessage::Type>(it);
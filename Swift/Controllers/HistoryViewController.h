@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -71,5 +71,7 @@ namespace Swift {
             ContactRosterItem* selectedItem_;
             HistoryMessage::Type selectedItemType_ = HistoryMessage::Chat;
             boost::gregorian::date currentResultDate_;
+            std::string keyword_;
+            static const int maxSearchResults = 100;
     };
 }
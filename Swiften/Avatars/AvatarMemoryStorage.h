@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include <Swiften/Avatars/AvatarStorage.h>
 #include <Swiften/Base/API.h>
@@ -33,12 +34,12 @@ namespace Swift {
             }
 
             virtual std::string getAvatarForJID(const JID& jid) const {
-                std::map<JID, std::string>::const_iterator i = jidAvatars.find(jid);
+                std::unordered_map<JID, std::string>::const_iterator i = jidAvatars.find(jid);
                 return i == jidAvatars.end() ? "" : i->second;
             }
 
         private:
             std::map<std::string, ByteArray> avatars;
-            std::map<JID, std::string> jidAvatars;
+            std::unordered_map<JID, std::string> jidAvatars;
     };
 }
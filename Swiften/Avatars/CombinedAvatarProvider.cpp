@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -33,7 +33,7 @@ void CombinedAvatarProvider::removeProvider(AvatarProvider* provider) {
 
 void CombinedAvatarProvider::handleAvatarChanged(const JID& jid) {
     std::string oldHash;
-    std::map<JID, std::string>::const_iterator i = avatars.find(jid);
+    std::unordered_map<JID, std::string>::const_iterator i = avatars.find(jid);
     if (i != avatars.end()) {
         oldHash = i->second;
     }
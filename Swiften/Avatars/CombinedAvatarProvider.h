@@ -1,12 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 #include <Swiften/Avatars/AvatarProvider.h>
@@ -27,6 +27,6 @@ namespace Swift {
 
         private:
             std::vector<AvatarProvider*> providers;
-            mutable std::map<JID, std::string> avatars;
+            mutable std::unordered_map<JID, std::string> avatars;
     };
 }
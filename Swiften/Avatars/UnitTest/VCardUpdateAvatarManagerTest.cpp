@@ -1,9 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include <boost/bind.hpp>
 
 #include <QA/Checker/IO.h>
@@ -35,6 +39,7 @@ class VCardUpdateAvatarManagerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testVCardWithEmptyPhoto);
         CPPUNIT_TEST(testStanzaChannelReset_ClearsHash);
         CPPUNIT_TEST(testStanzaChannelReset_ReceiveHashAfterResetUpdatesHash);
+        CPPUNIT_TEST(testStanzaChannelReset_NotifiesInJIDOrder);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -162,6 +167,25 @@ class VCardUpdateAvatarManagerTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(avatar1Hash, *hash);
         }
 
+        void testStanzaChannelReset_NotifiesInJIDOrder() {
+            std::shared_ptr<VCardUpdateAvatarManager> testling = createManager();
+            stanzaChannel->onPresenceReceived(createPresenceWithPhotoHash(user1, avatar1Hash));
+            stanzaChannel->onIQReceived(createVCardResult(avatar1));
+            std::vector<JID> users;
+            for (int i = 0; i < 20; ++i) {
+                users.push_back(JID("user" + std::to_string((i * 7) % 20 + 2) + "@bar.com"));
+                stanzaChannel->onPresenceReceived(createPresenceWithPhotoHash(users.back(), avatar1Hash));
+            }
+            users.push_back(user1.toBare());
+            changes.clear();
+
+            stanzaChannel->setAvailable(false);
+            stanzaChannel->setAvailable(true);
+
+            std::sort(users.begin(), users.end());
+            CPPUNIT_ASSERT(users == changes);
+        }
+
     private:
         std::shared_ptr<VCardUpdateAvatarManager> createManager() {
             std::shared_ptr<VCardUpdateAvatarManager> result(new VCardUpdateAvatarManager(vcardManager, stanzaChannel, avatarStorage, crypto.get(), mucRegistry));
@@ -6,6 +6,9 @@
 
 #include <Swiften/Avatars/VCardUpdateAvatarManager.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <boost/bind.hpp>
 
 #include <Swiften/Avatars/AvatarStorage.h>
@@ -81,7 +84,7 @@ void VCardUpdateAvatarManager::setAvatar(const JID& jid, const ByteArray& avatar
 */
 
 boost::optional<std::string> VCardUpdateAvatarManager::getAvatarHash(const JID& jid) const {
-    std::map<JID, std::string>::const_iterator i = avatarHashes_.find(getAvatarJID(jid));
+    std::unordered_map<JID, std::string>::const_iterator i = avatarHashes_.find(getAvatarJID(jid));
     if (i != avatarHashes_.end()) {
         return i->second;
     }
@@ -97,10 +100,15 @@ JID VCardUpdateAvatarManager::getAvatarJID(const JID& jid) const {
 
 void VCardUpdateAvatarManager::handleStanzaChannelAvailableChanged(bool available) {
     if (available) {
-        std::map<JID, std::string> oldAvatarHashes;
-        avatarHashes_.swap(oldAvatarHashes);
-        for(std::map<JID, std::string>::const_iterator i = oldAvatarHashes.begin(); i != oldAvatarHashes.end(); ++i) {
-            onAvatarChanged(i->first);
+        std::vector<JID> changedJIDs;
+        for (const auto& avatarHash : avatarHashes_) {
+            changedJIDs.push_back(avatarHash.first);
+        }
+        avatarHashes_.clear();
+        // Notify in JID order, independent of the hash map layout
+        std::sort(changedJIDs.begin(), changedJIDs.end());
+        for (const auto& jid : changedJIDs) {
+            onAvatarChanged(jid);
         }
     }
 }
@@ -1,13 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <map>
 #include <memory>
+#include <unordered_map>
 
 #include <Swiften/Avatars/AvatarProvider.h>
 #include <Swiften/Base/API.h>
@@ -41,6 +41,6 @@ namespace Swift {
             AvatarStorage* avatarStorage_;
             CryptoProvider* crypto_;
             MUCRegistry* mucRegistry_;
-            std::map<JID, std::string> avatarHashes_;
+            std::unordered_map<JID, std::string> avatarHashes_;
     };
 }
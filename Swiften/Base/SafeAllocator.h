@@ -7,6 +7,8 @@
 #pragma once
 
 #include <algorithm>
+#include <new>
+#include <utility>
 #include <vector>
 
 #include <Swiften/Base/API.h>
@@ -31,6 +33,21 @@ namespace Swift {
                 std::allocator<T>::deallocate(p, num);
             }
 
+            /**
+             * Elements added by resize(n) or the size constructor are default-initialized,
+             * so growing a buffer that is about to be overwritten does not fill it first.
+             * Use resize(n, 0) where the new elements need to be zero.
+             */
+            template<typename U>
+            void construct(U* p) {
+                ::new (static_cast<void*>(p)) U;
+            }
+
+            template<typename U, typename... Args>
+            void construct(U* p, Args&&... args) {
+                ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+            }
+
             SWIFTEN_DEFAULT_COPY_ASSIGMNENT_OPERATOR(SafeAllocator)
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -158,11 +158,20 @@ bool String::isValidXMPPCharacter(std::uint32_t codepoint) {
 }
 
 std::string String::sanitizeXMPPString(const std::string& input) {
-    std::string result;
-    result.reserve(input.length());
+    std::string result(input);
+    sanitizeXMPPStringInPlace(result);
+    result.shrink_to_fit();
+    return result;
+}
 
-    auto it = input.data();
-    const auto end = it + input.length();
+void String::sanitizeXMPPStringInPlace(std::string& input, size_t offset) {
+    if (offset >= input.size()) {
+        return;
+    }
+    // The sanitized string is never longer than the input, so it can be compacted in place.
+    char* out = &input[offset];
+    const char* it = out;
+    const char* const end = input.data() + input.size();
 
     std::size_t consumed;
     bool status = UTF8_ACCEPT;
@@ -171,7 +180,10 @@ std::string String::sanitizeXMPPString(const std::string& input) {
         const auto codepoint = getNextCodepoint(it, end, consumed, status);
         if (status) {
             if (isValidXMPPCharacter(codepoint)) {
-                std::copy(it, it + consumed, std::back_inserter(result));
+                if (out != it) {
+                    std::copy(it, it + consumed, out);
+                }
+                out += consumed;
             }
             it += consumed;
         }
@@ -179,8 +191,7 @@ std::string String::sanitizeXMPPString(const std::string& input) {
             ++it;
         }
     }
-    result.shrink_to_fit();
-    return result;
+    input.resize(static_cast<size_t>(out - input.data()));
 }
 
 std::vector<std::string> String::split(const std::string& s, char c) {
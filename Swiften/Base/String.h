@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -24,6 +24,10 @@ namespace Swift {
             SWIFTEN_API void replaceAll(std::string&, char c, const std::string& s);
             SWIFTEN_API bool isValidXMPPCharacter(std::uint32_t codepoint);
             SWIFTEN_API std::string sanitizeXMPPString(const std::string& input);
+            /**
+             * Removes the characters that are not allowed in XMPP from \p input, starting at \p offset.
+             */
+            SWIFTEN_API void sanitizeXMPPStringInPlace(std::string& input, size_t offset = 0);
 
             inline bool beginsWith(const std::string& s, char c) {
                 return s.size() > 0 && s[0] == c;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,6 +29,7 @@ using namespace Swift;
         CPPUNIT_TEST(testReplaceAll_MatchingReplace);
         CPPUNIT_TEST(testIsValidXMPPCharacter);
         CPPUNIT_TEST(testSanitizeXMPPString);
+        CPPUNIT_TEST(testSanitizeXMPPStringInPlace_WithOffset);
         CPPUNIT_TEST(testSplit);
 #ifdef SWIFTEN_PLATFORM_WINDOWS
         CPPUNIT_TEST(testConvertWStringToString);
@@ -149,6 +150,14 @@ using namespace Swift;
             }
         }
 
+        void testSanitizeXMPPStringInPlace_WithOffset() {
+            std::string input("\x01kept\x01Q\x0BW\x81T");
+
+            String::sanitizeXMPPStringInPlace(input, 5);
+
+            CPPUNIT_ASSERT_EQUAL(std::string("\x01keptQWT"), input);
+        }
+
         void testSplit() {
             std::vector<std::string> result = String::split("abc def ghi", ' ');
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -94,7 +94,8 @@ Client::Client(const JID& jid, const SafeString& password, NetworkFactories* net
             getNetworkFactories()->getDomainNameResolver(),
             getNetworkFactories()->getNetworkEnvironment(),
             getNetworkFactories()->getNATTraverser(),
-            getNetworkFactories()->getCryptoProvider());
+            getNetworkFactories()->getCryptoProvider(),
+            getNetworkFactories()->getEventLoop());
 #else
     fileTransferManager = new DummyFileTransferManager();
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeString.h>
 #include <Swiften/Base/URL.h>
+#include <Swiften/StreamManagement/StanzaAckRequestPolicy.h>
 #include <Swiften/TLS/TLSOptions.h>
 
 namespace Swift {
@@ -56,7 +57,11 @@ namespace Swift {
         bool allowPLAINWithoutTLS = false;
 
         /**
-         * Use XEP-196 stream resumption when available.
+         * Use XEP-198 stream resumption when available.
+         *
+         * When the connection is lost, the client reconnects and resumes the
+         * stream, instead of reporting the disconnection. Only has an effect
+         * if acks are used, and is not supported with BOSH.
          *
          * Default: false
          */
@@ -78,6 +83,13 @@ namespace Swift {
          */
         bool useAcks = true;
 
+        /**
+         * When to request XEP-0198 acks for sent stanzas, and how many
+         * unacked stanzas to keep.
+         * Default: an ack request after every message, unbounded
+         */
+        StanzaAckRequestPolicy stanzaAckRequestPolicy;
+
         /**
          * Use Single Sign On.
          * Default: false
@@ -150,5 +162,12 @@ namespace Swift {
          * waits from a session close to the socket close.
          */
         int sessionShutdownTimeoutInMilliseconds = 10000;
+
+        /**
+         * The time to wait for a connection attempt to the server before
+         * starting an attempt to its next address, while the earlier attempts
+         * keep running. A value of 0 tries the addresses one at a time.
+         */
+        int connectionAttemptDelayInMilliseconds = 250;
     };
 }
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Client/ClientSession.h>
 
+#include <deque>
 #include <memory>
 
 #include <boost/bind.hpp>
@@ -37,6 +38,8 @@
 #include <Swiften/Elements/StreamFeatures.h>
 #include <Swiften/Elements/StreamManagementEnabled.h>
 #include <Swiften/Elements/StreamManagementFailed.h>
+#include <Swiften/Elements/StreamResume.h>
+#include <Swiften/Elements/StreamResumed.h>
 #include <Swiften/Elements/TLSProceed.h>
 #include <Swiften/Network/Timer.h>
 #include <Swiften/Network/TimerFactory.h>
@@ -115,9 +118,12 @@ void ClientSession::sendStreamHeader() {
 }
 
 void ClientSession::sendStanza(std::shared_ptr<Stanza> stanza) {
+    writtenBytes = 0;
     stream->writeElement(stanza);
     if (stanzaAckRequester_) {
-        stanzaAckRequester_->handleStanzaSent(stanza);
+        // Streams that write asynchronously report no size here, which only
+        // disables the byte-based ack request condition.
+        stanzaAckRequester_->handleStanzaSent(stanza, writtenBytes);
     }
 }
 
@@ -310,7 +316,19 @@ void ClientSession::handleElement(std::shared_ptr<ToplevelElement> element) {
             needSessionStart = streamFeatures->hasSession();
             needResourceBind = streamFeatures->hasResourceBind();
             needAcking = streamFeatures->hasStreamManagement() && useAcks;
-            if (!needResourceBind) {
+            if (previousResumeState_) {
+                if (streamFeatures->hasStreamManagement()) {
+                    state = State::ResumingStream;
+                    std::shared_ptr<StreamResume> resume = std::make_shared<StreamResume>();
+                    resume->setResumeID(previousResumeState_->id);
+                    resume->setHandledStanzasCount(previousResumeState_->stanzaAckResponder->getHandledStanzasCount());
+                    stream->writeElement(resume);
+                }
+                else {
+                    handleStreamResumeFailed();
+                }
+            }
+            else if (!needResourceBind) {
                 // Resource binding is a MUST
                 finishSession(Error::ResourceBindError);
             }
@@ -329,18 +347,29 @@ void ClientSession::handleElement(std::shared_ptr<ToplevelElement> element) {
     else if (std::dynamic_pointer_cast<CompressFailure>(element)) {
         finishSession(Error::CompressionFailedError);
     }
-    else if (std::dynamic_pointer_cast<StreamManagementEnabled>(element)) {
-        stanzaAckRequester_ = std::make_shared<StanzaAckRequester>();
-        stanzaAckRequester_->onRequestAck.connect(boost::bind(&ClientSession::requestAck, shared_from_this()));
-        stanzaAckRequester_->onStanzaAcked.connect(boost::bind(&ClientSession::handleStanzaAcked, shared_from_this(), _1));
-        stanzaAckResponder_ = std::make_shared<StanzaAckResponder>();
-        stanzaAckResponder_->onAck.connect(boost::bind(&ClientSession::ack, shared_from_this(), _1));
+    else if (std::shared_ptr<StreamManagementEnabled> enabled = std::dynamic_pointer_cast<StreamManagementEnabled>(element)) {
+        std::shared_ptr<StanzaAckRequester> requester = std::make_shared<StanzaAckRequester>(stanzaAckRequestPolicy, timerFactory);
+        if (useStreamResumption && enabled->getResumeSupported() && !enabled->getResumeID().empty()) {
+            resumeID_ = enabled->getResumeID();
+            resumeLocation_ = enabled->getLocation();
+            requester->setResumable(true);
+        }
+        setAckHandlers(requester, std::make_shared<StanzaAckResponder>());
         needAcking = false;
         continueSessionInitialization();
     }
+    else if (std::shared_ptr<StreamResumed> resumed = std::dynamic_pointer_cast<StreamResumed>(element)) {
+        CHECK_STATE_OR_RETURN(State::ResumingStream);
+        handleStreamResumed(resumed);
+    }
     else if (std::dynamic_pointer_cast<StreamManagementFailed>(element)) {
-        needAcking = false;
-        continueSessionInitialization();
+        if (state == State::ResumingStream) {
+            handleStreamResumeFailed();
+        }
+        else {
+            needAcking = false;
+            continueSessionInitialization();
+        }
     }
     else if (AuthChallenge* challenge = dynamic_cast<AuthChallenge*>(element.get())) {
         CHECK_STATE_OR_RETURN(State::Authenticating);
@@ -403,7 +432,9 @@ void ClientSession::continueSessionInitialization() {
     }
     else if (needAcking) {
         state = State::EnablingSessionManagement;
-        stream->writeElement(std::make_shared<EnableStreamManagement>());
+        std::shared_ptr<EnableStreamManagement> enable = std::make_shared<EnableStreamManagement>();
+        enable->setResumeSupported(useStreamResumption);
+        stream->writeElement(enable);
     }
     else if (needSessionStart) {
         state = State::StartingSession;
@@ -411,6 +442,12 @@ void ClientSession::continueSessionInitialization() {
     }
     else {
         state = State::Initialized;
+        // Send the stanzas the server did not receive on the stream that could not be resumed
+        std::deque<std::shared_ptr<Stanza> > stanzas;
+        stanzas.swap(stanzasToResend_);
+        for (auto&& stanza : stanzas) {
+            sendStanza(stanza);
+        }
         onInitialized();
     }
 }
@@ -498,9 +535,26 @@ void ClientSession::handleStreamClosed(std::shared_ptr<Swift::Error> streamError
         streamShutdownTimeout.reset();
     }
 
+    // The stream can be resumed on a new connection if it was not closed on purpose
+    if (stanzaAckRequester_ && !resumeID_.empty() && previousState != State::Finishing) {
+        resumeState_ = std::make_shared<ResumeState>();
+        resumeState_->id = resumeID_;
+        resumeState_->location = resumeLocation_;
+        resumeState_->jid = localJID;
+        resumeState_->stanzaAckRequester = stanzaAckRequester_;
+        resumeState_->stanzaAckResponder = stanzaAckResponder_;
+    }
+
     if (stanzaAckRequester_) {
         stanzaAckRequester_->onRequestAck.disconnect(boost::bind(&ClientSession::requestAck, shared_from_this()));
         stanzaAckRequester_->onStanzaAcked.disconnect(boost::bind(&ClientSession::handleStanzaAcked, shared_from_this(), _1));
+        stanzaAckRequester_->onStanzaDropped.disconnect(boost::bind(&ClientSession::handleStanzaDropped, shared_from_this(), _1));
+        stanzaAckRequester_->onBackpressureChanged.disconnect(boost::bind(&ClientSession::handleStanzaAckBackpressureChanged, shared_from_this(), _1));
+        stream->onDataWritten.disconnect(boost::bind(&ClientSession::handleDataWritten, shared_from_this(), _1));
+        // A requester kept for resuming releases its backpressure once its stanzas are resent
+        if (!resumeState_ && stanzaAckRequester_->isBackpressureActive()) {
+            onStanzaAckBackpressureChanged(false);
+        }
         stanzaAckRequester_.reset();
     }
     if (stanzaAckResponder_) {
@@ -569,6 +623,62 @@ void ClientSession::finishSession(std::shared_ptr<Swift::Error> error) {
     }
 }
 
+void ClientSession::handleStreamResumed(std::shared_ptr<StreamResumed> resumed) {
+    if (!resumed->getResumeID().empty() && resumed->getResumeID() != previousResumeState_->id) {
+        finishSession(Error::StreamResumeFailedError);
+        return;
+    }
+    std::shared_ptr<ResumeState> previous = previousResumeState_;
+    previousResumeState_.reset();
+    localJID = previous->jid;
+    resumeID_ = previous->id;
+    resumeLocation_ = previous->location;
+    setAckHandlers(previous->stanzaAckRequester, previous->stanzaAckResponder);
+    if (resumed->getHandledStanzasCount()) {
+        stanzaAckRequester_->handleAckReceived(*resumed->getHandledStanzasCount());
+    }
+
+    // Send the stanzas the server did not receive before the connection was lost
+    for (auto&& stanza : stanzaAckRequester_->takeUnackedStanzas()) {
+        sendStanza(stanza);
+    }
+
+    resumed_ = true;
+    state = State::Initialized;
+    onInitialized();
+}
+
+void ClientSession::handleStreamResumeFailed() {
+    // The server forgot the previous stream, so bind a new resource instead (XEP-0198, section 5)
+    // and resend what it did not acknowledge once the new session is up.
+    std::shared_ptr<StanzaAckRequester> previousRequester = previousResumeState_->stanzaAckRequester;
+    previousResumeState_.reset();
+    bool backpressureActive = previousRequester->isBackpressureActive();
+    stanzasToResend_ = previousRequester->takeUnackedStanzas();
+    if (backpressureActive) {
+        onStanzaAckBackpressureChanged(false);
+    }
+
+    if (!needResourceBind) {
+        // Resource binding is a MUST
+        finishSession(Error::ResourceBindError);
+    }
+    else {
+        continueSessionInitialization();
+    }
+}
+
+void ClientSession::setAckHandlers(std::shared_ptr<StanzaAckRequester> requester, std::shared_ptr<StanzaAckResponder> responder) {
+    stanzaAckRequester_ = requester;
+    stanzaAckRequester_->onRequestAck.connect(boost::bind(&ClientSession::requestAck, shared_from_this()));
+    stanzaAckRequester_->onStanzaAcked.connect(boost::bind(&ClientSession::handleStanzaAcked, shared_from_this(), _1));
+    stanzaAckRequester_->onStanzaDropped.connect(boost::bind(&ClientSession::handleStanzaDropped, shared_from_this(), _1));
+    stanzaAckRequester_->onBackpressureChanged.connect(boost::bind(&ClientSession::handleStanzaAckBackpressureChanged, shared_from_this(), _1));
+    stream->onDataWritten.connect(boost::bind(&ClientSession::handleDataWritten, shared_from_this(), _1));
+    stanzaAckResponder_ = responder;
+    stanzaAckResponder_->onAck.connect(boost::bind(&ClientSession::ack, shared_from_this(), _1));
+}
+
 void ClientSession::requestAck() {
     stream->writeElement(std::make_shared<StanzaAckRequest>());
 }
@@ -577,6 +687,18 @@ void ClientSession::handleStanzaAcked(std::shared_ptr<Stanza> stanza) {
     onStanzaAcked(stanza);
 }
 
+void ClientSession::handleStanzaDropped(std::shared_ptr<Stanza> stanza) {
+    onStanzaDropped(stanza);
+}
+
+void ClientSession::handleStanzaAckBackpressureChanged(bool active) {
+    onStanzaAckBackpressureChanged(active);
+}
+
+void ClientSession::handleDataWritten(const SafeByteArray& data) {
+    writtenBytes += data.size();
+}
+
 void ClientSession::ack(unsigned int handledStanzasCount) {
     stream->writeElement(std::make_shared<StanzaAck>(handledStanzasCount));
 }
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 
@@ -16,6 +17,7 @@
 #include <Swiften/Elements/ToplevelElement.h>
 #include <Swiften/JID/JID.h>
 #include <Swiften/Session/SessionStream.h>
+#include <Swiften/StreamManagement/StanzaAckRequestPolicy.h>
 
 namespace Swift {
     class CertificateTrustChecker;
@@ -25,6 +27,7 @@ namespace Swift {
     class Stanza;
     class StanzaAckRequester;
     class StanzaAckResponder;
+    class StreamResumed;
     class TimerFactory;
     class Timer;
 
@@ -40,6 +43,7 @@ namespace Swift {
                 WaitingForCredentials,
                 Authenticating,
                 EnablingSessionManagement,
+                ResumingStream,
                 BindingResource,
                 StartingSession,
                 Initialized,
@@ -60,6 +64,7 @@ namespace Swift {
                     TLSError,
                     StreamError,
                     StreamEndError, // The server send a closing stream tag.
+                    StreamResumeFailedError,
                 } type;
                 std::shared_ptr<boost::system::error_code> errorCode;
                 Error(Type type) : type(type) {}
@@ -71,6 +76,17 @@ namespace Swift {
                 RequireTLS
             };
 
+            /**
+             * The state needed to resume a stream (XEP-0198) on a new connection.
+             */
+            struct ResumeState {
+                std::string id;
+                std::string location;
+                JID jid;
+                std::shared_ptr<StanzaAckRequester> stanzaAckRequester;
+                std::shared_ptr<StanzaAckResponder> stanzaAckResponder;
+            };
+
             ~ClientSession();
 
             static std::shared_ptr<ClientSession> create(const JID& jid, std::shared_ptr<SessionStream> stream, IDNConverter* idnConverter, CryptoProvider* crypto, TimerFactory* timerFactory) {
@@ -97,12 +113,60 @@ namespace Swift {
                 useAcks = b;
             }
 
+            /**
+             * Sets when acks are requested for sent stanzas, and how many
+             * unacked stanzas are kept. Only has an effect if acks are used.
+             */
+            void setStanzaAckRequestPolicy(const StanzaAckRequestPolicy& policy) {
+                stanzaAckRequestPolicy = policy;
+            }
+
+            /**
+             * Asks the server to allow resuming the stream after the connection drops.
+             * Only has an effect if acks are used.
+             */
+            void setUseStreamResumption(bool b) {
+                useStreamResumption = b;
+            }
+
+            /**
+             * Resumes the stream described by \p state instead of binding a new resource.
+             * If the server cannot resume it, a new resource is bound and the stanzas
+             * it did not acknowledge are resent. Must be called before \ref start().
+             */
+            void setResumeState(std::shared_ptr<ResumeState> state) {
+                previousResumeState_ = state;
+            }
+
+            /**
+             * Returns the state to resume this session with, if the connection
+             * was lost while the stream could be resumed; nullptr otherwise.
+             */
+            std::shared_ptr<ResumeState> getResumeState() const {
+                return resumeState_;
+            }
+
+            /**
+             * Returns whether the session was initialized by resuming a previous stream.
+             */
+            bool isResumed() const {
+                return resumed_;
+            }
+
             bool getStreamManagementEnabled() const {
                 // Explicitly convert to bool. In C++11, it would be cleaner to
                 // compare to nullptr.
                 return static_cast<bool>(stanzaAckRequester_);
             }
 
+            /**
+             * Returns the requester tracking unacked stanzas, or nullptr if
+             * stream management is not enabled.
+             */
+            std::shared_ptr<StanzaAckRequester> getStanzaAckRequester() const {
+                return stanzaAckRequester_;
+            }
+
             bool getRosterVersioningSupported() const {
                 return rosterVersioningSupported;
             }
@@ -151,6 +215,8 @@ namespace Swift {
             boost::signals2::signal<void (std::shared_ptr<Swift::Error>)> onFinished;
             boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaReceived;
             boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
+            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaDropped;
+            boost::signals2::signal<void (bool)> onStanzaAckBackpressureChanged;
 
         private:
             ClientSession(
@@ -182,8 +248,14 @@ namespace Swift {
 
             void requestAck();
             void handleStanzaAcked(std::shared_ptr<Stanza> stanza);
+            void handleStanzaDropped(std::shared_ptr<Stanza> stanza);
+            void handleStanzaAckBackpressureChanged(bool active);
+            void handleDataWritten(const SafeByteArray& data);
             void ack(unsigned int handledStanzasCount);
             void continueAfterTLSEncrypted();
+            void handleStreamResumed(std::shared_ptr<StreamResumed> resumed);
+            void handleStreamResumeFailed();
+            void setAckHandlers(std::shared_ptr<StanzaAckRequester> requester, std::shared_ptr<StanzaAckResponder> responder);
             void checkTrustOrFinish(const std::vector<Certificate::ref>& certificateChain, std::shared_ptr<CertificateVerificationError> error);
             void initiateShutdown(bool sendFooter);
 
@@ -200,6 +272,9 @@ namespace Swift {
             bool useStreamCompression;
             UseTLS useTLS;
             bool useAcks;
+            bool useStreamResumption = false;
+            StanzaAckRequestPolicy stanzaAckRequestPolicy;
+            size_t writtenBytes = 0;
             bool needSessionStart;
             bool needResourceBind;
             bool needAcking;
@@ -207,6 +282,12 @@ namespace Swift {
             ClientAuthenticator* authenticator;
             std::shared_ptr<StanzaAckRequester> stanzaAckRequester_;
             std::shared_ptr<StanzaAckResponder> stanzaAckResponder_;
+            std::string resumeID_;
+            std::string resumeLocation_;
+            std::shared_ptr<ResumeState> previousResumeState_;
+            std::shared_ptr<ResumeState> resumeState_;
+            std::deque<std::shared_ptr<Stanza> > stanzasToResend_;
+            bool resumed_ = false;
             std::shared_ptr<Swift::Error> error_;
             CertificateTrustChecker* certificateTrustChecker;
             bool singleSignOn;
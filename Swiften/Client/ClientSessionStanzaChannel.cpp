@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,9 @@
 
 namespace Swift {
 
+ClientSessionStanzaChannel::ClientSessionStanzaChannel() : resuming(false) {
+}
+
 ClientSessionStanzaChannel::~ClientSessionStanzaChannel() {
     if (session) {
         session->onFinished.disconnect(boost::bind(&ClientSessionStanzaChannel::handleSessionFinished, this, _1));
@@ -52,17 +55,39 @@ void ClientSessionStanzaChannel::send(std::shared_ptr<Stanza> stanza) {
         SWIFT_LOG(warning) << "Client: Trying to send a stanza while disconnected." << std::endl;
         return;
     }
+    if (resuming) {
+        pendingStanzas.push_back(stanza);
+        return;
+    }
     session->sendStanza(stanza);
 }
 
+void ClientSessionStanzaChannel::abortResumption() {
+    if (resuming) {
+        resuming = false;
+        pendingStanzas.clear();
+        onAvailableChanged(false);
+    }
+}
+
 void ClientSessionStanzaChannel::handleSessionFinished(std::shared_ptr<Error>) {
+    bool canResume = !!session->getResumeState();
     session->onFinished.disconnect(boost::bind(&ClientSessionStanzaChannel::handleSessionFinished, this, _1));
     session->onStanzaReceived.disconnect(boost::bind(&ClientSessionStanzaChannel::handleStanza, this, _1));
     session->onStanzaAcked.disconnect(boost::bind(&ClientSessionStanzaChannel::handleStanzaAcked, this, _1));
     session->onInitialized.disconnect(boost::bind(&ClientSessionStanzaChannel::handleSessionInitialized, this));
     session.reset();
 
-    onAvailableChanged(false);
+    if (canResume) {
+        // Stay available, the owner of the channel will try to resume the stream
+        resuming = true;
+    }
+    else if (resuming) {
+        abortResumption();
+    }
+    else {
+        onAvailableChanged(false);
+    }
 }
 
 void ClientSessionStanzaChannel::handleStanza(std::shared_ptr<Stanza> stanza) {
@@ -106,6 +131,19 @@ void ClientSessionStanzaChannel::handleStanzaAcked(std::shared_ptr<Stanza> stanz
 
 
 void ClientSessionStanzaChannel::handleSessionInitialized() {
+    if (resuming) {
+        resuming = false;
+        std::vector<std::shared_ptr<Stanza> > stanzas;
+        stanzas.swap(pendingStanzas);
+        for (auto&& stanza : stanzas) {
+            session->sendStanza(stanza);
+        }
+        if (session->isResumed()) {
+            return;
+        }
+        // The server state of the previous session is gone
+        onAvailableChanged(false);
+    }
     onAvailableChanged(true);
 }
 
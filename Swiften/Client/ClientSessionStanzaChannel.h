@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/IDGenerator.h>
@@ -19,9 +20,16 @@
 namespace Swift {
     /**
      * StanzaChannel implementation around a ClientSession.
+     *
+     * When a session that can be resumed loses its connection, the channel stays
+     * available, and queues the stanzas sent until the next session resumes the
+     * stream (or until \ref abortResumption is called). If the next session had to
+     * bind a new resource instead, the queued stanzas are sent on it, and the channel
+     * reports becoming unavailable and available again.
      */
     class SWIFTEN_API ClientSessionStanzaChannel : public StanzaChannel {
         public:
+            ClientSessionStanzaChannel();
             virtual ~ClientSessionStanzaChannel();
 
             void setSession(std::shared_ptr<ClientSession> session);
@@ -33,9 +41,19 @@ namespace Swift {
             virtual std::vector<Certificate::ref> getPeerCertificateChain() const;
 
             bool isAvailable() const {
-                return session && session->getState() == ClientSession::State::Initialized;
+                return resuming || (session && session->getState() == ClientSession::State::Initialized);
             }
 
+            bool isResuming() const {
+                return resuming;
+            }
+
+            /**
+             * Gives up on resuming the previous session, dropping the queued stanzas
+             * and making the channel unavailable.
+             */
+            void abortResumption();
+
         private:
             std::string getNewIQID();
             void send(std::shared_ptr<Stanza> stanza);
@@ -47,6 +65,8 @@ namespace Swift {
         private:
             IDGenerator idGenerator;
             std::shared_ptr<ClientSession> session;
+            bool resuming;
+            std::vector<std::shared_ptr<Stanza> > pendingStanzas;
     };
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
 
 #include <Swiften/Base/Algorithm.h>
@@ -31,6 +32,29 @@
 
 namespace Swift {
 
+/**
+ * Splits a stream management location ("host", "host:port" or "[IPv6]:port").
+ */
+static void parseLocation(const std::string& location, std::string& host, int& port) {
+    std::string::size_type portSeparator = location.rfind(':');
+    if (portSeparator != std::string::npos && location.find(':') != portSeparator && location[0] != '[') {
+        // Bare IPv6 address without a port
+        portSeparator = std::string::npos;
+    }
+    host = location.substr(0, portSeparator);
+    if (host.size() > 2 && host[0] == '[' && host[host.size() - 1] == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+    port = -1;
+    if (portSeparator != std::string::npos) {
+        try {
+            port = boost::lexical_cast<int>(location.substr(portSeparator + 1));
+        }
+        catch (const boost::bad_lexical_cast&) {
+        }
+    }
+}
+
 CoreClient::CoreClient(const JID& jid, const SafeByteArray& password, NetworkFactories* networkFactories) : jid_(jid), password_(password), networkFactories(networkFactories), disconnectRequested_(false), certificateTrustChecker(nullptr) {
     stanzaChannel_ = new ClientSessionStanzaChannel();
     stanzaChannel_->onMessageReceived.connect(boost::bind(&CoreClient::handleMessageReceived, this, _1));
@@ -56,6 +80,12 @@ CoreClient::~CoreClient() {
 void CoreClient::connect(const ClientOptions& o) {
     SWIFT_LOG(debug) << "Connecting ";
 
+    boost::optional<ClientError> error;
+    abortResumption(error);
+    startConnecting(o);
+}
+
+void CoreClient::startConnecting(const ClientOptions& o) {
     forceReset();
     disconnectRequested_ = false;
 
@@ -118,6 +148,7 @@ void CoreClient::connect(const ClientOptions& o) {
         connector_ = std::make_shared<ChainedConnector>(host, port, serviceLookupPrefix, networkFactories->getDomainNameResolver(), connectionFactories, networkFactories->getTimerFactory());
         connector_->onConnectFinished.connect(boost::bind(&CoreClient::handleConnectorFinished, this, _1, _2));
         connector_->setTimeoutMilliseconds(2*60*1000);
+        connector_->setConnectionAttemptDelayMilliseconds(o.connectionAttemptDelayInMilliseconds);
         connector_->start();
     }
     else {
@@ -173,9 +204,17 @@ void CoreClient::bindSessionToStream() {
             break;
     }
     session_->setUseAcks(options.useAcks);
+    session_->setStanzaAckRequestPolicy(options.stanzaAckRequestPolicy);
+    session_->setUseStreamResumption(options.useStreamResumption && options.boshURL.isEmpty() && !options.forgetPassword);
+    if (resumeState_) {
+        session_->setResumeState(resumeState_);
+    }
     stanzaChannel_->setSession(session_);
+    session_->onInitialized.connect(boost::bind(&CoreClient::handleSessionInitialized, this));
     session_->onFinished.connect(boost::bind(&CoreClient::handleSessionFinished, this, _1));
     session_->onNeedCredentials.connect(boost::bind(&CoreClient::handleNeedCredentials, this));
+    session_->onStanzaDropped.connect(boost::bind(&CoreClient::handleStanzaDropped, this, _1));
+    session_->onStanzaAckBackpressureChanged.connect(boost::bind(&CoreClient::handleStanzaAckBackpressureChanged, this, _1));
     session_->start();
 }
 
@@ -183,6 +222,9 @@ void CoreClient::bindSessionToStream() {
  * Only called for TCP sessions. BOSH is handled inside the BOSHSessionStream.
  */
 void CoreClient::handleConnectorFinished(std::shared_ptr<Connection> connection, std::shared_ptr<Error> error) {
+    if (connection && connector_->getConnectLatency()) {
+        SWIFT_LOG(debug) << "Connected in " << connector_->getConnectLatency()->count() << " ms" << std::endl;
+    }
     resetConnector();
     if (!connection) {
         if (options.forgetPassword) {
@@ -192,6 +234,7 @@ void CoreClient::handleConnectorFinished(std::shared_ptr<Connection> connection,
         if (!disconnectRequested_) {
             clientError = std::dynamic_pointer_cast<DomainNameResolveError>(error) ? boost::optional<ClientError>(ClientError::DomainNameResolveError) : boost::optional<ClientError>(ClientError::ConnectionError);
         }
+        abortResumption(clientError);
         onDisconnected(clientError);
     }
     else {
@@ -200,7 +243,9 @@ void CoreClient::handleConnectorFinished(std::shared_ptr<Connection> connection,
 
         if (certificate_ && certificate_->isNull()) {
             //certificate cannot be read so do not initailise session
-            onDisconnected(boost::optional<ClientError>(ClientError::ClientCertificateLoadError));
+            boost::optional<ClientError> clientError(ClientError::ClientCertificateLoadError);
+            abortResumption(clientError);
+            onDisconnected(clientError);
             return;
         }
 
@@ -237,6 +282,7 @@ void CoreClient::handleSessionFinished(std::shared_ptr<Error> error) {
     if (options.forgetPassword) {
         purgePassword();
     }
+    std::shared_ptr<ClientSession::ResumeState> resumeState = session_->getResumeState();
     resetSession();
 
     boost::optional<ClientError> actualError;
@@ -277,6 +323,9 @@ void CoreClient::handleSessionFinished(std::shared_ptr<Error> error) {
                 case ClientSession::Error::StreamEndError:
                     clientError = ClientError(ClientError::StreamError);
                     break;
+                case ClientSession::Error::StreamResumeFailedError:
+                    clientError = ClientError(ClientError::StreamError);
+                    break;
             }
             clientError.setErrorCode(actualError->errorCode);
         }
@@ -354,9 +403,54 @@ void CoreClient::handleSessionFinished(std::shared_ptr<Error> error) {
         }
         actualError = boost::optional<ClientError>(clientError);
     }
+
+    if (resumeState && !disconnectRequested_) {
+        resumeSession(resumeState, actualError);
+        return;
+    }
+    abortResumption(actualError);
     onDisconnected(actualError);
 }
 
+void CoreClient::handleSessionInitialized() {
+    if (session_->isResumed()) {
+        SWIFT_LOG(debug) << "Stream resumed" << std::endl;
+        resumeState_.reset();
+        resumeError_.reset();
+        onResumed();
+    }
+    else if (resumeState_) {
+        SWIFT_LOG(debug) << "Could not resume stream " << resumeState_->id << ", bound a new resource" << std::endl;
+        resumeState_.reset();
+        resumeError_.reset();
+    }
+}
+
+void CoreClient::resumeSession(std::shared_ptr<ClientSession::ResumeState> resumeState, const boost::optional<ClientError>& error) {
+    SWIFT_LOG(debug) << "Connection lost, resuming stream " << resumeState->id << std::endl;
+    resumeState_ = resumeState;
+    resumeError_ = error;
+
+    ClientOptions resumeOptions = options;
+    if (!resumeState->location.empty()) {
+        parseLocation(resumeState->location, resumeOptions.manualHostname, resumeOptions.manualPort);
+    }
+    startConnecting(resumeOptions);
+}
+
+void CoreClient::abortResumption(boost::optional<ClientError>& error) {
+    if (resumeState_) {
+        SWIFT_LOG(debug) << "Failed to resume stream " << resumeState_->id << std::endl;
+        resumeState_.reset();
+        // Report the error that caused the connection loss, unless the user disconnected.
+        if (error) {
+            error = resumeError_;
+        }
+        resumeError_.reset();
+    }
+    stanzaChannel_->abortResumption();
+}
+
 void CoreClient::handleNeedCredentials() {
     assert(session_);
     session_->sendCredentials(password_);
@@ -418,6 +512,14 @@ void CoreClient::handleStanzaAcked(Stanza::ref stanza) {
     onStanzaAcked(stanza);
 }
 
+void CoreClient::handleStanzaDropped(Stanza::ref stanza) {
+    onStanzaDropped(stanza);
+}
+
+void CoreClient::handleStanzaAckBackpressureChanged(bool active) {
+    onStanzaAckBackpressureChanged(active);
+}
+
 bool CoreClient::isAvailable() const {
     return stanzaChannel_->isAvailable();
 }
@@ -457,8 +559,11 @@ void CoreClient::resetConnector() {
 }
 
 void CoreClient::resetSession() {
+    session_->onInitialized.disconnect(boost::bind(&CoreClient::handleSessionInitialized, this));
     session_->onFinished.disconnect(boost::bind(&CoreClient::handleSessionFinished, this, _1));
     session_->onNeedCredentials.disconnect(boost::bind(&CoreClient::handleNeedCredentials, this));
+    session_->onStanzaDropped.disconnect(boost::bind(&CoreClient::handleStanzaDropped, this, _1));
+    session_->onStanzaAckBackpressureChanged.disconnect(boost::bind(&CoreClient::handleStanzaAckBackpressureChanged, this, _1));
 
     sessionStream_->onDataRead.disconnect(boost::bind(&CoreClient::handleDataRead, this, _1));
     sessionStream_->onDataWritten.disconnect(boost::bind(&CoreClient::handleDataWritten, this, _1));
@@ -9,12 +9,14 @@
 #include <memory>
 #include <string>
 
+#include <boost/optional.hpp>
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
 #include <Swiften/Client/ClientError.h>
 #include <Swiften/Client/ClientOptions.h>
+#include <Swiften/Client/ClientSession.h>
 #include <Swiften/Entity/Entity.h>
 #include <Swiften/JID/JID.h>
 #include <Swiften/TLS/CertificateWithKey.h>
@@ -22,7 +24,6 @@
 namespace Swift {
     class CertificateTrustChecker;
     class ChainedConnector;
-    class ClientSession;
     class ClientSessionStanzaChannel;
     class Connection;
     class ConnectionFactory;
@@ -156,6 +157,21 @@ namespace Swift {
              */
             boost::signals2::signal<void ()> onConnected;
 
+            /**
+             * Emitted when the stream was resumed on a new connection, after the
+             * connection was lost.
+             *
+             * Resuming is transparent: the client stays available while reconnecting,
+             * and neither onDisconnected nor onConnected are emitted.
+             * If resuming fails, onDisconnected is emitted with the error that
+             * caused the connection loss. If the server no longer knows the stream,
+             * a new resource is bound instead, the unacknowledged stanzas are resent,
+             * and onConnected is emitted without onResumed.
+             *
+             * \see ClientOptions::useStreamResumption
+             */
+            boost::signals2::signal<void ()> onResumed;
+
             /**
              * Emitted when the client receives data.
              *
@@ -190,6 +206,25 @@ namespace Swift {
              */
             boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
 
+            /**
+             * Emitted for a stanza that will not be reported as acked, because
+             * the maximum number of unacked stanzas was exceeded on a stream
+             * that cannot be resumed. The stanza may or may not have been
+             * received by the server.
+             *
+             * \see StanzaAckRequestPolicy::maxUnackedStanzas
+             */
+            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaDropped;
+
+            /**
+             * Emitted with true when the maximum number of unacked stanzas
+             * is reached, and with false when enough of them were acked.
+             * Senders should hold back non-essential stanzas in between.
+             *
+             * \see StanzaAckRequestPolicy::maxUnackedStanzas
+             */
+            boost::signals2::signal<void (bool)> onStanzaAckBackpressureChanged;
+
         protected:
             std::shared_ptr<ClientSession> getSession() const {
                 return session_;
@@ -208,14 +243,20 @@ namespace Swift {
             void handleConnectorFinished(std::shared_ptr<Connection>, std::shared_ptr<Error> error);
             void handleStanzaChannelAvailableChanged(bool available);
             void handleSessionFinished(std::shared_ptr<Error>);
+            void handleSessionInitialized();
             void handleNeedCredentials();
             void handleDataRead(const SafeByteArray&);
             void handleDataWritten(const SafeByteArray&);
             void handlePresenceReceived(std::shared_ptr<Presence>);
             void handleMessageReceived(std::shared_ptr<Message>);
             void handleStanzaAcked(std::shared_ptr<Stanza>);
+            void handleStanzaDropped(std::shared_ptr<Stanza>);
+            void handleStanzaAckBackpressureChanged(bool active);
             void purgePassword();
             void bindSessionToStream();
+            void startConnecting(const ClientOptions&);
+            void resumeSession(std::shared_ptr<ClientSession::ResumeState> resumeState, const boost::optional<ClientError>& error);
+            void abortResumption(boost::optional<ClientError>& error);
 
             void resetConnector();
             void resetSession();
@@ -236,5 +277,7 @@ namespace Swift {
             CertificateWithKey::ref certificate_;
             bool disconnectRequested_;
             CertificateTrustChecker* certificateTrustChecker;
+            std::shared_ptr<ClientSession::ResumeState> resumeState_;
+            boost::optional<ClientError> resumeError_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -27,12 +27,15 @@
 #include <Swiften/Elements/Message.h>
 #include <Swiften/Elements/ResourceBind.h>
 #include <Swiften/Elements/StanzaAck.h>
+#include <Swiften/Elements/StanzaAckRequest.h>
 #include <Swiften/Elements/StartTLSFailure.h>
 #include <Swiften/Elements/StartTLSRequest.h>
 #include <Swiften/Elements/StreamError.h>
 #include <Swiften/Elements/StreamFeatures.h>
 #include <Swiften/Elements/StreamManagementEnabled.h>
 #include <Swiften/Elements/StreamManagementFailed.h>
+#include <Swiften/Elements/StreamResume.h>
+#include <Swiften/Elements/StreamResumed.h>
 #include <Swiften/Elements/TLSProceed.h>
 #include <Swiften/IDN/IDNConverter.h>
 #include <Swiften/IDN/PlatformIDNConverter.h>
@@ -60,6 +63,13 @@ class ClientSessionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testAuthenticate_EXTERNAL);
         CPPUNIT_TEST(testStreamManagement);
         CPPUNIT_TEST(testStreamManagement_Failed);
+        CPPUNIT_TEST(testStreamResumption_ConnectionLost);
+        CPPUNIT_TEST(testStreamResumption_ClosedByClient);
+        CPPUNIT_TEST(testStreamResumption_NotEnabled);
+        CPPUNIT_TEST(testStreamResumption_Resume);
+        CPPUNIT_TEST(testStreamResumption_ResumeFailedBindsNewResource);
+        CPPUNIT_TEST(testStreamResumption_ResendsStanzasBeyondMaxUnacked);
+        CPPUNIT_TEST(testStreamManagement_ReportsStanzasBeyondMaxUnacked);
         CPPUNIT_TEST(testUnexpectedChallenge);
         CPPUNIT_TEST(testFinishAcksStanzas);
 
@@ -90,6 +100,8 @@ class ClientSessionTest : public CppUnit::TestFixture {
             sessionFinishedReceived = false;
             needCredentials = false;
             blindCertificateTrustChecker = new BlindCertificateTrustChecker();
+            ackedStanzas.clear();
+            droppedStanzas.clear();
         }
 
         void tearDown() {
@@ -376,6 +388,155 @@ class ClientSessionTest : public CppUnit::TestFixture {
             session->finish();
         }
 
+        void testStreamResumption_ConnectionLost() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeSession(session, true);
+            CPPUNIT_ASSERT(server->enableStreamManagement->getResumeSupported());
+            CPPUNIT_ASSERT(!session->getResumeState());
+
+            server->breakConnection();
+
+            std::shared_ptr<ClientSession::ResumeState> resumeState = session->getResumeState();
+            CPPUNIT_ASSERT(resumeState);
+            CPPUNIT_ASSERT_EQUAL(std::string("resume-id"), resumeState->id);
+            CPPUNIT_ASSERT_EQUAL(std::string("other.bar.com:5223"), resumeState->location);
+            CPPUNIT_ASSERT_EQUAL(JID("foo@bar.com/bla"), resumeState->jid);
+        }
+
+        void testStreamResumption_ClosedByClient() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeSession(session, true);
+
+            session->finish();
+            server->onStreamEndReceived();
+
+            CPPUNIT_ASSERT(!session->getResumeState());
+        }
+
+        void testStreamResumption_NotEnabled() {
+            std::shared_ptr<ClientSession> session(createSession());
+            initializeSession(session, true);
+            CPPUNIT_ASSERT(!server->enableStreamManagement->getResumeSupported());
+
+            server->breakConnection();
+
+            CPPUNIT_ASSERT(!session->getResumeState());
+        }
+
+        void testStreamResumption_Resume() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeSession(session, true);
+            server->sendMessage();
+            server->sendMessage();
+            session->sendStanza(createMessage("m1"));
+            session->sendStanza(createMessage("m2"));
+            session->sendStanza(createMessage("m3"));
+            server->breakConnection();
+
+            server = std::make_shared<MockSessionStream>();
+            std::shared_ptr<ClientSession> resumedSession(createSession());
+            resumedSession->setUseStreamResumption(true);
+            resumedSession->setResumeState(session->getResumeState());
+            resumedSession->onStanzaAcked.connect(boost::bind(&ClientSessionTest::handleStanzaAcked, this, _1));
+            authenticate(resumedSession);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveStreamResume("resume-id", 2);
+            server->sendStreamResumed("resume-id", 1);
+
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Initialized, resumedSession->getState());
+            CPPUNIT_ASSERT(resumedSession->isResumed());
+            CPPUNIT_ASSERT(resumedSession->getStreamManagementEnabled());
+            CPPUNIT_ASSERT_EQUAL(JID("foo@bar.com/bla"), resumedSession->getLocalJID());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), ackedStanzas.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("m1"), ackedStanzas[0]->getID());
+            server->receiveMessage("m2");
+            server->receiveAckRequest();
+            server->receiveMessage("m3");
+            server->receiveAckRequest();
+        }
+
+        void testStreamResumption_ResendsStanzasBeyondMaxUnacked() {
+            StanzaAckRequestPolicy policy;
+            policy.maxUnackedStanzas = 2;
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            session->setStanzaAckRequestPolicy(policy);
+            session->onStanzaDropped.connect(boost::bind(&ClientSessionTest::handleStanzaDropped, this, _1));
+            initializeSession(session, true);
+            session->sendStanza(createMessage("m1"));
+            session->sendStanza(createMessage("m2"));
+            session->sendStanza(createMessage("m3"));
+            CPPUNIT_ASSERT(droppedStanzas.empty());
+            server->breakConnection();
+
+            server = std::make_shared<MockSessionStream>();
+            std::shared_ptr<ClientSession> resumedSession(createSession());
+            resumedSession->setUseStreamResumption(true);
+            resumedSession->setResumeState(session->getResumeState());
+            authenticate(resumedSession);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveStreamResume("resume-id", 0);
+            server->sendStreamResumed("resume-id", 0);
+
+            server->receiveMessage("m1");
+            server->receiveAckRequest();
+            server->receiveMessage("m2");
+            server->receiveAckRequest();
+            server->receiveMessage("m3");
+            server->receiveAckRequest();
+        }
+
+        void testStreamManagement_ReportsStanzasBeyondMaxUnacked() {
+            StanzaAckRequestPolicy policy;
+            policy.maxUnackedStanzas = 2;
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setStanzaAckRequestPolicy(policy);
+            session->onStanzaAcked.connect(boost::bind(&ClientSessionTest::handleStanzaAcked, this, _1));
+            session->onStanzaDropped.connect(boost::bind(&ClientSessionTest::handleStanzaDropped, this, _1));
+            initializeSession(session, true);
+            session->sendStanza(createMessage("m1"));
+            session->sendStanza(createMessage("m2"));
+            session->sendStanza(createMessage("m3"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), droppedStanzas.size());
+            CPPUNIT_ASSERT_EQUAL(std::string("m1"), droppedStanzas[0]->getID());
+
+            session->finish();
+        }
+
+        void testStreamResumption_ResumeFailedBindsNewResource() {
+            std::shared_ptr<ClientSession> session(createSession());
+            session->setUseStreamResumption(true);
+            initializeSession(session, true);
+            session->sendStanza(createMessage("m1"));
+            server->breakConnection();
+            sessionFinishedReceived = false;
+
+            server = std::make_shared<MockSessionStream>();
+            std::shared_ptr<ClientSession> resumedSession(createSession());
+            resumedSession->setUseStreamResumption(true);
+            resumedSession->setResumeState(session->getResumeState());
+            authenticate(resumedSession);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveStreamResume("resume-id", 0);
+            server->sendStreamManagementFailed();
+            server->receiveBind();
+            server->sendBindResult();
+            server->receiveStreamManagementEnable();
+            CPPUNIT_ASSERT(server->enableStreamManagement->getResumeSupported());
+            server->sendStreamManagementEnabledWithResumption();
+
+            CPPUNIT_ASSERT_EQUAL(ClientSession::State::Initialized, resumedSession->getState());
+            CPPUNIT_ASSERT(!resumedSession->isResumed());
+            CPPUNIT_ASSERT(resumedSession->getStreamManagementEnabled());
+            CPPUNIT_ASSERT(!sessionFinishedReceived);
+            server->receiveMessage("m1");
+            server->receiveAckRequest();
+        }
+
         void testFinishAcksStanzas() {
             std::shared_ptr<ClientSession> session(createSession());
             initializeSession(session);
@@ -432,7 +593,21 @@ class ClientSessionTest : public CppUnit::TestFixture {
             return session;
         }
 
-        void initializeSession(std::shared_ptr<ClientSession> session) {
+        void initializeSession(std::shared_ptr<ClientSession> session, bool resumable = false) {
+            authenticate(session);
+            server->sendStreamFeaturesWithBindAndStreamManagement();
+            server->receiveBind();
+            server->sendBindResult();
+            server->receiveStreamManagementEnable();
+            if (resumable) {
+                server->sendStreamManagementEnabledWithResumption();
+            }
+            else {
+                server->sendStreamManagementEnabled();
+            }
+        }
+
+        void authenticate(std::shared_ptr<ClientSession> session) {
             session->start();
             server->receiveStreamStart();
             server->sendStreamStart();
@@ -442,11 +617,20 @@ class ClientSessionTest : public CppUnit::TestFixture {
             server->sendAuthSuccess();
             server->receiveStreamStart();
             server->sendStreamStart();
-            server->sendStreamFeaturesWithBindAndStreamManagement();
-            server->receiveBind();
-            server->sendBindResult();
-            server->receiveStreamManagementEnable();
-            server->sendStreamManagementEnabled();
+        }
+
+        static std::shared_ptr<Message> createMessage(const std::string& id) {
+            std::shared_ptr<Message> message = std::make_shared<Message>();
+            message->setID(id);
+            return message;
+        }
+
+        void handleStanzaAcked(std::shared_ptr<Stanza> stanza) {
+            ackedStanzas.push_back(stanza);
+        }
+
+        void handleStanzaDropped(std::shared_ptr<Stanza> stanza) {
+            droppedStanzas.push_back(stanza);
         }
 
         void handleSessionFinished(std::shared_ptr<Error> error) {
@@ -626,6 +810,21 @@ class ClientSessionTest : public CppUnit::TestFixture {
                     onElementReceived(std::make_shared<StreamManagementEnabled>());
                 }
 
+                void sendStreamManagementEnabledWithResumption() {
+                    std::shared_ptr<StreamManagementEnabled> enabled = std::make_shared<StreamManagementEnabled>();
+                    enabled->setResumeSupported();
+                    enabled->setResumeID("resume-id");
+                    enabled->setLocation("other.bar.com:5223");
+                    onElementReceived(enabled);
+                }
+
+                void sendStreamResumed(const std::string& id, unsigned int handledStanzasCount) {
+                    std::shared_ptr<StreamResumed> resumed = std::make_shared<StreamResumed>();
+                    resumed->setResumeID(id);
+                    resumed->setHandledStanzasCount(handledStanzasCount);
+                    onElementReceived(resumed);
+                }
+
                 void sendStreamManagementFailed() {
                     onElementReceived(std::make_shared<StreamManagementFailed>());
                 }
@@ -665,7 +864,31 @@ class ClientSessionTest : public CppUnit::TestFixture {
                 void receiveStreamManagementEnable() {
                     Event event = popEvent();
                     CPPUNIT_ASSERT(event.element);
-                    CPPUNIT_ASSERT(std::dynamic_pointer_cast<EnableStreamManagement>(event.element));
+                    enableStreamManagement = std::dynamic_pointer_cast<EnableStreamManagement>(event.element);
+                    CPPUNIT_ASSERT(enableStreamManagement);
+                }
+
+                void receiveStreamResume(const std::string& id, unsigned int handledStanzasCount) {
+                    Event event = popEvent();
+                    CPPUNIT_ASSERT(event.element);
+                    std::shared_ptr<StreamResume> resume = std::dynamic_pointer_cast<StreamResume>(event.element);
+                    CPPUNIT_ASSERT(resume);
+                    CPPUNIT_ASSERT_EQUAL(id, resume->getResumeID());
+                    CPPUNIT_ASSERT(resume->getHandledStanzasCount());
+                    CPPUNIT_ASSERT_EQUAL(handledStanzasCount, *resume->getHandledStanzasCount());
+                }
+
+                void receiveMessage(const std::string& id) {
+                    Event event = popEvent();
+                    CPPUNIT_ASSERT(event.element);
+                    std::shared_ptr<Message> message = std::dynamic_pointer_cast<Message>(event.element);
+                    CPPUNIT_ASSERT(message);
+                    CPPUNIT_ASSERT_EQUAL(id, message->getID());
+                }
+
+                void receiveAckRequest() {
+                    Event event = popEvent();
+                    CPPUNIT_ASSERT(std::dynamic_pointer_cast<StanzaAckRequest>(event.element));
                 }
 
                 void receiveBind() {
@@ -700,6 +923,7 @@ class ClientSessionTest : public CppUnit::TestFixture {
                 std::string bindID;
                 int resetCount;
                 std::deque<Event> receivedEvents;
+                std::shared_ptr<EnableStreamManagement> enableStreamManagement;
         };
 
         std::shared_ptr<IDNConverter> idnConverter;
@@ -707,6 +931,8 @@ class ClientSessionTest : public CppUnit::TestFixture {
         bool sessionFinishedReceived;
         bool needCredentials;
         std::shared_ptr<Error> sessionFinishedError;
+        std::vector<std::shared_ptr<Stanza> > ackedStanzas;
+        std::vector<std::shared_ptr<Stanza> > droppedStanzas;
         BlindCertificateTrustChecker* blindCertificateTrustChecker;
         std::shared_ptr<CryptoProvider> crypto;
         std::shared_ptr<DummyTimerFactory> timerFactory;
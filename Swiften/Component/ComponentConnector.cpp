@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,21 +9,26 @@
 #include <boost/bind.hpp>
 
 #include <Swiften/Network/ConnectionFactory.h>
+#include <Swiften/Network/ConnectionRace.h>
 #include <Swiften/Network/DomainNameAddressQuery.h>
 #include <Swiften/Network/DomainNameResolver.h>
 #include <Swiften/Network/TimerFactory.h>
 
 namespace Swift {
 
-ComponentConnector::ComponentConnector(const std::string& hostname, int port, DomainNameResolver* resolver, ConnectionFactory* connectionFactory, TimerFactory* timerFactory) : hostname(hostname), port(port), resolver(resolver), connectionFactory(connectionFactory), timerFactory(timerFactory), timeoutMilliseconds(0) {
+ComponentConnector::ComponentConnector(const std::string& hostname, int port, DomainNameResolver* resolver, ConnectionFactory* connectionFactory, TimerFactory* timerFactory) : hostname(hostname), port(port), resolver(resolver), connectionFactory(connectionFactory), timerFactory(timerFactory), timeoutMilliseconds(0), connectionAttemptDelayMilliseconds(250) {
 }
 
 void ComponentConnector::setTimeoutMilliseconds(int milliseconds) {
     timeoutMilliseconds = milliseconds;
 }
 
+void ComponentConnector::setConnectionAttemptDelayMilliseconds(int milliseconds) {
+    connectionAttemptDelayMilliseconds = milliseconds;
+}
+
 void ComponentConnector::start() {
-    assert(!currentConnection);
+    assert(!race);
     assert(!timer);
     assert(!addressQuery);
     addressQuery = resolver->createAddressQuery(hostname);
@@ -47,39 +52,21 @@ void ComponentConnector::handleAddressQueryResult(const std::vector<HostAddress>
         finish(std::shared_ptr<Connection>());
     }
     else {
-        addressQueryResults = std::deque<HostAddress>(addresses.begin(), addresses.end());
-        tryNextAddress();
+        std::vector<HostAddressPort> candidates;
+        for (const auto& address : addresses) {
+            candidates.push_back(HostAddressPort(address, port));
+        }
+        race = ConnectionRace::create(connectionFactory, timerFactory, connectionAttemptDelayMilliseconds, 0);
+        race->onFinished.connect(boost::bind(&ComponentConnector::handleRaceFinished, shared_from_this(), _1));
+        std::shared_ptr<ConnectionRace> newRace = race;
+        newRace->addCandidates(candidates);
+        newRace->setComplete();
     }
 }
 
-void ComponentConnector::tryNextAddress() {
-    assert(!addressQueryResults.empty());
-    HostAddress address = addressQueryResults.front();
-    addressQueryResults.pop_front();
-    tryConnect(HostAddressPort(address, port));
-}
-
-void ComponentConnector::tryConnect(const HostAddressPort& target) {
-    assert(!currentConnection);
-    currentConnection = connectionFactory->createConnection();
-    currentConnection->onConnectFinished.connect(boost::bind(&ComponentConnector::handleConnectionConnectFinished, shared_from_this(), _1));
-    currentConnection->connect(target);
-}
-
-void ComponentConnector::handleConnectionConnectFinished(bool error) {
-    currentConnection->onConnectFinished.disconnect(boost::bind(&ComponentConnector::handleConnectionConnectFinished, shared_from_this(), _1));
-    if (error) {
-        currentConnection.reset();
-        if (!addressQueryResults.empty()) {
-            tryNextAddress();
-        }
-        else {
-            finish(std::shared_ptr<Connection>());
-        }
-    }
-    else {
-        finish(currentConnection);
-    }
+void ComponentConnector::handleRaceFinished(std::shared_ptr<Connection> connection) {
+    connectLatency = race->getConnectLatency();
+    finish(connection);
 }
 
 void ComponentConnector::finish(std::shared_ptr<Connection> connection) {
@@ -92,9 +79,10 @@ void ComponentConnector::finish(std::shared_ptr<Connection> connection) {
         addressQuery->onResult.disconnect(boost::bind(&ComponentConnector::handleAddressQueryResult, shared_from_this(), _1, _2));
         addressQuery.reset();
     }
-    if (currentConnection) {
-        currentConnection->onConnectFinished.disconnect(boost::bind(&ComponentConnector::handleConnectionConnectFinished, shared_from_this(), _1));
-        currentConnection.reset();
+    if (race) {
+        race->onFinished.disconnect(boost::bind(&ComponentConnector::handleRaceFinished, shared_from_this(), _1));
+        race->stop();
+        race.reset();
     }
     onConnectFinished(connection);
 }
@@ -1,15 +1,17 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
 
+#include <boost/optional.hpp>
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
@@ -22,6 +24,7 @@ namespace Swift {
     class DomainNameAddressQuery;
     class DomainNameResolver;
     class ConnectionFactory;
+    class ConnectionRace;
     class TimerFactory;
 
     class SWIFTEN_API ComponentConnector : public boost::signals2::trackable, public std::enable_shared_from_this<ComponentConnector> {
@@ -34,6 +37,20 @@ namespace Swift {
 
             void setTimeoutMilliseconds(int milliseconds);
 
+            /**
+             * Sets the time to wait for a connection attempt before starting
+             * an attempt to the next address (see \ref ConnectionRace).
+             * Defaults to 250 ms; a value of 0 tries the addresses one at a time.
+             */
+            void setConnectionAttemptDelayMilliseconds(int milliseconds);
+
+            /**
+             * Returns the time it took to connect to the address that was used.
+             */
+            boost::optional<std::chrono::milliseconds> getConnectLatency() const {
+                return connectLatency;
+            }
+
             void start();
             void stop();
 
@@ -43,10 +60,7 @@ namespace Swift {
             ComponentConnector(const std::string& hostname, int port, DomainNameResolver*, ConnectionFactory*, TimerFactory*);
 
             void handleAddressQueryResult(const std::vector<HostAddress>& address, boost::optional<DomainNameResolveError> error);
-            void tryNextAddress();
-            void tryConnect(const HostAddressPort& target);
-
-            void handleConnectionConnectFinished(bool error);
+            void handleRaceFinished(std::shared_ptr<Connection>);
             void finish(std::shared_ptr<Connection>);
             void handleTimeout();
 
@@ -58,9 +72,10 @@ namespace Swift {
             ConnectionFactory* connectionFactory;
             TimerFactory* timerFactory;
             int timeoutMilliseconds;
+            int connectionAttemptDelayMilliseconds;
             std::shared_ptr<Timer> timer;
             std::shared_ptr<DomainNameAddressQuery> addressQuery;
-            std::deque<HostAddress> addressQueryResults;
-            std::shared_ptr<Connection> currentConnection;
+            std::shared_ptr<ConnectionRace> race;
+            boost::optional<std::chrono::milliseconds> connectLatency;
     };
 }
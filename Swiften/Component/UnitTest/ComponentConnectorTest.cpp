@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,6 +28,7 @@ class ComponentConnectorTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testConnect_TimeoutDuringResolve);
         CPPUNIT_TEST(testConnect_TimeoutDuringConnect);
         CPPUNIT_TEST(testConnect_NoTimeout);
+        CPPUNIT_TEST(testConnect_SlowAddressIsRacedAgainstNextAddress);
         CPPUNIT_TEST(testStop_Timeout);
         CPPUNIT_TEST_SUITE_END();
 
@@ -129,6 +130,26 @@ class ComponentConnectorTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(connections[0]);
         }
 
+        void testConnect_SlowAddressIsRacedAgainstNextAddress() {
+            ComponentConnector::ref testling(createConnector("foo.com", 1234));
+            testling->setTimeoutMilliseconds(1000);
+            resolver->addAddress("foo.com", host1);
+            resolver->addAddress("foo.com", host2);
+            connectionFactory->isResponsive = false;
+
+            testling->start();
+            eventLoop->processEvents();
+            connectionFactory->isResponsive = true;
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(HostAddressPort(host2, 1234) == *(connections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(connectionFactory->connections[0]->disconnected);
+            CPPUNIT_ASSERT(testling->getConnectLatency());
+        }
+
         void testStop_Timeout() {
             ComponentConnector::ref testling(createConnector("foo.com", 1234));
             testling->setTimeoutMilliseconds(10);
@@ -162,7 +183,7 @@ class ComponentConnectorTest : public CppUnit::TestFixture {
 
         struct MockConnection : public Connection {
             public:
-                MockConnection(const std::vector<HostAddressPort>& failingPorts, bool isResponsive, EventLoop* eventLoop) : eventLoop(eventLoop), failingPorts(failingPorts), isResponsive(isResponsive) {}
+                MockConnection(const std::vector<HostAddressPort>& failingPorts, bool isResponsive, EventLoop* eventLoop) : eventLoop(eventLoop), failingPorts(failingPorts), isResponsive(isResponsive), disconnected(false) {}
 
                 void listen() { assert(false); }
                 void connect(const HostAddressPort& address) {
@@ -173,7 +194,7 @@ class ComponentConnectorTest : public CppUnit::TestFixture {
                     }
                 }
 
-                void disconnect() { assert(false); }
+                void disconnect() { disconnected = true; }
                 void write(const SafeByteArray&) { assert(false); }
                 HostAddressPort getLocalAddress() const { return HostAddressPort(); }
                 HostAddressPort getRemoteAddress() const { return HostAddressPort(); }
@@ -182,6 +203,7 @@ class ComponentConnectorTest : public CppUnit::TestFixture {
                 boost::optional<HostAddressPort> hostAddressPort;
                 std::vector<HostAddressPort> failingPorts;
                 bool isResponsive;
+                bool disconnected;
         };
 
         struct MockConnectionFactory : public ConnectionFactory {
@@ -189,12 +211,15 @@ class ComponentConnectorTest : public CppUnit::TestFixture {
             }
 
             std::shared_ptr<Connection> createConnection() {
-                return std::make_shared<MockConnection>(failingPorts, isResponsive, eventLoop);
+                std::shared_ptr<MockConnection> connection = std::make_shared<MockConnection>(failingPorts, isResponsive, eventLoop);
+                connections.push_back(connection);
+                return connection;
             }
 
             EventLoop* eventLoop;
             bool isResponsive;
             std::vector<HostAddressPort> failingPorts;
+            std::vector<std::shared_ptr<MockConnection> > connections;
         };
 
     private:
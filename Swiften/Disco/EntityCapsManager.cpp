@@ -6,6 +6,9 @@
 
 #include <Swiften/Disco/EntityCapsManager.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <boost/bind.hpp>
 
 #include <Swiften/Client/StanzaChannel.h>
@@ -27,7 +30,7 @@ void EntityCapsManager::handlePresenceReceived(std::shared_ptr<Presence> presenc
             return;
         }
         std::string hash = capsInfo->getVersion();
-        std::map<JID, std::string>::iterator i = caps.find(from);
+        std::unordered_map<JID, std::string>::iterator i = caps.find(from);
         if (i == caps.end() || i->second != hash) {
             caps.insert(std::make_pair(from, hash));
             DiscoInfo::ref disco = capsProvider->getCaps(hash);
@@ -41,7 +44,7 @@ void EntityCapsManager::handlePresenceReceived(std::shared_ptr<Presence> presenc
         }
     }
     else {
-        std::map<JID, std::string>::iterator i = caps.find(from);
+        std::unordered_map<JID, std::string>::iterator i = caps.find(from);
         if (i != caps.end()) {
             caps.erase(i);
             onCapsChanged(from);
@@ -51,25 +54,36 @@ void EntityCapsManager::handlePresenceReceived(std::shared_ptr<Presence> presenc
 
 void EntityCapsManager::handleStanzaChannelAvailableChanged(bool available) {
     if (available) {
-        std::map<JID, std::string> capsCopy;
-        capsCopy.swap(caps);
-        for (std::map<JID,std::string>::const_iterator i = capsCopy.begin(); i != capsCopy.end(); ++i) {
-            onCapsChanged(i->first);
+        std::vector<JID> changedJIDs;
+        changedJIDs.reserve(caps.size());
+        for (std::unordered_map<JID, std::string>::const_iterator i = caps.begin(); i != caps.end(); ++i) {
+            changedJIDs.push_back(i->first);
+        }
+        caps.clear();
+        // Notify in JID order, independent of the hash map layout
+        std::sort(changedJIDs.begin(), changedJIDs.end());
+        for (const auto& jid : changedJIDs) {
+            onCapsChanged(jid);
         }
     }
 }
 
 void EntityCapsManager::handleCapsAvailable(const std::string& hash) {
     // TODO: Use Boost.Bimap ?
-    for (std::map<JID,std::string>::const_iterator i = caps.begin(); i != caps.end(); ++i) {
+    std::vector<JID> changedJIDs;
+    for (std::unordered_map<JID, std::string>::const_iterator i = caps.begin(); i != caps.end(); ++i) {
         if (i->second == hash) {
-            onCapsChanged(i->first);
+            changedJIDs.push_back(i->first);
         }
     }
+    std::sort(changedJIDs.begin(), changedJIDs.end());
+    for (const auto& jid : changedJIDs) {
+        onCapsChanged(jid);
+    }
 }
 
 DiscoInfo::ref EntityCapsManager::getCaps(const JID& jid) const {
-    std::map<JID, std::string>::const_iterator i = caps.find(jid);
+    std::unordered_map<JID, std::string>::const_iterator i = caps.find(jid);
     if (i != caps.end()) {
         return capsProvider->getCaps(i->second);
     }
@@ -6,7 +6,7 @@
 
 #pragma once
 
-#include <map>
+#include <unordered_map>
 
 #include <boost/signals2.hpp>
 
@@ -45,7 +45,7 @@ namespace Swift {
 
         private:
             CapsProvider* capsProvider;
-            std::map<JID, std::string> caps;
+            std::unordered_map<JID, std::string> caps;
             LRUCache<std::string, DiscoInfo::ref, 64> lruDiscoCache;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,6 +12,17 @@
 namespace Swift {
     class SWIFTEN_API EnableStreamManagement : public ToplevelElement {
         public:
-            EnableStreamManagement() {}
+            EnableStreamManagement() : resumeSupported(false) {}
+
+            void setResumeSupported(bool b) {
+                resumeSupported = b;
+            }
+
+            bool getResumeSupported() const {
+                return resumeSupported;
+            }
+
+        private:
+            bool resumeSupported;
     };
 }
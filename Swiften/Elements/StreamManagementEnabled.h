@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2014 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -33,8 +33,20 @@ namespace Swift {
                 return resumeID;
             }
 
+            /**
+             * The preferred location (host[:port]) to reconnect to when resuming the stream.
+             */
+            void setLocation(const std::string& location) {
+                this->location = location;
+            }
+
+            const std::string& getLocation() const {
+                return location;
+            }
+
         private:
             bool resumeSupported;
             std::string resumeID;
+            std::string location;
     };
 }
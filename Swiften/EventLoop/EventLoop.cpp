@@ -1,24 +1,15 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/EventLoop/EventLoop.h>
 
-#include <algorithm>
 #include <cassert>
-#include <vector>
-
-#include <boost/bind.hpp>
-#include <boost/lambda/bind.hpp>
-#include <boost/lambda/lambda.hpp>
-#include <boost/optional.hpp>
 
 #include <Swiften/Base/Log.h>
 
-namespace lambda = boost::lambda;
-
 namespace Swift {
 
 inline void invokeCallback(const Event& event) {
@@ -50,20 +41,13 @@ void EventLoop::handleNextEvents() {
         handlingEvents_ = true;
         std::unique_lock<std::recursive_mutex> lock(removeEventsMutex_);
         {
-            std::vector<Event> nextEvents;
-            {
-                std::unique_lock<std::recursive_mutex> lock(eventsMutex_);
-                for (int n = 0; ((n < eventsBatched) && !events_.empty()); n++) {
-                    nextEvents.push_back(events_.front());
-                    events_.pop_front();
-                }
-                callEventPosted = !events_.empty();
-            }
-            if (!nextEvents.empty()) {
-                for (const auto& event : nextEvents) {
-                    invokeCallback(event);
-                }
+            // Events are popped one at a time, so an event removed by an earlier callback
+            // of this batch is not executed.
+            Event event(nullptr, boost::function<void ()>());
+            for (int n = 0; ((n < eventsBatched) && events_.pop(event)); n++) {
+                invokeCallback(event);
             }
+            callEventPosted = !events_.empty();
         }
         handlingEvents_ = false;
     }
@@ -75,28 +59,15 @@ void EventLoop::handleNextEvents() {
 
 void EventLoop::postEvent(boost::function<void ()> callback, std::shared_ptr<EventOwner> owner) {
     Event event(owner, callback);
-    bool callEventPosted = false;
-    {
-        std::unique_lock<std::recursive_mutex> lock(eventsMutex_);
-
-        callEventPosted = events_.empty();
-
-        event.id = nextEventID_;
-        nextEventID_++;
-        events_.push_back(event);
-    }
-    if (callEventPosted) {
+    event.id = nextEventID_++;
+    if (events_.push(std::move(event))) {
         eventPosted();
     }
 }
 
 void EventLoop::removeEventsFromOwner(std::shared_ptr<EventOwner> owner) {
-    std::unique_lock<std::recursive_mutex> removeLock(removeEventsMutex_, std::defer_lock);
-    std::unique_lock<std::recursive_mutex> eventsLock(eventsMutex_, std::defer_lock);
-
-    std::lock(removeLock, eventsLock);
-
-    events_.remove_if(lambda::bind(&Event::owner, lambda::_1) == owner);
+    std::unique_lock<std::recursive_mutex> removeLock(removeEventsMutex_);
+    events_.removeEventsFromOwner(owner);
 }
 
 }
@@ -1,18 +1,19 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <list>
+#include <atomic>
 #include <mutex>
 
 #include <boost/function.hpp>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/EventLoop/Event.h>
+#include <Swiften/EventLoop/EventQueue.h>
 
 namespace Swift {
     class EventOwner;
@@ -22,6 +23,9 @@ namespace Swift {
      *
      *  Events are added to the event queue using the \ref postEvent method and can be removed from the queue using
      *  the \ref removeEventsFromOwner method.
+     *
+     *  Posting an event is lock-free; events are queued in an \ref EventQueue and removed events are
+     *  tombstoned in place rather than unlinked from the queue.
      */
     class SWIFTEN_API EventLoop {
         public:
@@ -62,10 +66,9 @@ namespace Swift {
             virtual void eventPosted() = 0;
 
         private:
-            unsigned int nextEventID_;
-            std::list<Event> events_;
+            std::atomic<unsigned int> nextEventID_;
+            EventQueue events_;
             bool handlingEvents_;
-            std::recursive_mutex eventsMutex_;
             std::recursive_mutex removeEventsMutex_;
     };
 }
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/EventLoop/EventQueue.h>
+
+#include <cassert>
+#include <thread>
+
+namespace Swift {
+
+/*
+ * The queue is an intrusive MPSC linked list with a stub node (D. Vyukov).
+ * Producers only swap head_ and link the previous head to the new node, so
+ * pushing never blocks. The consumer owns tail_ and may observe a producer
+ * that has swapped head_ but not linked its node yet; pop() then reports no
+ * event and size_ stays non-zero, so the event loop simply retries.
+ */
+
+EventQueue::EventQueue() : head_(&stub_), tail_(&stub_), size_(0), nodePoolCursor_(0) {
+    for (auto& slot : nodePool_) {
+        slot.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+EventQueue::~EventQueue() {
+    while (Node* node = popNode()) {
+        delete node;
+    }
+    for (auto& slot : nodePool_) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+bool EventQueue::push(Event&& event) {
+    Node* node = acquireNode();
+    node->event = std::move(event);
+    // Count the event before publishing it, so the consumer never sees more events than size_.
+    bool wasEmpty = size_.fetch_add(1, std::memory_order_acq_rel) == 0;
+    pushNode(node);
+    return wasEmpty;
+}
+
+bool EventQueue::pop(Event& event) {
+    while (Node* node = popNode()) {
+        size_.fetch_sub(1, std::memory_order_acq_rel);
+        bool removed = node->event.callback.empty();
+        if (!removed) {
+            event.id = node->event.id;
+            event.owner = std::move(node->event.owner);
+            event.callback.swap(node->event.callback);
+            node->event.callback.clear();
+        }
+        releaseNode(node);
+        if (!removed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EventQueue::removeEventsFromOwner(const std::shared_ptr<EventOwner>& owner) {
+    // Only the consumer advances tail_ and recycles nodes, so walking the list is safe here.
+    // Every node pushed before this call is reached: up to the head at the start of the
+    // walk, a node without a successor belongs to a producer that has not linked the
+    // next node yet, which it is about to do. Nodes pushed concurrently with this call
+    // may or may not be reached.
+    Node* last = head_.load(std::memory_order_acquire);
+    Node* node = tail_;
+    while (true) {
+        if (node != &stub_ && node->event.owner == owner) {
+            node->event.owner.reset();
+            node->event.callback.clear();
+        }
+        if (node == last) {
+            break;
+        }
+        Node* next = node->next.load(std::memory_order_acquire);
+        while (!next) {
+            std::this_thread::yield();
+            next = node->next.load(std::memory_order_acquire);
+        }
+        node = next;
+    }
+}
+
+void EventQueue::pushNode(Node* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+EventQueue::Node* EventQueue::popNode() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+        if (!next) {
+            return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+        // A producer is in the middle of pushing.
+        return nullptr;
+    }
+    pushNode(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+EventQueue::Node* EventQueue::acquireNode() {
+    size_t start = nodePoolCursor_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < nodePoolProbes; ++i) {
+        std::atomic<Node*>& slot = nodePool_[(start + i) % nodePoolSize];
+        if (slot.load(std::memory_order_relaxed)) {
+            if (Node* node = slot.exchange(nullptr, std::memory_order_acquire)) {
+                nodePoolCursor_.store(start + i, std::memory_order_relaxed);
+                return node;
+            }
+        }
+    }
+    return new Node();
+}
+
+void EventQueue::releaseNode(Node* node) {
+    assert(node != &stub_);
+    assert(!node->event.owner && node->event.callback.empty());
+    size_t start = nodePoolCursor_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < nodePoolProbes; ++i) {
+        std::atomic<Node*>& slot = nodePool_[(start + i) % nodePoolSize];
+        Node* expected = nullptr;
+        if (!slot.load(std::memory_order_relaxed) && slot.compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed)) {
+            nodePoolCursor_.store(start + i, std::memory_order_relaxed);
+            return;
+        }
+    }
+    delete node;
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/EventLoop/Event.h>
+
+namespace Swift {
+    class EventOwner;
+
+    /**
+     *  The \ref EventQueue class is the lock-free multi-producer/single-consumer queue backing \ref EventLoop.
+     *
+     *  Any thread can \ref push events concurrently. The \ref pop and \ref removeEventsFromOwner methods
+     *  must not be called concurrently with each other; \ref EventLoop serializes them with a mutex.
+     *  Queue nodes are recycled through a small lock-free pool, so posting an event does not
+     *  allocate once the queue has warmed up.
+     */
+    class SWIFTEN_API EventQueue {
+        public:
+            EventQueue();
+            ~EventQueue();
+
+            EventQueue(const EventQueue&) = delete;
+            EventQueue& operator=(const EventQueue&) = delete;
+
+            /**
+             * Appends \p event to the queue.
+             * Returns true if the queue was empty before this call.
+             */
+            bool push(Event&& event);
+
+            /**
+             * Moves the oldest event that has not been removed into \p event.
+             * Returns false if no such event is (yet) available.
+             */
+            bool pop(Event& event);
+
+            /**
+             * Marks all queued events of \p owner as removed, releasing their callbacks
+             * and owner references. The nodes themselves are recycled by \ref pop.
+             */
+            void removeEventsFromOwner(const std::shared_ptr<EventOwner>& owner);
+
+            bool empty() const {
+                return size_.load(std::memory_order_acquire) == 0;
+            }
+
+        private:
+            struct Node {
+                Node() : next(nullptr), event(std::shared_ptr<EventOwner>(), boost::function<void()>()) {
+                }
+
+                std::atomic<Node*> next;
+                Event event;
+            };
+
+            void pushNode(Node* node);
+            Node* popNode();
+            Node* acquireNode();
+            void releaseNode(Node* node);
+
+        private:
+            static const size_t nodePoolSize = 128;
+            static const size_t nodePoolProbes = 16;
+
+            std::atomic<Node*> head_;
+            Node* tail_;
+            Node stub_;
+            std::atomic<size_t> size_;
+            std::array<std::atomic<Node*>, nodePoolSize> nodePool_;
+            std::atomic<size_t> nodePoolCursor_;
+    };
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -22,7 +22,9 @@ class EventLoopTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(EventLoopTest);
         CPPUNIT_TEST(testPost);
         CPPUNIT_TEST(testRemove);
+        CPPUNIT_TEST(testRemove_FromEarlierEventInBatch);
         CPPUNIT_TEST(testHandleEvent_Recursive);
+        CPPUNIT_TEST(testPost_MultipleProducers);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -61,6 +63,22 @@ class EventLoopTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(3, events_[1]);
         }
 
+        void testRemove_FromEarlierEventInBatch() {
+            DummyEventLoop testling;
+            std::shared_ptr<MyEventOwner> eventOwner1(new MyEventOwner());
+            std::shared_ptr<MyEventOwner> eventOwner2(new MyEventOwner());
+
+            testling.postEvent(boost::bind(&EventLoopTest::removeEvents, this, &testling, eventOwner2), eventOwner1);
+            testling.postEvent(boost::bind(&EventLoopTest::logEvent, this, 1), eventOwner2);
+            testling.postEvent(boost::bind(&EventLoopTest::logEvent, this, 2), eventOwner1);
+            testling.processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(events_.size()));
+            CPPUNIT_ASSERT_EQUAL(0, events_[0]);
+            CPPUNIT_ASSERT_EQUAL(2, events_[1]);
+            CPPUNIT_ASSERT_EQUAL(1L, eventOwner2.use_count());
+        }
+
         void testHandleEvent_Recursive() {
             DummyEventLoop testling;
             std::shared_ptr<MyEventOwner> eventOwner(new MyEventOwner());
@@ -74,11 +92,37 @@ class EventLoopTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(1, events_[1]);
         }
 
+        void testPost_MultipleProducers() {
+            DummyEventLoop testling;
+            const int producerCount = 4;
+            const int eventsPerProducer = 1000;
+            int handledEvents = 0;
+
+            std::vector<std::thread> producers;
+            for (int i = 0; i < producerCount; ++i) {
+                producers.push_back(std::thread([&]() {
+                    for (int j = 0; j < eventsPerProducer; ++j) {
+                        testling.postEvent([&]() { handledEvents++; });
+                    }
+                }));
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            testling.processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(producerCount * eventsPerProducer, handledEvents);
+        }
+
     private:
         struct MyEventOwner : public EventOwner {};
         void logEvent(int i) {
             events_.push_back(i);
         }
+        void removeEvents(DummyEventLoop* loop, std::shared_ptr<MyEventOwner> eventOwner) {
+            logEvent(0);
+            loop->removeEventsFromOwner(eventOwner);
+        }
         void runEventLoop(DummyEventLoop* loop, std::shared_ptr<MyEventOwner> eventOwner) {
             loop->processEvents();
             CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(events_.size()));
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -32,6 +32,9 @@
 
 using namespace Swift;
 
+// The number of IBB data blocks that are sent before their acknowledgements arrive
+static const unsigned int IBB_WINDOW_SIZE = 8;
+
 DefaultFileTransferTransporter::DefaultFileTransferTransporter(
         const JID& initiator,
         const JID& responder,
@@ -51,6 +54,7 @@ DefaultFileTransferTransporter::DefaultFileTransferTransporter(
             s5bRegistry(s5bRegistry),
             s5bServerManager(s5bServerManager),
             s5bProxy(s5bProxy),
+            timerFactory(timerFactory),
             crypto(crypto),
             router(router) {
 
@@ -155,8 +159,9 @@ std::shared_ptr<TransportSession> DefaultFileTransferTransporter::createIBBSendS
     }
     closeRemoteSession();
     std::shared_ptr<IBBSendSession> ibbSession = std::make_shared<IBBSendSession>(
-            sessionID, initiator, responder, stream, router);
+            sessionID, initiator, responder, stream, router, timerFactory);
     ibbSession->setBlockSize(blockSize);
+    ibbSession->setWindowSize(IBB_WINDOW_SIZE);
     return std::make_shared<IBBSendTransportSession>(ibbSession);
 }
 
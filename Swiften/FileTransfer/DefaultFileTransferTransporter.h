@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -101,6 +101,7 @@ namespace Swift {
             SOCKS5BytestreamRegistry* s5bRegistry;
             SOCKS5BytestreamServerManager* s5bServerManager;
             SOCKS5BytestreamProxiesManager* s5bProxy;
+            TimerFactory* timerFactory;
             CryptoProvider* crypto;
             IQRouter* router;
             LocalJingleTransportCandidateGenerator* localCandidateGenerator;
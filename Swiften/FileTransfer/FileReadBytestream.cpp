@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,8 @@
 
 #include <cassert>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <boost/filesystem/fstream.hpp>
 #include <boost/numeric/conversion/cast.hpp>
@@ -16,7 +18,45 @@
 
 namespace Swift {
 
-FileReadBytestream::FileReadBytestream(const boost::filesystem::path& file) : file(file), stream(nullptr) {
+class FileReadBytestream::FreeBuffers {
+    public:
+        static const size_t maximumFreeBuffers = 8;
+
+        ~FreeBuffers() {
+            for (auto buffer : buffers_) {
+                delete buffer;
+            }
+        }
+
+        ByteArray* take() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (buffers_.empty()) {
+                return nullptr;
+            }
+            ByteArray* buffer = buffers_.back();
+            buffers_.pop_back();
+            return buffer;
+        }
+
+        // Called from the thread that releases the last reference to a chunk,
+        // which is not necessarily the thread reading the file.
+        void give(ByteArray* buffer) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (buffers_.size() < maximumFreeBuffers) {
+                    buffers_.push_back(buffer);
+                    return;
+                }
+            }
+            delete buffer;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<ByteArray*> buffers_;
+};
+
+FileReadBytestream::FileReadBytestream(const boost::filesystem::path& file) : file(file), stream(nullptr), freeBuffers(std::make_shared<FreeBuffers>()) {
 }
 
 FileReadBytestream::~FileReadBytestream() {
@@ -31,7 +71,16 @@ std::shared_ptr<ByteArray> FileReadBytestream::read(size_t size)  {
     if (!stream) {
         stream = new boost::filesystem::ifstream(file, std::ios_base::in|std::ios_base::binary);
     }
-    std::shared_ptr<ByteArray> result = std::make_shared<ByteArray>();
+    ByteArray* buffer = freeBuffers->take();
+    if (!buffer) {
+        buffer = new ByteArray();
+    }
+    // Chunks that are still referenced when the stream goes away keep the free list alive.
+    std::shared_ptr<FreeBuffers> freeBuffers = this->freeBuffers;
+    std::shared_ptr<ByteArray> result(buffer, [freeBuffers](ByteArray* buffer) {
+        freeBuffers->give(buffer);
+    });
+    // Recycled buffers keep their size, so only the part that grows is initialized
     result->resize(size);
     assert(stream->good());
     stream->read(reinterpret_cast<char*>(vecptr(*result)), boost::numeric_cast<std::streamsize>(size));
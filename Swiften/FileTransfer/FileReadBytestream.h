@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <memory>
+
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/path.hpp>
 
@@ -13,6 +15,13 @@
 #include <Swiften/FileTransfer/ReadBytestream.h>
 
 namespace Swift {
+    /**
+     * Reads a file in chunks.
+     *
+     * The buffers of the chunks are recycled: when the last reference to a
+     * chunk is released (e.g. after a connection wrote it), its buffer is
+     * used for a later chunk instead of being freed.
+     */
     class SWIFTEN_API FileReadBytestream : public ReadBytestream {
         public:
             FileReadBytestream(const boost::filesystem::path& file);
@@ -22,7 +31,10 @@ namespace Swift {
             virtual bool isFinished() const;
 
         private:
+            class FreeBuffers;
+
             boost::filesystem::path file;
             boost::filesystem::ifstream* stream;
+            std::shared_ptr<FreeBuffers> freeBuffers;
     };
 }
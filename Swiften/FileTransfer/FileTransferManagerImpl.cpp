@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -51,7 +51,8 @@ FileTransferManagerImpl::FileTransferManagerImpl(
         DomainNameResolver* domainNameResolver,
         NetworkEnvironment* networkEnvironment,
         NATTraverser* natTraverser,
-        CryptoProvider* crypto) :
+        CryptoProvider* crypto,
+        EventLoop* eventLoop) :
             iqRouter(router),
             capsProvider(capsProvider),
             presenceOracle(presOracle) {
@@ -74,12 +75,14 @@ FileTransferManagerImpl::FileTransferManagerImpl(
             iqRouter,
             transporterFactory,
             timerFactory,
-            crypto);
+            crypto,
+            eventLoop);
     incomingFTManager = new IncomingFileTransferManager(
             jingleSessionManager,
             transporterFactory,
             timerFactory,
-            crypto);
+            crypto,
+            eventLoop);
     incomingFTManager->onIncomingFileTransfer.connect(onIncomingFileTransfer);
 }
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -35,6 +35,7 @@ namespace Swift {
     class CryptoProvider;
     class DomainNameResolver;
     class EntityCapsProvider;
+    class EventLoop;
     class FileTransferTransporterFactory;
     class IQRouter;
     class IncomingFileTransferManager;
@@ -64,7 +65,8 @@ namespace Swift {
                     DomainNameResolver* domainNameResolver,
                     NetworkEnvironment* networkEnvironment,
                     NATTraverser* natTraverser,
-                    CryptoProvider* crypto);
+                    CryptoProvider* crypto,
+                    EventLoop* eventLoop);
             virtual ~FileTransferManagerImpl();
 
             OutgoingFileTransfer::ref createOutgoingFileTransfer(
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,9 +7,11 @@
 #include <Swiften/FileTransfer/IBBReceiveSession.h>
 
 #include <cassert>
+#include <map>
 
 #include <boost/bind.hpp>
 
+#include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/Log.h>
 #include <Swiften/FileTransfer/BytestreamException.h>
 #include <Swiften/FileTransfer/IBBRequest.h>
@@ -18,6 +20,11 @@
 
 namespace Swift {
 
+namespace {
+    // How far ahead of the expected block data may arrive (see handleSetRequest)
+    const int maxBlocksAhead = 16;
+}
+
 class IBBReceiveSession::IBBResponder : public SetResponder<IBB> {
     public:
         IBBResponder(IBBReceiveSession* session, IQRouter* router) : SetResponder<IBB>(router), session(session), sequenceNumber(0), receivedSize(0) {
@@ -27,10 +34,17 @@ class IBBReceiveSession::IBBResponder : public SetResponder<IBB> {
         virtual bool handleSetRequest(const JID& from, const JID&, const std::string& id, IBB::ref ibb) {
             if (from == session->from && ibb->getStreamID() == session->id) {
                 if (ibb->getAction() == IBB::Data) {
-                    if (sequenceNumber == ibb->getSequenceNumber()) {
-                        session->bytestream->write(ibb->getData());
-                        receivedSize += ibb->getData().size();
-                        sequenceNumber++;
+                    // A sender with several blocks in flight sends a block again if it bounced
+                    // with a temporary error, so the blocks after it may arrive first. These are
+                    // kept until the missing block arrives.
+                    int blocksAhead = (ibb->getSequenceNumber() - sequenceNumber + 65536) % 65536;
+                    bool validSequenceNumber = ibb->getSequenceNumber() >= 0 && ibb->getSequenceNumber() < 65536;
+                    if (validSequenceNumber && blocksAhead == 0) {
+                        writeData(ibb->getData());
+                        for (auto i = laterBlocks.find(sequenceNumber); i != laterBlocks.end(); i = laterBlocks.find(sequenceNumber)) {
+                            writeData(i->second);
+                            laterBlocks.erase(i);
+                        }
                         sendResponse(from, id, IBB::ref());
                         if (receivedSize >= session->size) {
                             if (receivedSize > session->size) {
@@ -39,6 +53,11 @@ class IBBReceiveSession::IBBResponder : public SetResponder<IBB> {
                             session->finish(boost::optional<FileTransferError>());
                         }
                     }
+                    else if (validSequenceNumber && blocksAhead <= maxBlocksAhead && laterBlocks.count(ibb->getSequenceNumber()) == 0) {
+                        SWIFT_LOG(debug) << "Received data " << blocksAhead << " blocks ahead";
+                        laterBlocks[ibb->getSequenceNumber()] = ibb->getData();
+                        sendResponse(from, id, IBB::ref());
+                    }
                     else {
                         SWIFT_LOG(warning) << "Received data out of order";
                         sendError(from, id, ErrorPayload::NotAcceptable, ErrorPayload::Cancel);
@@ -60,10 +79,19 @@ class IBBReceiveSession::IBBResponder : public SetResponder<IBB> {
             return false;
         }
 
+    private:
+        void writeData(const ByteArray& data) {
+            session->bytestream->write(data);
+            receivedSize += data.size();
+            // Sequence numbers wrap around after 65535 (XEP-0047)
+            sequenceNumber = (sequenceNumber + 1) % 65536;
+        }
+
     private:
         IBBReceiveSession* session;
         int sequenceNumber;
         unsigned long long receivedSize;
+        std::map<int, ByteArray> laterBlocks;
 };
 
 
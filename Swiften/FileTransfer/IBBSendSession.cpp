@@ -1,47 +1,67 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/FileTransfer/IBBSendSession.h>
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/FileTransfer/BytestreamException.h>
 #include <Swiften/FileTransfer/IBBRequest.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimerFactory.h>
 #include <Swiften/Queries/IQRouter.h>
 
 namespace Swift {
 
+namespace {
+    const int maxRetries = 3;
+    const unsigned int minimumBlockSize = 1024;
+    // Doubled for every retry of the same block
+    const int resendDelayMilliseconds = 500;
+}
+
 IBBSendSession::IBBSendSession(
         const std::string& id,
         const JID& from,
         const JID& to,
         std::shared_ptr<ReadBytestream> bytestream,
-        IQRouter* router) :
+        IQRouter* router,
+        TimerFactory* timerFactory) :
             id(id),
             from(from),
             to(to),
             bytestream(bytestream),
             router(router),
+            timerFactory(timerFactory),
             blockSize(4096),
+            maxWindowSize(1),
+            windowSize(1),
             sequenceNumber(0),
+            blockCount(0),
             active(false),
             waitingForData(false) {
     bytestream->onDataAvailable.connect(boost::bind(&IBBSendSession::handleDataAvailable, this));
 }
 
 IBBSendSession::~IBBSendSession() {
+    stopResendTimer();
     bytestream->onDataAvailable.disconnect(boost::bind(&IBBSendSession::handleDataAvailable, this));
+    for (auto& block : sentBlocks) {
+        block.responseConnection.disconnect();
+    }
 }
 
 void IBBSendSession::start() {
     IBBRequest::ref request = IBBRequest::create(
             from, to, IBB::createIBBOpen(id, boost::numeric_cast<int>(blockSize)), router);
-    request->onResponse.connect(boost::bind(&IBBSendSession::handleIBBResponse, this, _1, _2));
+    request->onResponse.connect(boost::bind(&IBBSendSession::handleOpenResponse, this, _1, _2));
     active = true;
     request->send();
     currentRequest = request;
@@ -52,21 +72,57 @@ void IBBSendSession::stop() {
         IBBRequest::create(from, to, IBB::createIBBClose(id), router)->send();
     }
     if (currentRequest) {
-        currentRequest->onResponse.disconnect(boost::bind(&IBBSendSession::handleIBBResponse, this, _1, _2));
+        currentRequest->onResponse.disconnect(boost::bind(&IBBSendSession::handleOpenResponse, this, _1, _2));
+    }
+    for (auto& block : sentBlocks) {
+        block.responseConnection.disconnect();
     }
     finish(boost::optional<FileTransferError>());
 }
 
-void IBBSendSession::handleIBBResponse(IBB::ref, ErrorPayload::ref error) {
+void IBBSendSession::handleOpenResponse(IBB::ref, ErrorPayload::ref error) {
     currentRequest.reset();
 
     if (!error && active) {
-        if (!bytestream->isFinished()) {
-            sendMoreData();
+        sendMoreData();
+    }
+    else {
+        finish(FileTransferError(FileTransferError::PeerError));
+    }
+}
+
+void IBBSendSession::handleDataResponse(unsigned long long index, IBB::ref, ErrorPayload::ref error) {
+    auto i = std::find_if(sentBlocks.begin(), sentBlocks.end(), [&](const Block& block) { return block.index == index; });
+    if (i == sentBlocks.end()) {
+        return;
+    }
+    Block block = *i;
+    sentBlocks.erase(i);
+    if (!active) {
+        return;
+    }
+
+    if (!error) {
+        if (windowSize < maxWindowSize) {
+            windowSize++;
         }
-        else {
-            finish(boost::optional<FileTransferError>());
+        sendMoreData();
+    }
+    else if (error->getType() == ErrorPayload::Wait && block.retries < maxRetries) {
+        // The block did not reach the receiver; send it (and any later blocks that bounce) again in order,
+        // once the blocks in flight are answered and the receiver had time to recover
+        block.retries++;
+        block.request.reset();
+        auto position = std::find_if(blocksToResend.begin(), blocksToResend.end(), [&](const Block& other) { return other.index > block.index; });
+        blocksToResend.insert(position, block);
+        windowSize = 1;
+        blockSize = std::max(blockSize / 2, std::min(blockSize, minimumBlockSize));
+        if (timerFactory && !resendTimer) {
+            resendTimer = timerFactory->createTimer(resendDelayMilliseconds << (block.retries - 1));
+            resendTimer->onTick.connect(boost::bind(&IBBSendSession::handleResendTimerTick, this));
+            resendTimer->start();
         }
+        sendMoreData();
     }
     else {
         finish(FileTransferError(FileTransferError::PeerError));
@@ -75,26 +131,64 @@ void IBBSendSession::handleIBBResponse(IBB::ref, ErrorPayload::ref error) {
 
 void IBBSendSession::sendMoreData() {
     try {
-        std::shared_ptr<ByteArray> data = bytestream->read(blockSize);
-        if (!data->empty()) {
+        while (active && !resendTimer && sentBlocks.size() < windowSize) {
+            if (!blocksToResend.empty()) {
+                Block block = blocksToResend.front();
+                blocksToResend.pop_front();
+                sendBlock(block);
+                continue;
+            }
+            if (bytestream->isFinished()) {
+                break;
+            }
+            std::shared_ptr<ByteArray> data = bytestream->read(blockSize);
+            if (data->empty()) {
+                waitingForData = true;
+                break;
+            }
             waitingForData = false;
-            IBBRequest::ref request = IBBRequest::create(from, to, IBB::createIBBData(id, sequenceNumber, *data), router);
-            sequenceNumber++;
-            request->onResponse.connect(boost::bind(&IBBSendSession::handleIBBResponse, this, _1, _2));
-            request->send();
-            currentRequest = request;
+            Block block;
+            block.index = blockCount++;
+            block.sequenceNumber = sequenceNumber;
+            block.data = data;
+            block.retries = 0;
+            // Sequence numbers wrap around after 65535 (XEP-0047)
+            sequenceNumber = (sequenceNumber + 1) % 65536;
+            sendBlock(block);
             onBytesSent(data->size());
         }
-        else {
-            waitingForData = true;
-        }
     }
     catch (const BytestreamException&) {
         finish(FileTransferError(FileTransferError::ReadError));
+        return;
+    }
+    if (active && sentBlocks.empty() && blocksToResend.empty() && bytestream->isFinished()) {
+        finish(boost::optional<FileTransferError>());
+    }
+}
+
+void IBBSendSession::sendBlock(Block block) {
+    block.request = IBBRequest::create(from, to, IBB::createIBBData(id, block.sequenceNumber, *block.data), router);
+    block.responseConnection = block.request->onResponse.connect(boost::bind(&IBBSendSession::handleDataResponse, this, block.index, _1, _2));
+    sentBlocks.push_back(block);
+    block.request->send();
+}
+
+void IBBSendSession::handleResendTimerTick() {
+    stopResendTimer();
+    sendMoreData();
+}
+
+void IBBSendSession::stopResendTimer() {
+    if (resendTimer) {
+        resendTimer->stop();
+        resendTimer->onTick.disconnect(boost::bind(&IBBSendSession::handleResendTimerTick, this));
+        resendTimer.reset();
     }
 }
 
 void IBBSendSession::finish(boost::optional<FileTransferError> error) {
+    stopResendTimer();
     active = false;
     onFinished(error);
 }
@@ -1,17 +1,20 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <algorithm>
+#include <deque>
 #include <memory>
 
 #include <boost/optional.hpp>
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/ByteArray.h>
 #include <Swiften/Elements/ErrorPayload.h>
 #include <Swiften/Elements/IBB.h>
 #include <Swiften/FileTransfer/FileTransferError.h>
@@ -21,7 +24,26 @@
 namespace Swift {
     class IQRouter;
     class IBBRequest;
+    class Timer;
+    class TimerFactory;
 
+    /**
+     * Sends a bytestream in-band (XEP-0047).
+     *
+     * Up to the window size of data blocks are sent before their
+     * acknowledgements arrive. The window starts at one block, and grows by
+     * one block for every acknowledged block. If a block bounces with a
+     * temporary (wait) error, e.g. because a server limits the rate of
+     * stanzas, the window falls back to one block, and the block size is
+     * halved. No new blocks are sent until the blocks in flight are answered,
+     * and the bounced blocks are sent again in order after a delay (if a
+     * timer factory is set).
+     *
+     * The blocks sent after a bounced block may reach the receiver before the
+     * bounced block is sent again, so windows of more than one block need a
+     * receiver that accepts blocks ahead of the expected one (like
+     * \ref IBBReceiveSession).
+     */
     class SWIFTEN_API IBBSendSession {
         public:
             IBBSendSession(
@@ -29,7 +51,8 @@ namespace Swift {
                     const JID& from,
                     const JID& to,
                     std::shared_ptr<ReadBytestream> bytestream,
-                    IQRouter* router);
+                    IQRouter* router,
+                    TimerFactory* timerFactory = nullptr);
             ~IBBSendSession();
 
             void start();
@@ -47,14 +70,35 @@ namespace Swift {
                 this->blockSize = blockSize;
             }
 
+            /**
+             * Sets the maximum number of unacknowledged data blocks.
+             * Defaults to 1.
+             */
+            void setWindowSize(unsigned int windowSize) {
+                maxWindowSize = std::max(windowSize, 1U);
+            }
+
             boost::signals2::signal<void (boost::optional<FileTransferError>)> onFinished;
             boost::signals2::signal<void (size_t)> onBytesSent;
 
         private:
-            void handleIBBResponse(IBB::ref, ErrorPayload::ref);
+            struct Block {
+                unsigned long long index;
+                int sequenceNumber;
+                std::shared_ptr<ByteArray> data;
+                int retries;
+                std::shared_ptr<IBBRequest> request;
+                boost::signals2::connection responseConnection;
+            };
+
+            void handleOpenResponse(IBB::ref, ErrorPayload::ref);
+            void handleDataResponse(unsigned long long index, IBB::ref, ErrorPayload::ref);
             void finish(boost::optional<FileTransferError>);
             void sendMoreData();
+            void sendBlock(Block block);
             void handleDataAvailable();
+            void handleResendTimerTick();
+            void stopResendTimer();
 
         private:
             std::string id;
@@ -62,10 +106,17 @@ namespace Swift {
             JID to;
             std::shared_ptr<ReadBytestream> bytestream;
             IQRouter* router;
+            TimerFactory* timerFactory;
+            std::shared_ptr<Timer> resendTimer;
             unsigned int blockSize;
+            unsigned int maxWindowSize;
+            unsigned int windowSize;
             int sequenceNumber;
+            unsigned long long blockCount;
             bool active;
             bool waitingForData;
             std::shared_ptr<IBBRequest> currentRequest;
+            std::deque<Block> sentBlocks;
+            std::deque<Block> blocksToResend;
     };
 }
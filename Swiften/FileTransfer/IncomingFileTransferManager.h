@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,6 +19,7 @@ namespace Swift {
     class FileTransferTransporterFactory;
     class TimerFactory;
     class CryptoProvider;
+    class EventLoop;
 
     class SWIFTEN_API IncomingFileTransferManager : public IncomingJingleSessionHandler {
         public:
@@ -26,7 +27,8 @@ namespace Swift {
                     JingleSessionManager* jingleSessionManager,
                     FileTransferTransporterFactory* transporterFactory,
                     TimerFactory* timerFactory,
-                    CryptoProvider* crypto);
+                    CryptoProvider* crypto,
+                    EventLoop* eventLoop);
             virtual ~IncomingFileTransferManager();
 
             boost::signals2::signal<void (IncomingFileTransfer::ref)> onIncomingFileTransfer;
@@ -42,5 +44,6 @@ namespace Swift {
             FileTransferTransporterFactory* transporterFactory;
             TimerFactory* timerFactory;
             CryptoProvider* crypto;
+            EventLoop* eventLoop;
     };
 }
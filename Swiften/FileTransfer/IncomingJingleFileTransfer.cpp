@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -37,10 +37,12 @@ IncomingJingleFileTransfer::IncomingJingleFileTransfer(
         JingleContentPayload::ref content,
         FileTransferTransporterFactory* transporterFactory,
         TimerFactory* timerFactory,
-        CryptoProvider* crypto) :
+        CryptoProvider* crypto,
+        EventLoop* eventLoop) :
             JingleFileTransfer(session, toJID, transporterFactory),
             initialContent(content),
             crypto(crypto),
+            eventLoop(eventLoop),
             state(Initial),
             receivedBytes(0),
             hashCalculator(nullptr) {
@@ -77,7 +79,9 @@ void IncomingJingleFileTransfer::accept(
     assert(!hashCalculator);
 
     hashCalculator = new IncrementalBytestreamHashCalculator(
-            hashes.find("md5") != hashes.end(), hashes.find("sha-1") != hashes.end(), crypto);
+            hashes.find("md5") != hashes.end(), hashes.find("sha-1") != hashes.end(), crypto, eventLoop);
+    hashCalculator->onHashesCalculated.connect(
+            boost::bind(&IncomingJingleFileTransfer::handleHashesCalculated, this));
 
     writeStreamDataReceivedConnection = stream->onWrite.connect(
             boost::bind(&IncomingJingleFileTransfer::handleWriteStreamDataReceived, this, _1));
@@ -152,7 +156,7 @@ void IncomingJingleFileTransfer::handleSessionInfoReceived(JinglePayload::ref ji
         if (transferHash->getFileInfo().getHashes().find("md5") != transferHash->getFileInfo().getHashes().end()) {
             hashes["md5"] = transferHash->getFileInfo().getHash("md5").get();
         }
-        if (state == WaitingForHash) {
+        if (state == WaitingForHash && hashCalculator->hasHashes()) {
             checkHashAndTerminate();
         }
     }
@@ -195,19 +199,13 @@ void IncomingJingleFileTransfer::checkHashAndTerminate() {
 void IncomingJingleFileTransfer::checkIfAllDataReceived() {
     if (receivedBytes == getFileSizeInBytes()) {
         SWIFT_LOG(debug) << "All data received." << std::endl;
-        bool hashInfoAvailable = false;
-        for (const auto& hashElement : hashes) {
-            hashInfoAvailable |= !hashElement.second.empty();
-        }
-
-        if (!hashInfoAvailable) {
+        // The hash is checked once the hashing thread caught up with the transfer
+        setState(WaitingForHash);
+        hashCalculator->calculateHashes();
+        if (!hasHashInfo()) {
             SWIFT_LOG(debug) << "No hash information yet. Waiting a while on hash info." << std::endl;
-            setState(WaitingForHash);
             waitOnHashTimer->start();
         }
-        else {
-            checkHashAndTerminate();
-        }
     }
     else if (receivedBytes > getFileSizeInBytes()) {
         SWIFT_LOG(debug) << "We got more than we could handle!" << std::endl;
@@ -247,6 +245,21 @@ void IncomingJingleFileTransfer::handleTransportReplaceReceived(
     }
 }
 
+void IncomingJingleFileTransfer::handleHashesCalculated() {
+    SWIFT_LOG(debug) << std::endl;
+    if (state == WaitingForHash && hasHashInfo()) {
+        checkHashAndTerminate();
+    }
+}
+
+bool IncomingJingleFileTransfer::hasHashInfo() const {
+    bool hashInfoAvailable = false;
+    for (const auto& hashElement : hashes) {
+        hashInfoAvailable |= !hashElement.second.empty();
+    }
+    return hashInfoAvailable;
+}
+
 JingleContentID IncomingJingleFileTransfer::getContentID() const {
     return JingleContentID(initialContent->getName(), initialContent->getCreator());
 }
@@ -322,9 +335,8 @@ FileTransfer::State::Type IncomingJingleFileTransfer::getExternalState(State sta
 
 void IncomingJingleFileTransfer::stopAll() {
     if (state != Initial) {
+        // The hash calculator is kept until destruction, as this can be called while it emits its result
         writeStreamDataReceivedConnection.disconnect();
-        delete hashCalculator;
-        hashCalculator = nullptr;
     }
     switch (state) {
         case Initial: break;
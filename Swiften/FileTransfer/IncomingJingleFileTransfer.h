@@ -22,6 +22,7 @@
 
 namespace Swift {
     class CryptoProvider;
+    class EventLoop;
     class FileTransferTransporterFactory;
     class IncrementalBytestreamHashCalculator;
     class JID;
@@ -48,7 +49,8 @@ namespace Swift {
                 std::shared_ptr<JingleContentPayload> content,
                 FileTransferTransporterFactory*,
                 TimerFactory*,
-                CryptoProvider*);
+                CryptoProvider*,
+                EventLoop*);
             virtual ~IncomingJingleFileTransfer();
 
             virtual void accept(std::shared_ptr<WriteBytestream>, const FileTransferOptions& = FileTransferOptions()) SWIFTEN_OVERRIDE;
@@ -84,6 +86,8 @@ namespace Swift {
             virtual JingleContentID getContentID() const SWIFTEN_OVERRIDE;
             void checkIfAllDataReceived();
             bool verifyData();
+            void handleHashesCalculated();
+            bool hasHashInfo() const;
             void handleWaitOnHashTimerTicked();
             void handleTransferFinished(boost::optional<FileTransferError>);
 
@@ -111,6 +115,7 @@ namespace Swift {
         private:
             std::shared_ptr<JingleContentPayload> initialContent;
             CryptoProvider* crypto;
+            EventLoop* eventLoop;
             State state;
             std::shared_ptr<JingleFileTransferDescription> description;
             std::shared_ptr<WriteBytestream> stream;
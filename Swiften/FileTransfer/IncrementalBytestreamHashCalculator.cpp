@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,63 +13,170 @@
 
 #include <Swiften/FileTransfer/IncrementalBytestreamHashCalculator.h>
 
+#include <algorithm>
+#include <cassert>
+
+#include <boost/bind.hpp>
+
 #include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/EventLoop/EventLoop.h>
+#include <Swiften/EventLoop/EventOwner.h>
 #include <Swiften/StringCodecs/Hexify.h>
 
 namespace Swift {
 
-IncrementalBytestreamHashCalculator::IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto) {
+const size_t IncrementalBytestreamHashCalculator::blockSize;
+const size_t IncrementalBytestreamHashCalculator::maximumQueuedBytes;
+
+// Blocks are recycled, so that feeding data does not allocate
+static const size_t maximumFreeBlocks = IncrementalBytestreamHashCalculator::maximumQueuedBytes / IncrementalBytestreamHashCalculator::blockSize;
+
+IncrementalBytestreamHashCalculator::IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto, EventLoop* eventLoop) : eventLoop(eventLoop), eventOwner(std::make_shared<EventOwner>()), dataComplete(false), hashesCalculated(false), thread(nullptr), queuedBytes(0), stopRequested(false) {
     md5Hasher = doMD5 ? crypto->createMD5() : nullptr;
     sha1Hasher = doSHA1 ? crypto->createSHA1() : nullptr;
 }
 
 IncrementalBytestreamHashCalculator::~IncrementalBytestreamHashCalculator() {
+    if (thread) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopRequested = true;
+        }
+        queueNonEmpty.notify_one();
+        thread->join();
+        delete thread;
+        // The worker is gone, so it cannot post any more events
+        eventLoop->removeEventsFromOwner(eventOwner);
+    }
+
     delete md5Hasher;
     delete sha1Hasher;
 }
 
 void IncrementalBytestreamHashCalculator::feedData(const ByteArray& data) {
-    if (md5Hasher) {
-        md5Hasher->update(data);
+    feedData(vecptr(data), data.size());
+}
+
+void IncrementalBytestreamHashCalculator::feedData(const SafeByteArray& data) {
+    feedData(vecptr(data), data.size());
+}
+
+void IncrementalBytestreamHashCalculator::feedData(const unsigned char* data, size_t size) {
+    assert(!dataComplete);
+    if (size > 0) {
+        startWorker();
     }
-    if (sha1Hasher) {
-        sha1Hasher->update(data);
+    while (size > 0) {
+        size_t length = std::min(size, blockSize);
+        std::shared_ptr<ByteArray> block;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            // Wait for the worker to catch up, unless the queue is empty (i.e. it already did)
+            queueNotFull.wait(lock, [&]() { return queue.empty() || queuedBytes + length <= maximumQueuedBytes; });
+            if (freeBlocks.empty()) {
+                block = std::make_shared<ByteArray>();
+            }
+            else {
+                block = freeBlocks.back();
+                freeBlocks.pop_back();
+            }
+        }
+        block->assign(data, data + length);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(block);
+            queuedBytes += length;
+        }
+        queueNonEmpty.notify_one();
+        data += length;
+        size -= length;
     }
 }
-/*
-void IncrementalBytestreamHashCalculator::feedData(const SafeByteArray& data) {
-    if (md5Hasher) {
-        md5Hasher->update(createByteArray(data.data(), data.size()));
+
+void IncrementalBytestreamHashCalculator::calculateHashes() {
+    assert(!dataComplete);
+    dataComplete = true;
+    startWorker();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::shared_ptr<ByteArray>());
     }
-    if (sha1Hasher) {
-        sha1Hasher->update(createByteArray(data.data(), data.size()));
+    queueNonEmpty.notify_one();
+}
+
+void IncrementalBytestreamHashCalculator::startWorker() {
+    if (!thread) {
+        thread = new std::thread(boost::bind(&IncrementalBytestreamHashCalculator::run, this));
     }
-}*/
+}
 
-ByteArray IncrementalBytestreamHashCalculator::getSHA1Hash() {
-    assert(sha1Hasher);
-    if (!sha1Hash) {
-        sha1Hash = sha1Hasher->getHash();
+void IncrementalBytestreamHashCalculator::run() {
+    while (true) {
+        std::shared_ptr<ByteArray> block;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueNonEmpty.wait(lock, [&]() { return stopRequested || !queue.empty(); });
+            if (stopRequested) {
+                return;
+            }
+            block = queue.front();
+            queue.pop_front();
+        }
+
+        if (!block) {
+            boost::optional<ByteArray> md5Hash;
+            if (md5Hasher) {
+                md5Hash = md5Hasher->getHash();
+            }
+            boost::optional<ByteArray> sha1Hash;
+            if (sha1Hasher) {
+                sha1Hash = sha1Hasher->getHash();
+            }
+            eventLoop->postEvent(boost::bind(&IncrementalBytestreamHashCalculator::handleHashesCalculated, this, md5Hash, sha1Hash), eventOwner);
+            return;
+        }
+
+        if (md5Hasher) {
+            md5Hasher->update(*block);
+        }
+        if (sha1Hasher) {
+            sha1Hasher->update(*block);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queuedBytes -= block->size();
+            if (freeBlocks.size() < maximumFreeBlocks) {
+                freeBlocks.push_back(block);
+            }
+        }
+        queueNotFull.notify_one();
     }
+}
+
+void IncrementalBytestreamHashCalculator::handleHashesCalculated(boost::optional<ByteArray> md5Hash, boost::optional<ByteArray> sha1Hash) {
+    this->md5Hash = md5Hash;
+    this->sha1Hash = sha1Hash;
+    hashesCalculated = true;
+    onHashesCalculated();
+}
+
+ByteArray IncrementalBytestreamHashCalculator::getSHA1Hash() {
+    assert(sha1Hash);
     return *sha1Hash;
 }
 
 ByteArray IncrementalBytestreamHashCalculator::getMD5Hash() {
-    assert(md5Hasher);
-    if (!md5Hash) {
-        md5Hash = md5Hasher->getHash();
-    }
+    assert(md5Hash);
     return *md5Hash;
 }
 
 std::string IncrementalBytestreamHashCalculator::getSHA1String() {
-    assert(sha1Hasher);
-    return Hexify::hexify(getSHA1Hash());;
+    return Hexify::hexify(getSHA1Hash());
 }
 
 std::string IncrementalBytestreamHashCalculator::getMD5String() {
-    assert(md5Hasher);
-    return Hexify::hexify(getMD5Hash());;
+    return Hexify::hexify(getMD5Hash());
 }
 
 }
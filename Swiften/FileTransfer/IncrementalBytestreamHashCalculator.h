@@ -5,43 +5,109 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/optional.hpp>
+#include <boost/signals2.hpp>
 
+#include <Swiften/Base/API.h>
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/SafeByteArray.h>
 
 namespace Swift {
     class Hash;
     class CryptoProvider;
+    class EventLoop;
+    class EventOwner;
 
-    class IncrementalBytestreamHashCalculator {
+    /**
+     * Calculates the MD5 and/or SHA-1 hash of a bytestream while it is transferred.
+     *
+     * The hashes are calculated on a worker thread, so that hashing does not hold
+     * up the event loop that services the connection. Fed data is queued in blocks
+     * of at most \ref blockSize bytes, and every block is passed to both hashes in
+     * turn while it is still in the cache. The worker thread is only started when
+     * the first data is fed, so that transfers which never send any data do not
+     * cost a thread. At most \ref maximumQueuedBytes bytes are
+     * queued; if the worker falls behind, \ref feedData blocks until it caught up.
+     *
+     * After \ref calculateHashes is called, \ref onHashesCalculated is emitted
+     * from the event loop once all data is hashed.
+     */
+    class SWIFTEN_API IncrementalBytestreamHashCalculator {
     public:
-        IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto);
+        static const size_t blockSize = 65536;
+        static const size_t maximumQueuedBytes = 1024 * 1024;
+
+        IncrementalBytestreamHashCalculator(bool doMD5, bool doSHA1, CryptoProvider* crypto, EventLoop* eventLoop);
         ~IncrementalBytestreamHashCalculator();
 
         void feedData(const ByteArray& data);
-        //void feedData(const SafeByteArray& data);
+        void feedData(const SafeByteArray& data);
+
+        /**
+         * Signals that all data was fed, and starts finishing the hashes.
+         */
+        void calculateHashes();
 
+        /**
+         * Returns whether the hashes are calculated (i.e. whether
+         * \ref onHashesCalculated was emitted).
+         */
+        bool hasHashes() const {
+            return hashesCalculated;
+        }
+
+        /**
+         * The hashes can only be retrieved after they are calculated.
+         */
         ByteArray getSHA1Hash();
         ByteArray getMD5Hash();
 
         std::string getSHA1String();
         std::string getMD5String();
 
+    public:
+        boost::signals2::signal<void ()> onHashesCalculated;
+
+    private:
+        void feedData(const unsigned char* data, size_t size);
+        void startWorker();
+        void run();
+        void handleHashesCalculated(boost::optional<ByteArray> md5Hash, boost::optional<ByteArray> sha1Hash);
+
     private:
+        EventLoop* eventLoop;
+        std::shared_ptr<EventOwner> eventOwner;
         Hash* md5Hasher;
         Hash* sha1Hasher;
         boost::optional<ByteArray> md5Hash;
         boost::optional<ByteArray> sha1Hash;
+        bool dataComplete;
+        bool hashesCalculated;
+
+        std::thread* thread;
+        std::mutex queueMutex;
+        std::condition_variable queueNonEmpty;
+        std::condition_variable queueNotFull;
+        // An empty reference marks the end of the data
+        std::deque<std::shared_ptr<ByteArray> > queue;
+        std::vector<std::shared_ptr<ByteArray> > freeBlocks;
+        size_t queuedBytes;
+        bool stopRequested;
     };
 
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,12 +28,14 @@ OutgoingFileTransferManager::OutgoingFileTransferManager(
         IQRouter* router,
         FileTransferTransporterFactory* transporterFactory,
         TimerFactory* timerFactory,
-        CryptoProvider* crypto) :
+        CryptoProvider* crypto,
+        EventLoop* eventLoop) :
             jingleSessionManager(jingleSessionManager),
             iqRouter(router),
             transporterFactory(transporterFactory),
             timerFactory(timerFactory),
-            crypto(crypto) {
+            crypto(crypto),
+            eventLoop(eventLoop) {
     idGenerator = new IDGenerator();
 }
 
@@ -59,7 +61,8 @@ std::shared_ptr<OutgoingFileTransfer> OutgoingFileTransferManager::createOutgoin
                 idGenerator,
                 fileInfo,
                 config,
-                crypto));
+                crypto,
+                eventLoop));
 }
 
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -26,6 +26,7 @@ namespace Swift {
     class ReadBytestream;
     class JingleFileTransferFileInfo;
     class CryptoProvider;
+    class EventLoop;
     class FileTransferOptions;
     class TimerFactory;
 
@@ -36,7 +37,8 @@ namespace Swift {
                     IQRouter* router,
                     FileTransferTransporterFactory* transporterFactory,
                     TimerFactory* timerFactory,
-                    CryptoProvider* crypto);
+                    CryptoProvider* crypto,
+                    EventLoop* eventLoop);
             ~OutgoingFileTransferManager();
 
             std::shared_ptr<OutgoingFileTransfer> createOutgoingFileTransfer(
@@ -53,5 +55,6 @@ namespace Swift {
             TimerFactory* timerFactory;
             IDGenerator* idGenerator;
             CryptoProvider* crypto;
+            EventLoop* eventLoop;
     };
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -52,7 +52,8 @@ OutgoingJingleFileTransfer::OutgoingJingleFileTransfer(
         IDGenerator* idGenerator,
         const JingleFileTransferFileInfo& fileInfo,
         const FileTransferOptions& options,
-        CryptoProvider* crypto) :
+        CryptoProvider* crypto,
+        EventLoop* eventLoop) :
             JingleFileTransfer(session, toJID, transporterFactory),
             idGenerator(idGenerator),
             stream(stream),
@@ -65,9 +66,11 @@ OutgoingJingleFileTransfer::OutgoingJingleFileTransfer(
     setFileInfo(fileInfo.getName(), fileInfo.getSize(), fileInfo.getDescription());
 
     // calculate both, MD5 and SHA-1 since we don't know which one the other side supports
-    hashCalculator = new IncrementalBytestreamHashCalculator(true, true, crypto);
-    stream->onRead.connect(
-            boost::bind(&IncrementalBytestreamHashCalculator::feedData, hashCalculator, _1));
+    hashCalculator = new IncrementalBytestreamHashCalculator(true, true, crypto, eventLoop);
+    streamReadConnection = stream->onRead.connect([this](const std::vector<unsigned char>& data) {
+        hashCalculator->feedData(data);
+    });
+    hashCalculator->onHashesCalculated.connect(boost::bind(&OutgoingJingleFileTransfer::handleHashesCalculated, this));
 
     waitForRemoteTermination = timerFactory->createTimer(5000);
     waitForRemoteTermination->onTick.connect(boost::bind(&OutgoingJingleFileTransfer::handleWaitForRemoteTerminationTimeout, this));
@@ -79,8 +82,7 @@ OutgoingJingleFileTransfer::~OutgoingJingleFileTransfer() {
         waitForRemoteTermination->stop();
     }
 
-    stream->onRead.disconnect(
-            boost::bind(&IncrementalBytestreamHashCalculator::feedData, hashCalculator, _1));
+    streamReadConnection.disconnect();
     delete hashCalculator;
     hashCalculator = nullptr;
     removeTransporter();
@@ -247,14 +249,23 @@ void OutgoingJingleFileTransfer::handleTransferFinished(boost::optional<FileTran
         terminate(JinglePayload::Reason::ConnectivityError);
     }
     else {
-        sendSessionInfoHash();
-
-        // wait for other party to terminate session after they have verified the hash
+        // The hash is sent once the hashing thread caught up with the transfer
         setInternalState(WaitForTermination);
-        waitForRemoteTermination->start();
+        hashCalculator->calculateHashes();
     }
 }
 
+void OutgoingJingleFileTransfer::handleHashesCalculated() {
+    SWIFT_LOG(debug) << std::endl;
+    if (state != WaitForTermination) {
+        return;
+    }
+    sendSessionInfoHash();
+
+    // wait for other party to terminate session after they have verified the hash
+    waitForRemoteTermination->start();
+}
+
 void OutgoingJingleFileTransfer::startTransferring(std::shared_ptr<TransportSession> transportSession) {
     SWIFT_LOG(debug) << std::endl;
 
@@ -27,6 +27,7 @@
 
 namespace Swift {
     class CryptoProvider;
+    class EventLoop;
     class FileTransferTransporterFactory;
     class IDGenerator;
     class IncrementalBytestreamHashCalculator;
@@ -45,7 +46,8 @@ namespace Swift {
                 IDGenerator*,
                 const JingleFileTransferFileInfo&,
                 const FileTransferOptions&,
-                CryptoProvider*);
+                CryptoProvider*,
+                EventLoop*);
             virtual ~OutgoingJingleFileTransfer();
 
             virtual void start() SWIFTEN_OVERRIDE;
@@ -84,6 +86,7 @@ namespace Swift {
             virtual void fallback() SWIFTEN_OVERRIDE;
             void handleTransferFinished(boost::optional<FileTransferError>);
 
+            void handleHashesCalculated();
             void sendSessionInfoHash();
 
             virtual void startTransferring(std::shared_ptr<TransportSession>) SWIFTEN_OVERRIDE;
@@ -115,6 +118,7 @@ namespace Swift {
 
             Timer::ref waitForRemoteTermination;
 
+            boost::signals2::connection streamReadConnection;
             boost::signals2::connection processedBytesConnection;
             boost::signals2::connection transferFinishedConnection;
     };
@@ -192,7 +192,7 @@ void SOCKS5BytestreamClientSession::sendData() {
     if (!readBytestream->isFinished()) {
         try {
             std::shared_ptr<ByteArray> dataToSend = readBytestream->read(boost::numeric_cast<size_t>(chunkSize));
-            connection->write(createSafeByteArray(*dataToSend));
+            connection->writeBuffer(dataToSend);
             onBytesSent(dataToSend->size());
         }
         catch (const BytestreamException&) {
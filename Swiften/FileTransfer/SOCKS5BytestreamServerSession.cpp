@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -158,10 +158,10 @@ void SOCKS5BytestreamServerSession::process() {
 void SOCKS5BytestreamServerSession::sendData() {
     if (!readBytestream->isFinished()) {
         try {
-            SafeByteArray dataToSend = createSafeByteArray(*readBytestream->read(boost::numeric_cast<size_t>(chunkSize)));
-            if (!dataToSend.empty()) {
-                connection->write(dataToSend);
-                onBytesSent(dataToSend.size());
+            std::shared_ptr<ByteArray> dataToSend = readBytestream->read(boost::numeric_cast<size_t>(chunkSize));
+            if (!dataToSend->empty()) {
+                connection->writeBuffer(dataToSend);
+                onBytesSent(dataToSend->size());
                 waitingForData = false;
             }
             else {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2016 Isode Limited.
+ * Copyright (c) 2015-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -43,10 +43,10 @@ public:
             SOCKS5BytestreamProxiesManager* /* s5bProxy */,
             IDGenerator* /* idGenerator */,
             ConnectionFactory*,
-            TimerFactory*,
+            TimerFactory* timerFactory,
             CryptoProvider* cryptoProvider,
             IQRouter* iqRouter,
-            const FileTransferOptions& ftOptions) : initiator_(initiator), responder_(responder), role_(role), s5bRegistry_(s5bRegistry), crypto_(cryptoProvider), iqRouter_(iqRouter), ftOptions_(ftOptions) {
+            const FileTransferOptions& ftOptions) : initiator_(initiator), responder_(responder), role_(role), s5bRegistry_(s5bRegistry), timerFactory_(timerFactory), crypto_(cryptoProvider), iqRouter_(iqRouter), ftOptions_(ftOptions) {
 
     }
 
@@ -86,7 +86,7 @@ public:
 
     virtual std::shared_ptr<TransportSession> createIBBSendSession(const std::string& sessionID, unsigned int blockSize, std::shared_ptr<ReadBytestream> stream) {
         std::shared_ptr<IBBSendSession> ibbSession = std::make_shared<IBBSendSession>(
-                sessionID, initiator_, responder_, stream, iqRouter_);
+                sessionID, initiator_, responder_, stream, iqRouter_, timerFactory_);
         ibbSession->setBlockSize(blockSize);
         return std::make_shared<IBBSendTransportSession>(ibbSession);
     }
@@ -143,6 +143,7 @@ private:
     JID responder_;
     Role role_;
     SOCKS5BytestreamRegistry* s5bRegistry_;
+    TimerFactory* timerFactory_;
     CryptoProvider* crypto_;
     std::string s5bSessionID_;
     IQRouter* iqRouter_;
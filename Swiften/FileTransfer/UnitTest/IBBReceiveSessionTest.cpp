@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,6 +28,7 @@ class IBBReceiveSessionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testReceiveMultipleData);
         CPPUNIT_TEST(testReceiveDataForOtherSession);
         CPPUNIT_TEST(testReceiveDataOutOfOrder);
+        CPPUNIT_TEST(testReceiveDataAheadOfMissingBlock);
         CPPUNIT_TEST(testReceiveLastData);
         CPPUNIT_TEST(testReceiveClose);
         CPPUNIT_TEST(testStopWhileActive);
@@ -113,6 +114,26 @@ class IBBReceiveSessionTest : public CppUnit::TestFixture {
             testling->stop();
         }
 
+        void testReceiveDataAheadOfMissingBlock() {
+            std::shared_ptr<IBBReceiveSession> testling(createSession("foo@bar.com/baz", "mysession", 9));
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBOpen("mysession", 0x10), "foo@bar.com/baz", "id-open"));
+
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBData("mysession", 0, createByteArray("abc")), "foo@bar.com/baz", "id-a"));
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBData("mysession", 2, createByteArray("ghi")), "foo@bar.com/baz", "id-c"));
+            CPPUNIT_ASSERT(stanzaChannel->isResultAtIndex(2, "id-c"));
+            CPPUNIT_ASSERT(createByteArray("abc") == bytestream->getData());
+            CPPUNIT_ASSERT(!finished);
+
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBData("mysession", 1, createByteArray("def")), "foo@bar.com/baz", "id-b"));
+            CPPUNIT_ASSERT(stanzaChannel->isResultAtIndex(3, "id-b"));
+            CPPUNIT_ASSERT(createByteArray("abcdefghi") == bytestream->getData());
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(!error);
+
+            testling->stop();
+        }
+
         void testReceiveLastData() {
             std::shared_ptr<IBBReceiveSession> testling(createSession("foo@bar.com/baz", "mysession", 6));
             testling->start();
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -15,6 +15,7 @@
 #include <Swiften/Client/DummyStanzaChannel.h>
 #include <Swiften/FileTransfer/ByteArrayReadBytestream.h>
 #include <Swiften/FileTransfer/IBBSendSession.h>
+#include <Swiften/Network/DummyTimerFactory.h>
 #include <Swiften/Queries/IQRouter.h>
 
 using namespace Swift;
@@ -32,6 +33,11 @@ class IBBSendSessionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testDataStreamResumeAfterPauseSendsData);
         CPPUNIT_TEST(testDataStreamResumeBeforePauseDoesNotSendData);
         CPPUNIT_TEST(testDataStreamResumeAfterResumeDoesNotSendData);
+        CPPUNIT_TEST(testWindowGrowsWithResponses);
+        CPPUNIT_TEST(testWaitErrorResendsBlocksInOrder);
+        CPPUNIT_TEST(testWaitErrorOnOneBlockInWindowResendsOnlyThatBlock);
+        CPPUNIT_TEST(testWaitErrorResendsAfterIncreasingDelay);
+        CPPUNIT_TEST(testCancelErrorFinishesWithError);
 
         CPPUNIT_TEST_SUITE_END();
 
@@ -39,11 +45,13 @@ class IBBSendSessionTest : public CppUnit::TestFixture {
         void setUp() {
             stanzaChannel = new DummyStanzaChannel();
             iqRouter = new IQRouter(stanzaChannel);
+            timerFactory = new DummyTimerFactory();
             bytestream = std::make_shared<ByteArrayReadBytestream>(createByteArray("abcdefg"));
             finished = false;
         }
 
         void tearDown() {
+            delete timerFactory;
             delete iqRouter;
             delete stanzaChannel;
         }
@@ -204,14 +212,153 @@ class IBBSendSessionTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(5, static_cast<int>(stanzaChannel->sentStanzas.size()));
         }
 
+        void testWindowGrowsWithResponses() {
+            stanzaChannel->uniqueIDs_ = true;
+            std::shared_ptr<IBBSendSession> testling = createSession("foo@bar.com/baz");
+            testling->setBlockSize(1);
+            testling->setWindowSize(3);
+            testling->start();
+
+            stanzaChannel->onIQReceived(createIBBResult(0));
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            stanzaChannel->onIQReceived(createIBBResult(1));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            stanzaChannel->onIQReceived(createIBBResult(2));
+            CPPUNIT_ASSERT_EQUAL(6, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            stanzaChannel->onIQReceived(createIBBResult(3));
+            CPPUNIT_ASSERT_EQUAL(7, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            for (size_t i = 1; i < stanzaChannel->sentStanzas.size(); ++i) {
+                IBB::ref ibb = stanzaChannel->sentStanzas[i]->getPayload<IBB>();
+                CPPUNIT_ASSERT_EQUAL(static_cast<int>(i - 1), ibb->getSequenceNumber());
+                CPPUNIT_ASSERT(createByteArray(std::string(1, static_cast<char>('a' + i - 1))) == ibb->getData());
+            }
+            CPPUNIT_ASSERT(!finished);
+
+            for (size_t i = 4; i < 8; ++i) {
+                stanzaChannel->onIQReceived(createIBBResult(i));
+            }
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(!error);
+        }
+
+        void testWaitErrorResendsBlocksInOrder() {
+            stanzaChannel->uniqueIDs_ = true;
+            std::shared_ptr<IBBSendSession> testling = createSession("foo@bar.com/baz");
+            testling->setBlockSize(3);
+            testling->setWindowSize(2);
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBResult(0));
+            stanzaChannel->onIQReceived(createIBBResult(1));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            stanzaChannel->onIQReceived(createIBBError(2, ErrorPayload::Wait));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            stanzaChannel->onIQReceived(createIBBError(3, ErrorPayload::Wait));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            timerFactory->setTime(500);
+            CPPUNIT_ASSERT_EQUAL(5, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            IBB::ref ibb = stanzaChannel->sentStanzas[4]->getPayload<IBB>();
+            CPPUNIT_ASSERT_EQUAL(1, ibb->getSequenceNumber());
+            CPPUNIT_ASSERT(createByteArray("def") == ibb->getData());
+
+            stanzaChannel->onIQReceived(createIBBResult(4));
+            CPPUNIT_ASSERT_EQUAL(6, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            ibb = stanzaChannel->sentStanzas[5]->getPayload<IBB>();
+            CPPUNIT_ASSERT_EQUAL(2, ibb->getSequenceNumber());
+            CPPUNIT_ASSERT(createByteArray("g") == ibb->getData());
+
+            stanzaChannel->onIQReceived(createIBBResult(5));
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(!error);
+        }
+
+        void testWaitErrorOnOneBlockInWindowResendsOnlyThatBlock() {
+            stanzaChannel->uniqueIDs_ = true;
+            std::shared_ptr<IBBSendSession> testling = createSession("foo@bar.com/baz");
+            testling->setBlockSize(3);
+            testling->setWindowSize(2);
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBResult(0));
+            stanzaChannel->onIQReceived(createIBBResult(1));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            stanzaChannel->onIQReceived(createIBBError(2, ErrorPayload::Wait));
+            stanzaChannel->onIQReceived(createIBBResult(3));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            CPPUNIT_ASSERT(!finished);
+
+            timerFactory->setTime(500);
+            CPPUNIT_ASSERT_EQUAL(5, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            IBB::ref ibb = stanzaChannel->sentStanzas[4]->getPayload<IBB>();
+            CPPUNIT_ASSERT_EQUAL(1, ibb->getSequenceNumber());
+            CPPUNIT_ASSERT(createByteArray("def") == ibb->getData());
+
+            stanzaChannel->onIQReceived(createIBBResult(4));
+            CPPUNIT_ASSERT_EQUAL(5, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(!error);
+        }
+
+        void testWaitErrorResendsAfterIncreasingDelay() {
+            stanzaChannel->uniqueIDs_ = true;
+            std::shared_ptr<IBBSendSession> testling = createSession("foo@bar.com/baz");
+            testling->setBlockSize(3);
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBResult(0));
+
+            stanzaChannel->onIQReceived(createIBBError(1, ErrorPayload::Wait));
+            timerFactory->setTime(499);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            timerFactory->setTime(500);
+            CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(stanzaChannel->sentStanzas.size()));
+
+            stanzaChannel->onIQReceived(createIBBError(2, ErrorPayload::Wait));
+            timerFactory->setTime(1499);
+            CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            timerFactory->setTime(1500);
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+            IBB::ref ibb = stanzaChannel->sentStanzas[3]->getPayload<IBB>();
+            CPPUNIT_ASSERT_EQUAL(0, ibb->getSequenceNumber());
+        }
+
+        void testCancelErrorFinishesWithError() {
+            stanzaChannel->uniqueIDs_ = true;
+            std::shared_ptr<IBBSendSession> testling = createSession("foo@bar.com/baz");
+            testling->setBlockSize(3);
+            testling->setWindowSize(2);
+            testling->start();
+            stanzaChannel->onIQReceived(createIBBResult(0));
+            stanzaChannel->onIQReceived(createIBBResult(1));
+
+            stanzaChannel->onIQReceived(createIBBError(2, ErrorPayload::Cancel));
+
+            CPPUNIT_ASSERT(finished);
+            CPPUNIT_ASSERT(error);
+            stanzaChannel->onIQReceived(createIBBResult(3));
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(stanzaChannel->sentStanzas.size()));
+        }
+
     private:
+        IQ::ref createIBBResult(size_t index) {
+            return IQ::createResult(JID("baz@fum.com/dum"), stanzaChannel->sentStanzas[index]->getTo(), stanzaChannel->sentStanzas[index]->getID(), std::shared_ptr<IBB>());
+        }
+
+        IQ::ref createIBBError(size_t index, ErrorPayload::Type type) {
+            return IQ::createError(JID("baz@fum.com/dum"), stanzaChannel->sentStanzas[index]->getTo(), stanzaChannel->sentStanzas[index]->getID(), ErrorPayload::ResourceConstraint, type);
+        }
+
         IQ::ref createIBBResult() {
             return IQ::createResult(JID("baz@fum.com/dum"), stanzaChannel->sentStanzas[stanzaChannel->sentStanzas.size()-1]->getTo(), stanzaChannel->sentStanzas[stanzaChannel->sentStanzas.size()-1]->getID(), std::shared_ptr<IBB>());
         }
 
     private:
         std::shared_ptr<IBBSendSession> createSession(const std::string& to) {
-            std::shared_ptr<IBBSendSession> session(new IBBSendSession("myid", JID(), JID(to), bytestream, iqRouter));
+            std::shared_ptr<IBBSendSession> session(new IBBSendSession("myid", JID(), JID(to), bytestream, iqRouter, timerFactory));
             session->onFinished.connect(boost::bind(&IBBSendSessionTest::handleFinished, this, _1));
             return session;
         }
@@ -224,6 +371,7 @@ class IBBSendSessionTest : public CppUnit::TestFixture {
     private:
         DummyStanzaChannel* stanzaChannel;
         IQRouter* iqRouter;
+        DummyTimerFactory* timerFactory;
         bool finished;
         boost::optional<FileTransferError> error;
         std::shared_ptr<ByteArrayReadBytestream> bytestream;
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,6 +19,7 @@
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/Log.h>
 #include <Swiften/Base/Override.h>
+#include <Swiften/Base/sleep.h>
 #include <Swiften/Client/DummyStanzaChannel.h>
 #include <Swiften/Crypto/CryptoProvider.h>
 #include <Swiften/Crypto/PlatformCryptoProvider.h>
@@ -49,12 +50,13 @@ class IncomingJingleFileTransferTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(IncomingJingleFileTransferTest);
         CPPUNIT_TEST(test_AcceptOnyIBBSendsSessionAccept);
         CPPUNIT_TEST(test_OnlyIBBTransferReceiveWorks);
+        CPPUNIT_TEST(test_HashIsVerifiedAfterHashing);
         //CPPUNIT_TEST(test_AcceptFailingS5BFallsBackToIBB);
         CPPUNIT_TEST_SUITE_END();
 public:
         std::shared_ptr<IncomingJingleFileTransfer> createTestling() {
             JID ourJID("our@jid.org/full");
-            return std::make_shared<IncomingJingleFileTransfer>(ourJID, std::shared_ptr<JingleSession>(session), jingleContentPayload, ftTransporterFactory, timerFactory, crypto.get());
+            return std::make_shared<IncomingJingleFileTransfer>(ourJID, std::shared_ptr<JingleSession>(session), jingleContentPayload, ftTransporterFactory, timerFactory, crypto.get(), eventLoop);
         }
 
         IQ::ref createIBBRequest(IBB::ref ibb, const JID& from, const std::string& id) {
@@ -145,6 +147,32 @@ public:
             CPPUNIT_ASSERT(createByteArray("abc") == byteStream->getData());
         }
 
+        void test_HashIsVerifiedAfterHashing() {
+            std::shared_ptr<JingleFileTransferDescription> desc = std::make_shared<JingleFileTransferDescription>();
+            JingleFileTransferFileInfo fileInfo("file.txt", "", 3);
+            fileInfo.addHash(HashElement("sha-1", crypto->getSHA1Hash(createByteArray("abc"))));
+            desc->setFileInfo(fileInfo);
+            jingleContentPayload->addDescription(desc);
+            JingleIBBTransportPayload::ref tpRef = std::make_shared<JingleIBBTransportPayload>();
+            tpRef->setSessionID("mysession");
+            jingleContentPayload->addTransport(tpRef);
+
+            std::shared_ptr<IncomingJingleFileTransfer> fileTransfer = createTestling();
+            std::shared_ptr<ByteArrayWriteBytestream> byteStream = std::make_shared<ByteArrayWriteBytestream>();
+            fileTransfer->accept(byteStream);
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBOpen("mysession", 0x10), "foo@bar.com/baz", "id-open"));
+            stanzaChannel->onIQReceived(createIBBRequest(IBB::createIBBData("mysession", 0, createByteArray("abc")), "foo@bar.com/baz", "id-a"));
+
+            // The hash is calculated on a separate thread
+            for (int i = 0; i < 1000 && session->calledCommands.size() < 2; ++i) {
+                Swift::sleep(10);
+                eventLoop->processEvents();
+            }
+
+            FakeJingleSession::TerminateCall terminateCall = getCall<FakeJingleSession::TerminateCall>(1);
+            CPPUNIT_ASSERT_EQUAL(JinglePayload::Reason::Success, terminateCall.reason);
+        }
+
         void test_AcceptFailingS5BFallsBackToIBB() {
             //1. create your test incoming file transfer
             addFileTransferDescription();
@@ -219,7 +247,7 @@ private:
     }
 
 private:
-    EventLoop* eventLoop;
+    DummyEventLoop* eventLoop;
     std::shared_ptr<CryptoProvider> crypto;
     std::shared_ptr<FakeJingleSession> session;
     std::shared_ptr<JingleContentPayload> jingleContentPayload;
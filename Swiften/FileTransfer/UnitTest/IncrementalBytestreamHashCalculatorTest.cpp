@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+
+#include <boost/bind.hpp>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Base/Algorithm.h>
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Base/sleep.h>
+#include <Swiften/Crypto/CryptoProvider.h>
+#include <Swiften/Crypto/PlatformCryptoProvider.h>
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/FileTransfer/IncrementalBytestreamHashCalculator.h>
+#include <Swiften/StringCodecs/Hexify.h>
+
+using namespace Swift;
+
+class IncrementalBytestreamHashCalculatorTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(IncrementalBytestreamHashCalculatorTest);
+        CPPUNIT_TEST(testCalculateHashes);
+        CPPUNIT_TEST(testCalculateHashes_SafeByteArray);
+        CPPUNIT_TEST(testCalculateHashes_MoreDataThanQueueSize);
+        CPPUNIT_TEST(testCalculateHashes_NoData);
+        CPPUNIT_TEST(testDestroyWhileCalculating);
+        CPPUNIT_TEST(testDestroyWithoutData);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            crypto = std::shared_ptr<CryptoProvider>(PlatformCryptoProvider::create());
+            eventLoop = new DummyEventLoop();
+            hashesCalculated = 0;
+        }
+
+        void tearDown() {
+            delete eventLoop;
+        }
+
+        void testCalculateHashes() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = createTestling();
+
+            testling->feedData(createByteArray("ab"));
+            testling->feedData(createByteArray("c"));
+            testling->calculateHashes();
+            waitForHashes(testling);
+
+            CPPUNIT_ASSERT_EQUAL(1, hashesCalculated);
+            CPPUNIT_ASSERT_EQUAL(std::string("900150983cd24fb0d6963f7d28e17f72"), testling->getMD5String());
+            CPPUNIT_ASSERT_EQUAL(std::string("a9993e364706816aba3e25717850c26c9cd0d89d"), testling->getSHA1String());
+        }
+
+        void testCalculateHashes_SafeByteArray() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = createTestling();
+
+            testling->feedData(createSafeByteArray("abc"));
+            testling->calculateHashes();
+            waitForHashes(testling);
+
+            CPPUNIT_ASSERT_EQUAL(std::string("a9993e364706816aba3e25717850c26c9cd0d89d"), testling->getSHA1String());
+        }
+
+        void testCalculateHashes_MoreDataThanQueueSize() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = createTestling();
+            ByteArray data;
+            for (size_t i = 0; i < 3 * IncrementalBytestreamHashCalculator::maximumQueuedBytes + 17; ++i) {
+                data.push_back(static_cast<unsigned char>(i * 13));
+            }
+
+            testling->feedData(data);
+            testling->feedData(data);
+            testling->calculateHashes();
+            waitForHashes(testling);
+
+            ByteArray allData = data;
+            append(allData, data);
+            CPPUNIT_ASSERT(crypto->getMD5Hash(allData) == testling->getMD5Hash());
+            CPPUNIT_ASSERT(crypto->getSHA1Hash(allData) == testling->getSHA1Hash());
+        }
+
+        void testCalculateHashes_NoData() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = createTestling();
+
+            testling->calculateHashes();
+            waitForHashes(testling);
+
+            CPPUNIT_ASSERT_EQUAL(std::string("da39a3ee5e6b4b0d3255bfef95601890afd80709"), testling->getSHA1String());
+        }
+
+        void testDestroyWhileCalculating() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = createTestling();
+
+            testling->feedData(ByteArray(IncrementalBytestreamHashCalculator::maximumQueuedBytes, 'a'));
+            testling->calculateHashes();
+            testling.reset();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(0, hashesCalculated);
+        }
+
+        void testDestroyWithoutData() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = createTestling();
+
+            testling->feedData(ByteArray());
+            testling.reset();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(0, hashesCalculated);
+        }
+
+    private:
+        std::shared_ptr<IncrementalBytestreamHashCalculator> createTestling() {
+            std::shared_ptr<IncrementalBytestreamHashCalculator> testling = std::make_shared<IncrementalBytestreamHashCalculator>(true, true, crypto.get(), eventLoop);
+            testling->onHashesCalculated.connect(boost::bind(&IncrementalBytestreamHashCalculatorTest::handleHashesCalculated, this));
+            return testling;
+        }
+
+        void waitForHashes(std::shared_ptr<IncrementalBytestreamHashCalculator> testling) {
+            for (int i = 0; i < 1000 && !testling->hasHashes(); ++i) {
+                Swift::sleep(10);
+                eventLoop->processEvents();
+            }
+            CPPUNIT_ASSERT(testling->hasHashes());
+        }
+
+        void handleHashesCalculated() {
+            hashesCalculated++;
+        }
+
+    private:
+        std::shared_ptr<CryptoProvider> crypto;
+        DummyEventLoop* eventLoop;
+        int hashesCalculated;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IncrementalBytestreamHashCalculatorTest);
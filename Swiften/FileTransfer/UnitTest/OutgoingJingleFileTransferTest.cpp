@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2013-2016 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -97,7 +97,8 @@ public:
                 idGen,
                 fileInfo,
                 options,
-                crypto.get()));
+                crypto.get(),
+                eventLoop));
         }
 
         IQ::ref createIBBRequest(IBB::ref ibb, const JID& from, const std::string& id) {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -32,5 +32,16 @@ namespace Swift {
             virtual std::vector<HistoryMessage> getMessagesFromPreviousDate(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date) const = 0;
             virtual ContactsMap getContacts(const JID& selfJID, HistoryMessage::Type type, const std::string& keyword) const = 0;
             virtual boost::posix_time::ptime getLastTimeStampFromMUC(const JID& selfJID, const JID& mucJID) const = 0;
+
+            /**
+             * Searches the messages of type \p type containing all words of \p keyword
+             * (as a prefix of a word), exchanged with \p contactJID, or with anyone if
+             * \p contactJID is invalid.
+             *
+             * Returns one page: the newest \p maxResults matches sent before \p before
+             * (or before now if it is not a date), ranked by relevance. To get the next
+             * page, pass the time of the oldest returned message as \p before.
+             */
+            virtual std::vector<HistoryMessage> searchMessages(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const std::string& keyword, const boost::posix_time::ptime& before, int maxResults) const = 0;
     };
 }
@@ -1,76 +1,249 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/History/SQLiteHistoryStorage.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <sstream>
 
 #include <boost/bind.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
-#include <boost/lexical_cast.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 
 #include <sqlite3.h>
 
 #include <Swiften/Base/Path.h>
 
-inline std::string getEscapedString(const std::string& s) {
-    std::string result(s);
+namespace {
+    const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+    std::string getColumnText(sqlite3_stmt* statement, int column) {
+        const unsigned char* text = sqlite3_column_text(statement, column);
+        return text ? std::string(reinterpret_cast<const char*>(text)) : std::string();
+    }
+
+    void bindText(sqlite3_stmt* statement, int parameter, const std::string& text) {
+        sqlite3_bind_text(statement, parameter, text.c_str(), boost::numeric_cast<int>(text.size()), SQLITE_TRANSIENT);
+    }
+
+    /**
+     * Turns the words of \p keyword into an FTS5 query matching messages that
+     * contain all of them (as a prefix of a word).
+     */
+    std::string getFullTextQuery(const std::string& keyword) {
+        std::string query;
+        std::istringstream words(keyword);
+        std::string word;
+        while (words >> word) {
+            if (!query.empty()) {
+                query += ' ';
+            }
+            query += '"';
+            for (char c : word) {
+                query += c;
+                if (c == '"') {
+                    query += '"';
+                }
+            }
+            query += "\"*";
+        }
+        return query;
+    }
+
+    /**
+     * Turns \p keyword into a LIKE pattern matching messages that contain it.
+     */
+    std::string getLikePattern(const std::string& keyword) {
+        std::string pattern;
+        for (char c : keyword) {
+            if (c == '%' || c == '_' || c == '\\') {
+                pattern += '\\';
+            }
+            pattern += c;
+        }
+        return "%" + pattern + "%";
+    }
 
-    size_t pos = result.find('\'');
-    while (pos != std::string::npos) {
-        result.insert(pos, "'");
-        pos = result.find('\'', pos + 2);
+    /**
+     * Matches the messages between the JIDs bound to ?1 (self) and ?2 (contact),
+     * and with the contact resource bound to ?3 if \p matchResource is set.
+     */
+    std::string getConversationCondition(bool matchResource) {
+        if (matchResource) {
+            return "((fromBare=?1 AND toBare=?2 AND toResource=?3) OR (fromBare=?2 AND fromResource=?3 AND toBare=?1))";
+        }
+        return "((fromBare=?1 AND toBare=?2) OR (fromBare=?2 AND toBare=?1))";
     }
-    return result;
 }
 
 namespace Swift {
 
-SQLiteHistoryStorage::SQLiteHistoryStorage(const boost::filesystem::path& file) : db_(nullptr) {
-    thread_ = new std::thread(boost::bind(&SQLiteHistoryStorage::run, this));
+SQLiteHistoryStorage::SQLiteHistoryStorage(const boost::filesystem::path& file) : fullTextIndex_(false), rebuildFullTextIndex_(false), db_(nullptr), selectJIDStatement_(nullptr), selectIDStatement_(nullptr), writeDB_(nullptr), insertMessageStatement_(nullptr), insertJIDStatement_(nullptr), writeSelectIDStatement_(nullptr), writing_(false), stopping_(false) {
+    // Every connection to ":memory:" gets a database of its own, so both connections
+    // open an in-memory database through a shared cache instead, with a name that is
+    // unique to this storage.
+    std::string location = pathToString(file);
+    int openFlags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    bool inMemory = (location == ":memory:");
+    if (inMemory) {
+        std::ostringstream uri;
+        uri << "file:swiften-history-" << this << "?mode=memory&cache=shared";
+        location = uri.str();
+        openFlags |= SQLITE_OPEN_URI;
+    }
+
+    sqlite3_open_v2(location.c_str(), &writeDB_, openFlags, nullptr);
+    if (!writeDB_) {
+        std::cerr << "Error opening database " << pathToString(file) << std::endl;
+    }
+    sqlite3_busy_timeout(writeDB_, 5000);
+
+    // Write-ahead logging lets queries run while messages are written, and only
+    // syncs on checkpoints.
+    execute(writeDB_, "PRAGMA journal_mode=WAL");
+    execute(writeDB_, "PRAGMA synchronous=NORMAL");
+
+    execute(writeDB_, "CREATE TABLE IF NOT EXISTS messages('message' STRING, 'fromBare' INTEGER, 'fromResource' STRING, 'toBare' INTEGER, 'toResource' STRING, 'type' INTEGER, 'time' INTEGER, 'offset' INTEGER)");
+    execute(writeDB_, "CREATE TABLE IF NOT EXISTS jids('id' INTEGER PRIMARY KEY ASC AUTOINCREMENT, 'jid' STRING UNIQUE NOT NULL)");
+
+    // Conversations are looked up in both directions, per type, and by time.
+    // The resources make the indexes cover the contacts query.
+    execute(writeDB_, "CREATE INDEX IF NOT EXISTS messages_from ON messages('fromBare', 'type', 'toBare', 'time', 'fromResource', 'toResource')");
+    execute(writeDB_, "CREATE INDEX IF NOT EXISTS messages_to ON messages('toBare', 'type', 'fromBare', 'time', 'fromResource', 'toResource')");
+
+    // Keep a full-text index of the messages if SQLite supports it. The index refers
+    // to messages by rowid, which only changes when vacuuming the database.
+    sqlite3_stmt* ftsTableStatement = prepareStatement(writeDB_, "SELECT 1 FROM sqlite_master WHERE name='messages_fts'");
+    bool hadFullTextIndex = (sqlite3_step(ftsTableStatement) == SQLITE_ROW);
+    sqlite3_finalize(ftsTableStatement);
+    fullTextIndex_ = hadFullTextIndex || sqlite3_exec(writeDB_, "CREATE VIRTUAL TABLE messages_fts USING fts5(message, content='messages', content_rowid='rowid')", nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (fullTextIndex_) {
+        execute(writeDB_, "CREATE TRIGGER IF NOT EXISTS messages_fts_insert AFTER INSERT ON messages BEGIN INSERT INTO messages_fts(rowid, message) VALUES (new.rowid, new.message); END");
+        execute(writeDB_, "CREATE TRIGGER IF NOT EXISTS messages_fts_delete AFTER DELETE ON messages BEGIN INSERT INTO messages_fts(messages_fts, rowid, message) VALUES ('delete', old.rowid, old.message); END");
+        // Messages stored before the index existed are indexed by the storage thread,
+        // which counts as writing (for flush())
+        rebuildFullTextIndex_ = !hadFullTextIndex;
+        writing_ = rebuildFullTextIndex_;
+    }
+    else {
+        std::cerr << "SQLite has no FTS5 support; history searches will not be indexed" << std::endl;
+    }
+
+    insertMessageStatement_ = prepareStatement(writeDB_, "INSERT INTO messages('message', 'fromBare', 'fromResource', 'toBare', 'toResource', 'type', 'time', 'offset') VALUES(?, ?, ?, ?, ?, ?, ?, ?)");
+    insertJIDStatement_ = prepareStatement(writeDB_, "INSERT INTO jids('jid') VALUES(?)");
+    writeSelectIDStatement_ = prepareStatement(writeDB_, "SELECT id FROM jids WHERE jid=?");
 
-    sqlite3_open(pathToString(file).c_str(), &db_);
+    sqlite3_open_v2(location.c_str(), &db_, openFlags, nullptr);
     if (!db_) {
         std::cerr << "Error opening database " << pathToString(file) << std::endl;
     }
-
-    char* errorMessage;
-    int result = sqlite3_exec(db_, "CREATE TABLE IF NOT EXISTS messages('message' STRING, 'fromBare' INTEGER, 'fromResource' STRING, 'toBare' INTEGER, 'toResource' STRING, 'type' INTEGER, 'time' INTEGER, 'offset' INTEGER)", nullptr, nullptr, &errorMessage);
-    if (result != SQLITE_OK) {
-        std::cerr << "SQL Error: " << errorMessage << std::endl;
-        sqlite3_free(errorMessage);
+    sqlite3_busy_timeout(db_, 5000);
+    if (inMemory) {
+        // Connections sharing a cache lock tables instead of using the write-ahead log,
+        // so don't let queries wait for (or fail on) the storage thread's transactions
+        execute(db_, "PRAGMA read_uncommitted=1");
     }
+    selectJIDStatement_ = prepareStatement(db_, "SELECT jid FROM jids WHERE id=?");
+    selectIDStatement_ = prepareStatement(db_, "SELECT id FROM jids WHERE jid=?");
 
-    result = sqlite3_exec(db_, "CREATE TABLE IF NOT EXISTS jids('id' INTEGER PRIMARY KEY ASC AUTOINCREMENT, 'jid' STRING UNIQUE NOT NULL)", nullptr, nullptr, &errorMessage);
-    if (result != SQLITE_OK) {
-        std::cerr << "SQL Error: " << errorMessage << std::endl;
-        sqlite3_free(errorMessage);
-    }
+    thread_ = new std::thread(boost::bind(&SQLiteHistoryStorage::run, this));
 }
 
 SQLiteHistoryStorage::~SQLiteHistoryStorage() {
-    sqlite3_close(db_);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueChanged_.notify_all();
+    thread_->join();
     delete thread_;
+
+    sqlite3_finalize(selectJIDStatement_);
+    sqlite3_finalize(selectIDStatement_);
+    sqlite3_close(db_);
+    sqlite3_finalize(insertMessageStatement_);
+    sqlite3_finalize(insertJIDStatement_);
+    sqlite3_finalize(writeSelectIDStatement_);
+    sqlite3_close(writeDB_);
 }
 
 void SQLiteHistoryStorage::addMessage(const HistoryMessage& message) {
-    int secondsSinceEpoch = (message.getTime() - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_seconds();
-
-    std::string statement = std::string("INSERT INTO messages('message', 'fromBare', 'fromResource', 'toBare', 'toResource', 'type', 'time', 'offset') VALUES(") +
-                    "'" + getEscapedString(message.getMessage()) + "', " +
-                    boost::lexical_cast<std::string>(getIDForJID(message.getFromJID().toBare())) + ", '" +
-                    getEscapedString(message.getFromJID().getResource()) + "', " +
-                    boost::lexical_cast<std::string>(getIDForJID(message.getToJID().toBare())) + ", '" +
-                    getEscapedString(message.getToJID().getResource()) + "', " +
-                    boost::lexical_cast<std::string>(message.getType()) + ", " +
-                    boost::lexical_cast<std::string>(secondsSinceEpoch) + ", " +
-                    boost::lexical_cast<std::string>(message.getOffset()) + ")";
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        pendingMessages_.push_back(message);
+    }
+    queueChanged_.notify_all();
+}
+
+void SQLiteHistoryStorage::flush() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    queueChanged_.wait(lock, [this] { return pendingMessages_.empty() && !writing_; });
+}
+
+void SQLiteHistoryStorage::run() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    if (rebuildFullTextIndex_) {
+        lock.unlock();
+        execute(writeDB_, "INSERT INTO messages_fts(messages_fts) VALUES('rebuild')");
+        lock.lock();
+        writing_ = false;
+        queueChanged_.notify_all();
+    }
+    while (true) {
+        queueChanged_.wait(lock, [this] { return stopping_ || !pendingMessages_.empty(); });
+        if (pendingMessages_.empty()) {
+            break;
+        }
+        // Everything queued while the previous batch was written goes in one transaction
+        std::vector<HistoryMessage> messages;
+        messages.swap(pendingMessages_);
+        writing_ = true;
+        lock.unlock();
+        writeMessages(messages);
+        lock.lock();
+        writing_ = false;
+        queueChanged_.notify_all();
+    }
+}
+
+void SQLiteHistoryStorage::writeMessages(const std::vector<HistoryMessage>& messages) {
+    execute(writeDB_, "BEGIN TRANSACTION");
+    for (const auto& message : messages) {
+        int secondsSinceEpoch = (message.getTime() - epoch).total_seconds();
+
+        sqlite3_reset(insertMessageStatement_);
+        bindText(insertMessageStatement_, 1, message.getMessage());
+        sqlite3_bind_int64(insertMessageStatement_, 2, getIDForJID(message.getFromJID().toBare()));
+        bindText(insertMessageStatement_, 3, message.getFromJID().getResource());
+        sqlite3_bind_int64(insertMessageStatement_, 4, getIDForJID(message.getToJID().toBare()));
+        bindText(insertMessageStatement_, 5, message.getToJID().getResource());
+        sqlite3_bind_int(insertMessageStatement_, 6, message.getType());
+        sqlite3_bind_int(insertMessageStatement_, 7, secondsSinceEpoch);
+        sqlite3_bind_int(insertMessageStatement_, 8, message.getOffset());
+        if (sqlite3_step(insertMessageStatement_) != SQLITE_DONE) {
+            std::cerr << "SQL Error: " << sqlite3_errmsg(writeDB_) << std::endl;
+        }
+    }
+    execute(writeDB_, "COMMIT TRANSACTION");
+}
+
+sqlite3_stmt* SQLiteHistoryStorage::prepareStatement(sqlite3* db, const std::string& query) const {
+    sqlite3_stmt* statement = nullptr;
+    int r = sqlite3_prepare_v2(db, query.c_str(), boost::numeric_cast<int>(query.size()), &statement, nullptr);
+    if (r != SQLITE_OK) {
+        std::cout << "Error: " << sqlite3_errmsg(db) << std::endl;
+    }
+    return statement;
+}
+
+void SQLiteHistoryStorage::execute(sqlite3* db, const std::string& statement) {
     char* errorMessage;
-    int result = sqlite3_exec(db_, statement.c_str(), nullptr, nullptr, &errorMessage);
+    int result = sqlite3_exec(db, statement.c_str(), nullptr, nullptr, &errorMessage);
     if (result != SQLITE_OK) {
         std::cerr << "SQL Error: " << errorMessage << std::endl;
         sqlite3_free(errorMessage);
@@ -78,8 +251,6 @@ void SQLiteHistoryStorage::addMessage(const HistoryMessage& message) {
 }
 
 std::vector<HistoryMessage> SQLiteHistoryStorage::getMessagesFromDate(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date) const {
-    sqlite3_stmt* selectStatement;
-
     boost::optional<long long> selfID = getIDFromJID(selfJID.toBare());
     boost::optional<long long> contactID = getIDFromJID(contactJID.toBare());
 
@@ -88,79 +259,153 @@ std::vector<HistoryMessage> SQLiteHistoryStorage::getMessagesFromDate(const JID&
         return std::vector<HistoryMessage>();
     }
 
-    std::string selectQuery = "SELECT * FROM messages WHERE (type=" + boost::lexical_cast<std::string>(type);
-    if (contactJID.isBare()) {
-        // match only bare jid
-        selectQuery += " AND ((fromBare=" + boost::lexical_cast<std::string>(*selfID) + " AND toBare=" +
-                boost::lexical_cast<std::string>(*contactID) + ") OR (fromBare=" +
-                boost::lexical_cast<std::string>(*contactID) + " AND toBare=" + boost::lexical_cast<std::string>(*selfID) + ")))";
-    }
-    else {
-        // match resource too
-        selectQuery += " AND ((fromBare=" + boost::lexical_cast<std::string>(*selfID) + " AND (toBare=" +
-                boost::lexical_cast<std::string>(*contactID) +" AND toResource='" +
-                getEscapedString(contactJID.getResource()) + "')) OR ((fromBare=" +
-                boost::lexical_cast<std::string>(*contactID) + " AND fromResource='" +
-                getEscapedString(contactJID.getResource()) + "') AND toBare=" +
-                boost::lexical_cast<std::string>(*selfID) + ")))";
-    }
-
+    std::string selectQuery = "SELECT message, fromBare, fromResource, toBare, toResource, type, time, offset FROM messages WHERE type=?4 AND " + getConversationCondition(!contactJID.isBare());
     if (!date.is_not_a_date()) {
-        int lowerBound = (boost::posix_time::ptime(date) - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_seconds();
-        int upperBound = lowerBound + 86400;
-
-        selectQuery += " AND (time>=" + boost::lexical_cast<std::string>(lowerBound) +
-                " AND time<" + boost::lexical_cast<std::string>(upperBound) + ")";
+        selectQuery += " AND time>=?5 AND time<?6";
     }
+    // Both directions are looked up through different indexes, so the rows need sorting.
+    // Messages from the same second are kept in the order they were stored.
+    selectQuery += " ORDER BY time, rowid";
 
-    int r = sqlite3_prepare(db_, selectQuery.c_str(), boost::numeric_cast<int>(selectQuery.size()), &selectStatement, nullptr);
-    if (r != SQLITE_OK) {
-        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
+    sqlite3_stmt* selectStatement = prepareStatement(db_, selectQuery);
+    sqlite3_bind_int64(selectStatement, 1, *selfID);
+    sqlite3_bind_int64(selectStatement, 2, *contactID);
+    if (!contactJID.isBare()) {
+        bindText(selectStatement, 3, contactJID.getResource());
     }
-    r = sqlite3_step(selectStatement);
+    sqlite3_bind_int(selectStatement, 4, type);
+    if (!date.is_not_a_date()) {
+        int lowerBound = (boost::posix_time::ptime(date) - epoch).total_seconds();
+        sqlite3_bind_int(selectStatement, 5, lowerBound);
+        sqlite3_bind_int(selectStatement, 6, lowerBound + 86400);
+    }
+    int r = sqlite3_step(selectStatement);
 
     // Retrieve result
     std::vector<HistoryMessage> result;
     while (r == SQLITE_ROW) {
-        std::string message(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 0)));
-
-        // fromJID
-        boost::optional<JID> fromJID(getJIDFromID(sqlite3_column_int(selectStatement, 1)));
-        std::string fromResource(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 2)));
-        if (fromJID) {
-            fromJID = boost::optional<JID>(JID(fromJID->getNode(), fromJID->getDomain(), fromResource));
-        }
+        result.push_back(getMessage(selectStatement));
+        r = sqlite3_step(selectStatement);
+    }
+    if (r != SQLITE_DONE) {
+        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
+    }
+    sqlite3_finalize(selectStatement);
 
-        // toJID
-        boost::optional<JID> toJID(getJIDFromID(sqlite3_column_int(selectStatement, 3)));
-        std::string toResource(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 4)));
-        if (toJID) {
-            toJID = boost::optional<JID>(JID(toJID->getNode(), toJID->getDomain(), toResource));
-        }
+    return result;
+}
 
-        // message type
-        HistoryMessage::Type type = static_cast<HistoryMessage::Type>(sqlite3_column_int(selectStatement, 5));
+std::vector<HistoryMessage> SQLiteHistoryStorage::searchMessages(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const std::string& keyword, const boost::posix_time::ptime& before, int maxResults) const {
+    std::vector<HistoryMessage> result;
+    boost::optional<long long> selfID = getIDFromJID(selfJID.toBare());
+    boost::optional<long long> contactID;
+    if (contactJID.isValid()) {
+        contactID = getIDFromJID(contactJID.toBare());
+    }
+    std::string fullTextQuery = getFullTextQuery(keyword);
+    if (!selfID || (contactJID.isValid() && !contactID) || fullTextQuery.empty() || maxResults <= 0) {
+        return result;
+    }
 
-        // timestamp
-        int secondsSinceEpoch(sqlite3_column_int(selectStatement, 6));
-        boost::posix_time::ptime time(boost::gregorian::date(1970, 1, 1), boost::posix_time::seconds(secondsSinceEpoch));
+    // ?1-?3 select the conversation, ?4 the type, ?5 the keyword, ?6 the page end
+    std::string condition = "type=?4 AND time<?6 AND ";
+    if (contactID) {
+        condition += getConversationCondition(!contactJID.isBare());
+    }
+    else {
+        condition += "(fromBare=?1 OR toBare=?1)";
+    }
+    std::string columns = "messages.message, messages.fromBare, messages.fromResource, messages.toBare, messages.toResource, messages.type, messages.time, messages.offset";
+    std::string query;
+    if (fullTextIndex_) {
+        query = "SELECT " + columns + ", bm25(messages_fts) FROM messages_fts JOIN messages ON messages.rowid=messages_fts.rowid WHERE messages_fts MATCH ?5 AND " + condition;
+    }
+    else {
+        query = "SELECT " + columns + " FROM messages WHERE message LIKE ?5 ESCAPE '\\' AND " + condition;
+    }
+    // The keyword is only matched once, newest first; the page is cut below
+    query += " ORDER BY messages.time DESC";
 
-        // offset from utc
-        int offset = sqlite3_column_int(selectStatement, 7);
+    sqlite3_stmt* selectStatement = prepareStatement(db_, query);
+    sqlite3_bind_int64(selectStatement, 1, *selfID);
+    if (contactID) {
+        sqlite3_bind_int64(selectStatement, 2, *contactID);
+        if (!contactJID.isBare()) {
+            bindText(selectStatement, 3, contactJID.getResource());
+        }
+    }
+    sqlite3_bind_int(selectStatement, 4, type);
+    bindText(selectStatement, 5, fullTextIndex_ ? fullTextQuery : getLikePattern(keyword));
+    sqlite3_bind_int(selectStatement, 6, before.is_not_a_date_time() ? std::numeric_limits<int>::max() : (before - epoch).total_seconds());
 
-        result.push_back(HistoryMessage(message, (fromJID ? *fromJID : JID()), (toJID ? *toJID : JID()), type, time, offset));
+    // The page holds the newest matches (including all matches sent in the
+    // same second as the oldest one), ranked by relevance.
+    std::vector<std::pair<double, HistoryMessage> > page;
+    int pageEnd = 0;
+    int r = sqlite3_step(selectStatement);
+    while (r == SQLITE_ROW) {
+        int time = sqlite3_column_int(selectStatement, 6);
+        if (page.size() >= static_cast<size_t>(maxResults) && time != pageEnd) {
+            break;
+        }
+        pageEnd = time;
+        page.push_back(std::make_pair(fullTextIndex_ ? sqlite3_column_double(selectStatement, 8) : 0.0, getMessage(selectStatement)));
         r = sqlite3_step(selectStatement);
     }
-    if (r != SQLITE_DONE) {
+    if (r != SQLITE_DONE && r != SQLITE_ROW) {
         std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
     }
     sqlite3_finalize(selectStatement);
 
+    // Lower bm25 scores are better; ties stay newest first
+    std::stable_sort(page.begin(), page.end(), [](const std::pair<double, HistoryMessage>& a, const std::pair<double, HistoryMessage>& b) {
+        return a.first < b.first;
+    });
+    for (const auto& match : page) {
+        result.push_back(match.second);
+    }
     return result;
 }
 
+HistoryMessage SQLiteHistoryStorage::getMessage(sqlite3_stmt* selectStatement) const {
+    std::string message(getColumnText(selectStatement, 0));
+
+    // fromJID
+    boost::optional<JID> fromJID(getJIDFromID(sqlite3_column_int64(selectStatement, 1)));
+    std::string fromResource(getColumnText(selectStatement, 2));
+    if (fromJID) {
+        fromJID = boost::optional<JID>(JID(fromJID->getNode(), fromJID->getDomain(), fromResource));
+    }
+
+    // toJID
+    boost::optional<JID> toJID(getJIDFromID(sqlite3_column_int64(selectStatement, 3)));
+    std::string toResource(getColumnText(selectStatement, 4));
+    if (toJID) {
+        toJID = boost::optional<JID>(JID(toJID->getNode(), toJID->getDomain(), toResource));
+    }
+
+    // message type
+    HistoryMessage::Type type = static_cast<HistoryMessage::Type>(sqlite3_column_int(selectStatement, 5));
+
+    // timestamp
+    int secondsSinceEpoch(sqlite3_column_int(selectStatement, 6));
+    boost::posix_time::ptime time(epoch + boost::posix_time::seconds(secondsSinceEpoch));
+
+    // offset from utc
+    int offset = sqlite3_column_int(selectStatement, 7);
+
+    return HistoryMessage(message, (fromJID ? *fromJID : JID()), (toJID ? *toJID : JID()), type, time, offset);
+}
+
 long long SQLiteHistoryStorage::getIDForJID(const JID& jid) {
-    boost::optional<long long> id = getIDFromJID(jid);
+    {
+        std::lock_guard<std::mutex> lock(jidCacheMutex_);
+        auto i = jidToID_.find(jid);
+        if (i != jidToID_.end()) {
+            return i->second;
+        }
+    }
+    boost::optional<long long> id = selectIDFromJID(writeSelectIDStatement_, jid);
     if (id) {
         return *id;
     }
@@ -170,51 +415,66 @@ long long SQLiteHistoryStorage::getIDForJID(const JID& jid) {
 }
 
 long long SQLiteHistoryStorage::addJID(const JID& jid) {
-    std::string statement = std::string("INSERT INTO jids('jid') VALUES('") + getEscapedString(jid.toString()) + "')";
-    char* errorMessage;
-    int result = sqlite3_exec(db_, statement.c_str(), nullptr, nullptr, &errorMessage);
-    if (result != SQLITE_OK) {
-        std::cerr << "SQL Error: " << errorMessage << std::endl;
-        sqlite3_free(errorMessage);
-    }
-    return sqlite3_last_insert_rowid(db_);
+    sqlite3_reset(insertJIDStatement_);
+    bindText(insertJIDStatement_, 1, jid.toString());
+    if (sqlite3_step(insertJIDStatement_) != SQLITE_DONE) {
+        std::cerr << "SQL Error: " << sqlite3_errmsg(writeDB_) << std::endl;
+    }
+    long long id = sqlite3_last_insert_rowid(writeDB_);
+    cacheJID(jid, id);
+    return id;
 }
 
 boost::optional<JID> SQLiteHistoryStorage::getJIDFromID(long long id) const {
-    boost::optional<JID> result;
-    sqlite3_stmt* selectStatement;
-    std::string selectQuery("SELECT jid FROM jids WHERE id=" + boost::lexical_cast<std::string>(id));
-    int r = sqlite3_prepare(db_, selectQuery.c_str(), boost::numeric_cast<int>(selectQuery.size()), &selectStatement, nullptr);
-    if (r != SQLITE_OK) {
-        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(jidCacheMutex_);
+        auto i = idToJID_.find(id);
+        if (i != idToJID_.end()) {
+            return i->second;
+        }
     }
-    r = sqlite3_step(selectStatement);
-    if (r == SQLITE_ROW) {
-        result = boost::optional<JID>(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 0)));
+    boost::optional<JID> result;
+    sqlite3_reset(selectJIDStatement_);
+    sqlite3_bind_int64(selectJIDStatement_, 1, id);
+    if (sqlite3_step(selectJIDStatement_) == SQLITE_ROW) {
+        result = boost::optional<JID>(getColumnText(selectJIDStatement_, 0));
+        cacheJID(*result, id);
     }
-    sqlite3_finalize(selectStatement);
+    sqlite3_reset(selectJIDStatement_);
     return result;
 }
 
 boost::optional<long long> SQLiteHistoryStorage::getIDFromJID(const JID& jid) const {
-    boost::optional<long long> result;
-    sqlite3_stmt* selectStatement;
-    std::string selectQuery("SELECT id FROM jids WHERE jid='" + jid.toString() + "'");
-    long long r = sqlite3_prepare(db_, selectQuery.c_str(), boost::numeric_cast<int>(selectQuery.size()), &selectStatement, nullptr);
-    if (r != SQLITE_OK) {
-        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(jidCacheMutex_);
+        auto i = jidToID_.find(jid);
+        if (i != jidToID_.end()) {
+            return i->second;
+        }
     }
-    r = sqlite3_step(selectStatement);
-    if (r == SQLITE_ROW) {
-        result = boost::optional<long long>(sqlite3_column_int(selectStatement, 0));
+    return selectIDFromJID(selectIDStatement_, jid);
+}
+
+boost::optional<long long> SQLiteHistoryStorage::selectIDFromJID(sqlite3_stmt* statement, const JID& jid) const {
+    boost::optional<long long> result;
+    sqlite3_reset(statement);
+    bindText(statement, 1, jid.toString());
+    if (sqlite3_step(statement) == SQLITE_ROW) {
+        result = boost::optional<long long>(sqlite3_column_int64(statement, 0));
+        cacheJID(jid, *result);
     }
-    sqlite3_finalize(selectStatement);
+    sqlite3_reset(statement);
     return result;
 }
 
+void SQLiteHistoryStorage::cacheJID(const JID& jid, long long id) const {
+    std::lock_guard<std::mutex> lock(jidCacheMutex_);
+    jidToID_[jid] = id;
+    idToJID_.insert(std::make_pair(id, jid));
+}
+
 ContactsMap SQLiteHistoryStorage::getContacts(const JID& selfJID, HistoryMessage::Type type, const std::string& keyword) const {
     ContactsMap result;
-    sqlite3_stmt* selectStatement;
 
     // get id
     boost::optional<long long> id = getIDFromJID(selfJID);
@@ -222,32 +482,40 @@ ContactsMap SQLiteHistoryStorage::getContacts(const JID& selfJID, HistoryMessage
         return result;
     }
 
-    // get contacts
-    std::string query = "SELECT DISTINCT messages.'fromBare', messages.'fromResource', messages.'toBare', messages.'toResource', messages.'time' "
-        "FROM messages WHERE (type="
-        + boost::lexical_cast<std::string>(type) + " AND (toBare="
-        + boost::lexical_cast<std::string>(*id) + " OR fromBare=" + boost::lexical_cast<std::string>(*id) + "))";
+    // get contacts, and the days with messages (timestamps are never before the epoch)
+    std::string query = "SELECT DISTINCT messages.'fromBare', messages.'fromResource', messages.'toBare', messages.'toResource', messages.'time' / 86400 ";
 
     // match keyword
-    if (getEscapedString(keyword).length()) {
-        query += " AND message LIKE '%" + getEscapedString(keyword) + "%'";
+    std::string fullTextQuery = getFullTextQuery(keyword);
+    if (fullTextIndex_ && !fullTextQuery.empty()) {
+        query += "FROM messages_fts JOIN messages ON messages.rowid=messages_fts.rowid WHERE messages_fts MATCH ?3 AND (type=?1 AND (toBare=?2 OR fromBare=?2))";
+    }
+    else {
+        query += "FROM messages WHERE (type=?1 AND (toBare=?2 OR fromBare=?2))";
+        if (!keyword.empty()) {
+            query += " AND message LIKE ?3 ESCAPE '\\'";
+        }
     }
 
-    int r = sqlite3_prepare(db_, query.c_str(), boost::numeric_cast<int>(query.size()), &selectStatement, nullptr);
-    if (r != SQLITE_OK) {
-        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
+    sqlite3_stmt* selectStatement = prepareStatement(db_, query);
+    sqlite3_bind_int(selectStatement, 1, type);
+    sqlite3_bind_int64(selectStatement, 2, *id);
+    if (fullTextIndex_ && !fullTextQuery.empty()) {
+        bindText(selectStatement, 3, fullTextQuery);
+    }
+    else if (!keyword.empty()) {
+        bindText(selectStatement, 3, getLikePattern(keyword));
     }
 
-    r = sqlite3_step(selectStatement);
+    int r = sqlite3_step(selectStatement);
     while (r == SQLITE_ROW) {
-        int fromBareID = sqlite3_column_int(selectStatement, 0);
-        std::string fromResource(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 1)));
-        int toBareID = sqlite3_column_int(selectStatement, 2);
-        std::string toResource(reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, 3)));
+        long long fromBareID = sqlite3_column_int64(selectStatement, 0);
+        std::string fromResource(getColumnText(selectStatement, 1));
+        long long toBareID = sqlite3_column_int64(selectStatement, 2);
+        std::string toResource(getColumnText(selectStatement, 3));
         std::string resource;
 
-        int secondsSinceEpoch(sqlite3_column_int(selectStatement, 4));
-        boost::posix_time::ptime time(boost::gregorian::date(1970, 1, 1), boost::posix_time::seconds(secondsSinceEpoch));
+        boost::gregorian::date date(epoch.date() + boost::gregorian::days(sqlite3_column_int(selectStatement, 4)));
 
         boost::optional<JID> contactJID;
 
@@ -261,12 +529,12 @@ ContactsMap SQLiteHistoryStorage::getContacts(const JID& selfJID, HistoryMessage
         }
 
         // check if it is a MUC contact (from a private conversation)
-        if (type == HistoryMessage::PrivateMessage) {
+        if (contactJID && type == HistoryMessage::PrivateMessage) {
             contactJID = boost::optional<JID>(JID(contactJID->getNode(), contactJID->getDomain(), resource));
         }
 
         if (contactJID) {
-            result[*contactJID].insert(time.date());
+            result[*contactJID].insert(date);
         }
 
         r = sqlite3_step(selectStatement);
@@ -281,7 +549,6 @@ ContactsMap SQLiteHistoryStorage::getContacts(const JID& selfJID, HistoryMessage
 }
 
 boost::gregorian::date SQLiteHistoryStorage::getNextDateWithLogs(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date, bool reverseOrder) const {
-    sqlite3_stmt* selectStatement;
     boost::optional<long long> selfID = getIDFromJID(selfJID.toBare());
     boost::optional<long long> contactID = getIDFromJID(contactJID.toBare());
 
@@ -290,42 +557,29 @@ boost::gregorian::date SQLiteHistoryStorage::getNextDateWithLogs(const JID& self
         return boost::gregorian::date(boost::gregorian::not_a_date_time);
     }
 
-    std::string selectQuery = "SELECT time FROM messages WHERE (type=" + boost::lexical_cast<std::string>(type);
-    if (contactJID.isBare()) {
-        // match only bare jid
-        selectQuery += " AND ((fromBare=" + boost::lexical_cast<std::string>(*selfID) + " AND toBare=" +
-                boost::lexical_cast<std::string>(*contactID) + ") OR (fromBare=" +
-                boost::lexical_cast<std::string>(*contactID) + " AND toBare=" + boost::lexical_cast<std::string>(*selfID) + ")))";
-    }
-    else {
-        // match resource too
-        selectQuery += " AND ((fromBare=" + boost::lexical_cast<std::string>(*selfID) + " AND (toBare=" +
-                boost::lexical_cast<std::string>(*contactID) +" AND toResource='" +
-                getEscapedString(contactJID.getResource()) + "')) OR ((fromBare=" +
-                boost::lexical_cast<std::string>(*contactID) + " AND fromResource='" +
-                getEscapedString(contactJID.getResource()) + "') AND toBare=" +
-                boost::lexical_cast<std::string>(*selfID) + ")))";
-    }
-
-    int timeStamp = (boost::posix_time::ptime(date) - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_seconds() + (reverseOrder ? 0 : 86400);
-
-    selectQuery += " AND time" + (reverseOrder ? std::string("<") : std::string(">")) + boost::lexical_cast<std::string>(timeStamp);
+    std::string selectQuery = "SELECT time FROM messages WHERE type=?4 AND " + getConversationCondition(!contactJID.isBare());
+    selectQuery += " AND time" + (reverseOrder ? std::string("<") : std::string(">")) + "?5";
     selectQuery += " ORDER BY time " + (reverseOrder ? std::string("DESC") : std::string("ASC")) + " LIMIT 1";
 
-    int r = sqlite3_prepare(db_, selectQuery.c_str(), boost::numeric_cast<int>(selectQuery.size()), &selectStatement, nullptr);
-    if (r != SQLITE_OK) {
-        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
+    sqlite3_stmt* selectStatement = prepareStatement(db_, selectQuery);
+    sqlite3_bind_int64(selectStatement, 1, *selfID);
+    sqlite3_bind_int64(selectStatement, 2, *contactID);
+    if (!contactJID.isBare()) {
+        bindText(selectStatement, 3, contactJID.getResource());
     }
+    sqlite3_bind_int(selectStatement, 4, type);
+    int timeStamp = (boost::posix_time::ptime(date) - epoch).total_seconds() + (reverseOrder ? 0 : 86400);
+    sqlite3_bind_int(selectStatement, 5, timeStamp);
 
-    r = sqlite3_step(selectStatement);
-    if (r == SQLITE_ROW) {
+    boost::gregorian::date result(boost::gregorian::not_a_date_time);
+    if (sqlite3_step(selectStatement) == SQLITE_ROW) {
         int secondsSinceEpoch(sqlite3_column_int(selectStatement, 0));
-        boost::posix_time::ptime time(boost::gregorian::date(1970, 1, 1), boost::posix_time::seconds(secondsSinceEpoch));
-        std::cout << "next day is: " << time.date() << "\n";
-        return time.date();
+        boost::posix_time::ptime time(epoch + boost::posix_time::seconds(secondsSinceEpoch));
+        result = time.date();
     }
+    sqlite3_finalize(selectStatement);
 
-    return boost::gregorian::date(boost::gregorian::not_a_date_time);
+    return result;
 }
 
 std::vector<HistoryMessage> SQLiteHistoryStorage::getMessagesFromNextDate(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date) const {
@@ -357,30 +611,21 @@ boost::posix_time::ptime SQLiteHistoryStorage::getLastTimeStampFromMUC(const JID
         return boost::posix_time::ptime(boost::posix_time::not_a_date_time);
     }
 
+    sqlite3_stmt* selectStatement = prepareStatement(db_, "SELECT messages.'time', messages.'offset' from messages WHERE toBare=?1 AND fromBare=?2 AND type=1 ORDER BY time DESC LIMIT 1");
+    sqlite3_bind_int64(selectStatement, 1, *selfID);
+    sqlite3_bind_int64(selectStatement, 2, *mucID);
 
-    sqlite3_stmt* selectStatement;
-    std::string selectQuery = "SELECT messages.'time', messages.'offset' from messages WHERE type=1 AND (toBare=" +
-                boost::lexical_cast<std::string>(*selfID) + " AND fromBare=" +
-                boost::lexical_cast<std::string>(*mucID) + ") ORDER BY time DESC LIMIT 1";
-
-    int r = sqlite3_prepare(db_, selectQuery.c_str(), boost::numeric_cast<int>(selectQuery.size()), &selectStatement, nullptr);
-    if (r != SQLITE_OK) {
-        std::cout << "Error: " << sqlite3_errmsg(db_) << std::endl;
-    }
-
-    r = sqlite3_step(selectStatement);
-    if (r == SQLITE_ROW) {
+    boost::posix_time::ptime result(boost::posix_time::not_a_date_time);
+    if (sqlite3_step(selectStatement) == SQLITE_ROW) {
         int secondsSinceEpoch(sqlite3_column_int(selectStatement, 0));
-        boost::posix_time::ptime time(boost::gregorian::date(1970, 1, 1), boost::posix_time::seconds(secondsSinceEpoch));
+        boost::posix_time::ptime time(epoch + boost::posix_time::seconds(secondsSinceEpoch));
         int offset = sqlite3_column_int(selectStatement, 1);
 
-        return time - boost::posix_time::hours(offset);
+        result = time - boost::posix_time::hours(offset);
     }
+    sqlite3_finalize(selectStatement);
 
-    return boost::posix_time::ptime(boost::posix_time::not_a_date_time);
-}
-
-void SQLiteHistoryStorage::run() {
+    return result;
 }
 
 }
@@ -1,12 +1,17 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <boost/filesystem/path.hpp>
 #include <boost/optional.hpp>
@@ -15,8 +20,22 @@
 #include <Swiften/History/HistoryStorage.h>
 
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace Swift {
+    /**
+     * Stores the history in an SQLite database.
+     *
+     * Added messages are queued, and written by a storage thread in one
+     * transaction per batch, so adding messages never blocks on the disk.
+     * Queries are run on the caller's thread, using a separate connection
+     * (the database uses write-ahead logging, so reads do not wait for writes).
+     * An in-memory database (":memory:") is private to the storage, and shared
+     * by both connections.
+     * Keyword searches use an FTS5 full-text index if SQLite supports it.
+     * Messages that are still queued are not returned by queries; use
+     * \ref flush() to wait for them to be written.
+     */
     class SWIFTEN_API SQLiteHistoryStorage : public HistoryStorage {
         public:
             SQLiteHistoryStorage(const boost::filesystem::path& file);
@@ -28,17 +47,52 @@ namespace Swift {
             std::vector<HistoryMessage> getMessagesFromNextDate(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date) const;
             std::vector<HistoryMessage> getMessagesFromPreviousDate(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date) const;
             boost::posix_time::ptime getLastTimeStampFromMUC(const JID& selfJID, const JID& mucJID) const;
+            std::vector<HistoryMessage> searchMessages(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const std::string& keyword, const boost::posix_time::ptime& before, int maxResults) const;
+
+            /**
+             * Blocks until all added messages are written to the database.
+             */
+            void flush();
 
         private:
             void run();
+            void writeMessages(const std::vector<HistoryMessage>& messages);
+            HistoryMessage getMessage(sqlite3_stmt* selectStatement) const;
             boost::gregorian::date getNextDateWithLogs(const JID& selfJID, const JID& contactJID, HistoryMessage::Type type, const boost::gregorian::date& date, bool reverseOrder) const;
             long long getIDForJID(const JID&);
             long long addJID(const JID&);
 
             boost::optional<JID> getJIDFromID(long long id) const;
             boost::optional<long long> getIDFromJID(const JID& jid) const;
+            boost::optional<long long> selectIDFromJID(sqlite3_stmt* statement, const JID& jid) const;
+            void cacheJID(const JID& jid, long long id) const;
+
+            sqlite3_stmt* prepareStatement(sqlite3* db, const std::string& query) const;
+            void execute(sqlite3* db, const std::string& statement);
+
+            bool fullTextIndex_;
+            bool rebuildFullTextIndex_;
 
+            // Queries run on the caller's thread
             sqlite3* db_;
+            sqlite3_stmt* selectJIDStatement_;
+            sqlite3_stmt* selectIDStatement_;
+
+            // Writes only happen on the storage thread
+            sqlite3* writeDB_;
+            sqlite3_stmt* insertMessageStatement_;
+            sqlite3_stmt* insertJIDStatement_;
+            sqlite3_stmt* writeSelectIDStatement_;
+
+            mutable std::mutex jidCacheMutex_;
+            mutable std::unordered_map<JID, long long> jidToID_;
+            mutable std::unordered_map<long long, JID> idToJID_;
+
+            std::mutex queueMutex_;
+            std::condition_variable queueChanged_;
+            std::vector<HistoryMessage> pendingMessages_;
+            bool writing_;
+            bool stopping_;
             std::thread* thread_;
     };
 }
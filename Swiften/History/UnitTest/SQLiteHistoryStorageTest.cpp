@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/History/SQLiteHistoryStorage.h>
+
+using namespace Swift;
+
+class SQLiteHistoryStorageTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(SQLiteHistoryStorageTest);
+        CPPUNIT_TEST(testGetMessagesFromDate_InterleavedDirections);
+        CPPUNIT_TEST(testGetMessagesFromDate_SameSecond);
+        CPPUNIT_TEST(testGetMessagesFromDate_InMemory);
+        CPPUNIT_TEST(testSearchMessages_ReturnsNewestMatches);
+        CPPUNIT_TEST(testSearchMessages_PageIncludesMatchesFromSameSecond);
+        CPPUNIT_TEST(testSearchMessages_RanksByRelevance);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("history-%%%%-%%%%.db");
+            start = boost::posix_time::ptime(boost::gregorian::date(2017, 3, 1), boost::posix_time::hours(12));
+        }
+
+        void tearDown() {
+            boost::filesystem::remove(file);
+            boost::filesystem::remove(file.string() + "-wal");
+            boost::filesystem::remove(file.string() + "-shm");
+        }
+
+        void testGetMessagesFromDate_InterleavedDirections() {
+            std::unique_ptr<SQLiteHistoryStorage> testling(new SQLiteHistoryStorage(file));
+            for (int i = 0; i < 10; ++i) {
+                testling->addMessage(createMessage(i, i % 2 == 0, start + boost::posix_time::seconds(i)));
+            }
+            testling->flush();
+
+            std::vector<HistoryMessage> messages = testling->getMessagesFromDate(self, contact, HistoryMessage::Chat, start.date());
+
+            CPPUNIT_ASSERT_EQUAL(10, static_cast<int>(messages.size()));
+            for (int i = 0; i < 10; ++i) {
+                CPPUNIT_ASSERT_EQUAL("m" + std::to_string(i), messages[i].getMessage());
+            }
+        }
+
+        void testGetMessagesFromDate_SameSecond() {
+            std::unique_ptr<SQLiteHistoryStorage> testling(new SQLiteHistoryStorage(file));
+            testling->addMessage(createMessage(0, false, start));
+            testling->addMessage(createMessage(1, true, start));
+            testling->addMessage(createMessage(2, false, start));
+            testling->flush();
+
+            std::vector<HistoryMessage> messages = testling->getMessagesFromDate(self, contact, HistoryMessage::Chat, start.date());
+
+            CPPUNIT_ASSERT_EQUAL(3, static_cast<int>(messages.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("m0"), messages[0].getMessage());
+            CPPUNIT_ASSERT_EQUAL(std::string("m1"), messages[1].getMessage());
+            CPPUNIT_ASSERT_EQUAL(std::string("m2"), messages[2].getMessage());
+        }
+
+        void testGetMessagesFromDate_InMemory() {
+            std::unique_ptr<SQLiteHistoryStorage> testling(new SQLiteHistoryStorage(":memory:"));
+            std::unique_ptr<SQLiteHistoryStorage> otherStorage(new SQLiteHistoryStorage(":memory:"));
+            testling->addMessage(createMessage(0, false, start));
+            testling->addMessage(createMessage(1, true, start + boost::posix_time::seconds(1)));
+            testling->flush();
+
+            std::vector<HistoryMessage> messages = testling->getMessagesFromDate(self, contact, HistoryMessage::Chat, start.date());
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(messages.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("m0"), messages[0].getMessage());
+            CPPUNIT_ASSERT_EQUAL(std::string("m1"), messages[1].getMessage());
+            CPPUNIT_ASSERT(otherStorage->getMessagesFromDate(self, contact, HistoryMessage::Chat, start.date()).empty());
+        }
+
+        void testSearchMessages_ReturnsNewestMatches() {
+            std::unique_ptr<SQLiteHistoryStorage> testling(new SQLiteHistoryStorage(file));
+            for (int i = 0; i < 5; ++i) {
+                testling->addMessage(createMessage("apple " + std::to_string(i), start + boost::posix_time::seconds(i)));
+                testling->addMessage(createMessage("pear " + std::to_string(i), start + boost::posix_time::seconds(i)));
+            }
+            testling->flush();
+
+            std::vector<HistoryMessage> messages = testling->searchMessages(self, contact, HistoryMessage::Chat, "apple", boost::posix_time::ptime(boost::posix_time::not_a_date_time), 2);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(messages.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("apple 4"), messages[0].getMessage());
+            CPPUNIT_ASSERT_EQUAL(std::string("apple 3"), messages[1].getMessage());
+
+            messages = testling->searchMessages(self, contact, HistoryMessage::Chat, "apple", start + boost::posix_time::seconds(3), 2);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(messages.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("apple 2"), messages[0].getMessage());
+            CPPUNIT_ASSERT_EQUAL(std::string("apple 1"), messages[1].getMessage());
+        }
+
+        void testSearchMessages_PageIncludesMatchesFromSameSecond() {
+            std::unique_ptr<SQLiteHistoryStorage> testling(new SQLiteHistoryStorage(file));
+            testling->addMessage(createMessage("apple 0", start));
+            testling->addMessage(createMessage("apple 1", start + boost::posix_time::seconds(1)));
+            testling->addMessage(createMessage("apple 2", start + boost::posix_time::seconds(1)));
+            testling->flush();
+
+            std::vector<HistoryMessage> messages = testling->searchMessages(self, contact, HistoryMessage::Chat, "apple", boost::posix_time::ptime(boost::posix_time::not_a_date_time), 1);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(messages.size()));
+        }
+
+        void testSearchMessages_RanksByRelevance() {
+            std::unique_ptr<SQLiteHistoryStorage> testling(new SQLiteHistoryStorage(file));
+            testling->addMessage(createMessage("apple apple apple", start));
+            testling->addMessage(createMessage("an apple in a long message about many other things", start + boost::posix_time::seconds(1)));
+            testling->flush();
+
+            std::vector<HistoryMessage> messages = testling->searchMessages(self, contact, HistoryMessage::Chat, "apple", boost::posix_time::ptime(boost::posix_time::not_a_date_time), 10);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(messages.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("apple apple apple"), messages[0].getMessage());
+        }
+
+    private:
+        HistoryMessage createMessage(int index, bool sent, const boost::posix_time::ptime& time) {
+            return HistoryMessage("m" + std::to_string(index), sent ? self : contact, sent ? contact : self, HistoryMessage::Chat, time);
+        }
+
+        HistoryMessage createMessage(const std::string& text, const boost::posix_time::ptime& time) {
+            return HistoryMessage(text, contact, self, HistoryMessage::Chat, time);
+        }
+
+    private:
+        const JID self = JID("self@example.com/swift");
+        const JID contact = JID("contact@example.com/resource");
+        boost::filesystem::path file;
+        boost::posix_time::ptime start;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SQLiteHistoryStorageTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2012-2016 Isode Limited.
+ * Copyright (c) 2012-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -44,7 +44,8 @@ namespace {
             return ContainerType();
         }
 
-        input.resize(MAX_STRINGPREP_SIZE);
+        // stringprep() needs the input to be null-terminated
+        input.resize(MAX_STRINGPREP_SIZE, 0);
         if (stringprep(&input[0], MAX_STRINGPREP_SIZE, static_cast<Stringprep_profile_flags>(0), getLibIDNProfile(profile)) == 0) {
             return input;
         }
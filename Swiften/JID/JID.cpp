@@ -1,19 +1,18 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #define SWIFTEN_CACHE_JID_PREP
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
 #include <sstream>
 #include <string>
-#include <vector>
-
-#ifdef SWIFTEN_CACHE_JID_PREP
-#include <mutex>
 #include <unordered_map>
-#endif
+#include <vector>
 
 #include <boost/optional.hpp>
 
@@ -29,14 +28,88 @@
 using namespace Swift;
 
 #ifdef SWIFTEN_CACHE_JID_PREP
-typedef std::unordered_map<std::string, std::string> PrepCache;
+static const size_t prepCacheCapacity = 65536;
 
-static std::mutex namePrepCacheMutex;
-static PrepCache nodePrepCache;
-static PrepCache domainPrepCache;
-static PrepCache resourcePrepCache;
+namespace {
+    struct PrepCaches {
+        PrepCaches() : node(prepCacheCapacity), domain(prepCacheCapacity), resource(prepCacheCapacity) {}
+
+        JIDPrepCache node;
+        JIDPrepCache domain;
+        JIDPrepCache resource;
+    };
+
+    // Created on first use and never destroyed, so JIDs with static storage duration can use it.
+    PrepCaches& getPrepCaches() {
+        static PrepCaches* caches = new PrepCaches();
+        return *caches;
+    }
+}
 #endif
 
+namespace {
+    /**
+     * Interns JID domains. The pool only holds weak references, so a domain is
+     * dropped from it when the last JID using it goes away.
+     */
+    class DomainPool {
+        public:
+            std::shared_ptr<const std::string> intern(const std::string& domain) {
+                Shard& shard = getShard(domain);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                std::weak_ptr<const std::string>& entry = shard.domains[domain];
+                std::shared_ptr<const std::string> result = entry.lock();
+                if (!result) {
+                    result = std::shared_ptr<const std::string>(new std::string(domain), [this](const std::string* domain) { release(domain); });
+                    entry = result;
+                }
+                return result;
+            }
+
+        private:
+            struct Shard {
+                std::mutex mutex;
+                std::unordered_map<std::string, std::weak_ptr<const std::string> > domains;
+            };
+
+            Shard& getShard(const std::string& domain) {
+                return shards_[(std::hash<std::string>()(domain) >> 16) % shardCount];
+            }
+
+            void release(const std::string* domain) {
+                {
+                    Shard& shard = getShard(*domain);
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    auto i = shard.domains.find(*domain);
+                    // The domain may have been interned again since the last reference was dropped.
+                    if (i != shard.domains.end() && i->second.expired()) {
+                        shard.domains.erase(i);
+                    }
+                }
+                delete domain;
+            }
+
+        private:
+            static const size_t shardCount = 16;
+            Shard shards_[shardCount];
+    };
+
+    // Created on first use and never destroyed, so JIDs with static storage duration can use it.
+    DomainPool& getDomainPool() {
+        static DomainPool* pool = new DomainPool();
+        return *pool;
+    }
+
+    const std::shared_ptr<const std::string>& getEmptyDomain() {
+        static const std::shared_ptr<const std::string>* emptyDomain = new std::shared_ptr<const std::string>(std::make_shared<const std::string>());
+        return *emptyDomain;
+    }
+
+    std::uint32_t combineHash(std::uint32_t seed, size_t hash) {
+        return seed ^ (static_cast<std::uint32_t>(hash) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    }
+}
+
 static const std::vector<char> escapedChars = {' ', '"', '&', '\'', '/', '<', '>', '@', ':'};
 
 static IDNConverter* idnConverter = nullptr;
@@ -65,26 +138,133 @@ static bool getEscapeSequenceValue(const std::string& sequence, unsigned char& v
     return (!s.fail() && !s.bad() && (value == 0x5C || std::find(escapedChars.begin(), escapedChars.end(), value) != escapedChars.end()));
 }
 
+static bool isDomainLabelCharacter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-';
+}
+
+/**
+ * Returns true if \p s consists of ASCII characters that \p profile maps to
+ * themselves, so preparing it would return it unchanged. For domains, this
+ * also requires that \p s is accepted by IDNA ToASCII with the STD3 rules.
+ * Anything else (including ACE labels) is left to the IDN converter.
+ */
+static bool isPreparedASCII(const std::string& s, IDNConverter::StringPrepProfile profile) {
+    switch (profile) {
+        case IDNConverter::XMPPNodePrep:
+            for (char c : s) {
+                if (c <= ' ' || c > '~' || (c >= 'A' && c <= 'Z')) {
+                    return false;
+                }
+                // Characters prohibited by Nodeprep
+                switch (c) {
+                    case '"': case '&': case '\'': case '/': case ':': case '<': case '>': case '@':
+                        return false;
+                }
+            }
+            return true;
+        case IDNConverter::XMPPResourcePrep:
+            for (char c : s) {
+                if (c < ' ' || c > '~') {
+                    return false;
+                }
+            }
+            return true;
+        case IDNConverter::NamePrep: {
+            if (s.size() > 253) {
+                return false;
+            }
+            size_t labelStart = 0;
+            while (true) {
+                size_t labelEnd = s.find('.', labelStart);
+                if (labelEnd == std::string::npos) {
+                    labelEnd = s.size();
+                }
+                size_t labelSize = labelEnd - labelStart;
+                if (labelSize == 0 || labelSize > 63 || s[labelStart] == '-' || s[labelEnd - 1] == '-' || s.compare(labelStart, 4, "xn--") == 0) {
+                    return false;
+                }
+                for (size_t i = labelStart; i < labelEnd; ++i) {
+                    if (!isDomainLabelCharacter(s[i])) {
+                        return false;
+                    }
+                }
+                if (labelEnd == s.size()) {
+                    return true;
+                }
+                labelStart = labelEnd + 1;
+            }
+        }
+        case IDNConverter::SASLPrep:
+            break;
+    }
+    return false;
+}
+
+static bool prepare(const std::string& s, IDNConverter::StringPrepProfile profile, std::string& result) {
+    if (isPreparedASCII(s, profile)) {
+        result = s;
+        return true;
+    }
+    try {
+        if (profile == IDNConverter::NamePrep && !idnConverter->getIDNAEncoded(s)) {
+            return false;
+        }
+        result = idnConverter->getStringPrepared(s, profile);
+    }
+    catch (...) {
+        return false;
+    }
+    return true;
+}
+
+#ifdef SWIFTEN_CACHE_JID_PREP
+static bool prepareCached(JIDPrepCache& cache, const std::string& s, IDNConverter::StringPrepProfile profile, std::string& result) {
+    if (isPreparedASCII(s, profile)) {
+        result = s;
+        return true;
+    }
+    if (cache.get(s, result)) {
+        return true;
+    }
+    // Prepare outside of the cache locks; failures are not cached.
+    if (!prepare(s, profile, result)) {
+        return false;
+    }
+    cache.put(s, result);
+    return true;
+}
+#endif
+
 namespace Swift {
 
-JID::JID(const char* jid) : valid_(true) {
+JID::JID(const char* jid) : domain_(getEmptyDomain()), valid_(true), hasResource_(false) {
     assert(jid);
     initializeFromString(std::string(jid));
+    updateHashes();
 }
 
-JID::JID(const std::string& jid) : valid_(true) {
+JID::JID(const std::string& jid) : domain_(getEmptyDomain()), valid_(true), hasResource_(false) {
     initializeFromString(jid);
+    updateHashes();
 }
 
-JID::JID(const std::string& node, const std::string& domain) : valid_(true), hasResource_(false) {
+JID::JID(const std::string& node, const std::string& domain) : domain_(getEmptyDomain()), valid_(true), hasResource_(false) {
     nameprepAndSetComponents(node, domain, "");
+    updateHashes();
 }
 
-JID::JID(const std::string& node, const std::string& domain, const std::string& resource) : valid_(true), hasResource_(true) {
+JID::JID(const std::string& node, const std::string& domain, const std::string& resource) : domain_(getEmptyDomain()), valid_(true), hasResource_(true) {
     if (resource.empty()) {
         valid_ = false;
     }
     nameprepAndSetComponents(node, domain, resource);
+    updateHashes();
+}
+
+void JID::updateHashes() {
+    std::hash<std::string> hashString;
+    bareHash_ = combineHash(combineHash(0, hashString(node_)), hashString(*domain_));
+    hash_ = hasResource_ ? combineHash(bareHash_, hashString(resource_)) : bareHash_;
 }
 
 void JID::initializeFromString(const std::string& jid) {
@@ -115,7 +295,7 @@ void JID::initializeFromString(const std::string& jid) {
 
 
 void JID::nameprepAndSetComponents(const std::string& node, const std::string& domain, const std::string& resource) {
-    if (domain.empty() || !idnConverter->getIDNAEncoded(domain)) {
+    if (domain.empty()) {
         valid_ = false;
         return;
     }
@@ -124,59 +304,25 @@ void JID::nameprepAndSetComponents(const std::string& node, const std::string& d
         valid_ = false;
         return;
     }
-#ifndef SWIFTEN_CACHE_JID_PREP
-    node_ = idnConverter->getStringPrepared(node, IDNConverter::XMPPNodePrep);
-    domain_ = idnConverter->getStringPrepared(domain, IDNConverter::NamePrep);
-    resource_ = idnConverter->getStringPrepared(resource, IDNConverter::XMPPResourcePrep);
-#else
-    std::unique_lock<std::mutex> lock(namePrepCacheMutex);
 
-    std::pair<PrepCache::iterator, bool> r;
-
-    r = nodePrepCache.insert(std::make_pair(node, std::string()));
-    if (r.second) {
-        try {
-            r.first->second = idnConverter->getStringPrepared(node, IDNConverter::XMPPNodePrep);
-        }
-        catch (...) {
-            nodePrepCache.erase(r.first);
-            valid_ = false;
-            return;
-        }
-    }
-    node_ = r.first->second;
-
-    r = domainPrepCache.insert(std::make_pair(domain, std::string()));
-    if (r.second) {
-        try {
-            r.first->second = idnConverter->getStringPrepared(domain, IDNConverter::NamePrep);
-        }
-        catch (...) {
-            domainPrepCache.erase(r.first);
-            valid_ = false;
-            return;
-        }
+    std::string preparedDomain;
+#ifndef SWIFTEN_CACHE_JID_PREP
+    if (!prepare(domain, IDNConverter::NamePrep, preparedDomain) || !prepare(node, IDNConverter::XMPPNodePrep, node_) || !prepare(resource, IDNConverter::XMPPResourcePrep, resource_)) {
+        valid_ = false;
+        return;
     }
-    domain_ = r.first->second;
-
-    r = resourcePrepCache.insert(std::make_pair(resource, std::string()));
-    if (r.second) {
-        try {
-            r.first->second = idnConverter->getStringPrepared(resource, IDNConverter::XMPPResourcePrep);
-        }
-        catch (...) {
-            resourcePrepCache.erase(r.first);
-            valid_ = false;
-            return;
-        }
+#else
+    if (!prepareCached(getPrepCaches().domain, domain, IDNConverter::NamePrep, preparedDomain) || !prepareCached(getPrepCaches().node, node, IDNConverter::XMPPNodePrep, node_) || !prepareCached(getPrepCaches().resource, resource, IDNConverter::XMPPResourcePrep, resource_)) {
+        valid_ = false;
+        return;
     }
-    resource_ = r.first->second;
 #endif
 
-    if (domain_.empty()) {
+    if (preparedDomain.empty()) {
         valid_ = false;
         return;
     }
+    domain_ = getDomainPool().intern(preparedDomain);
 }
 
 std::string JID::toString() const {
@@ -184,7 +330,7 @@ std::string JID::toString() const {
     if (!node_.empty()) {
         string += node_ + "@";
     }
-    string += domain_;
+    string += *domain_;
     if (!isBare()) {
         string += "/" + resource_;
     }
@@ -194,8 +340,13 @@ std::string JID::toString() const {
 int JID::compare(const Swift::JID& o, CompareType compareType) const {
     if (node_ < o.node_) { return -1; }
     if (node_ > o.node_) { return 1; }
-    if (domain_ < o.domain_) { return -1; }
-    if (domain_ > o.domain_) { return 1; }
+    // Interned domains are equal if they are the same object.
+    if (domain_ != o.domain_) {
+        int domainComparison = domain_->compare(*o.domain_);
+        if (domainComparison != 0) {
+            return domainComparison < 0 ? -1 : 1;
+        }
+    }
     if (compareType == WithResource) {
         if (hasResource_ != o.hasResource_) {
             return hasResource_ ? 1 : -1;
@@ -254,6 +405,21 @@ void JID::setIDNConverter(IDNConverter* converter) {
     idnConverter = converter;
 }
 
+JIDPrepCache::Statistics JID::getPrepCacheStatistics() {
+    JIDPrepCache::Statistics statistics;
+#ifdef SWIFTEN_CACHE_JID_PREP
+    PrepCaches& caches = getPrepCaches();
+    for (const JIDPrepCache* cache : {&caches.node, &caches.domain, &caches.resource}) {
+        JIDPrepCache::Statistics cacheStatistics = cache->getStatistics();
+        statistics.hits += cacheStatistics.hits;
+        statistics.misses += cacheStatistics.misses;
+        statistics.evictions += cacheStatistics.evictions;
+        statistics.size += cacheStatistics.size;
+    }
+#endif
+    return statistics;
+}
+
 std::ostream& operator<<(std::ostream& os, const JID& j) {
     os << j.toString();
     return os;
@@ -1,17 +1,21 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
 
 #include <boost/optional/optional.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/JID/JIDPrepCache.h>
 
 namespace Swift {
     class IDNConverter;
@@ -26,6 +30,11 @@ namespace Swift {
      *
      * A JID can be invalid (when isValid() returns false). No member methods are
      * guaranteed to work correctly if they do.
+     *
+     * Domains are interned, so JIDs of the same domain share a single copy of it.
+     * The hashes of the bare and full JID are computed once on construction, which
+     * makes hashing a JID (see std::hash<Swift::JID>) constant time, and lets
+     * comparisons of different JIDs fail fast.
      */
     class SWIFTEN_API JID {
         public:
@@ -94,7 +103,7 @@ namespace Swift {
              * e.g. JID("node@domain").getDomain() == "domain"
              */
             const std::string& getDomain() const {
-                return domain_;
+                return *domain_;
             }
 
             /**
@@ -132,6 +141,7 @@ namespace Swift {
                 JID result(*this);
                 result.hasResource_ = false;
                 result.resource_ = "";
+                result.hash_ = bareHash_;
                 return result;
             }
 
@@ -146,9 +156,19 @@ namespace Swift {
             std::string toString() const;
 
             bool equals(const JID& o, CompareType compareType) const {
+                if ((compareType == WithResource ? hash_ != o.hash_ : bareHash_ != o.bareHash_)) {
+                    return false;
+                }
                 return compare(o, compareType) == 0;
             }
 
+            /**
+             * Returns the (precomputed) hash of the JID, consistent with operator==.
+             */
+            size_t getHash() const {
+                return hash_;
+            }
+
             int compare(const JID& o, CompareType compareType) const;
 
             operator std::string() const {
@@ -162,11 +182,11 @@ namespace Swift {
             SWIFTEN_API friend std::ostream& operator<<(std::ostream& os, const Swift::JID& j);
 
             friend bool operator==(const Swift::JID& a, const Swift::JID& b) {
-                return a.compare(b, Swift::JID::WithResource) == 0;
+                return a.equals(b, Swift::JID::WithResource);
             }
 
             friend bool operator!=(const Swift::JID& a, const Swift::JID& b) {
-                return a.compare(b, Swift::JID::WithResource) != 0;
+                return !a.equals(b, Swift::JID::WithResource);
             }
 
             /**
@@ -182,17 +202,36 @@ namespace Swift {
              */
             static void setIDNConverter(IDNConverter*);
 
+            /**
+             * Returns the combined hit, miss and eviction counts of the caches used to
+             * stringprep JID parts. Parts that are already prepared ASCII bypass the
+             * caches, and are not counted.
+             */
+            static JIDPrepCache::Statistics getPrepCacheStatistics();
+
         private:
             void nameprepAndSetComponents(const std::string& node, const std::string& domain, const std::string& resource);
             void initializeFromString(const std::string&);
+            void updateHashes();
 
         private:
-            bool valid_;
             std::string node_;
-            std::string domain_;
-            bool hasResource_;
+            std::shared_ptr<const std::string> domain_;
             std::string resource_;
+            std::uint32_t bareHash_;
+            std::uint32_t hash_;
+            bool valid_;
+            bool hasResource_;
     };
 
     SWIFTEN_API std::ostream& operator<<(std::ostream& os, const Swift::JID& j);
 }
+
+namespace std {
+    template<>
+    struct hash<Swift::JID> {
+        size_t operator()(const Swift::JID& jid) const {
+            return jid.getHash();
+        }
+    };
+}
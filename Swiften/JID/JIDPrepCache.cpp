@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/JID/JIDPrepCache.h>
+
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace Swift {
+
+namespace {
+    struct Entry {
+        Entry(const std::string& value) : value(value), referenced(false) {}
+
+        std::string value;
+        bool referenced;
+    };
+    typedef std::unordered_map<std::string, Entry> EntryMap;
+}
+
+struct JIDPrepCache::Shard {
+    Shard() : hand(0), hits(0), misses(0), evictions(0) {}
+
+    std::mutex mutex;
+    EntryMap entries;
+    // The CLOCK ring; map nodes (and thus these pointers) are stable across rehashes.
+    std::vector<EntryMap::value_type*> clock;
+    size_t hand;
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t evictions;
+};
+
+JIDPrepCache::JIDPrepCache(size_t capacity, size_t shardCount) {
+    assert(shardCount > 0);
+    shardCapacity_ = std::max<size_t>(1, capacity / shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::unique_ptr<Shard>(new Shard()));
+    }
+}
+
+JIDPrepCache::~JIDPrepCache() {
+}
+
+JIDPrepCache::Shard& JIDPrepCache::getShard(const std::string& key) {
+    // Use other hash bits than the ones the shard's own map uses to pick a bucket.
+    size_t hash = std::hash<std::string>()(key);
+    return *shards_[(hash >> 16) % shards_.size()];
+}
+
+bool JIDPrepCache::get(const std::string& key, std::string& value) {
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    EntryMap::iterator i = shard.entries.find(key);
+    if (i == shard.entries.end()) {
+        shard.misses++;
+        return false;
+    }
+    shard.hits++;
+    i->second.referenced = true;
+    value = i->second.value;
+    return true;
+}
+
+void JIDPrepCache::put(const std::string& key, const std::string& value) {
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.find(key) != shard.entries.end()) {
+        // Another thread prepared the same string concurrently.
+        return;
+    }
+
+    if (shard.clock.size() < shardCapacity_) {
+        shard.clock.push_back(&*shard.entries.insert(std::make_pair(key, Entry(value))).first);
+        return;
+    }
+
+    // Give referenced entries a second chance, and replace the first unreferenced one.
+    while (shard.clock[shard.hand]->second.referenced) {
+        shard.clock[shard.hand]->second.referenced = false;
+        shard.hand = (shard.hand + 1) % shard.clock.size();
+    }
+    shard.entries.erase(shard.clock[shard.hand]->first);
+    shard.evictions++;
+    shard.clock[shard.hand] = &*shard.entries.insert(std::make_pair(key, Entry(value))).first;
+    shard.hand = (shard.hand + 1) % shard.clock.size();
+}
+
+JIDPrepCache::Statistics JIDPrepCache::getStatistics() const {
+    Statistics statistics;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        statistics.hits += shard->hits;
+        statistics.misses += shard->misses;
+        statistics.evictions += shard->evictions;
+        statistics.size += shard->entries.size();
+    }
+    return statistics;
+}
+
+void JIDPrepCache::clear() {
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->clock.clear();
+        shard->hand = 0;
+    }
+}
+
+}
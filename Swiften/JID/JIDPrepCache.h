@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Swiften/Base/API.h>
+
+namespace Swift {
+    /**
+     * A bounded, thread-safe cache of stringprep results, used by \ref JID.
+     *
+     * Entries are spread over independently locked shards, so concurrent lookups of
+     * different strings rarely contend. Each shard holds at most its share of the
+     * capacity and evicts with the CLOCK algorithm: a hit only marks the entry as
+     * referenced, and unreferenced entries are replaced first.
+     *
+     * The cache does not prepare strings itself; callers prepare a missing string
+     * without holding any lock and \ref put the result afterwards.
+     */
+    class SWIFTEN_API JIDPrepCache {
+        public:
+            struct Statistics {
+                Statistics() : hits(0), misses(0), evictions(0), size(0) {}
+
+                std::uint64_t hits;
+                std::uint64_t misses;
+                std::uint64_t evictions;
+                size_t size;
+            };
+
+        public:
+            JIDPrepCache(size_t capacity, size_t shardCount = 16);
+            ~JIDPrepCache();
+
+            JIDPrepCache(const JIDPrepCache&) = delete;
+            JIDPrepCache& operator=(const JIDPrepCache&) = delete;
+
+            /**
+             * Copies the cached result for \p key into \p value.
+             * Returns false if \p key is not in the cache.
+             */
+            bool get(const std::string& key, std::string& value);
+
+            void put(const std::string& key, const std::string& value);
+
+            Statistics getStatistics() const;
+
+            void clear();
+
+        private:
+            struct Shard;
+
+            Shard& getShard(const std::string& key);
+
+        private:
+            size_t shardCapacity_;
+            std::vector<std::unique_ptr<Shard> > shards_;
+    };
+}
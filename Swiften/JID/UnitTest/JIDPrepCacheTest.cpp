@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/JID/JIDPrepCache.h>
+
+using namespace Swift;
+
+class JIDPrepCacheTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(JIDPrepCacheTest);
+        CPPUNIT_TEST(testGet_Miss);
+        CPPUNIT_TEST(testGet_Hit);
+        CPPUNIT_TEST(testPut_ExistingKeyKeepsValue);
+        CPPUNIT_TEST(testPut_EvictsWhenFull);
+        CPPUNIT_TEST(testPut_EvictsUnreferencedEntriesFirst);
+        CPPUNIT_TEST(testPut_SizeBoundedAcrossShards);
+        CPPUNIT_TEST(testClear);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testGet_Miss() {
+            JIDPrepCache testling(4);
+            std::string value;
+
+            CPPUNIT_ASSERT(!testling.get("Foo", value));
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::uint64_t>(0), testling.getStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::uint64_t>(1), testling.getStatistics().misses);
+        }
+
+        void testGet_Hit() {
+            JIDPrepCache testling(4);
+            testling.put("Foo", "foo");
+            std::string value;
+
+            CPPUNIT_ASSERT(testling.get("Foo", value));
+            CPPUNIT_ASSERT_EQUAL(std::string("foo"), value);
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::uint64_t>(1), testling.getStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::uint64_t>(0), testling.getStatistics().misses);
+        }
+
+        void testPut_ExistingKeyKeepsValue() {
+            JIDPrepCache testling(4);
+            testling.put("Foo", "foo");
+            testling.put("Foo", "bar");
+            std::string value;
+
+            CPPUNIT_ASSERT(testling.get("Foo", value));
+            CPPUNIT_ASSERT_EQUAL(std::string("foo"), value);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getStatistics().size);
+        }
+
+        void testPut_EvictsWhenFull() {
+            JIDPrepCache testling(2, 1);
+            testling.put("A", "a");
+            testling.put("B", "b");
+            testling.put("C", "c");
+            std::string value;
+
+            CPPUNIT_ASSERT(!testling.get("A", value));
+            CPPUNIT_ASSERT(testling.get("B", value));
+            CPPUNIT_ASSERT(testling.get("C", value));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), testling.getStatistics().size);
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::uint64_t>(1), testling.getStatistics().evictions);
+        }
+
+        void testPut_EvictsUnreferencedEntriesFirst() {
+            JIDPrepCache testling(3, 1);
+            testling.put("A", "a");
+            testling.put("B", "b");
+            testling.put("C", "c");
+            std::string value;
+            testling.get("A", value);
+
+            testling.put("D", "d");
+
+            CPPUNIT_ASSERT(testling.get("A", value));
+            CPPUNIT_ASSERT(!testling.get("B", value));
+            CPPUNIT_ASSERT(testling.get("C", value));
+            CPPUNIT_ASSERT(testling.get("D", value));
+        }
+
+        void testPut_SizeBoundedAcrossShards() {
+            JIDPrepCache testling(64, 4);
+            for (int i = 0; i < 1000; ++i) {
+                testling.put("key" + std::to_string(i), "value");
+            }
+
+            CPPUNIT_ASSERT(testling.getStatistics().size <= 64);
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::uint64_t>(1000 - testling.getStatistics().size), testling.getStatistics().evictions);
+        }
+
+        void testClear() {
+            JIDPrepCache testling(4);
+            testling.put("Foo", "foo");
+
+            testling.clear();
+
+            std::string value;
+            CPPUNIT_ASSERT(!testling.get("Foo", value));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling.getStatistics().size);
+        }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(JIDPrepCacheTest);
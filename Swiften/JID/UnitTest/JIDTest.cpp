@@ -1,9 +1,11 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <unordered_set>
+
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
@@ -26,6 +28,15 @@ class JIDTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testConstructorWithString_UpperCaseResource);
         CPPUNIT_TEST(testConstructorWithString_EmptyNode);
         CPPUNIT_TEST(testConstructorWithString_IllegalResource);
+        CPPUNIT_TEST(testConstructorWithString_PreparedASCII);
+        CPPUNIT_TEST(testConstructorWithString_ASCIIDomainWithLeadingHyphen);
+        CPPUNIT_TEST(testConstructorWithString_ASCIIControlCharacterInResource);
+        CPPUNIT_TEST(testGetPrepCacheStatistics);
+        CPPUNIT_TEST(testGetHash_EqualJIDs);
+        CPPUNIT_TEST(testGetHash_ToBare);
+        CPPUNIT_TEST(testGetHash_BareAndFull);
+        CPPUNIT_TEST(testGetDomain_Interned);
+        CPPUNIT_TEST(testHashContainer);
         CPPUNIT_TEST(testConstructorWithString_SpacesInNode);
         CPPUNIT_TEST(testConstructorWithStrings);
         CPPUNIT_TEST(testConstructorWithStrings_EmptyDomain);
@@ -157,6 +168,68 @@ class JIDTest : public CppUnit::TestFixture
             CPPUNIT_ASSERT(!testling.isValid());
         }
 
+        void testConstructorWithString_PreparedASCII() {
+            JID testling("foo-1@bar-2.example.com/Some Resource");
+
+            CPPUNIT_ASSERT_EQUAL(std::string("foo-1"), testling.getNode());
+            CPPUNIT_ASSERT_EQUAL(std::string("bar-2.example.com"), testling.getDomain());
+            CPPUNIT_ASSERT_EQUAL(std::string("Some Resource"), testling.getResource());
+            CPPUNIT_ASSERT(testling.isValid());
+        }
+
+        void testConstructorWithString_ASCIIDomainWithLeadingHyphen() {
+            CPPUNIT_ASSERT(!JID("foo@-bar.com").isValid());
+        }
+
+        void testConstructorWithString_ASCIIControlCharacterInResource() {
+            CPPUNIT_ASSERT(!JID("foo@bar.com/baz\x07").isValid());
+        }
+
+        void testGetHash_EqualJIDs() {
+            CPPUNIT_ASSERT_EQUAL(JID("Foo@Bar.com/Baz").getHash(), JID("foo", "bar.com", "Baz").getHash());
+            CPPUNIT_ASSERT_EQUAL(std::hash<JID>()(JID("foo@bar.com")), JID("foo@bar.com").getHash());
+        }
+
+        void testGetHash_ToBare() {
+            CPPUNIT_ASSERT_EQUAL(JID("foo@bar.com").getHash(), JID("foo@bar.com/baz").toBare().getHash());
+            CPPUNIT_ASSERT(JID("foo@bar.com") == JID("foo@bar.com/baz").toBare());
+        }
+
+        void testGetHash_BareAndFull() {
+            CPPUNIT_ASSERT(JID("foo@bar.com").getHash() != JID("foo@bar.com/baz").getHash());
+            CPPUNIT_ASSERT(JID("foo@bar.com").equals(JID("foo@bar.com/baz"), JID::WithoutResource));
+            CPPUNIT_ASSERT(!JID("foo@bar.com").equals(JID("foo@bar.com/baz"), JID::WithResource));
+        }
+
+        void testGetDomain_Interned() {
+            JID jid1("foo@averyveryverylongdomain.example.com/bar");
+            JID jid2("baz@averyveryverylongdomain.example.com");
+
+            CPPUNIT_ASSERT_EQUAL(&jid1.getDomain(), &jid2.getDomain());
+        }
+
+        void testHashContainer() {
+            std::unordered_set<JID> jids;
+            jids.insert(JID("foo@bar.com"));
+            jids.insert(JID("foo@bar.com/baz"));
+            jids.insert(JID("Foo@bar.com"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), jids.size());
+            CPPUNIT_ASSERT(jids.find(JID("foo@bar.com/baz")) != jids.end());
+            CPPUNIT_ASSERT(jids.find(JID("foo@bar.com/qux")) == jids.end());
+        }
+
+        void testGetPrepCacheStatistics() {
+            JID("fo\xCF\x89@bar.com/statistics");
+            JIDPrepCache::Statistics before = JID::getPrepCacheStatistics();
+
+            JID testling("fo\xCF\x89@bar.com/statistics");
+
+            CPPUNIT_ASSERT(testling.isValid());
+            CPPUNIT_ASSERT_EQUAL(before.hits + 1, JID::getPrepCacheStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(before.misses, JID::getPrepCacheStatistics().misses);
+        }
+
         void testConstructorWithString_SpacesInNode() {
             CPPUNIT_ASSERT(!JID("   alice@wonderland.lit").isValid());
             CPPUNIT_ASSERT(!JID("alice   @wonderland.lit").isValid());
@@ -225,6 +225,7 @@ void BOSHConnection::handleConnectFinished(Connection::ref connection) {
             tlsLayer_->getContext()->onDataForApplication.connect(boost::bind(&BOSHConnection::handleTLSApplicationDataRead, shared_from_this(), _1));
             tlsLayer_->onConnected.connect(boost::bind(&BOSHConnection::handleTLSConnected, shared_from_this()));
             tlsLayer_->onError.connect(boost::bind(&BOSHConnection::handleTLSError, shared_from_this(), _1));
+            tlsLayer_->getContext()->setServerIdentity(boshURL_.getHost(), URL::getPortOrDefaultPort(boshURL_), boshURL_.getHost());
             tlsLayer_->connect();
         }
         else {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,40 +19,23 @@
 #include <Swiften/Base/Algorithm.h>
 #include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/Log.h>
-#include <Swiften/Base/SafeAllocator.h>
 #include <Swiften/Base/sleep.h>
 #include <Swiften/EventLoop/EventLoop.h>
+#include <Swiften/Network/BoostReadBufferPool.h>
 #include <Swiften/Network/HostAddressPort.h>
 
 namespace Swift {
 
-static const size_t BUFFER_SIZE = 4096;
+// The read buffer grows when reads fill it, and shrinks again after a number
+// of reads that only used a small part of it.
+static const size_t MIN_READ_BUFFER_SIZE = BoostReadBufferPool::minimumBufferSize;
+static const size_t MAX_READ_BUFFER_SIZE = BoostReadBufferPool::maximumBufferSize;
+static const int SMALL_READS_BEFORE_SHRINK = 16;
 
-// -----------------------------------------------------------------------------
-
-// A reference-counted non-modifiable buffer class.
-class SharedBuffer {
-    public:
-        SharedBuffer(const SafeByteArray& data) :
-                data_(new std::vector<char, SafeAllocator<char> >(data.begin(), data.end())),
-                buffer_(boost::asio::buffer(*data_)) {
-        }
-
-        // ConstBufferSequence requirements.
-        typedef boost::asio::const_buffer value_type;
-        typedef const boost::asio::const_buffer* const_iterator;
-        const boost::asio::const_buffer* begin() const { return &buffer_; }
-        const boost::asio::const_buffer* end() const { return &buffer_ + 1; }
-
-    private:
-        std::shared_ptr< std::vector<char, SafeAllocator<char> > > data_;
-        boost::asio::const_buffer buffer_;
-};
-
-// -----------------------------------------------------------------------------
+static const size_t DEFAULT_WRITE_COALESCING_THRESHOLD = 1024;
 
 BoostConnection::BoostConnection(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) :
-    eventLoop(eventLoop), ioService(ioService), socket_(*ioService), writing_(false), closeSocketAfterNextWrite_(false) {
+    eventLoop(eventLoop), ioService(ioService), socket_(*ioService), readBufferPool_(boost::asio::use_service<BoostReadBufferPool>(*ioService)), readBufferSize_(MIN_READ_BUFFER_SIZE), smallReadCount_(0), secureReadBuffers_(true), writing_(false), writeCoalescingThreshold_(DEFAULT_WRITE_COALESCING_THRESHOLD), queuedWriteBytes_(0), closeSocketAfterNextWrite_(false) {
 }
 
 BoostConnection::~BoostConnection() {
@@ -93,17 +76,53 @@ void BoostConnection::closeSocket() {
 
 void BoostConnection::write(const SafeByteArray& data) {
     std::lock_guard<std::mutex> lock(writeMutex_);
+    queuedWriteBytes_ += data.size();
+    // Queued buffers are not referenced by an in-flight write yet, so small writes can still be appended.
+    if (!writeQueue_.empty() && writeQueue_.back().safeData && data.size() < writeCoalescingThreshold_ && writeQueue_.back().size() + data.size() <= writeCoalescingThreshold_) {
+        append(*writeQueue_.back().safeData, data);
+    }
+    else {
+        QueuedWrite write;
+        write.safeData = std::make_shared<SafeByteArray>(data);
+        writeQueue_.push_back(write);
+    }
     if (!writing_) {
         writing_ = true;
-        doWrite(data);
+        doWrite();
     }
-    else {
-        append(writeQueue_, data);
+}
+
+void BoostConnection::writeBuffer(std::shared_ptr<const ByteArray> data) {
+    if (data->size() < writeCoalescingThreshold_) {
+        // Copying small buffers is cheap, and allows them to be coalesced
+        write(createSafeByteArray(*data));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    queuedWriteBytes_ += data->size();
+    QueuedWrite write;
+    write.data = data;
+    writeQueue_.push_back(write);
+    if (!writing_) {
+        writing_ = true;
+        doWrite();
     }
 }
 
-void BoostConnection::doWrite(const SafeByteArray& data) {
-    boost::asio::async_write(socket_, SharedBuffer(data),
+void BoostConnection::doWrite() {
+    // Flush everything queued so far with a single gathering write.
+    writesInFlight_.swap(writeQueue_);
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(writesInFlight_.size());
+    for (const auto& write : writesInFlight_) {
+        if (write.safeData) {
+            buffers.push_back(boost::asio::buffer(*write.safeData));
+        }
+        else {
+            buffers.push_back(boost::asio::buffer(*write.data));
+        }
+    }
+    boost::asio::async_write(socket_, buffers,
             boost::bind(&BoostConnection::handleDataWritten, shared_from_this(), boost::asio::placeholders::error));
 }
 
@@ -119,7 +138,7 @@ void BoostConnection::handleConnectFinished(const boost::system::error_code& err
 }
 
 void BoostConnection::doRead() {
-    readBuffer_ = std::make_shared<SafeByteArray>(BUFFER_SIZE);
+    readBuffer_ = readBufferPool_.getBuffer(readBufferSize_, secureReadBuffers_);
     std::lock_guard<std::mutex> lock(readCloseMutex_);
     socket_.async_read_some(
             boost::asio::buffer(*readBuffer_),
@@ -129,8 +148,13 @@ void BoostConnection::doRead() {
 void BoostConnection::handleSocketRead(const boost::system::error_code& error, size_t bytesTransferred) {
     SWIFT_LOG(debug) << "Socket read " << error << std::endl;
     if (!error) {
-        readBuffer_->resize(bytesTransferred);
-        eventLoop->postEvent(boost::bind(boost::ref(onDataRead), readBuffer_), shared_from_this());
+        // The buffer is handed over without copying, and goes back to the pool
+        // once the data is processed. Shrinking it does not move the data.
+        std::shared_ptr<SafeByteArray> data;
+        data.swap(readBuffer_);
+        data->resize(bytesTransferred);
+        adaptReadBufferSize(bytesTransferred);
+        eventLoop->postEvent(boost::bind(boost::ref(onDataRead), data), shared_from_this());
         doRead();
     }
     else if (/*error == boost::asio::error::eof ||*/ error == boost::asio::error::operation_aborted) {
@@ -141,6 +165,24 @@ void BoostConnection::handleSocketRead(const boost::system::error_code& error, s
     }
 }
 
+void BoostConnection::adaptReadBufferSize(size_t bytesTransferred) {
+    if (bytesTransferred == readBufferSize_) {
+        smallReadCount_ = 0;
+        if (readBufferSize_ < MAX_READ_BUFFER_SIZE) {
+            readBufferSize_ *= 4;
+        }
+    }
+    else if (readBufferSize_ > MIN_READ_BUFFER_SIZE && bytesTransferred < readBufferSize_ / 4) {
+        if (++smallReadCount_ >= SMALL_READS_BEFORE_SHRINK) {
+            smallReadCount_ = 0;
+            readBufferSize_ /= 4;
+        }
+    }
+    else {
+        smallReadCount_ = 0;
+    }
+}
+
 void BoostConnection::handleDataWritten(const boost::system::error_code& error) {
     SWIFT_LOG(debug) << "Data written " << error << std::endl;
     if (!error) {
@@ -154,6 +196,10 @@ void BoostConnection::handleDataWritten(const boost::system::error_code& error)
     }
     {
         std::lock_guard<std::mutex> lock(writeMutex_);
+        for (const auto& write : writesInFlight_) {
+            queuedWriteBytes_ -= write.size();
+        }
+        writesInFlight_.clear();
         if (writeQueue_.empty()) {
             writing_ = false;
             if (closeSocketAfterNextWrite_) {
@@ -161,8 +207,7 @@ void BoostConnection::handleDataWritten(const boost::system::error_code& error)
             }
         }
         else {
-            doWrite(writeQueue_);
-            writeQueue_.clear();
+            doWrite();
         }
     }
 }
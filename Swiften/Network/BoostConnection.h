@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
@@ -20,7 +22,10 @@
 #include <Swiften/TLS/CertificateVerificationError.h>
 #include <Swiften/TLS/CertificateWithKey.h>
 
+class BoostConnectionTest;
+
 namespace Swift {
+    class BoostReadBufferPool;
     class EventLoop;
 
     class SWIFTEN_API BoostConnection : public Connection, public EventOwner, public std::enable_shared_from_this<BoostConnection> {
@@ -37,6 +42,7 @@ namespace Swift {
             virtual void connect(const HostAddressPort& address);
             virtual void disconnect();
             virtual void write(const SafeByteArray& data);
+            virtual void writeBuffer(std::shared_ptr<const ByteArray> data);
 
             boost::asio::ip::tcp::socket& getSocket() {
                 return socket_;
@@ -45,6 +51,34 @@ namespace Swift {
             virtual HostAddressPort getLocalAddress() const;
             virtual HostAddressPort getRemoteAddress() const;
 
+            /**
+             * Read buffers are recycled through a per-io_service \ref BoostReadBufferPool,
+             * and passed on with the data read into them, without copying.
+             * By default, buffer contents are zeroed before reuse. Streams that never
+             * carry credentials or other sensitive data can disable this.
+             */
+            void setSecureReadBuffers(bool secure) {
+                secureReadBuffers_ = secure;
+            }
+
+            /**
+             * Writes smaller than \p threshold bytes that are queued while another write is
+             * in progress are appended to the previous queued buffer (as long as that stays
+             * below the threshold), instead of becoming a separate buffer of the next
+             * scatter-gather write. A threshold of 0 disables coalescing.
+             */
+            void setWriteCoalescingThreshold(size_t threshold) {
+                writeCoalescingThreshold_ = threshold;
+            }
+
+            /**
+             * Returns the number of bytes passed to \ref write or \ref writeBuffer that have not been
+             * written to the socket yet. This can be called from any thread.
+             */
+            size_t getQueuedWriteBytes() const {
+                return queuedWriteBytes_;
+            }
+
             bool setClientCertificate(CertificateWithKey::ref cert);
 
             Certificate::ref getPeerCertificate() const;
@@ -52,23 +86,44 @@ namespace Swift {
             std::shared_ptr<CertificateVerificationError> getPeerCertificateVerificationError() const;
 
         private:
+            friend class ::BoostConnectionTest;
+
+            // A queued write refers either to a copy of the data passed to write(), which
+            // later small writes can be appended to, or to a buffer passed to writeBuffer().
+            struct QueuedWrite {
+                std::shared_ptr<SafeByteArray> safeData;
+                std::shared_ptr<const ByteArray> data;
+
+                size_t size() const {
+                    return safeData ? safeData->size() : data->size();
+                }
+            };
+
             BoostConnection(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop);
 
             void handleConnectFinished(const boost::system::error_code& error);
             void handleSocketRead(const boost::system::error_code& error, size_t bytesTransferred);
             void handleDataWritten(const boost::system::error_code& error);
             void doRead();
-            void doWrite(const SafeByteArray& data);
+            void adaptReadBufferSize(size_t bytesTransferred);
+            void doWrite();
             void closeSocket();
 
         private:
             EventLoop* eventLoop;
             std::shared_ptr<boost::asio::io_service> ioService;
             boost::asio::ip::tcp::socket socket_;
+            BoostReadBufferPool& readBufferPool_;
             std::shared_ptr<SafeByteArray> readBuffer_;
+            size_t readBufferSize_;
+            int smallReadCount_;
+            bool secureReadBuffers_;
             std::mutex writeMutex_;
             bool writing_;
-            SafeByteArray writeQueue_;
+            std::vector<QueuedWrite> writeQueue_;
+            std::vector<QueuedWrite> writesInFlight_;
+            size_t writeCoalescingThreshold_;
+            std::atomic<size_t> queuedWriteBytes_;
             bool closeSocketAfterNextWrite_;
             std::mutex readCloseMutex_;
     };
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -10,11 +10,14 @@
 
 namespace Swift {
 
-BoostConnectionFactory::BoostConnectionFactory(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) : ioService(ioService), eventLoop(eventLoop) {
+BoostConnectionFactory::BoostConnectionFactory(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) : ioServicePool(std::make_shared<BoostIOServicePool>(ioService)), eventLoop(eventLoop) {
+}
+
+BoostConnectionFactory::BoostConnectionFactory(std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop) : ioServicePool(ioServicePool), eventLoop(eventLoop) {
 }
 
 std::shared_ptr<Connection> BoostConnectionFactory::createConnection() {
-    return BoostConnection::create(ioService, eventLoop);
+    return BoostConnection::create(ioServicePool->getNextIOService(), eventLoop);
 }
 
 }
@@ -10,6 +10,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Network/BoostConnection.h>
+#include <Swiften/Network/BoostIOServicePool.h>
 #include <Swiften/Network/ConnectionFactory.h>
 
 namespace Swift {
@@ -17,10 +18,15 @@ namespace Swift {
         public:
             BoostConnectionFactory(std::shared_ptr<boost::asio::io_service>, EventLoop* eventLoop);
 
+            /**
+             * Creates connections on the io_services of \p ioServicePool, round-robin.
+             */
+            BoostConnectionFactory(std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop);
+
             virtual std::shared_ptr<Connection> createConnection();
 
         private:
-            std::shared_ptr<boost::asio::io_service> ioService;
+            std::shared_ptr<BoostIOServicePool> ioServicePool;
             EventLoop* eventLoop;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,6 +25,9 @@ BoostConnectionServer::BoostConnectionServer(int port, std::shared_ptr<boost::as
 BoostConnectionServer::BoostConnectionServer(const HostAddress &address, int port, std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) : address_(address), port_(port), ioService_(ioService), eventLoop(eventLoop), acceptor_(nullptr) {
 }
 
+BoostConnectionServer::BoostConnectionServer(const HostAddress &address, int port, std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop) : address_(address), port_(port), ioServicePool_(ioServicePool), ioService_(ioServicePool->getNextIOService()), eventLoop(eventLoop), acceptor_(nullptr) {
+}
+
 void BoostConnectionServer::start() {
     boost::optional<Error> error = tryStart();
     if (error) {
@@ -76,7 +79,7 @@ void BoostConnectionServer::stop(boost::optional<Error> e) {
 }
 
 void BoostConnectionServer::acceptNextConnection() {
-    BoostConnection::ref newConnection(BoostConnection::create(ioService_, eventLoop));
+    BoostConnection::ref newConnection(BoostConnection::create(ioServicePool_ ? ioServicePool_->getNextIOService() : ioService_, eventLoop));
     acceptor_->async_accept(newConnection->getSocket(),
         boost::bind(&BoostConnectionServer::handleAccept, shared_from_this(), newConnection, boost::asio::placeholders::error));
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,6 +16,7 @@
 #include <Swiften/Base/API.h>
 #include <Swiften/EventLoop/EventOwner.h>
 #include <Swiften/Network/BoostConnection.h>
+#include <Swiften/Network/BoostIOServicePool.h>
 #include <Swiften/Network/ConnectionServer.h>
 
 namespace Swift {
@@ -31,6 +32,17 @@ namespace Swift {
                 return ref(new BoostConnectionServer(address, port, ioService, eventLoop));
             }
 
+            /**
+             * Creates a server that accepts connections on the io_services of \p ioServicePool, round-robin.
+             */
+            static ref create(int port, std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop) {
+                return ref(new BoostConnectionServer(HostAddress(), port, ioServicePool, eventLoop));
+            }
+
+            static ref create(const HostAddress &address, int port, std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop) {
+                return ref(new BoostConnectionServer(address, port, ioServicePool, eventLoop));
+            }
+
             virtual boost::optional<Error> tryStart(); // FIXME: This should become the new start
             virtual void start();
             virtual void stop();
@@ -42,6 +54,7 @@ namespace Swift {
         private:
             BoostConnectionServer(int port, std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop);
             BoostConnectionServer(const HostAddress &address, int port, std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop);
+            BoostConnectionServer(const HostAddress &address, int port, std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop);
 
             void stop(boost::optional<Error> e);
             void acceptNextConnection();
@@ -50,6 +63,7 @@ namespace Swift {
         private:
             HostAddress address_;
             int port_;
+            std::shared_ptr<BoostIOServicePool> ioServicePool_;
             std::shared_ptr<boost::asio::io_service> ioService_;
             EventLoop* eventLoop;
             boost::asio::ip::tcp::acceptor* acceptor_;
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,15 +16,18 @@
 
 namespace Swift {
 
-BoostConnectionServerFactory::BoostConnectionServerFactory(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) : ioService(ioService), eventLoop(eventLoop) {
+BoostConnectionServerFactory::BoostConnectionServerFactory(std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) : ioServicePool(std::make_shared<BoostIOServicePool>(ioService)), eventLoop(eventLoop) {
+}
+
+BoostConnectionServerFactory::BoostConnectionServerFactory(std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop) : ioServicePool(ioServicePool), eventLoop(eventLoop) {
 }
 
 std::shared_ptr<ConnectionServer> BoostConnectionServerFactory::createConnectionServer(int port) {
-    return BoostConnectionServer::create(port, ioService, eventLoop);
+    return BoostConnectionServer::create(port, ioServicePool, eventLoop);
 }
 
 std::shared_ptr<ConnectionServer> BoostConnectionServerFactory::createConnectionServer(const Swift::HostAddress &hostAddress, int port) {
-    return BoostConnectionServer::create(hostAddress, port, ioService, eventLoop);
+    return BoostConnectionServer::create(hostAddress, port, ioServicePool, eventLoop);
 }
 
 }
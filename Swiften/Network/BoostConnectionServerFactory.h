@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015-2016 Isode Limited.
+ * Copyright (c) 2015-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,12 +25,17 @@ namespace Swift {
         public:
             BoostConnectionServerFactory(std::shared_ptr<boost::asio::io_service>, EventLoop* eventLoop);
 
+            /**
+             * Creates connection servers whose accepted connections are spread over \p ioServicePool.
+             */
+            BoostConnectionServerFactory(std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop);
+
             virtual std::shared_ptr<ConnectionServer> createConnectionServer(int port);
 
             virtual std::shared_ptr<ConnectionServer> createConnectionServer(const Swift::HostAddress &hostAddress, int port);
 
         private:
-            std::shared_ptr<boost::asio::io_service> ioService;
+            std::shared_ptr<BoostIOServicePool> ioServicePool;
             EventLoop* eventLoop;
     };
 }
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Network/BoostIOServicePool.h>
+
+#include <cassert>
+
+namespace Swift {
+
+BoostIOServicePool::BoostIOServicePool(size_t threadCount) : next_(0) {
+    assert(threadCount > 0);
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads_.push_back(std::unique_ptr<BoostIOServiceThread>(new BoostIOServiceThread()));
+    }
+}
+
+BoostIOServicePool::BoostIOServicePool(std::shared_ptr<boost::asio::io_service> ioService) : next_(0) {
+    threads_.push_back(std::unique_ptr<BoostIOServiceThread>(new BoostIOServiceThread(ioService)));
+}
+
+BoostIOServicePool::~BoostIOServicePool() {
+}
+
+std::shared_ptr<boost::asio::io_service> BoostIOServicePool::getNextIOService() {
+    if (threads_.size() == 1) {
+        return threads_[0]->getIOService();
+    }
+    return threads_[next_++ % threads_.size()]->getIOService();
+}
+
+}
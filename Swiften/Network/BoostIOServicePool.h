@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Network/BoostIOServiceThread.h>
+
+namespace Swift {
+    /**
+     * A pool of io_services, each run by its own \ref BoostIOServiceThread.
+     *
+     * Every io_service in the pool is run by exactly one thread, so all handlers
+     * of a connection or timer created on it are serialized, like on a strand.
+     * Objects are spread over the pool by handing out io_services round-robin.
+     */
+    class SWIFTEN_API BoostIOServicePool {
+        public:
+            /**
+             * Construct a pool of \p threadCount io_services, each with its own thread.
+             */
+            BoostIOServicePool(size_t threadCount);
+
+            /**
+             * Construct a pool wrapping a single externally run \p ioService.
+             */
+            BoostIOServicePool(std::shared_ptr<boost::asio::io_service> ioService);
+
+            ~BoostIOServicePool();
+
+            size_t getSize() const {
+                return threads_.size();
+            }
+
+            BoostIOServiceThread* getIOServiceThread(size_t index) const {
+                return threads_[index].get();
+            }
+
+            /**
+             * Returns the next io_service of the pool in round-robin order.
+             * This method can be called from any thread.
+             */
+            std::shared_ptr<boost::asio::io_service> getNextIOService();
+
+        private:
+            std::vector<std::unique_ptr<BoostIOServiceThread> > threads_;
+            std::atomic<size_t> next_;
+    };
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,6 +13,7 @@
 #include <Swiften/Network/BoostConnectionFactory.h>
 #include <Swiften/Network/BoostConnectionServerFactory.h>
 #include <Swiften/Network/BoostTimerFactory.h>
+#include <Swiften/Network/CachingDomainNameResolver.h>
 #include <Swiften/Network/NullNATTraverser.h>
 #include <Swiften/Network/PlatformNATTraversalWorker.h>
 #include <Swiften/Network/PlatformNetworkEnvironment.h>
@@ -28,10 +29,18 @@
 
 namespace Swift {
 
-BoostNetworkFactories::BoostNetworkFactories(EventLoop* eventLoop, std::shared_ptr<boost::asio::io_service> ioService) : ioServiceThread(ioService), eventLoop(eventLoop) {
-    timerFactory = new BoostTimerFactory(ioServiceThread.getIOService(), eventLoop);
-    connectionFactory = new BoostConnectionFactory(ioServiceThread.getIOService(), eventLoop);
-    connectionServerFactory = new BoostConnectionServerFactory(ioServiceThread.getIOService(), eventLoop);
+BoostNetworkFactories::BoostNetworkFactories(EventLoop* eventLoop, std::shared_ptr<boost::asio::io_service> ioService) : ioServicePool(std::make_shared<BoostIOServicePool>(ioService)), eventLoop(eventLoop) {
+    createFactories();
+}
+
+BoostNetworkFactories::BoostNetworkFactories(EventLoop* eventLoop, size_t ioServiceThreadCount) : ioServicePool(std::make_shared<BoostIOServicePool>(ioServiceThreadCount)), eventLoop(eventLoop) {
+    createFactories();
+}
+
+void BoostNetworkFactories::createFactories() {
+    timerFactory = new BoostTimerFactory(ioServicePool, eventLoop);
+    connectionFactory = new BoostConnectionFactory(ioServicePool, eventLoop);
+    connectionServerFactory = new BoostConnectionServerFactory(ioServicePool, eventLoop);
 #ifdef SWIFT_EXPERIMENTAL_FT
     natTraverser = new PlatformNATTraversalWorker(eventLoop);
 #else
@@ -44,16 +53,18 @@ BoostNetworkFactories::BoostNetworkFactories(EventLoop* eventLoop, std::shared_p
     idnConverter = PlatformIDNConverter::create();
 #ifdef USE_UNBOUND
     // TODO: What to do about idnConverter.
-    domainNameResolver = new UnboundDomainNameResolver(idnConverter, ioServiceThread.getIOService(), eventLoop);
+    platformDomainNameResolver = new UnboundDomainNameResolver(idnConverter, ioServicePool->getIOServiceThread(0)->getIOService(), eventLoop);
 #else
-    domainNameResolver = new PlatformDomainNameResolver(idnConverter, eventLoop);
+    platformDomainNameResolver = new PlatformDomainNameResolver(idnConverter, eventLoop);
 #endif
+    domainNameResolver = new CachingDomainNameResolver(platformDomainNameResolver, eventLoop);
     cryptoProvider = PlatformCryptoProvider::create();
 }
 
 BoostNetworkFactories::~BoostNetworkFactories() {
     delete cryptoProvider;
     delete domainNameResolver;
+    delete platformDomainNameResolver;
     delete idnConverter;
     delete proxyProvider;
     delete tlsFactories;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,7 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/Override.h>
+#include <Swiften/Network/BoostIOServicePool.h>
 #include <Swiften/Network/BoostIOServiceThread.h>
 #include <Swiften/Network/NetworkFactories.h>
 
@@ -24,6 +25,14 @@ namespace Swift {
              * used for the construction of the BoostIOServiceThread.
              */
             BoostNetworkFactories(EventLoop* eventLoop, std::shared_ptr<boost::asio::io_service> ioService = std::shared_ptr<boost::asio::io_service>());
+
+            /**
+             * Construct the network factories, using the provided EventLoop and
+             * a pool of \p ioServiceThreadCount network threads. Connections,
+             * connection servers and timers are distributed round-robin over the
+             * pool; each of them stays on a single thread for its lifetime.
+             */
+            BoostNetworkFactories(EventLoop* eventLoop, size_t ioServiceThreadCount);
             virtual ~BoostNetworkFactories();
 
             virtual TimerFactory* getTimerFactory() const SWIFTEN_OVERRIDE {
@@ -35,7 +44,11 @@ namespace Swift {
             }
 
             BoostIOServiceThread* getIOServiceThread() {
-                return &ioServiceThread;
+                return ioServicePool->getIOServiceThread(0);
+            }
+
+            std::shared_ptr<BoostIOServicePool> getIOServicePool() const {
+                return ioServicePool;
             }
 
             DomainNameResolver* getDomainNameResolver() const SWIFTEN_OVERRIDE {
@@ -77,9 +90,13 @@ namespace Swift {
             }
 
         private:
-            BoostIOServiceThread ioServiceThread;
+            void createFactories();
+
+        private:
+            std::shared_ptr<BoostIOServicePool> ioServicePool;
             TimerFactory* timerFactory;
             ConnectionFactory* connectionFactory;
+            DomainNameResolver* platformDomainNameResolver;
             DomainNameResolver* domainNameResolver;
             ConnectionServerFactory* connectionServerFactory;
             NATTraverser* natTraverser;
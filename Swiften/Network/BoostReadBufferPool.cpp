@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Network/BoostReadBufferPool.h>
+
+#include <mutex>
+#include <vector>
+
+namespace Swift {
+
+boost::asio::io_service::id BoostReadBufferPool::id;
+
+// Buffers are kept in size classes of minimumBufferSize * 4^n.
+class BoostReadBufferPool::FreeBuffers {
+    public:
+        static const size_t sizeClasses = 3;
+        static const size_t maximumFreeBuffersPerClass = 32;
+
+        ~FreeBuffers() {
+            for (auto& buffers : buffers_) {
+                for (auto buffer : buffers) {
+                    delete buffer;
+                }
+            }
+        }
+
+        static size_t getSizeClass(size_t size) {
+            size_t sizeClass = 0;
+            for (size_t classSize = minimumBufferSize; classSize < size && sizeClass + 1 < sizeClasses; classSize *= 4) {
+                sizeClass++;
+            }
+            return sizeClass;
+        }
+
+        static size_t getClassSize(size_t sizeClass) {
+            return minimumBufferSize << (2 * sizeClass);
+        }
+
+        SafeByteArray* take(size_t sizeClass) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<SafeByteArray*>& buffers = buffers_[sizeClass];
+            if (buffers.empty()) {
+                return nullptr;
+            }
+            SafeByteArray* buffer = buffers.back();
+            buffers.pop_back();
+            return buffer;
+        }
+
+        void give(SafeByteArray* buffer) {
+            size_t sizeClass = getSizeClass(buffer->capacity());
+            size_t classSize = getClassSize(sizeClass);
+            if (buffer->capacity() == classSize) {
+                // Fits in the capacity, and leaves the new elements as they are
+                buffer->resize(classSize);
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::vector<SafeByteArray*>& buffers = buffers_[sizeClass];
+                if (buffers.size() < maximumFreeBuffersPerClass) {
+                    buffers.push_back(buffer);
+                    return;
+                }
+            }
+            delete buffer;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<SafeByteArray*> buffers_[sizeClasses];
+};
+
+BoostReadBufferPool::BoostReadBufferPool(boost::asio::io_service& ioService) : boost::asio::io_service::service(ioService), freeBuffers_(std::make_shared<FreeBuffers>()) {
+}
+
+BoostReadBufferPool::~BoostReadBufferPool() {
+}
+
+void BoostReadBufferPool::shutdown_service() {
+}
+
+std::shared_ptr<SafeByteArray> BoostReadBufferPool::getBuffer(size_t size, bool secure) {
+    size_t sizeClass = FreeBuffers::getSizeClass(size);
+    SafeByteArray* buffer = freeBuffers_->take(sizeClass);
+    if (!buffer) {
+        // New memory may hold anything, so it is zeroed like a released buffer
+        buffer = new SafeByteArray(FreeBuffers::getClassSize(sizeClass), 0);
+    }
+    return createReference(buffer, secure);
+}
+
+std::shared_ptr<SafeByteArray> BoostReadBufferPool::createReference(SafeByteArray* buffer, bool secure) {
+    // Buffers that are still referenced when the io_service goes away keep the free list alive.
+    std::shared_ptr<FreeBuffers> freeBuffers = freeBuffers_;
+    return std::shared_ptr<SafeByteArray>(buffer, [freeBuffers, secure](SafeByteArray* buffer) {
+        if (secure && !buffer->empty()) {
+            secureZeroMemory(reinterpret_cast<char*>(vecptr(*buffer)), buffer->size());
+        }
+        freeBuffers->give(buffer);
+    });
+}
+
+}
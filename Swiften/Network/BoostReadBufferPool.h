@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <boost/asio/io_service.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Base/SafeByteArray.h>
+
+namespace Swift {
+    /**
+     * A pool of recyclable read buffers, attached to an io_service as an asio service.
+     *
+     * Every io_service (and thus every network thread) gets its own pool, obtained
+     * with boost::asio::use_service<BoostReadBufferPool>(ioService).
+     * Buffers are handed out as ordinary SafeByteArray references; when the last
+     * reference is released, the buffer goes back to the pool instead of being freed.
+     *
+     * A buffer may be shrunk to the number of bytes read into it before it is passed
+     * on. When it is released, it is grown back to its full size, which does not fill
+     * it (see \ref SafeAllocator).
+     */
+    class SWIFTEN_API BoostReadBufferPool : public boost::asio::io_service::service {
+        public:
+            static boost::asio::io_service::id id;
+
+            static const size_t minimumBufferSize = 4096;
+            static const size_t maximumBufferSize = 65536;
+
+            BoostReadBufferPool(boost::asio::io_service& ioService);
+            virtual ~BoostReadBufferPool();
+
+            /**
+             * Returns a buffer of \p size bytes, rounded up to the next supported buffer size.
+             * If \p secure is true, the buffer contents are zeroed before the buffer is reused,
+             * so data read for one stream never lingers in a recycled buffer. Only the bytes
+             * up to the size of the buffer when it is released are zeroed, so it must only
+             * be shrunk, and only after it has been written to.
+             */
+            std::shared_ptr<SafeByteArray> getBuffer(size_t size, bool secure);
+
+        private:
+            virtual void shutdown_service();
+            std::shared_ptr<SafeByteArray> createReference(SafeByteArray* buffer, bool secure);
+
+        private:
+            class FreeBuffers;
+            std::shared_ptr<FreeBuffers> freeBuffers_;
+    };
+}
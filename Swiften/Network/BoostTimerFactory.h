@@ -9,6 +9,7 @@
 #include <boost/asio/io_service.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Network/BoostIOServicePool.h>
 #include <Swiften/Network/BoostTimer.h>
 #include <Swiften/Network/TimerFactory.h>
 
@@ -19,10 +20,15 @@ namespace Swift {
         public:
             BoostTimerFactory(std::shared_ptr<boost::asio::io_service>, EventLoop* eventLoop);
 
+            /**
+             * Creates timers on the io_services of \p ioServicePool, round-robin.
+             */
+            BoostTimerFactory(std::shared_ptr<BoostIOServicePool> ioServicePool, EventLoop* eventLoop);
+
             virtual std::shared_ptr<Timer> createTimer(int milliseconds);
 
         private:
-            std::shared_ptr<boost::asio::io_service> ioService;
+            std::shared_ptr<BoostIOServicePool> ioServicePool;
             EventLoop* eventLoop;
     };
 }
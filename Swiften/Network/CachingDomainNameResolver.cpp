@@ -1,30 +1,233 @@
 /*
- * Copyright (c) 2012-2016 Isode Limited.
+ * Copyright (c) 2012-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Network/CachingDomainNameResolver.h>
 
+#include <algorithm>
 #include <memory>
 
+#include <boost/bind.hpp>
+
+#include <Swiften/EventLoop/EventLoop.h>
+#include <Swiften/EventLoop/EventOwner.h>
+
 namespace Swift {
 
-CachingDomainNameResolver::CachingDomainNameResolver(DomainNameResolver* realResolver, EventLoop*) : realResolver(realResolver) {
+class CachingDomainNameResolver::ServiceQuery : public DomainNameServiceQuery, public std::enable_shared_from_this<ServiceQuery> {
+    public:
+        ServiceQuery(CachingDomainNameResolver* resolver, const std::string& serviceLookupPrefix, const std::string& domain) : resolver(resolver), serviceLookupPrefix(serviceLookupPrefix), domain(domain) {
+        }
+
+        virtual void run() {
+            resolver->runServiceQuery(shared_from_this());
+        }
+
+        virtual boost::optional<std::chrono::seconds> getTTL() const {
+            return ttl;
+        }
+
+        void emitOnResult(const std::vector<DomainNameServiceQuery::Result>& records, boost::optional<std::chrono::seconds> ttl) {
+            this->ttl = ttl;
+            onResult(records);
+        }
+
+        CachingDomainNameResolver* resolver;
+        std::string serviceLookupPrefix;
+        std::string domain;
+        boost::optional<std::chrono::seconds> ttl;
+};
+
+class CachingDomainNameResolver::AddressQuery : public DomainNameAddressQuery, public std::enable_shared_from_this<AddressQuery> {
+    public:
+        AddressQuery(CachingDomainNameResolver* resolver, const std::string& name) : resolver(resolver), name(name) {
+        }
+
+        virtual void run() {
+            resolver->runAddressQuery(shared_from_this());
+        }
+
+        virtual boost::optional<std::chrono::seconds> getTTL() const {
+            return ttl;
+        }
+
+        void emitOnResult(const std::vector<HostAddress>& addresses, boost::optional<DomainNameResolveError> error, boost::optional<std::chrono::seconds> ttl) {
+            this->ttl = ttl;
+            onResult(addresses, error);
+        }
+
+        CachingDomainNameResolver* resolver;
+        std::string name;
+        boost::optional<std::chrono::seconds> ttl;
+};
+
+namespace {
+    boost::optional<std::chrono::seconds> getRemainingTTL(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point expires) {
+        return std::chrono::duration_cast<std::chrono::seconds>(expires - now);
+    }
 }
 
-CachingDomainNameResolver::~CachingDomainNameResolver() {
+CachingDomainNameResolver::CachingDomainNameResolver(DomainNameResolver* realResolver, EventLoop* eventLoop) : realResolver(realResolver), eventLoop(eventLoop), eventOwner(std::make_shared<EventOwner>()), defaultTTL(std::chrono::minutes(5)), negativeTTL(std::chrono::seconds(10)), randomGenerator(&defaultRandomGenerator) {
+}
 
+CachingDomainNameResolver::~CachingDomainNameResolver() {
+    eventLoop->removeEventsFromOwner(eventOwner);
+    for (auto& lookup : serviceLookups) {
+        lookup.second.realQuery->onResult.disconnect_all_slots();
+    }
+    for (auto& lookup : addressLookups) {
+        lookup.second.realQuery->onResult.disconnect_all_slots();
+    }
 }
 
 DomainNameServiceQuery::ref CachingDomainNameResolver::createServiceQuery(const std::string& serviceLookupPrefix, const std::string& domain) {
-    //TODO: Cache
-    return realResolver->createServiceQuery(serviceLookupPrefix, domain);
+    return std::make_shared<ServiceQuery>(this, serviceLookupPrefix, domain);
 }
 
 DomainNameAddressQuery::ref CachingDomainNameResolver::createAddressQuery(const std::string& name) {
-    //TODO: Cache
-    return realResolver->createAddressQuery(name);
+    return std::make_shared<AddressQuery>(this, name);
+}
+
+void CachingDomainNameResolver::clear() {
+    serviceCache.clear();
+    addressCache.clear();
+}
+
+CachingDomainNameResolver::Statistics CachingDomainNameResolver::getStatistics() const {
+    Statistics result = statistics;
+    result.inFlight = serviceLookups.size() + addressLookups.size();
+    result.entries = serviceCache.size() + addressCache.size();
+    return result;
+}
+
+void CachingDomainNameResolver::runServiceQuery(std::shared_ptr<ServiceQuery> query) {
+    std::string name = query->serviceLookupPrefix + query->domain;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    auto cached = serviceCache.find(name);
+    if (cached != serviceCache.end() && now < cached->second.expires) {
+        statistics.hits++;
+        eventLoop->postEvent(boost::bind(&ServiceQuery::emitOnResult, query, getSortedRecords(cached->second.result.records), getRemainingTTL(now, cached->second.expires)), eventOwner);
+        return;
+    }
+
+    auto lookup = serviceLookups.find(name);
+    if (lookup != serviceLookups.end()) {
+        statistics.coalesced++;
+        lookup->second.queries.push_back(query);
+        return;
+    }
+
+    statistics.misses++;
+    removeExpiredEntries(now);
+    ServiceLookup& newLookup = serviceLookups[name];
+    newLookup.queries.push_back(query);
+    newLookup.realQuery = realResolver->createServiceQuery(query->serviceLookupPrefix, query->domain);
+    newLookup.realQuery->onResult.connect(boost::bind(&CachingDomainNameResolver::handleServiceQueryResult, this, name, _1));
+    newLookup.realQuery->run();
+}
+
+void CachingDomainNameResolver::runAddressQuery(std::shared_ptr<AddressQuery> query) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    auto cached = addressCache.find(query->name);
+    if (cached != addressCache.end() && now < cached->second.expires) {
+        statistics.hits++;
+        eventLoop->postEvent(boost::bind(&AddressQuery::emitOnResult, query, cached->second.result.addresses, cached->second.result.error, getRemainingTTL(now, cached->second.expires)), eventOwner);
+        return;
+    }
+
+    auto lookup = addressLookups.find(query->name);
+    if (lookup != addressLookups.end()) {
+        statistics.coalesced++;
+        lookup->second.queries.push_back(query);
+        return;
+    }
+
+    statistics.misses++;
+    removeExpiredEntries(now);
+    AddressLookup& newLookup = addressLookups[query->name];
+    newLookup.queries.push_back(query);
+    newLookup.realQuery = realResolver->createAddressQuery(query->name);
+    newLookup.realQuery->onResult.connect(boost::bind(&CachingDomainNameResolver::handleAddressQueryResult, this, query->name, _1, _2));
+    newLookup.realQuery->run();
+}
+
+void CachingDomainNameResolver::handleServiceQueryResult(const std::string& name, const std::vector<DomainNameServiceQuery::Result>& records) {
+    auto lookup = serviceLookups.find(name);
+    if (lookup == serviceLookups.end()) {
+        return;
+    }
+    // Keep the lookup alive while its signal is being emitted
+    ServiceLookup finishedLookup = std::move(lookup->second);
+    serviceLookups.erase(lookup);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    boost::optional<std::chrono::seconds> ttl = finishedLookup.realQuery->getTTL();
+    CacheEntry<ServiceResult>& entry = serviceCache[name];
+    entry.result.records = records;
+    entry.expires = getExpiryTime(now, ttl, records.empty());
+
+    for (const auto& query : finishedLookup.queries) {
+        query->emitOnResult(getSortedRecords(records), ttl);
+    }
+}
+
+void CachingDomainNameResolver::handleAddressQueryResult(const std::string& name, const std::vector<HostAddress>& addresses, boost::optional<DomainNameResolveError> error) {
+    auto lookup = addressLookups.find(name);
+    if (lookup == addressLookups.end()) {
+        return;
+    }
+    AddressLookup finishedLookup = std::move(lookup->second);
+    addressLookups.erase(lookup);
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    boost::optional<std::chrono::seconds> ttl = finishedLookup.realQuery->getTTL();
+    CacheEntry<AddressResult>& entry = addressCache[name];
+    entry.result.addresses = addresses;
+    entry.result.error = error;
+    entry.expires = getExpiryTime(now, ttl, error || addresses.empty());
+
+    for (const auto& query : finishedLookup.queries) {
+        query->emitOnResult(addresses, error, ttl);
+    }
+}
+
+std::vector<DomainNameServiceQuery::Result> CachingDomainNameResolver::getSortedRecords(const std::vector<DomainNameServiceQuery::Result>& records) {
+    // Every result gets its own weighted order, so that clients sharing the cache
+    // still spread over the servers of a domain
+    std::vector<DomainNameServiceQuery::Result> result(records);
+    DomainNameServiceQuery::sortResults(result, *randomGenerator);
+    return result;
+}
+
+std::chrono::steady_clock::time_point CachingDomainNameResolver::getExpiryTime(std::chrono::steady_clock::time_point now, boost::optional<std::chrono::seconds> ttl, bool negative) const {
+    std::chrono::seconds result = ttl ? *ttl : defaultTTL;
+    if (negative) {
+        result = std::min(result, negativeTTL);
+    }
+    return now + result;
+}
+
+void CachingDomainNameResolver::removeExpiredEntries(std::chrono::steady_clock::time_point now) {
+    for (auto i = serviceCache.begin(); i != serviceCache.end();) {
+        if (i->second.expires <= now) {
+            i = serviceCache.erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
+    for (auto i = addressCache.begin(); i != addressCache.end();) {
+        if (i->second.expires <= now) {
+            i = addressCache.erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
 }
 
 }
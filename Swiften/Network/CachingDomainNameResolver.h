@@ -1,24 +1,58 @@
 /*
- * Copyright (c) 2012-2016 Isode Limited.
+ * Copyright (c) 2012-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/StdRandomGenerator.h>
 #include <Swiften/Network/DomainNameResolver.h>
 #include <Swiften/Network/StaticDomainNameResolver.h>
 
-/*
- * FIXME: Does not do any caching yet.
- */
 namespace Swift {
     class EventLoop;
+    class EventOwner;
 
+    /**
+     * Caches the results of service and address lookups of another resolver.
+     *
+     * Results are kept for the time to live reported by the real resolver,
+     * or for the default time to live if it does not report one. Lookups
+     * that fail or return no records are kept for the (shorter) negative
+     * time to live. Identical lookups that are started while a lookup is
+     * in flight share its result instead of querying the real resolver again.
+     *
+     * Service records are ordered anew (see \ref DomainNameServiceQuery::sortResults)
+     * for every result, so results from the cache are not all in the same order.
+     *
+     * Results (also cached ones) are always delivered asynchronously, from the
+     * event loop.
+     */
     class SWIFTEN_API CachingDomainNameResolver : public DomainNameResolver {
+        public:
+            struct Statistics {
+                /** Lookups answered from the cache. */
+                unsigned long long hits = 0;
+                /** Lookups that were sent to the real resolver. */
+                unsigned long long misses = 0;
+                /** Lookups that joined a lookup that was already in flight. */
+                unsigned long long coalesced = 0;
+                /** Lookups of the real resolver that are currently in flight. */
+                size_t inFlight = 0;
+                /** Results currently in the cache (including expired ones). */
+                size_t entries = 0;
+            };
+
         public:
             CachingDomainNameResolver(DomainNameResolver* realResolver, EventLoop* eventLoop);
             ~CachingDomainNameResolver();
@@ -26,7 +60,86 @@ namespace Swift {
             virtual DomainNameServiceQuery::ref createServiceQuery(const std::string& serviceLookupPrefix, const std::string& domain);
             virtual DomainNameAddressQuery::ref createAddressQuery(const std::string& name);
 
+            /**
+             * Sets how long results are cached if the real resolver does not
+             * report a time to live. Defaults to 5 minutes.
+             */
+            void setDefaultTTL(std::chrono::seconds ttl) {
+                defaultTTL = ttl;
+            }
+
+            /**
+             * Sets the maximum time failed or empty lookups are cached.
+             * Defaults to 10 seconds. A value of 0 disables negative caching.
+             */
+            void setNegativeTTL(std::chrono::seconds ttl) {
+                negativeTTL = ttl;
+            }
+
+            /**
+             * Sets the generator used to order service records. The generator is
+             * not owned. Defaults to a \ref StdRandomGenerator.
+             */
+            void setRandomGenerator(RandomGenerator* generator) {
+                randomGenerator = generator;
+            }
+
+            /**
+             * Removes all cached results. Lookups in flight are not affected.
+             */
+            void clear();
+
+            Statistics getStatistics() const;
+
+        private:
+            class ServiceQuery;
+            class AddressQuery;
+
+            template<typename Result>
+            struct CacheEntry {
+                Result result;
+                std::chrono::steady_clock::time_point expires;
+            };
+
+            struct ServiceResult {
+                std::vector<DomainNameServiceQuery::Result> records;
+            };
+
+            struct AddressResult {
+                std::vector<HostAddress> addresses;
+                boost::optional<DomainNameResolveError> error;
+            };
+
+            struct ServiceLookup {
+                DomainNameServiceQuery::ref realQuery;
+                std::vector<std::shared_ptr<ServiceQuery> > queries;
+            };
+
+            struct AddressLookup {
+                DomainNameAddressQuery::ref realQuery;
+                std::vector<std::shared_ptr<AddressQuery> > queries;
+            };
+
+            void runServiceQuery(std::shared_ptr<ServiceQuery> query);
+            void runAddressQuery(std::shared_ptr<AddressQuery> query);
+            void handleServiceQueryResult(const std::string& name, const std::vector<DomainNameServiceQuery::Result>& records);
+            void handleAddressQueryResult(const std::string& name, const std::vector<HostAddress>& addresses, boost::optional<DomainNameResolveError> error);
+            std::vector<DomainNameServiceQuery::Result> getSortedRecords(const std::vector<DomainNameServiceQuery::Result>& records);
+            std::chrono::steady_clock::time_point getExpiryTime(std::chrono::steady_clock::time_point now, boost::optional<std::chrono::seconds> ttl, bool negative) const;
+            void removeExpiredEntries(std::chrono::steady_clock::time_point now);
+
         private:
             DomainNameResolver* realResolver;
+            EventLoop* eventLoop;
+            std::shared_ptr<EventOwner> eventOwner;
+            std::chrono::seconds defaultTTL;
+            std::chrono::seconds negativeTTL;
+            StdRandomGenerator defaultRandomGenerator;
+            RandomGenerator* randomGenerator;
+            std::map<std::string, ServiceLookup> serviceLookups;
+            std::map<std::string, AddressLookup> addressLookups;
+            std::map<std::string, CacheEntry<ServiceResult> > serviceCache;
+            std::map<std::string, CacheEntry<AddressResult> > addressCache;
+            Statistics statistics;
     };
 }
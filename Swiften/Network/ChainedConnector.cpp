@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -44,6 +44,10 @@ void ChainedConnector::setTimeoutMilliseconds(int milliseconds) {
     timeoutMilliseconds = milliseconds;
 }
 
+void ChainedConnector::setConnectionAttemptDelayMilliseconds(int milliseconds) {
+    connectionAttemptDelayMilliseconds = milliseconds;
+}
+
 void ChainedConnector::start() {
     SWIFT_LOG(debug) << "Starting queued connector for " << hostname << std::endl;
 
@@ -72,6 +76,9 @@ void ChainedConnector::tryNextConnectionFactory() {
         connectionFactoryQueue.pop_front();
         currentConnector = Connector::create(hostname, port, serviceLookupPrefix, resolver, connectionFactory, timerFactory);
         currentConnector->setTimeoutMilliseconds(timeoutMilliseconds);
+        if (connectionAttemptDelayMilliseconds) {
+            currentConnector->setConnectionAttemptDelayMilliseconds(*connectionAttemptDelayMilliseconds);
+        }
         currentConnector->onConnectFinished.connect(boost::bind(&ChainedConnector::handleConnectorFinished, this, _1, _2));
         currentConnector->start();
     }
@@ -81,6 +88,7 @@ void ChainedConnector::handleConnectorFinished(std::shared_ptr<Connection> conne
     SWIFT_LOG(debug) << "Connector finished" << std::endl;
     currentConnector->onConnectFinished.disconnect(boost::bind(&ChainedConnector::handleConnectorFinished, this, _1, _2));
     lastError = error;
+    connectLatency = currentConnector->getConnectLatency();
     currentConnector.reset();
     if (connection) {
         finish(connection, error);
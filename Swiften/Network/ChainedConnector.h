@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
@@ -30,6 +31,19 @@ namespace Swift {
             ~ChainedConnector();
 
             void setTimeoutMilliseconds(int milliseconds);
+
+            /**
+             * See Connector::setConnectionAttemptDelayMilliseconds().
+             */
+            void setConnectionAttemptDelayMilliseconds(int milliseconds);
+
+            /**
+             * Returns the time it took to connect, once a connection was made.
+             */
+            boost::optional<std::chrono::milliseconds> getConnectLatency() const {
+                return connectLatency;
+            }
+
             void start();
             void stop();
 
@@ -48,8 +62,10 @@ namespace Swift {
             std::vector<ConnectionFactory*> connectionFactories;
             TimerFactory* timerFactory;
             int timeoutMilliseconds;
+            boost::optional<int> connectionAttemptDelayMilliseconds;
             std::deque<ConnectionFactory*> connectionFactoryQueue;
             std::shared_ptr<Connector> currentConnector;
             std::shared_ptr<Error> lastError;
+            boost::optional<std::chrono::milliseconds> connectLatency;
     };
 }
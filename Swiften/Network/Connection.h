@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 #include <boost/signals2.hpp>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/ByteArray.h>
 #include <Swiften/Base/SafeByteArray.h>
 
 namespace Swift {
@@ -33,6 +34,15 @@ namespace Swift {
             virtual void disconnect() = 0;
             virtual void write(const SafeByteArray& data) = 0;
 
+            /**
+             * Writes a buffer that is not changed anymore after this call.
+             *
+             * Connections that can write the buffer as it is keep a reference
+             * to it until it is written, instead of copying it. By default,
+             * the data is copied and passed to \ref write.
+             */
+            virtual void writeBuffer(std::shared_ptr<const ByteArray> data);
+
             virtual HostAddressPort getLocalAddress() const = 0;
             virtual HostAddressPort getRemoteAddress() const = 0;
 
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/Network/ConnectionRace.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <boost/bind.hpp>
+
+#include <Swiften/Base/Log.h>
+#include <Swiften/Network/Connection.h>
+#include <Swiften/Network/ConnectionFactory.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimerFactory.h>
+
+namespace Swift {
+
+ConnectionRace::ConnectionRace(ConnectionFactory* connectionFactory, TimerFactory* timerFactory, int attemptDelayMilliseconds, int timeoutMilliseconds) : connectionFactory(connectionFactory), timerFactory(timerFactory), attemptDelayMilliseconds(attemptDelayMilliseconds), timeoutMilliseconds(timeoutMilliseconds), complete(false), finished(false), waitingForCandidates(true) {
+}
+
+ConnectionRace::~ConnectionRace() {
+    if (attemptDelayTimer) {
+        attemptDelayTimer->stop();
+    }
+}
+
+void ConnectionRace::addCandidates(const std::vector<HostAddressPort>& newCandidates) {
+    assert(!complete);
+    // The race may be released by the handler of onFinished
+    ConnectionRace::ref protectedThis = shared_from_this();
+    // Alternate between address families, starting with IPv6 (RFC 8305, section 4)
+    std::vector<HostAddressPort> ipv6Candidates;
+    std::vector<HostAddressPort> ipv4Candidates;
+    for (const auto& candidate : newCandidates) {
+        if (candidate.getAddress().getRawAddress().is_v6()) {
+            ipv6Candidates.push_back(candidate);
+        }
+        else {
+            ipv4Candidates.push_back(candidate);
+        }
+    }
+    for (size_t i = 0; i < std::max(ipv6Candidates.size(), ipv4Candidates.size()); ++i) {
+        if (i < ipv6Candidates.size()) {
+            candidates.push_back(ipv6Candidates[i]);
+        }
+        if (i < ipv4Candidates.size()) {
+            candidates.push_back(ipv4Candidates[i]);
+        }
+    }
+
+    if (!finished && waitingForCandidates && !candidates.empty()) {
+        startNextAttempt();
+    }
+}
+
+void ConnectionRace::setComplete() {
+    ConnectionRace::ref protectedThis = shared_from_this();
+    complete = true;
+    if (!finished && candidates.empty() && attempts.empty()) {
+        finished = true;
+        onFinished(std::shared_ptr<Connection>());
+    }
+}
+
+void ConnectionRace::stop() {
+    finished = true;
+    candidates.clear();
+    if (attemptDelayTimer) {
+        attemptDelayTimer->stop();
+        attemptDelayTimerConnection.disconnect();
+    }
+    for (auto& attempt : attempts) {
+        cancelAttempt(attempt);
+    }
+    attempts.clear();
+}
+
+void ConnectionRace::startNextAttempt() {
+    assert(!candidates.empty());
+    waitingForCandidates = false;
+
+    Attempt attempt;
+    attempt.target = candidates.front();
+    candidates.pop_front();
+    SWIFT_LOG(debug) << "Trying to connect to " << attempt.target.getAddress().toString() << ":" << attempt.target.getPort() << std::endl;
+    attempt.connection = connectionFactory->createConnection();
+    attempt.startTime = std::chrono::steady_clock::now();
+    attempt.onConnectFinishedConnection = attempt.connection->onConnectFinished.connect(boost::bind(&ConnectionRace::handleConnectFinished, shared_from_this(), attempt.connection, _1));
+    if (timeoutMilliseconds > 0) {
+        attempt.timer = timerFactory->createTimer(timeoutMilliseconds);
+        attempt.onTickConnection = attempt.timer->onTick.connect(boost::bind(&ConnectionRace::handleAttemptTimeout, shared_from_this(), attempt.connection));
+        attempt.timer->start();
+    }
+    std::shared_ptr<Connection> connection = attempt.connection;
+    attempts.push_back(attempt);
+
+    if (attemptDelayMilliseconds > 0) {
+        if (!attemptDelayTimer) {
+            attemptDelayTimer = timerFactory->createTimer(attemptDelayMilliseconds);
+            attemptDelayTimerConnection = attemptDelayTimer->onTick.connect(boost::bind(&ConnectionRace::handleAttemptDelayTimeout, shared_from_this()));
+        }
+        attemptDelayTimer->stop();
+        attemptDelayTimer->start();
+    }
+
+    connection->connect(attempt.target);
+}
+
+void ConnectionRace::handleConnectFinished(std::shared_ptr<Connection> connection, bool error) {
+    auto attempt = findAttempt(connection);
+    if (attempt == attempts.end()) {
+        return;
+    }
+    attempt->onConnectFinishedConnection.disconnect();
+    if (attempt->timer) {
+        attempt->timer->stop();
+        attempt->onTickConnection.disconnect();
+    }
+
+    if (error) {
+        SWIFT_LOG(debug) << "Connecting to " << attempt->target.getAddress().toString() << ":" << attempt->target.getPort() << " failed" << std::endl;
+        attempts.erase(attempt);
+        handleAttemptFailed();
+    }
+    else {
+        connectLatency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - attempt->startTime);
+        SWIFT_LOG(debug) << "Connected to " << attempt->target.getAddress().toString() << ":" << attempt->target.getPort() << " in " << connectLatency->count() << " ms" << std::endl;
+        attempts.erase(attempt);
+        stop();
+        onFinished(connection);
+    }
+}
+
+void ConnectionRace::handleAttemptTimeout(std::shared_ptr<Connection> connection) {
+    auto attempt = findAttempt(connection);
+    if (attempt == attempts.end()) {
+        return;
+    }
+    SWIFT_LOG(debug) << "Connecting to " << attempt->target.getAddress().toString() << ":" << attempt->target.getPort() << " timed out" << std::endl;
+    cancelAttempt(*attempt);
+    attempts.erase(attempt);
+    handleAttemptFailed();
+}
+
+void ConnectionRace::handleAttemptDelayTimeout() {
+    if (finished) {
+        return;
+    }
+    if (candidates.empty()) {
+        waitingForCandidates = true;
+    }
+    else {
+        startNextAttempt();
+    }
+}
+
+void ConnectionRace::handleAttemptFailed() {
+    if (finished) {
+        return;
+    }
+    if (!candidates.empty()) {
+        startNextAttempt();
+    }
+    else if (complete && attempts.empty()) {
+        stop();
+        onFinished(std::shared_ptr<Connection>());
+    }
+    else {
+        waitingForCandidates = true;
+    }
+}
+
+void ConnectionRace::cancelAttempt(Attempt& attempt) {
+    attempt.onConnectFinishedConnection.disconnect();
+    if (attempt.timer) {
+        attempt.timer->stop();
+        attempt.onTickConnection.disconnect();
+    }
+    attempt.connection->disconnect();
+}
+
+std::vector<ConnectionRace::Attempt>::iterator ConnectionRace::findAttempt(std::shared_ptr<Connection> connection) {
+    return std::find_if(attempts.begin(), attempts.end(), [&](const Attempt& attempt) { return attempt.connection == connection; });
+}
+
+}
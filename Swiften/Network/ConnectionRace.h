@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/signals2.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Network/HostAddressPort.h>
+
+namespace Swift {
+    class Connection;
+    class ConnectionFactory;
+    class Timer;
+    class TimerFactory;
+
+    /**
+     * Races connection attempts to a list of candidate addresses (RFC 8305).
+     *
+     * Candidates are tried in the order they are added, with IPv6 and IPv4
+     * addresses of each batch interleaved. A new attempt starts when the
+     * previous one fails, or when the attempt delay passes without the
+     * previous attempt finishing; earlier attempts keep running. The first
+     * attempt that succeeds wins, and all other attempts are cancelled.
+     *
+     * Candidates can be added while the race is running (e.g. while the
+     * addresses of the next SRV target are being resolved).
+     * \ref onFinished is emitted with a null connection when all attempts
+     * failed and \ref setComplete() was called.
+     */
+    class SWIFTEN_API ConnectionRace : public std::enable_shared_from_this<ConnectionRace> {
+        public:
+            typedef std::shared_ptr<ConnectionRace> ref;
+
+            /**
+             * @param attemptDelayMilliseconds The time to wait for an attempt before
+             *  starting the next one. A value of 0 tries the candidates one at a time.
+             * @param timeoutMilliseconds The time after which an attempt is cancelled
+             *  (0 for no timeout).
+             */
+            static ConnectionRace::ref create(ConnectionFactory* connectionFactory, TimerFactory* timerFactory, int attemptDelayMilliseconds, int timeoutMilliseconds) {
+                return ref(new ConnectionRace(connectionFactory, timerFactory, attemptDelayMilliseconds, timeoutMilliseconds));
+            }
+
+            ~ConnectionRace();
+
+            void addCandidates(const std::vector<HostAddressPort>& candidates);
+
+            /**
+             * Signals that no more candidates will be added.
+             */
+            void setComplete();
+
+            /**
+             * Cancels all attempts. \ref onFinished is not emitted.
+             */
+            void stop();
+
+            /**
+             * Returns the time it took the winning attempt to connect.
+             */
+            boost::optional<std::chrono::milliseconds> getConnectLatency() const {
+                return connectLatency;
+            }
+
+            boost::signals2::signal<void (std::shared_ptr<Connection>)> onFinished;
+
+        private:
+            ConnectionRace(ConnectionFactory*, TimerFactory*, int attemptDelayMilliseconds, int timeoutMilliseconds);
+
+            struct Attempt {
+                std::shared_ptr<Connection> connection;
+                std::shared_ptr<Timer> timer;
+                HostAddressPort target;
+                std::chrono::steady_clock::time_point startTime;
+                boost::signals2::connection onConnectFinishedConnection;
+                boost::signals2::connection onTickConnection;
+            };
+
+            void startNextAttempt();
+            void handleConnectFinished(std::shared_ptr<Connection> connection, bool error);
+            void handleAttemptTimeout(std::shared_ptr<Connection> connection);
+            void handleAttemptDelayTimeout();
+            void handleAttemptFailed();
+            void cancelAttempt(Attempt& attempt);
+            std::vector<Attempt>::iterator findAttempt(std::shared_ptr<Connection> connection);
+
+        private:
+            ConnectionFactory* connectionFactory;
+            TimerFactory* timerFactory;
+            int attemptDelayMilliseconds;
+            int timeoutMilliseconds;
+            std::shared_ptr<Timer> attemptDelayTimer;
+            boost::signals2::connection attemptDelayTimerConnection;
+            std::deque<HostAddressPort> candidates;
+            std::vector<Attempt> attempts;
+            bool complete;
+            bool finished;
+            bool waitingForCandidates;
+            boost::optional<std::chrono::milliseconds> connectLatency;
+    };
+}
@@ -10,6 +10,7 @@
 
 #include <Swiften/Base/Log.h>
 #include <Swiften/Network/ConnectionFactory.h>
+#include <Swiften/Network/ConnectionRace.h>
 #include <Swiften/Network/DomainNameAddressQuery.h>
 #include <Swiften/Network/DomainNameResolver.h>
 #include <Swiften/Network/HostAddress.h>
@@ -17,24 +18,25 @@
 
 namespace Swift {
 
-Connector::Connector(const std::string& hostname, int port, const boost::optional<std::string>& serviceLookupPrefix, DomainNameResolver* resolver, ConnectionFactory* connectionFactory, TimerFactory* timerFactory) : hostname(hostname), port(port), serviceLookupPrefix(serviceLookupPrefix), resolver(resolver), connectionFactory(connectionFactory), timerFactory(timerFactory), timeoutMilliseconds(0), queriedAllServices(true), foundSomeDNS(false) {
+Connector::Connector(const std::string& hostname, int port, const boost::optional<std::string>& serviceLookupPrefix, DomainNameResolver* resolver, ConnectionFactory* connectionFactory, TimerFactory* timerFactory) : hostname(hostname), port(port), serviceLookupPrefix(serviceLookupPrefix), resolver(resolver), connectionFactory(connectionFactory), timerFactory(timerFactory), timeoutMilliseconds(0), connectionAttemptDelayMilliseconds(250), queriedAllServices(true), foundSomeDNS(false) {
 }
 
 void Connector::setTimeoutMilliseconds(int milliseconds) {
     timeoutMilliseconds = milliseconds;
 }
 
+void Connector::setConnectionAttemptDelayMilliseconds(int milliseconds) {
+    connectionAttemptDelayMilliseconds = milliseconds;
+}
+
 void Connector::start() {
     SWIFT_LOG(debug) << "Starting connector for " << hostname << std::endl;
-    assert(!currentConnection);
+    assert(!race);
     assert(!serviceQuery);
-    assert(!timer);
     queriedAllServices = false;
     auto hostAddress = HostAddress::fromString(hostname);
-    if (timeoutMilliseconds > 0) {
-        timer = timerFactory->createTimer(timeoutMilliseconds);
-        timer->onTick.connect(boost::bind(&Connector::handleTimeout, shared_from_this()));
-    }
+    race = ConnectionRace::create(connectionFactory, timerFactory, connectionAttemptDelayMilliseconds, timeoutMilliseconds);
+    race->onFinished.connect(boost::bind(&Connector::handleRaceFinished, shared_from_this(), _1));
     if (serviceLookupPrefix) {
         serviceQuery = resolver->createServiceQuery(*serviceLookupPrefix, hostname);
         serviceQuery->onResult.connect(boost::bind(&Connector::handleServiceQueryResult, shared_from_this(), _1));
@@ -43,18 +45,19 @@ void Connector::start() {
     else if (hostAddress) {
         // hostname is already a valid address; skip name lookup.
         foundSomeDNS = true;
-        addressQueryResults.push_back(hostAddress.get());
-        tryNextAddress();
-    } else {
+        queriedAllServices = true;
+        tryConnect(std::vector<HostAddress>(1, hostAddress.get()), (port == -1 ? 5222 : port));
+        if (race) {
+            race->setComplete();
+        }
+    }
+    else {
+        queriedAllServices = true;
         queryAddress(hostname);
     }
 }
 
 void Connector::stop() {
-    if (currentConnection) {
-        currentConnection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-        currentConnection->disconnect();
-    }
     finish(std::shared_ptr<Connection>());
 }
 
@@ -72,112 +75,63 @@ void Connector::handleServiceQueryResult(const std::vector<DomainNameServiceQuer
     if (!serviceQueryResults.empty()) {
         foundSomeDNS = true;
     }
-    tryNextServiceOrFallback();
+    queryNextServiceOrFallback();
 }
 
-void Connector::tryNextServiceOrFallback() {
-    if (queriedAllServices) {
-        SWIFT_LOG(debug) << "Queried all services" << std::endl;
-        finish(std::shared_ptr<Connection>());
+void Connector::queryNextServiceOrFallback() {
+    if (!serviceQueryResults.empty()) {
+        SWIFT_LOG(debug) << "Querying next address" << std::endl;
+        queryAddress(serviceQueryResults.front().hostname);
     }
-    else if (serviceQueryResults.empty()) {
+    else if (!queriedAllServices) {
         SWIFT_LOG(debug) << "Falling back on A resolution" << std::endl;
         // Fall back on simple address resolving
         queriedAllServices = true;
         queryAddress(hostname);
     }
     else {
-        SWIFT_LOG(debug) << "Querying next address" << std::endl;
-        queryAddress(serviceQueryResults.front().hostname);
+        SWIFT_LOG(debug) << "Queried all services" << std::endl;
+        race->setComplete();
     }
 }
 
 void Connector::handleAddressQueryResult(const std::vector<HostAddress>& addresses, boost::optional<DomainNameResolveError> error) {
     SWIFT_LOG(debug) << addresses.size() << " addresses" << std::endl;
     addressQuery.reset();
-    if (error || addresses.empty()) {
-        if (!serviceQueryResults.empty()) {
-            serviceQueryResults.pop_front();
-        }
-        tryNextServiceOrFallback();
+    int connectPort = (port == -1 ? 5222 : port);
+    if (!serviceQueryResults.empty()) {
+        connectPort = serviceQueryResults.front().port;
+        serviceQueryResults.pop_front();
     }
-    else {
+    if (!error && !addresses.empty()) {
         foundSomeDNS = true;
-        addressQueryResults = std::deque<HostAddress>(addresses.begin(), addresses.end());
-        tryNextAddress();
+        tryConnect(addresses, connectPort);
     }
-}
-
-void Connector::tryNextAddress() {
-    if (addressQueryResults.empty()) {
-        SWIFT_LOG(debug) << "Done trying addresses. Moving on." << std::endl;
-        // Done trying all addresses. Move on to the next host.
-        if (!serviceQueryResults.empty()) {
-            serviceQueryResults.pop_front();
-        }
-        tryNextServiceOrFallback();
-    }
-    else {
-        SWIFT_LOG(debug) << "Trying next address" << std::endl;
-        HostAddress address = addressQueryResults.front();
-        addressQueryResults.pop_front();
-
-        int connectPort = (port == -1 ? 5222 : port);
-        if (!serviceQueryResults.empty()) {
-            connectPort = serviceQueryResults.front().port;
-        }
-
-        tryConnect(HostAddressPort(address, connectPort));
+    // Resolve the next host while connecting, so its addresses can join the race
+    if (race) {
+        queryNextServiceOrFallback();
     }
 }
 
-void Connector::tryConnect(const HostAddressPort& target) {
-    assert(!currentConnection);
-    SWIFT_LOG(debug) << "Trying to connect to " << target.getAddress().toString() << ":" << target.getPort() << std::endl;
-    currentConnection = connectionFactory->createConnection();
-    currentConnection->onConnectFinished.connect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-    currentConnection->connect(target);
-    if (timer) {
-        timer->start();
+void Connector::tryConnect(const std::vector<HostAddress>& addresses, int connectPort) {
+    std::vector<HostAddressPort> candidates;
+    for (const auto& address : addresses) {
+        candidates.push_back(HostAddressPort(address, connectPort));
     }
+    race->addCandidates(candidates);
 }
 
-void Connector::handleConnectionConnectFinished(bool error) {
-    SWIFT_LOG(debug) << "ConnectFinished: " << (error ? "error" : "success") << std::endl;
-    if (timer) {
-            timer->stop();
-            timer.reset();
-    }
-    if (!currentConnection) {
-        // We've hit a race condition where multiple finisheds were on the eventloop queue at once.
-        // This is particularly likely on macOS where the hourly momentary wakeup while asleep
-        // can cause both a timeout and an onConnectFinished to be queued sequentially (SWIFT-232).
-        // Let the first one process as normal, but ignore the second.
-        return;
-    }
-    currentConnection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-    if (error) {
-        currentConnection.reset();
-        if (!addressQueryResults.empty()) {
-            tryNextAddress();
-        }
-        else {
-            if (!serviceQueryResults.empty()) {
-                serviceQueryResults.pop_front();
-            }
-            tryNextServiceOrFallback();
-        }
-    }
-    else {
-        finish(currentConnection);
-    }
+void Connector::handleRaceFinished(std::shared_ptr<Connection> connection) {
+    SWIFT_LOG(debug) << "ConnectFinished: " << (connection ? "success" : "error") << std::endl;
+    connectLatency = race->getConnectLatency();
+    finish(connection);
 }
 
 void Connector::finish(std::shared_ptr<Connection> connection) {
-    if (timer) {
-        timer->stop();
-        timer->onTick.disconnect(boost::bind(&Connector::handleTimeout, shared_from_this()));
-        timer.reset();
+    if (race) {
+        race->onFinished.disconnect(boost::bind(&Connector::handleRaceFinished, shared_from_this(), _1));
+        race->stop();
+        race.reset();
     }
     if (serviceQuery) {
         serviceQuery->onResult.disconnect(boost::bind(&Connector::handleServiceQueryResult, shared_from_this(), _1));
@@ -187,17 +141,7 @@ void Connector::finish(std::shared_ptr<Connection> connection) {
         addressQuery->onResult.disconnect(boost::bind(&Connector::handleAddressQueryResult, shared_from_this(), _1, _2));
         addressQuery.reset();
     }
-    if (currentConnection) {
-        currentConnection->onConnectFinished.disconnect(boost::bind(&Connector::handleConnectionConnectFinished, shared_from_this(), _1));
-        currentConnection.reset();
-    }
     onConnectFinished(connection, (connection || foundSomeDNS) ? std::shared_ptr<Error>() : std::make_shared<DomainNameResolveError>());
 }
 
-void Connector::handleTimeout() {
-    SWIFT_LOG(debug) << "Timeout" << std::endl;
-    SWIFT_LOG_ASSERT(currentConnection, error) << "Connection not valid but triggered a timeout" <<std::endl;
-    handleConnectionConnectFinished(true);
-}
-
 }
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
@@ -24,8 +25,17 @@ namespace Swift {
     class DomainNameAddressQuery;
     class DomainNameResolver;
     class ConnectionFactory;
+    class ConnectionRace;
     class TimerFactory;
 
+    /**
+     * Connects to a host, looking up its SRV records and addresses.
+     *
+     * The addresses of all SRV targets (and of the host itself, as a fallback)
+     * are raced against each other (see \ref ConnectionRace): connection
+     * attempts are started one after the other, without waiting for earlier
+     * attempts to time out, and the first connection that succeeds is used.
+     */
     class SWIFTEN_API Connector : public boost::signals2::trackable, public std::enable_shared_from_this<Connector> {
         public:
             typedef std::shared_ptr<Connector> ref;
@@ -34,7 +44,26 @@ namespace Swift {
                 return ref(new Connector(hostname, port, serviceLookupPrefix, resolver, connectionFactory, timerFactory));
             }
 
+            /**
+             * Sets the time after which a connection attempt to a single
+             * address is given up.
+             */
             void setTimeoutMilliseconds(int milliseconds);
+
+            /**
+             * Sets the time to wait for a connection attempt before starting
+             * an attempt to the next address. Defaults to 250 ms; a value of 0
+             * tries the addresses one at a time.
+             */
+            void setConnectionAttemptDelayMilliseconds(int milliseconds);
+
+            /**
+             * Returns the time it took to connect to the address that was used.
+             */
+            boost::optional<std::chrono::milliseconds> getConnectLatency() const {
+                return connectLatency;
+            }
+
             /**
              * Start the connection attempt.
              * Note that after calling this method, the caller is responsible for calling #stop()
@@ -52,13 +81,11 @@ namespace Swift {
             void handleAddressQueryResult(const std::vector<HostAddress>& address, boost::optional<DomainNameResolveError> error);
             void queryAddress(const std::string& hostname);
 
-            void tryNextServiceOrFallback();
-            void tryNextAddress();
-            void tryConnect(const HostAddressPort& target);
+            void queryNextServiceOrFallback();
+            void tryConnect(const std::vector<HostAddress>& addresses, int port);
 
-            void handleConnectionConnectFinished(bool error);
+            void handleRaceFinished(std::shared_ptr<Connection>);
             void finish(std::shared_ptr<Connection>);
-            void handleTimeout();
 
 
         private:
@@ -69,13 +96,13 @@ namespace Swift {
             ConnectionFactory* connectionFactory;
             TimerFactory* timerFactory;
             int timeoutMilliseconds;
-            std::shared_ptr<Timer> timer;
+            int connectionAttemptDelayMilliseconds;
             std::shared_ptr<DomainNameServiceQuery> serviceQuery;
             std::deque<DomainNameServiceQuery::Result> serviceQueryResults;
             std::shared_ptr<DomainNameAddressQuery> addressQuery;
-            std::deque<HostAddress> addressQueryResults;
             bool queriedAllServices;
-            std::shared_ptr<Connection> currentConnection;
+            std::shared_ptr<ConnectionRace> race;
             bool foundSomeDNS;
+            boost::optional<std::chrono::milliseconds> connectLatency;
     };
 }
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include <boost/optional.hpp>
@@ -23,6 +24,12 @@ namespace Swift {
 
             virtual void run() = 0;
 
+            /**
+             * Returns the time to live of the addresses of the last result,
+             * if the resolver knows it.
+             */
+            virtual boost::optional<std::chrono::seconds> getTTL() const;
+
             boost::signals2::signal<void (const std::vector<HostAddress>&, boost::optional<DomainNameResolveError>)> onResult;
     };
 }
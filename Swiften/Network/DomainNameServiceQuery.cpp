@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -34,6 +34,10 @@ namespace Swift {
 DomainNameServiceQuery::~DomainNameServiceQuery() {
 }
 
+boost::optional<std::chrono::seconds> DomainNameServiceQuery::getTTL() const {
+    return boost::optional<std::chrono::seconds>();
+}
+
 void DomainNameServiceQuery::sortResults(std::vector<DomainNameServiceQuery::Result>& queries, RandomGenerator& generator) {
     ResultPriorityComparator comparator;
     std::stable_sort(queries.begin(), queries.end(), comparator);
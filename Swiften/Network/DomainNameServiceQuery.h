@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -34,6 +35,13 @@ namespace Swift {
             virtual ~DomainNameServiceQuery();
 
             virtual void run() = 0;
+
+            /**
+             * Returns the time to live of the records of the last result,
+             * if the resolver knows it.
+             */
+            virtual boost::optional<std::chrono::seconds> getTTL() const;
+
             static void sortResults(std::vector<DomainNameServiceQuery::Result>& queries, RandomGenerator& generator);
 
             boost::signals2::signal<void (const std::vector<Result>&)> onResult;
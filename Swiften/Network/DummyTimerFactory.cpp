@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -48,12 +48,14 @@ std::shared_ptr<Timer> DummyTimerFactory::createTimer(int milliseconds) {
 
 void DummyTimerFactory::setTime(int time) {
     assert(time > currentTime);
+    int previousTime = currentTime;
+    // Timers started by tick handlers start at the new time
+    currentTime = time;
     for (auto&& timer : timers) {
-        if (timer->getAlarmTime() > currentTime && timer->getAlarmTime() <= time && timer->isRunning) {
+        if (timer->getAlarmTime() > previousTime && timer->getAlarmTime() <= time && timer->isRunning) {
             timer->onTick();
         }
     }
-    currentTime = time;
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -51,6 +51,8 @@ void TLSConnection::handleTLSDataForApplication(const SafeByteArray& data) {
 }
 
 void TLSConnection::connect(const HostAddressPort& address) {
+    // The host name is not known here, so sessions are only keyed by address, without SNI
+    context->setServerIdentity(address.getAddress().toString(), address.getPort(), "");
     connection->connect(address);
 }
 
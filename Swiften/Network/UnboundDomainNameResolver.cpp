@@ -5,13 +5,15 @@
  */
 
 /*
- * Copyright (c) 2016 Isode Limited.
+ * Copyright (c) 2016-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Network/UnboundDomainNameResolver.h>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -69,12 +71,18 @@ class UnboundDomainNameServiceQuery : public DomainNameServiceQuery, public Unbo
             }
         }
 
+        virtual boost::optional<std::chrono::seconds> getTTL() const {
+            return ttl;
+        }
+
         void handleResult(int err, struct ub_result* result) {
             std::vector<DomainNameServiceQuery::Result> serviceRecords;
+            ttl = boost::optional<std::chrono::seconds>();
 
             if(err != 0) {
                 SWIFT_LOG(debug) << "resolve error: " << ub_strerror(err) << std::endl;
             } else {
+                ttl = std::chrono::seconds(result->ttl);
                 if(result->havedata) {
                     ldns_pkt* replyPacket = 0;
                     ldns_buffer* buffer = ldns_buffer_new(1024);
@@ -105,6 +113,7 @@ class UnboundDomainNameServiceQuery : public DomainNameServiceQuery, public Unbo
 
                             serviceRecord.hostname = std::string(reinterpret_cast<char*>(ldns_buffer_at(buffer, 0)));
                             serviceRecords.push_back(serviceRecord);
+                            ttl = std::min(*ttl, std::chrono::seconds(ldns_rr_ttl(rr)));
                             SWIFT_LOG(debug) << "hostname " << serviceRecord.hostname << " added" << std::endl;
                         }
                     }
@@ -119,6 +128,7 @@ class UnboundDomainNameServiceQuery : public DomainNameServiceQuery, public Unbo
 
     private:
         std::string name;
+        boost::optional<std::chrono::seconds> ttl;
 };
 
 class UnboundDomainNameAddressQuery : public DomainNameAddressQuery, public UnboundQuery, public std::enable_shared_from_this<UnboundDomainNameAddressQuery> {
@@ -142,15 +152,21 @@ class UnboundDomainNameAddressQuery : public DomainNameAddressQuery, public Unbo
             }
         }
 
+        virtual boost::optional<std::chrono::seconds> getTTL() const {
+            return ttl;
+        }
+
         void handleResult(int err, struct ub_result* result) {
             std::vector<HostAddress> addresses;
             boost::optional<DomainNameResolveError> error;
+            ttl = boost::optional<std::chrono::seconds>();
             SWIFT_LOG(debug) << "Result for: " << name << std::endl;
 
             if(err != 0) {
                 SWIFT_LOG(debug) << "resolve error: " << ub_strerror(err) << std::endl;
                 error = DomainNameResolveError();
             } else {
+                ttl = std::chrono::seconds(result->ttl);
                 if(result->havedata) {
                     for(int i=0; result->data[i]; i++) {
                         char address[100];
@@ -177,6 +193,7 @@ class UnboundDomainNameAddressQuery : public DomainNameAddressQuery, public Unbo
 
     private:
         std::string name;
+        boost::optional<std::chrono::seconds> ttl;
 };
 
 UnboundDomainNameResolver::UnboundDomainNameResolver(IDNConverter* idnConverter, std::shared_ptr<boost::asio::io_service> ioService, EventLoop* eventLoop) : idnConverter(idnConverter), ioService(ioService), ubDescriptior(*ioService), eventLoop(eventLoop) {
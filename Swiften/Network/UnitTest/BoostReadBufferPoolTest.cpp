@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <algorithm>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Network/BoostReadBufferPool.h>
+
+using namespace Swift;
+
+class BoostReadBufferPoolTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(BoostReadBufferPoolTest);
+        CPPUNIT_TEST(testGetBuffer_RoundsUpToSizeClass);
+        CPPUNIT_TEST(testGetBuffer_RecyclesReleasedBuffer);
+        CPPUNIT_TEST(testGetBuffer_RecyclesShrunkBuffer);
+        CPPUNIT_TEST(testGetBuffer_NewBufferIsZeroed);
+        CPPUNIT_TEST(testGetBuffer_SecureBufferIsZeroedOnReuse);
+        CPPUNIT_TEST(testGetBuffer_SecureShrunkBufferIsZeroedOnReuse);
+        CPPUNIT_TEST(testGetBuffer_InsecureBufferIsNotZeroedOnReuse);
+        CPPUNIT_TEST(testGetBuffer_InsecureShrunkBufferIsNotFilledOnReuse);
+        CPPUNIT_TEST(testGetBuffer_BufferOutlivesIOService);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testGetBuffer_RoundsUpToSizeClass() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4096), testling.getBuffer(100, true)->size());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(16384), testling.getBuffer(5000, true)->size());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(65536), testling.getBuffer(65536, true)->size());
+        }
+
+        void testGetBuffer_RecyclesReleasedBuffer() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, true);
+            const unsigned char* data = vecptr(*buffer);
+            buffer.reset();
+            buffer = testling.getBuffer(4096, true);
+
+            CPPUNIT_ASSERT(data == vecptr(*buffer));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4096), buffer->size());
+        }
+
+        void testGetBuffer_RecyclesShrunkBuffer() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, true);
+            const unsigned char* data = vecptr(*buffer);
+            buffer->resize(10);
+            buffer.reset();
+            buffer = testling.getBuffer(4096, true);
+
+            CPPUNIT_ASSERT(data == vecptr(*buffer));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4096), buffer->size());
+        }
+
+        void testGetBuffer_NewBufferIsZeroed() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, false);
+
+            CPPUNIT_ASSERT(std::all_of(buffer->begin(), buffer->end(), [](unsigned char c) { return c == 0; }));
+        }
+
+        void testGetBuffer_SecureBufferIsZeroedOnReuse() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, true);
+            (*buffer)[0] = 'x';
+            buffer.reset();
+            buffer = testling.getBuffer(4096, true);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>(0), (*buffer)[0]);
+        }
+
+        void testGetBuffer_SecureShrunkBufferIsZeroedOnReuse() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, true);
+            (*buffer)[5] = 'x';
+            buffer->resize(10);
+            buffer.reset();
+            buffer = testling.getBuffer(4096, true);
+
+            CPPUNIT_ASSERT(std::all_of(buffer->begin(), buffer->end(), [](unsigned char c) { return c == 0; }));
+        }
+
+        void testGetBuffer_InsecureBufferIsNotZeroedOnReuse() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, false);
+            (*buffer)[0] = 'x';
+            buffer.reset();
+            buffer = testling.getBuffer(4096, false);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>('x'), (*buffer)[0]);
+        }
+
+        void testGetBuffer_BufferOutlivesIOService() {
+            std::shared_ptr<SafeByteArray> buffer;
+            {
+                boost::asio::io_service ioService;
+                buffer = boost::asio::use_service<BoostReadBufferPool>(ioService).getBuffer(4096, true);
+            }
+            (*buffer)[0] = 'x';
+            buffer.reset();
+        }
+
+        void testGetBuffer_InsecureShrunkBufferIsNotFilledOnReuse() {
+            BoostReadBufferPool& testling = boost::asio::use_service<BoostReadBufferPool>(ioService_);
+
+            std::shared_ptr<SafeByteArray> buffer = testling.getBuffer(4096, false);
+            (*buffer)[20] = 'x';
+            buffer->resize(10);
+            buffer.reset();
+            buffer = testling.getBuffer(4096, false);
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<unsigned char>('x'), (*buffer)[20]);
+        }
+
+    private:
+        boost::asio::io_service ioService_;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BoostReadBufferPoolTest);
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/optional.hpp>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/EventLoop/DummyEventLoop.h>
+#include <Swiften/Network/CachingDomainNameResolver.h>
+#include <Swiften/Network/StaticDomainNameResolver.h>
+
+using namespace Swift;
+
+namespace {
+    // Alternately picks the first and the last candidate
+    class AlternatingRandomGenerator : public RandomGenerator {
+        public:
+            virtual int generateRandomInteger(int max) {
+                pickFirst = !pickFirst;
+                return pickFirst ? 0 : max;
+            }
+
+        private:
+            bool pickFirst = false;
+    };
+}
+
+class CachingDomainNameResolverTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(CachingDomainNameResolverTest);
+        CPPUNIT_TEST(testAddressQuery);
+        CPPUNIT_TEST(testAddressQuery_RepeatedQueryIsAnsweredFromCache);
+        CPPUNIT_TEST(testAddressQuery_ConcurrentQueriesAreCoalesced);
+        CPPUNIT_TEST(testAddressQuery_ExpiredResultIsResolvedAgain);
+        CPPUNIT_TEST(testAddressQuery_FailureIsCached);
+        CPPUNIT_TEST(testAddressQuery_FailureIsNotCachedWithoutNegativeTTL);
+        CPPUNIT_TEST(testServiceQuery_RepeatedQueryIsAnsweredFromCache);
+        CPPUNIT_TEST(testServiceQuery_CachedRecordsAreSortedForEachQuery);
+        CPPUNIT_TEST(testClear);
+        CPPUNIT_TEST(testDestroyWithQueryInFlight);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            eventLoop = new DummyEventLoop();
+            realResolver = new StaticDomainNameResolver(eventLoop);
+            realResolver->addAddress("foo.com", HostAddress::fromString("1.1.1.1").get());
+            realResolver->addXMPPClientService("foo.com", "xmpp.foo.com", 5222);
+            testling = new CachingDomainNameResolver(realResolver, eventLoop);
+        }
+
+        void tearDown() {
+            delete testling;
+            delete realResolver;
+            delete eventLoop;
+        }
+
+        void testAddressQuery() {
+            resolveAddress("foo.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(addressResults.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("1.1.1.1"), addressResults[0].toString());
+            CPPUNIT_ASSERT(!addressError);
+            CPPUNIT_ASSERT_EQUAL(0ULL, testling->getStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().misses);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(testling->getStatistics().inFlight));
+        }
+
+        void testAddressQuery_RepeatedQueryIsAnsweredFromCache() {
+            resolveAddress("foo.com");
+            eventLoop->processEvents();
+            realResolver->addAddress("foo.com", HostAddress::fromString("2.2.2.2").get());
+            addressResults.clear();
+
+            resolveAddress("foo.com");
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(addressResults.size()));
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(addressResults.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("1.1.1.1"), addressResults[0].toString());
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().misses);
+        }
+
+        void testAddressQuery_ConcurrentQueriesAreCoalesced() {
+            resolveAddress("foo.com");
+            resolveAddress("foo.com");
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(testling->getStatistics().inFlight));
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(addressResults.size()));
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().misses);
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().coalesced);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(testling->getStatistics().inFlight));
+        }
+
+        void testAddressQuery_ExpiredResultIsResolvedAgain() {
+            testling->setDefaultTTL(std::chrono::seconds(0));
+            resolveAddress("foo.com");
+            eventLoop->processEvents();
+            realResolver->addAddress("foo.com", HostAddress::fromString("2.2.2.2").get());
+            addressResults.clear();
+
+            resolveAddress("foo.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(addressResults.size()));
+            CPPUNIT_ASSERT_EQUAL(0ULL, testling->getStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(2ULL, testling->getStatistics().misses);
+        }
+
+        void testAddressQuery_FailureIsCached() {
+            resolveAddress("bar.com");
+            eventLoop->processEvents();
+            realResolver->addAddress("bar.com", HostAddress::fromString("2.2.2.2").get());
+            addressError.reset();
+
+            resolveAddress("bar.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT(addressError);
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(addressResults.size()));
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().hits);
+        }
+
+        void testAddressQuery_FailureIsNotCachedWithoutNegativeTTL() {
+            testling->setNegativeTTL(std::chrono::seconds(0));
+            resolveAddress("bar.com");
+            eventLoop->processEvents();
+            realResolver->addAddress("bar.com", HostAddress::fromString("2.2.2.2").get());
+            addressError.reset();
+
+            resolveAddress("bar.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT(!addressError);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(addressResults.size()));
+            CPPUNIT_ASSERT_EQUAL(2ULL, testling->getStatistics().misses);
+        }
+
+        void testServiceQuery_RepeatedQueryIsAnsweredFromCache() {
+            resolveService("_xmpp-client._tcp.", "foo.com");
+            eventLoop->processEvents();
+            realResolver->addXMPPClientService("foo.com", "xmpp2.foo.com", 5222);
+            serviceResults.clear();
+
+            resolveService("_xmpp-client._tcp.", "foo.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(serviceResults.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("xmpp.foo.com"), serviceResults[0].hostname);
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().hits);
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().misses);
+        }
+
+        void testServiceQuery_CachedRecordsAreSortedForEachQuery() {
+            realResolver->addService("_xmpp-server._tcp.bar.com", DomainNameServiceQuery::Result("xmpp1.bar.com", 5269, 0, 10));
+            realResolver->addService("_xmpp-server._tcp.bar.com", DomainNameServiceQuery::Result("xmpp2.bar.com", 5269, 0, 10));
+            AlternatingRandomGenerator generator;
+            testling->setRandomGenerator(&generator);
+
+            resolveService("_xmpp-server._tcp.", "bar.com");
+            eventLoop->processEvents();
+            resolveService("_xmpp-server._tcp.", "bar.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(serviceResults.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("xmpp1.bar.com"), serviceResults[0].hostname);
+            CPPUNIT_ASSERT_EQUAL(std::string("xmpp2.bar.com"), serviceResults[1].hostname);
+            CPPUNIT_ASSERT_EQUAL(std::string("xmpp2.bar.com"), serviceResults[2].hostname);
+            CPPUNIT_ASSERT_EQUAL(std::string("xmpp1.bar.com"), serviceResults[3].hostname);
+            CPPUNIT_ASSERT_EQUAL(1ULL, testling->getStatistics().hits);
+        }
+
+        void testClear() {
+            resolveAddress("foo.com");
+            eventLoop->processEvents();
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(testling->getStatistics().entries));
+
+            testling->clear();
+            resolveAddress("foo.com");
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(2ULL, testling->getStatistics().misses);
+        }
+
+        void testDestroyWithQueryInFlight() {
+            resolveAddress("foo.com");
+            delete testling;
+            testling = nullptr;
+
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(addressResults.size()));
+        }
+
+    private:
+        void resolveAddress(const std::string& name) {
+            DomainNameAddressQuery::ref query = testling->createAddressQuery(name);
+            query->onResult.connect(boost::bind(&CachingDomainNameResolverTest::handleAddressResult, this, _1, _2));
+            query->run();
+        }
+
+        void resolveService(const std::string& prefix, const std::string& domain) {
+            DomainNameServiceQuery::ref query = testling->createServiceQuery(prefix, domain);
+            query->onResult.connect(boost::bind(&CachingDomainNameResolverTest::handleServiceResult, this, _1));
+            query->run();
+        }
+
+        void handleAddressResult(const std::vector<HostAddress>& addresses, boost::optional<DomainNameResolveError> error) {
+            addressResults.insert(addressResults.end(), addresses.begin(), addresses.end());
+            addressError = error;
+        }
+
+        void handleServiceResult(const std::vector<DomainNameServiceQuery::Result>& results) {
+            serviceResults.insert(serviceResults.end(), results.begin(), results.end());
+        }
+
+    private:
+        DummyEventLoop* eventLoop;
+        StaticDomainNameResolver* realResolver;
+        CachingDomainNameResolver* testling;
+        std::vector<HostAddress> addressResults;
+        boost::optional<DomainNameResolveError> addressError;
+        std::vector<DomainNameServiceQuery::Result> serviceResults;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CachingDomainNameResolverTest);
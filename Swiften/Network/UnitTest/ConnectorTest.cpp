@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -37,6 +37,10 @@ class ConnectorTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testConnect_TimeoutDuringConnectToOnlyCandidate);
         CPPUNIT_TEST(testConnect_TimeoutDuringConnectToCandidateFallsBack);
         CPPUNIT_TEST(testConnect_NoTimeout);
+        CPPUNIT_TEST(testConnect_SlowCandidateIsRacedAgainstNextCandidate);
+        CPPUNIT_TEST(testConnect_SlowCandidateIsRacedAgainstNextSRVHost);
+        CPPUNIT_TEST(testConnect_NoConnectionAttemptDelay);
+        CPPUNIT_TEST(testConnect_AlternatesAddressFamilies);
         CPPUNIT_TEST(testStop_DuringSRVQuery);
         CPPUNIT_TEST(testStop_Timeout);
         CPPUNIT_TEST_SUITE_END();
@@ -280,6 +284,94 @@ class ConnectorTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(!std::dynamic_pointer_cast<DomainNameResolveError>(error));
         }
 
+        void testConnect_SlowCandidateIsRacedAgainstNextCandidate() {
+            Connector::ref testling(createConnector());
+            testling->setTimeoutMilliseconds(1000);
+            resolver->addXMPPClientService("foo.com", "host-foo.com", 1234);
+            resolver->addAddress("host-foo.com", host1.getAddress());
+            resolver->addAddress("host-foo.com", host2.getAddress());
+
+            connectionFactory->isResponsive = false;
+            testling->start();
+            eventLoop->processEvents();
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connectionFactory->connections.size()));
+
+            connectionFactory->isResponsive = true;
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(connectionFactory->connections.size()));
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(HostAddressPort(host2.getAddress(), 1234) == *(connections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(connectionFactory->connections[0]->disconnected);
+            CPPUNIT_ASSERT(!connectionFactory->connections[1]->disconnected);
+            CPPUNIT_ASSERT(testling->getConnectLatency());
+        }
+
+        void testConnect_SlowCandidateIsRacedAgainstNextSRVHost() {
+            Connector::ref testling(createConnector());
+            resolver->addXMPPClientService("foo.com", host1);
+            resolver->addXMPPClientService("foo.com", host2);
+
+            connectionFactory->isResponsive = false;
+            testling->start();
+            eventLoop->processEvents();
+            connectionFactory->isResponsive = true;
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(connections[0]);
+            CPPUNIT_ASSERT(host2 == *(connections[0]->hostAddressPort));
+            CPPUNIT_ASSERT(connectionFactory->connections[0]->disconnected);
+        }
+
+        void testConnect_NoConnectionAttemptDelay() {
+            Connector::ref testling(createConnector());
+            testling->setConnectionAttemptDelayMilliseconds(0);
+            resolver->addXMPPClientService("foo.com", host1);
+            resolver->addXMPPClientService("foo.com", host2);
+
+            connectionFactory->isResponsive = false;
+            testling->start();
+            eventLoop->processEvents();
+            timerFactory->setTime(250);
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connectionFactory->connections.size()));
+            CPPUNIT_ASSERT_EQUAL(0, static_cast<int>(connections.size()));
+            testling->stop();
+        }
+
+        void testConnect_AlternatesAddressFamilies() {
+            Connector::ref testling(createConnector());
+            auto ipv4Address1 = HostAddress::fromString("1.1.1.1").get();
+            auto ipv4Address2 = HostAddress::fromString("2.2.2.2").get();
+            auto ipv6Address1 = HostAddress::fromString("2001:db8::1").get();
+            auto ipv6Address2 = HostAddress::fromString("2001:db8::2").get();
+            resolver->addXMPPClientService("foo.com", "host-foo.com", 1234);
+            resolver->addAddress("host-foo.com", ipv4Address1);
+            resolver->addAddress("host-foo.com", ipv4Address2);
+            resolver->addAddress("host-foo.com", ipv6Address1);
+            resolver->addAddress("host-foo.com", ipv6Address2);
+            connectionFactory->failingPorts.push_back(HostAddressPort(ipv4Address1, 1234));
+            connectionFactory->failingPorts.push_back(HostAddressPort(ipv4Address2, 1234));
+            connectionFactory->failingPorts.push_back(HostAddressPort(ipv6Address1, 1234));
+            connectionFactory->failingPorts.push_back(HostAddressPort(ipv6Address2, 1234));
+
+            testling->start();
+            eventLoop->processEvents();
+
+            CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(connectionFactory->connections.size()));
+            CPPUNIT_ASSERT(ipv6Address1 == connectionFactory->connections[0]->hostAddressPort->getAddress());
+            CPPUNIT_ASSERT(ipv4Address1 == connectionFactory->connections[1]->hostAddressPort->getAddress());
+            CPPUNIT_ASSERT(ipv6Address2 == connectionFactory->connections[2]->hostAddressPort->getAddress());
+            CPPUNIT_ASSERT(ipv4Address2 == connectionFactory->connections[3]->hostAddressPort->getAddress());
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(connections.size()));
+            CPPUNIT_ASSERT(!connections[0]);
+        }
+
         void testStop_DuringSRVQuery() {
             Connector::ref testling(createConnector());
             resolver->addXMPPClientService("foo.com", host1);
@@ -329,7 +421,7 @@ class ConnectorTest : public CppUnit::TestFixture {
 
         struct MockConnection : public Connection {
             public:
-                MockConnection(const std::vector<HostAddressPort>& failingPorts, bool isResponsive, EventLoop* eventLoop) : eventLoop(eventLoop), failingPorts(failingPorts), isResponsive(isResponsive) {}
+                MockConnection(const std::vector<HostAddressPort>& failingPorts, bool isResponsive, EventLoop* eventLoop) : eventLoop(eventLoop), failingPorts(failingPorts), isResponsive(isResponsive), disconnected(false) {}
 
                 void listen() { assert(false); }
                 void connect(const HostAddressPort& address) {
@@ -342,13 +434,14 @@ class ConnectorTest : public CppUnit::TestFixture {
 
                 HostAddressPort getLocalAddress() const { return HostAddressPort(); }
                 HostAddressPort getRemoteAddress() const { return HostAddressPort(); }
-                void disconnect() { assert(false); }
+                void disconnect() { disconnected = true; }
                 void write(const SafeByteArray&) { assert(false); }
 
                 EventLoop* eventLoop;
                 boost::optional<HostAddressPort> hostAddressPort;
                 std::vector<HostAddressPort> failingPorts;
                 bool isResponsive;
+                bool disconnected;
         };
 
         struct MockConnectionFactory : public ConnectionFactory {
@@ -356,12 +449,15 @@ class ConnectorTest : public CppUnit::TestFixture {
             }
 
             std::shared_ptr<Connection> createConnection() {
-                return std::make_shared<MockConnection>(failingPorts, isResponsive, eventLoop);
+                std::shared_ptr<MockConnection> connection = std::make_shared<MockConnection>(failingPorts, isResponsive, eventLoop);
+                connections.push_back(connection);
+                return connection;
             }
 
             EventLoop* eventLoop;
             bool isResponsive;
             std::vector<HostAddressPort> failingPorts;
+            std::vector<std::shared_ptr<MockConnection> > connections;
         };
 
     private:
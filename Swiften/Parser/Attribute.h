@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,6 +9,8 @@
 #include <string>
 
 namespace Swift {
+    class AttributeMap;
+
     class Attribute {
         public:
             Attribute(const std::string& name, const std::string& ns) : name(name), ns(ns) {
@@ -26,6 +28,14 @@ namespace Swift {
                 return o.name == name && o.ns == ns;
             }
 
+        private:
+            friend class AttributeMap;
+
+            void assign(const std::string& name, const std::string& ns) {
+                this->name = name;
+                this->ns = ns;
+            }
+
         private:
             std::string name;
             std::string ns;
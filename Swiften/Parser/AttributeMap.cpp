@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2016 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #include <Swiften/Parser/AttributeMap.h>
 
 #include <algorithm>
+#include <utility>
 
 #include <boost/lambda/bind.hpp>
 #include <boost/lambda/lambda.hpp>
@@ -52,5 +53,22 @@ boost::optional<std::string> AttributeMap::getAttributeValue(const std::string&
 }
 
 void AttributeMap::addAttribute(const std::string& name, const std::string& ns, const std::string& value) {
-    attributes.push_back(Entry(Attribute(name, ns), value));
+    if (unusedAttributes.empty()) {
+        attributes.push_back(Entry(Attribute(name, ns), value));
+    }
+    else {
+        Entry& entry = unusedAttributes.back();
+        entry.attribute.assign(name, ns);
+        entry.value = value;
+        attributes.push_back(std::move(entry));
+        unusedAttributes.pop_back();
+    }
+}
+
+void AttributeMap::clear() {
+    // Moving the entries keeps the storage of their strings
+    for (auto& entry : attributes) {
+        unusedAttributes.push_back(std::move(entry));
+    }
+    attributes.clear();
 }
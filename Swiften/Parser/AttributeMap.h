@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -32,6 +32,8 @@ namespace Swift {
                     }
 
                 private:
+                    friend class AttributeMap;
+
                     Attribute attribute;
                     std::string value;
             };
@@ -44,6 +46,13 @@ namespace Swift {
 
             void addAttribute(const std::string& name, const std::string& ns, const std::string& value);
 
+            /**
+             * Removes all attributes. The removed entries are kept, and their
+             * strings are assigned to by the next added attributes, so that
+             * they do not need to be allocated again.
+             */
+            void clear();
+
             const std::vector<Entry>& getEntries() const {
                 return attributes;
             }
@@ -51,5 +60,6 @@ namespace Swift {
         private:
             typedef std::vector<Entry> AttributeValueMap;
             AttributeValueMap attributes;
+            AttributeValueMap unusedAttributes;
     };
 }
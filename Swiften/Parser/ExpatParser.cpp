@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #include <Swiften/Parser/ExpatParser.h>
 
 #include <cassert>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -14,7 +15,6 @@
 
 #include <boost/numeric/conversion/cast.hpp>
 
-#include <Swiften/Base/String.h>
 #include <Swiften/Parser/XMLParserClient.h>
 
 #pragma clang diagnostic ignored "-Wdisabled-macro-expansion"
@@ -23,76 +23,95 @@ namespace Swift {
 
 static const char NAMESPACE_SEPARATOR = '\x01';
 
+namespace {
+    // Scratch strings and attributes are reused for every tag, so that splitting
+    // element and attribute names into local name and namespace does not allocate
+    // once the buffers have grown to the sizes used by the stream.
+    struct ParserState {
+        XML_Parser parser;
+        XMLParserClient* client;
+        std::string element;
+        std::string ns;
+        std::string attributeName;
+        std::string attributeNamespace;
+        std::string attributeValue;
+        std::string characterData;
+        AttributeMap attributes;
+    };
+
+    void splitName(const XML_Char* name, std::string& localName, std::string& ns) {
+        const XML_Char* separator = std::strchr(name, NAMESPACE_SEPARATOR);
+        if (separator) {
+            ns.assign(name, separator);
+            localName.assign(separator + 1);
+        }
+        else {
+            ns.clear();
+            localName.assign(name);
+        }
+    }
+}
+
 struct ExpatParser::Private {
-    XML_Parser parser_;
+    ParserState state_;
 };
 
-static void handleStartElement(void* parser, const XML_Char* name, const XML_Char** attributes) {
-    std::pair<std::string,std::string> nsTagPair = String::getSplittedAtFirst(name, NAMESPACE_SEPARATOR);
-    if (nsTagPair.second == "") {
-        nsTagPair.second = nsTagPair.first;
-        nsTagPair.first = "";
+static void handleStartElement(void* data, const XML_Char* name, const XML_Char** attributes) {
+    ParserState* state = static_cast<ParserState*>(data);
+    splitName(name, state->element, state->ns);
+    state->attributes.clear();
+    for (const XML_Char** currentAttribute = attributes; *currentAttribute; currentAttribute += 2) {
+        splitName(*currentAttribute, state->attributeName, state->attributeNamespace);
+        state->attributeValue.assign(*(currentAttribute + 1));
+        state->attributes.addAttribute(state->attributeName, state->attributeNamespace, state->attributeValue);
     }
-    AttributeMap attributeValues;
-    const XML_Char** currentAttribute = attributes;
-    while (*currentAttribute) {
-        std::pair<std::string,std::string> nsAttributePair = String::getSplittedAtFirst(*currentAttribute, NAMESPACE_SEPARATOR);
-        if (nsAttributePair.second == "") {
-            nsAttributePair.second = nsAttributePair.first;
-            nsAttributePair.first = "";
-        }
-        attributeValues.addAttribute(nsAttributePair.second, nsAttributePair.first, std::string(*(currentAttribute+1)));
-        currentAttribute += 2;
-    }
-
-    static_cast<XMLParser*>(parser)->getClient()->handleStartElement(nsTagPair.second, nsTagPair.first, attributeValues);
+    state->client->handleStartElement(state->element, state->ns, state->attributes);
 }
 
-static void handleEndElement(void* parser, const XML_Char* name) {
-    std::pair<std::string,std::string> nsTagPair = String::getSplittedAtFirst(name, NAMESPACE_SEPARATOR);
-    if (nsTagPair.second == "") {
-        nsTagPair.second = nsTagPair.first;
-        nsTagPair.first = "";
-    }
-    static_cast<XMLParser*>(parser)->getClient()->handleEndElement(nsTagPair.second, nsTagPair.first);
+static void handleEndElement(void* data, const XML_Char* name) {
+    ParserState* state = static_cast<ParserState*>(data);
+    splitName(name, state->element, state->ns);
+    state->client->handleEndElement(state->element, state->ns);
 }
 
-static void handleCharacterData(void* parser, const XML_Char* data, int len) {
+static void handleCharacterData(void* data, const XML_Char* characterData, int len) {
     assert(len >= 0);
-    static_cast<XMLParser*>(parser)->getClient()->handleCharacterData(std::string(data, static_cast<size_t>(len)));
+    ParserState* state = static_cast<ParserState*>(data);
+    state->characterData.assign(characterData, static_cast<size_t>(len));
+    state->client->handleCharacterData(state->characterData);
 }
 
 static void handleXMLDeclaration(void*, const XML_Char*, const XML_Char*, int) {
 }
 
-static void handleEntityDeclaration(void* parser, const XML_Char*, int, const XML_Char*, int, const XML_Char*, const XML_Char*, const XML_Char*, const XML_Char*) {
-    static_cast<ExpatParser*>(parser)->stopParser();
+static void handleEntityDeclaration(void* data, const XML_Char*, int, const XML_Char*, int, const XML_Char*, const XML_Char*, const XML_Char*, const XML_Char*) {
+    XML_StopParser(static_cast<ParserState*>(data)->parser, static_cast<XML_Bool>(0));
 }
 
-
 ExpatParser::ExpatParser(XMLParserClient* client) : XMLParser(client), p(new Private()) {
-    p->parser_ = XML_ParserCreateNS("UTF-8", NAMESPACE_SEPARATOR);
-    XML_SetUserData(p->parser_, this);
-    XML_SetElementHandler(p->parser_, handleStartElement, handleEndElement);
-    XML_SetCharacterDataHandler(p->parser_, handleCharacterData);
-    XML_SetXmlDeclHandler(p->parser_, handleXMLDeclaration);
-    XML_SetEntityDeclHandler(p->parser_, handleEntityDeclaration);
+    p->state_.parser = XML_ParserCreateNS("UTF-8", NAMESPACE_SEPARATOR);
+    p->state_.client = client;
+    XML_SetUserData(p->state_.parser, &p->state_);
+    XML_SetElementHandler(p->state_.parser, handleStartElement, handleEndElement);
+    XML_SetCharacterDataHandler(p->state_.parser, handleCharacterData);
+    XML_SetXmlDeclHandler(p->state_.parser, handleXMLDeclaration);
+    XML_SetEntityDeclHandler(p->state_.parser, handleEntityDeclaration);
 }
 
 ExpatParser::~ExpatParser() {
-    XML_ParserFree(p->parser_);
+    XML_ParserFree(p->state_.parser);
 }
 
-bool ExpatParser::parse(const std::string& data) {
-    bool success = XML_Parse(p->parser_, data.c_str(), boost::numeric_cast<int>(data.size()), false) == XML_STATUS_OK;
+bool ExpatParser::parse(const char* data, size_t size) {
+    bool success = XML_Parse(p->state_.parser, data, boost::numeric_cast<int>(size), false) == XML_STATUS_OK;
     /*if (!success) {
-        std::cout << "ERROR: " << XML_ErrorString(XML_GetErrorCode(p->parser_)) << " while parsing " << data << std::endl;
+        std::cout << "ERROR: " << XML_ErrorString(XML_GetErrorCode(p->state_.parser)) << " while parsing " << data << std::endl;
     }*/
     return success;
 }
 
 void ExpatParser::stopParser() {
-    XML_StopParser(p->parser_, static_cast<XML_Bool>(0));
+    XML_StopParser(p->state_.parser, static_cast<XML_Bool>(0));
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,6 +29,12 @@ namespace Swift {
                 return (tag_.empty() ? true : element == tag_) && (xmlns_.empty() ? true : xmlns_ == ns);
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = tag_;
+                ns = xmlns_;
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new PARSER_TYPE(parsers_);
             }
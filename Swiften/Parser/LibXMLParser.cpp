@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,37 +20,64 @@
 
 namespace Swift {
 
+namespace {
+    // See ExpatParser: scratch strings and attributes are reused for every tag.
+    struct ParserState {
+        XMLParserClient* client;
+        std::string element;
+        std::string ns;
+        std::string attributeName;
+        std::string attributeNamespace;
+        std::string attributeValue;
+        std::string characterData;
+        AttributeMap attributes;
+    };
+
+    void assignOrClear(std::string& target, const xmlChar* value) {
+        if (value) {
+            target.assign(reinterpret_cast<const char*>(value));
+        }
+        else {
+            target.clear();
+        }
+    }
+}
+
 struct LibXMLParser::Private {
     xmlSAXHandler handler_;
     xmlParserCtxtPtr context_;
+    ParserState state_;
 };
 
-static void handleStartElement(void* parser, const xmlChar* name, const xmlChar*, const xmlChar* xmlns, int, const xmlChar**, int nbAttributes, int nbDefaulted, const xmlChar ** attributes) {
-    AttributeMap attributeValues;
+static void handleStartElement(void* data, const xmlChar* name, const xmlChar*, const xmlChar* xmlns, int, const xmlChar**, int nbAttributes, int nbDefaulted, const xmlChar ** attributes) {
+    ParserState* state = static_cast<ParserState*>(data);
+    state->attributes.clear();
     if (nbDefaulted != 0) {
         // Just because i don't understand what this means yet :-)
         SWIFT_LOG(error) << "Unexpected nbDefaulted on XML element" << std::endl;
     }
     for (int i = 0; i < nbAttributes*5; i += 5) {
-        std::string attributeNS = "";
-        if (attributes[i+2]) {
-            attributeNS = std::string(reinterpret_cast<const char*>(attributes[i+2]));
-        }
-        attributeValues.addAttribute(
-                std::string(reinterpret_cast<const char*>(attributes[i])),
-                attributeNS,
-                std::string(reinterpret_cast<const char*>(attributes[i+3]),
-                    boost::numeric_cast<size_t>(attributes[i+4]-attributes[i+3])));
+        assignOrClear(state->attributeName, attributes[i]);
+        assignOrClear(state->attributeNamespace, attributes[i+2]);
+        state->attributeValue.assign(reinterpret_cast<const char*>(attributes[i+3]), boost::numeric_cast<size_t>(attributes[i+4]-attributes[i+3]));
+        state->attributes.addAttribute(state->attributeName, state->attributeNamespace, state->attributeValue);
     }
-    static_cast<XMLParser*>(parser)->getClient()->handleStartElement(reinterpret_cast<const char*>(name), (xmlns ? reinterpret_cast<const char*>(xmlns) : std::string()), attributeValues);
+    assignOrClear(state->element, name);
+    assignOrClear(state->ns, xmlns);
+    state->client->handleStartElement(state->element, state->ns, state->attributes);
 }
 
-static void handleEndElement(void *parser, const xmlChar* name, const xmlChar*, const xmlChar* xmlns) {
-    static_cast<XMLParser*>(parser)->getClient()->handleEndElement(reinterpret_cast<const char*>(name), (xmlns ? reinterpret_cast<const char*>(xmlns) : std::string()));
+static void handleEndElement(void* data, const xmlChar* name, const xmlChar*, const xmlChar* xmlns) {
+    ParserState* state = static_cast<ParserState*>(data);
+    assignOrClear(state->element, name);
+    assignOrClear(state->ns, xmlns);
+    state->client->handleEndElement(state->element, state->ns);
 }
 
-static void handleCharacterData(void* parser, const xmlChar* data, int len) {
-    static_cast<XMLParser*>(parser)->getClient()->handleCharacterData(std::string(reinterpret_cast<const char*>(data), boost::numeric_cast<size_t>(len)));
+static void handleCharacterData(void* data, const xmlChar* characterData, int len) {
+    ParserState* state = static_cast<ParserState*>(data);
+    state->characterData.assign(reinterpret_cast<const char*>(characterData), boost::numeric_cast<size_t>(len));
+    state->client->handleCharacterData(state->characterData);
 }
 
 static void handleError(void*, const char* /*m*/, ... ) {
@@ -82,7 +109,8 @@ LibXMLParser::LibXMLParser(XMLParserClient* client) : XMLParser(client), p(new P
     p->handler_.warning = &handleWarning;
     p->handler_.error = &handleError;
 
-    p->context_ = xmlCreatePushParserCtxt(&p->handler_, this, nullptr, 0, nullptr);
+    p->state_.client = client;
+    p->context_ = xmlCreatePushParserCtxt(&p->handler_, &p->state_, nullptr, 0, nullptr);
     xmlCtxtUseOptions(p->context_, XML_PARSE_NOENT);
     assert(p->context_);
 }
@@ -93,8 +121,8 @@ LibXMLParser::~LibXMLParser() {
     }
 }
 
-bool LibXMLParser::parse(const std::string& data) {
-    if (xmlParseChunk(p->context_, data.c_str(), boost::numeric_cast<int>(data.size()), false) == XML_ERR_OK) {
+bool LibXMLParser::parse(const char* data, size_t size) {
+    if (xmlParseChunk(p->context_, data, boost::numeric_cast<int>(size), false) == XML_ERR_OK) {
         return true;
     }
     xmlError* error = xmlCtxtGetLastError(p->context_);
@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <string>
+
 #include <Swiften/Base/API.h>
 #include <Swiften/Parser/AttributeMap.h>
 
@@ -25,6 +27,16 @@ namespace Swift {
              */
             virtual bool canParse(const std::string& element, const std::string& ns, const AttributeMap& attributes) const = 0;
 
+            /**
+             * Retrieves the top-level element and namespace this factory parses, if canParse()
+             * depends on nothing else. An empty element or namespace matches any element or namespace.
+             *
+             * This allows \ref PayloadParserFactoryCollection to find the factory through a hash lookup
+             * instead of calling canParse(). The key must not change while the factory is registered.
+             * The default implementation returns false, in which case only canParse() is used.
+             */
+            virtual bool getElementKey(std::string& element, std::string& ns) const;
+
             /**
              * Creates a new payload parser.
              */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,8 +8,6 @@
 
 #include <algorithm>
 
-#include <boost/bind.hpp>
-
 #include <Swiften/Parser/PayloadParserFactory.h>
 
 namespace Swift {
@@ -22,10 +20,12 @@ PayloadParserFactoryCollection::~PayloadParserFactoryCollection() {
 
 void PayloadParserFactoryCollection::addFactory(PayloadParserFactory* factory) {
     factories_.push_back(factory);
+    indexFactory(factories_.size() - 1);
 }
 
 void PayloadParserFactoryCollection::removeFactory(PayloadParserFactory* factory) {
     factories_.erase(std::remove(factories_.begin(), factories_.end(), factory), factories_.end());
+    rebuildIndex();
 }
 
 void PayloadParserFactoryCollection::setDefaultFactory(PayloadParserFactory* factory) {
@@ -33,10 +33,54 @@ void PayloadParserFactoryCollection::setDefaultFactory(PayloadParserFactory* fac
 }
 
 PayloadParserFactory* PayloadParserFactoryCollection::getPayloadParserFactory(const std::string& element, const std::string& ns, const AttributeMap& attributes) {
-    std::vector<PayloadParserFactory*>::reverse_iterator i = std::find_if(
-            factories_.rbegin(), factories_.rend(),
-            boost::bind(&PayloadParserFactory::canParse, _1, element, ns, attributes));
-    return (i != factories_.rend() ? *i : defaultFactory_);
+    static const std::string any;
+
+    // Find the most recently added keyed factory for the element, stored as index + 1.
+    size_t match = 0;
+    auto updateMatch = [&match](const std::unordered_map<std::string, FactoryIndices>& elements, const std::string& key) {
+        auto i = elements.find(key);
+        if (i != elements.end() && !i->second.empty()) {
+            match = std::max(match, i->second.back() + 1);
+        }
+    };
+    auto i = keyedFactories_.find(ns);
+    if (i != keyedFactories_.end()) {
+        updateMatch(i->second, element);
+        updateMatch(i->second, any);
+    }
+    if (!ns.empty()) {
+        i = keyedFactories_.find(any);
+        if (i != keyedFactories_.end()) {
+            updateMatch(i->second, element);
+        }
+    }
+
+    // Unkeyed factories added after that one still take precedence.
+    for (auto j = unkeyedFactories_.rbegin(); j != unkeyedFactories_.rend() && *j >= match; ++j) {
+        if (factories_[*j]->canParse(element, ns, attributes)) {
+            return factories_[*j];
+        }
+    }
+    return (match > 0 ? factories_[match - 1] : defaultFactory_);
+}
+
+void PayloadParserFactoryCollection::indexFactory(size_t index) {
+    std::string element;
+    std::string ns;
+    if (factories_[index]->getElementKey(element, ns) && !(element.empty() && ns.empty())) {
+        keyedFactories_[ns][element].push_back(index);
+    }
+    else {
+        unkeyedFactories_.push_back(index);
+    }
+}
+
+void PayloadParserFactoryCollection::rebuildIndex() {
+    keyedFactories_.clear();
+    unkeyedFactories_.clear();
+    for (size_t i = 0; i < factories_.size(); ++i) {
+        indexFactory(i);
+    }
 }
 
 }
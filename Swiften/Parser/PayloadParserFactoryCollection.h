@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <Swiften/Base/API.h>
@@ -14,6 +16,13 @@
 namespace Swift {
     class PayloadParserFactory;
 
+    /**
+     * A collection of payload parser factories.
+     *
+     * When several factories can parse the same element, the one that was added last is used.
+     * Factories that declare their element key (see PayloadParserFactory::getElementKey())
+     * are found through a hash lookup; the others are asked through canParse().
+     */
     class SWIFTEN_API PayloadParserFactoryCollection {
         public:
             PayloadParserFactoryCollection();
@@ -26,7 +35,17 @@ namespace Swift {
             PayloadParserFactory* getPayloadParserFactory(const std::string& element, const std::string& ns, const AttributeMap& attributes);
 
         private:
+            void indexFactory(size_t index);
+            void rebuildIndex();
+
+        private:
+            typedef std::vector<size_t> FactoryIndices;
+
             std::vector<PayloadParserFactory*> factories_;
+            // Indices into factories_ (in registration order), by namespace and element. Empty strings are wildcards.
+            std::unordered_map<std::string, std::unordered_map<std::string, FactoryIndices> > keyedFactories_;
+            // Indices into factories_ (in registration order) of factories without an element key.
+            FactoryIndices unkeyedFactories_;
             PayloadParserFactory* defaultFactory_;
     };
 }
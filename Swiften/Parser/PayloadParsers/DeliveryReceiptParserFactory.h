@@ -26,6 +26,12 @@ namespace Swift {
                 return ns == "urn:xmpp:receipts" && element == "received";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "received";
+                ns = "urn:xmpp:receipts";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new DeliveryReceiptParser();
             }
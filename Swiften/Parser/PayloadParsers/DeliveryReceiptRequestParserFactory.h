@@ -26,6 +26,12 @@ namespace Swift {
                 return ns == "urn:xmpp:receipts" && element == "request";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "request";
+                ns = "urn:xmpp:receipts";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new DeliveryReceiptRequestParser();
             }
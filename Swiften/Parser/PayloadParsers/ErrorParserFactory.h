@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2015 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -22,6 +22,12 @@ namespace Swift {
                 return element == "error";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "error";
+                ns = "";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new ErrorParser(factories);
             }
@@ -20,6 +20,12 @@ namespace Swift {
                 return ns == "jabber:x:data";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "";
+                ns = "jabber:x:data";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new FormParser();
             }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (c) 2015 Isode Limited.
+ * Copyright (c) 2015-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -29,6 +29,12 @@ namespace Swift {
                 return element == "content" && ns == "urn:xmpp:jingle:1";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "content";
+                ns = "urn:xmpp:jingle:1";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new JingleContentPayloadParser(factories);
             }
@@ -20,6 +20,12 @@ namespace Swift {
                 return element == "join" && ns == "urn:xmpp:mix:1";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "join";
+                ns = "urn:xmpp:mix:1";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new MIXJoinParser();
             }
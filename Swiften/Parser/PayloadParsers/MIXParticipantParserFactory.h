@@ -20,6 +20,12 @@ namespace Swift {
                 return element == "participant" && ns == "urn:xmpp:mix:0";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "participant";
+                ns = "urn:xmpp:mix:0";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new MIXParticipantParser();
             }
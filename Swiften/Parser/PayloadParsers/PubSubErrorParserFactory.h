@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2015 Isode Limited.
+ * Copyright (c) 2013-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,6 +21,12 @@ namespace Swift {
                 return ns == "http://jabber.org/protocol/pubsub#errors";
             }
 
+            virtual bool getElementKey(std::string& element, std::string& ns) const {
+                element = "";
+                ns = "http://jabber.org/protocol/pubsub#errors";
+                return true;
+            }
+
             virtual PayloadParser* createPayloadParser() {
                 return new PubSubErrorParser();
             }
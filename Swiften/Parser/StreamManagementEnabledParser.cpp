@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011 Isode Limited.
+ * Copyright (c) 2011-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,6 +20,7 @@ void StreamManagementEnabledParser::handleStartElement(const std::string&, const
             getElementGeneric()->setResumeSupported();
         }
         getElementGeneric()->setResumeID(attributes.getAttribute("id"));
+        getElementGeneric()->setLocation(attributes.getAttribute("location"));
     }
     ++level;
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -22,6 +22,8 @@ class AttributeMapTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testGetBoolAttribute_Invalid);
         CPPUNIT_TEST(testGetBoolAttribute_UnknownWithDefaultTrue);
         CPPUNIT_TEST(testGetBoolAttribute_UnknownWithDefaultFalse);
+        CPPUNIT_TEST(testClear);
+        CPPUNIT_TEST(testClear_ReusesEntries);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -80,6 +82,28 @@ class AttributeMapTest : public CppUnit::TestFixture
 
             CPPUNIT_ASSERT(!testling.getBoolAttribute("foo", false));
         }
+
+        void testClear() {
+            AttributeMap testling;
+            testling.addAttribute("foo", "", "bar");
+            testling.clear();
+            testling.addAttribute("baz", "", "bam");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getEntries().size());
+            CPPUNIT_ASSERT_EQUAL(std::string(""), testling.getAttribute("foo"));
+            CPPUNIT_ASSERT_EQUAL(std::string("bam"), testling.getAttribute("baz"));
+        }
+
+        void testClear_ReusesEntries() {
+            AttributeMap testling;
+            testling.addAttribute("foo", "", std::string(100, 'a'));
+            const char* value = testling.getEntries()[0].getValue().data();
+            testling.clear();
+            testling.addAttribute("baz", "", std::string(50, 'b'));
+
+            CPPUNIT_ASSERT(value == testling.getEntries()[0].getValue().data());
+            CPPUNIT_ASSERT_EQUAL(std::string(50, 'b'), testling.getAttribute("baz"));
+        }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(AttributeMapTest);
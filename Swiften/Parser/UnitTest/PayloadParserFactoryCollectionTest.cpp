@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,6 +20,11 @@ class PayloadParserFactoryCollectionTest : public CppUnit::TestFixture
         CPPUNIT_TEST(testGetPayloadParserFactory_TwoMatchingFactories);
         CPPUNIT_TEST(testGetPayloadParserFactory_MatchWithDefaultFactory);
         CPPUNIT_TEST(testGetPayloadParserFactory_NoMatchWithDefaultFactory);
+        CPPUNIT_TEST(testGetPayloadParserFactory_KeyedFactory);
+        CPPUNIT_TEST(testGetPayloadParserFactory_KeyedFactoryWithWildcards);
+        CPPUNIT_TEST(testGetPayloadParserFactory_KeyedFactoryOverridesEarlierFactory);
+        CPPUNIT_TEST(testGetPayloadParserFactory_UnkeyedFactoryOverridesEarlierKeyedFactory);
+        CPPUNIT_TEST(testGetPayloadParserFactory_RemovedKeyedFactory);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -88,6 +93,72 @@ class PayloadParserFactoryCollectionTest : public CppUnit::TestFixture
             CPPUNIT_ASSERT(factory == &factory2);
         }
 
+        void testGetPayloadParserFactory_KeyedFactory() {
+            PayloadParserFactoryCollection testling;
+            KeyedFactory factory1("foo", "ns1");
+            testling.addFactory(&factory1);
+            KeyedFactory factory2("foo", "ns2");
+            testling.addFactory(&factory2);
+
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns1", AttributeMap()) == &factory1);
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns2", AttributeMap()) == &factory2);
+            CPPUNIT_ASSERT(!testling.getPayloadParserFactory("foo", "ns3", AttributeMap()));
+            CPPUNIT_ASSERT(!testling.getPayloadParserFactory("bar", "ns1", AttributeMap()));
+        }
+
+        void testGetPayloadParserFactory_KeyedFactoryWithWildcards() {
+            PayloadParserFactoryCollection testling;
+            KeyedFactory factory1("", "ns1");
+            testling.addFactory(&factory1);
+            KeyedFactory factory2("foo", "");
+            testling.addFactory(&factory2);
+
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("bar", "ns1", AttributeMap()) == &factory1);
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns1", AttributeMap()) == &factory2);
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns2", AttributeMap()) == &factory2);
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "", AttributeMap()) == &factory2);
+            CPPUNIT_ASSERT(!testling.getPayloadParserFactory("bar", "ns2", AttributeMap()));
+        }
+
+        void testGetPayloadParserFactory_KeyedFactoryOverridesEarlierFactory() {
+            PayloadParserFactoryCollection testling;
+            DummyFactory factory1("foo");
+            testling.addFactory(&factory1);
+            KeyedFactory factory2("foo", "ns1");
+            testling.addFactory(&factory2);
+
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns1", AttributeMap()) == &factory2);
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns2", AttributeMap()) == &factory1);
+        }
+
+        void testGetPayloadParserFactory_UnkeyedFactoryOverridesEarlierKeyedFactory() {
+            PayloadParserFactoryCollection testling;
+            KeyedFactory factory1("foo", "ns1");
+            testling.addFactory(&factory1);
+            DummyFactory factory2("foo");
+            testling.addFactory(&factory2);
+            KeyedFactory factory3("bar", "ns1");
+            testling.addFactory(&factory3);
+
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns1", AttributeMap()) == &factory2);
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("bar", "ns1", AttributeMap()) == &factory3);
+        }
+
+        void testGetPayloadParserFactory_RemovedKeyedFactory() {
+            PayloadParserFactoryCollection testling;
+            KeyedFactory factory1("foo", "ns1");
+            testling.addFactory(&factory1);
+            KeyedFactory factory2("foo", "ns1");
+            testling.addFactory(&factory2);
+
+            testling.removeFactory(&factory2);
+
+            CPPUNIT_ASSERT(testling.getPayloadParserFactory("foo", "ns1", AttributeMap()) == &factory1);
+
+            testling.removeFactory(&factory1);
+
+            CPPUNIT_ASSERT(!testling.getPayloadParserFactory("foo", "ns1", AttributeMap()));
+        }
 
     private:
         struct DummyFactory : public PayloadParserFactory {
@@ -98,6 +169,22 @@ class PayloadParserFactoryCollectionTest : public CppUnit::TestFixture
             virtual PayloadParser* createPayloadParser() { return nullptr; }
             std::string element;
         };
+
+        struct KeyedFactory : public PayloadParserFactory {
+            KeyedFactory(const std::string& element, const std::string& ns) : element(element), ns(ns) {}
+            virtual bool canParse(const std::string&, const std::string&, const AttributeMap&) const {
+                CPPUNIT_FAIL("canParse() called on keyed factory");
+                return false;
+            }
+            virtual bool getElementKey(std::string& e, std::string& n) const {
+                e = element;
+                n = ns;
+                return true;
+            }
+            virtual PayloadParser* createPayloadParser() { return nullptr; }
+            std::string element;
+            std::string ns;
+        };
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(PayloadParserFactoryCollectionTest);
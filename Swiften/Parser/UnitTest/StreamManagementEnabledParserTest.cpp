@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -15,6 +15,7 @@ using namespace Swift;
 class StreamManagementEnabledParserTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(StreamManagementEnabledParserTest);
         CPPUNIT_TEST(testParse);
+        CPPUNIT_TEST(testParse_Location);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -28,6 +29,19 @@ class StreamManagementEnabledParserTest : public CppUnit::TestFixture {
             std::shared_ptr<StreamManagementEnabled> element = std::dynamic_pointer_cast<StreamManagementEnabled>(testling.getElement());
             CPPUNIT_ASSERT(element->getResumeSupported());
             CPPUNIT_ASSERT_EQUAL(std::string("some-long-sm-id"), element->getResumeID());
+            CPPUNIT_ASSERT(element->getLocation().empty());
+        }
+
+        void testParse_Location() {
+            StreamManagementEnabledParser testling;
+            ElementParserTester parser(&testling);
+
+            CPPUNIT_ASSERT(parser.parse(
+                "<enabled xmlns=\"urn:xmpp:sm:3\" id=\"some-long-sm-id\" location=\"[2001:41D0:1:A49b::1]:9222\" resume=\"1\"/>"));
+
+            std::shared_ptr<StreamManagementEnabled> element = std::dynamic_pointer_cast<StreamManagementEnabled>(testling.getElement());
+            CPPUNIT_ASSERT(element->getResumeSupported());
+            CPPUNIT_ASSERT_EQUAL(std::string("[2001:41D0:1:A49b::1]:9222"), element->getLocation());
         }
 };
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -31,6 +31,7 @@ class XMLParserTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testParse_InvalidXML);
         CPPUNIT_TEST(testParse_InErrorState);
         CPPUNIT_TEST(testParse_Incremental);
+        CPPUNIT_TEST(testParse_PointerAndSize);
         CPPUNIT_TEST(testParse_WhitespaceInAttribute);
         CPPUNIT_TEST(testParse_AttributeWithoutNamespace);
         CPPUNIT_TEST(testParse_AttributeWithNamespace);
@@ -217,6 +218,20 @@ class XMLParserTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string("iq"), client_.events[1].data);
         }
 
+        void testParse_PointerAndSize() {
+            ParserType testling(&client_);
+            const char data[] = "<iq><query/></iq>garbage";
+
+            CPPUNIT_ASSERT(testling.parse(data, 4));
+            CPPUNIT_ASSERT(testling.parse(data + 4, 13));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), client_.events.size());
+            CPPUNIT_ASSERT_EQUAL(Client::StartElement, client_.events[1].type);
+            CPPUNIT_ASSERT_EQUAL(std::string("query"), client_.events[1].data);
+            CPPUNIT_ASSERT_EQUAL(Client::EndElement, client_.events[3].type);
+            CPPUNIT_ASSERT_EQUAL(std::string("iq"), client_.events[3].data);
+        }
+
         void testParse_WhitespaceInAttribute() {
             ParserType testling(&client_);
 
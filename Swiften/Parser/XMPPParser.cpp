@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -63,7 +63,11 @@ XMPPParser::~XMPPParser() {
 }
 
 bool XMPPParser::parse(const std::string& data) {
-    bool xmlParseResult = xmlParser_->parse(data);
+    return parse(data.c_str(), data.size());
+}
+
+bool XMPPParser::parse(const char* data, size_t size) {
+    bool xmlParseResult = xmlParser_->parse(data, size);
     return xmlParseResult && !parseErrorOccurred_;
 }
 
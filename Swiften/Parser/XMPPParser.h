@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -30,6 +30,7 @@ namespace Swift {
             virtual ~XMPPParser();
 
             bool parse(const std::string&);
+            bool parse(const char* data, size_t size);
 
         private:
             virtual void handleStartElement(
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Presence/PresenceOracle.h>
 
+#include <algorithm>
 #include <queue>
 
 #include <boost/bind.hpp>
@@ -47,20 +48,20 @@ void PresenceOracle::handleIncomingPresence(Presence::ref presence) {
             passedPresence->setFrom(bareJID);
             passedPresence->setStatus(presence->getStatus());
         }
-        PresenceMap jidMap = entries_[bareJID];
+        Entry& entry = entries_[bareJID];
         if (passedPresence->getFrom().isBare() && presence->getType() == Presence::Unavailable) {
             /* Have a bare-JID only presence of offline */
-            jidMap.clear();
+            entry.presences.clear();
         } else if (passedPresence->getType() == Presence::Available) {
             /* Don't have a bare-JID only offline presence once there are available presences */
-            jidMap.erase(bareJID);
+            entry.removePresence(bareJID);
         }
-        if (passedPresence->getType() == Presence::Unavailable && jidMap.size() > 1) {
-            jidMap.erase(passedPresence->getFrom());
+        if (passedPresence->getType() == Presence::Unavailable && entry.presences.size() > 1) {
+            entry.removePresence(passedPresence->getFrom());
         } else {
-            jidMap[passedPresence->getFrom()] = passedPresence;
+            entry.setPresence(passedPresence->getFrom(), passedPresence);
         }
-        entries_[bareJID] = jidMap;
+        entry.update();
         onPresenceChange(passedPresence);
     }
 }
@@ -71,22 +72,69 @@ void PresenceOracle::handleJIDRemoved(const JID& removedJID) {
     unavailablePresence->setType(Presence::Unavailable);
     unavailablePresence->setFrom(removedJID);
 
-    if (entries_.find(removedJID) != entries_.end()) {
-        entries_[removedJID].clear();
-        entries_[removedJID][removedJID] = unavailablePresence;
+    EntryMap::iterator i = entries_.find(removedJID);
+    if (i != entries_.end()) {
+        i->second.presences.clear();
+        i->second.setPresence(removedJID, unavailablePresence);
+        i->second.update();
     }
 
     onPresenceChange(unavailablePresence);
 }
 
+namespace {
+    struct JIDLessThan {
+        bool operator()(const std::pair<JID, Presence::ref>& a, const JID& b) const {
+            return a.first < b;
+        }
+    };
+}
+
+void PresenceOracle::Entry::setPresence(const JID& jid, Presence::ref presence) {
+    auto i = std::lower_bound(presences.begin(), presences.end(), jid, JIDLessThan());
+    if (i != presences.end() && i->first == jid) {
+        i->second = presence;
+    }
+    else {
+        presences.insert(i, std::make_pair(jid, presence));
+    }
+}
+
+void PresenceOracle::Entry::removePresence(const JID& jid) {
+    auto i = std::lower_bound(presences.begin(), presences.end(), jid, JIDLessThan());
+    if (i != presences.end() && i->first == jid) {
+        presences.erase(i);
+    }
+}
+
+void PresenceOracle::Entry::update() {
+    std::vector<Presence::ref> allPresences;
+    allPresences.reserve(presences.size());
+    highestPriorityPresence.reset();
+    for (const auto& jidPresence : presences) {
+        const Presence::ref& current = jidPresence.second;
+        if (!current) {
+            continue;
+        }
+        allPresences.push_back(current);
+        if (!highestPriorityPresence
+                || current->getPriority() > highestPriorityPresence->getPriority()
+                || (current->getPriority() == highestPriorityPresence->getPriority()
+                        && StatusShow::typeToAvailabilityOrdering(current->getShow()) > StatusShow::typeToAvailabilityOrdering(highestPriorityPresence->getShow()))) {
+            highestPriorityPresence = current;
+        }
+    }
+    accountPresence = getActivePresence(allPresences);
+}
+
 Presence::ref PresenceOracle::getLastPresence(const JID& jid) const {
-    PresencesMap::const_iterator i = entries_.find(jid.toBare());
+    EntryMap::const_iterator i = entries_.find(jid.toBare());
     if (i == entries_.end()) {
         return Presence::ref();
     }
-    PresenceMap presenceMap = i->second;
-    PresenceMap::const_iterator j = presenceMap.find(jid);
-    if (j != presenceMap.end()) {
+    const std::vector<std::pair<JID, Presence::ref> >& presences = i->second.presences;
+    auto j = std::lower_bound(presences.begin(), presences.end(), jid, JIDLessThan());
+    if (j != presences.end() && j->first == jid) {
         return j->second;
     }
     else {
@@ -96,11 +144,11 @@ Presence::ref PresenceOracle::getLastPresence(const JID& jid) const {
 
 std::vector<Presence::ref> PresenceOracle::getAllPresence(const JID& bareJID) const {
     std::vector<Presence::ref> results;
-    PresencesMap::const_iterator i = entries_.find(bareJID);
+    EntryMap::const_iterator i = entries_.find(bareJID);
     if (i == entries_.end()) {
         return results;
     }
-    for (const auto& jidPresence : i->second) {
+    for (const auto& jidPresence : i->second.presences) {
         if (jidPresence.second) {
             results.push_back(jidPresence.second);
         }
@@ -187,28 +235,19 @@ Presence::ref PresenceOracle::getActivePresence(const std::vector<Presence::ref>
 }
 
 Presence::ref PresenceOracle::getAccountPresence(const JID& jid) const {
-    Presence::ref accountPresence;
-    std::vector<Presence::ref> allPresences = getAllPresence(jid.toBare());
-    accountPresence = getActivePresence(allPresences);
-    return accountPresence;
+    EntryMap::const_iterator i = entries_.find(jid.toBare());
+    if (i == entries_.end()) {
+        return Presence::ref();
+    }
+    return i->second.accountPresence;
 }
 
 Presence::ref PresenceOracle::getHighestPriorityPresence(const JID& bareJID) const {
-    PresencesMap::const_iterator i = entries_.find(bareJID);
+    EntryMap::const_iterator i = entries_.find(bareJID);
     if (i == entries_.end()) {
         return Presence::ref();
     }
-    Presence::ref highest;
-    for (const auto& jidPresence : i->second) {
-        Presence::ref current = jidPresence.second;
-        if (!highest
-                || current->getPriority() > highest->getPriority()
-                || (current->getPriority() == highest->getPriority()
-                        && StatusShow::typeToAvailabilityOrdering(current->getShow()) > StatusShow::typeToAvailabilityOrdering(highest->getShow()))) {
-            highest = current;
-        }
-    }
-    return highest;
+    return i->second.highestPriorityPresence;
 }
 
 }
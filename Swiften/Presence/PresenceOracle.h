@@ -1,13 +1,15 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/signals2.hpp>
 
@@ -22,6 +24,10 @@ namespace Swift {
      * The PresenceOracle class observes all received presence stanzas for
      * the \ref StanzaChannel class passed in the constructor and maintains a
      * cache.
+     *
+     * Presences are indexed by bare JID. The highest priority presence and the
+     * account presence of a bare JID are recomputed when one of its presences
+     * changes, so querying them does not depend on the number of resources.
      */
     class SWIFTEN_API PresenceOracle {
         public:
@@ -69,9 +75,18 @@ namespace Swift {
             void handleJIDRemoved(const JID& removedJID);
 
         private:
-            typedef std::map<JID, Presence::ref> PresenceMap;
-            typedef std::map<JID, PresenceMap> PresencesMap;
-            PresencesMap entries_;
+            struct Entry {
+                // Sorted by JID
+                std::vector<std::pair<JID, Presence::ref> > presences;
+                Presence::ref highestPriorityPresence;
+                Presence::ref accountPresence;
+
+                void setPresence(const JID& jid, Presence::ref presence);
+                void removePresence(const JID& jid);
+                void update();
+            };
+            typedef std::unordered_map<JID, Entry> EntryMap;
+            EntryMap entries_;
             StanzaChannel* stanzaChannel_;
             XMPPRoster* xmppRoster_;
     };
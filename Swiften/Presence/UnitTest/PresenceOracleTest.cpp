@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -30,6 +30,10 @@ class PresenceOracleTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testHighestPresenceGlobal);
         CPPUNIT_TEST(testHighestPresenceChangePriority);
         CPPUNIT_TEST(testGetActivePresence);
+        CPPUNIT_TEST(testGetAccountPresence_FollowsPresenceChanges);
+        CPPUNIT_TEST(testGetAccountPresence_UnknownJID);
+        CPPUNIT_TEST(testGetAllPresence_ResourceGoesOffline);
+        CPPUNIT_TEST(testJIDRemoved);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -188,6 +192,50 @@ class PresenceOracleTest : public CppUnit::TestFixture {
             }
         }
 
+        void testGetAccountPresence_FollowsPresenceChanges() {
+            JID bareJID("alice@wonderland.lit");
+            Presence::ref away = createPresence("alice@wonderland.lit/resourceA", 10, Presence::Available, StatusShow::Away);
+            Presence::ref online = createPresence("alice@wonderland.lit/resourceB", 5, Presence::Available, StatusShow::Online);
+            Presence::ref offline = createPresence("alice@wonderland.lit/resourceB", 0, Presence::Unavailable, StatusShow::None);
+
+            stanzaChannel_->onPresenceReceived(away);
+            CPPUNIT_ASSERT_EQUAL(away, oracle_->getAccountPresence(bareJID));
+            stanzaChannel_->onPresenceReceived(online);
+            CPPUNIT_ASSERT_EQUAL(online, oracle_->getAccountPresence(JID("alice@wonderland.lit/resourceA")));
+            CPPUNIT_ASSERT_EQUAL(away, oracle_->getHighestPriorityPresence(bareJID));
+            stanzaChannel_->onPresenceReceived(offline);
+            CPPUNIT_ASSERT_EQUAL(away, oracle_->getAccountPresence(bareJID));
+        }
+
+        void testGetAccountPresence_UnknownJID() {
+            CPPUNIT_ASSERT(!oracle_->getAccountPresence(JID("alice@wonderland.lit")));
+            CPPUNIT_ASSERT(!oracle_->getHighestPriorityPresence(JID("alice@wonderland.lit")));
+        }
+
+        void testGetAllPresence_ResourceGoesOffline() {
+            JID bareJID("alice@wonderland.lit");
+            stanzaChannel_->onPresenceReceived(makeOnline("blah", 5));
+            stanzaChannel_->onPresenceReceived(makeOnline("bert", 10));
+            stanzaChannel_->onPresenceReceived(makeOffline("/blah"));
+
+            std::vector<Presence::ref> presences = oracle_->getAllPresence(bareJID);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), presences.size());
+            CPPUNIT_ASSERT_EQUAL(JID("alice@wonderland.lit/bert"), presences[0]->getFrom());
+            CPPUNIT_ASSERT(!oracle_->getLastPresence(JID("alice@wonderland.lit/blah")));
+        }
+
+        void testJIDRemoved() {
+            JID bareJID("alice@wonderland.lit");
+            xmppRoster_->addContact(bareJID, "Alice", std::vector<std::string>(), RosterItemPayload::Both);
+            stanzaChannel_->onPresenceReceived(makeOnline("blah", 5));
+
+            xmppRoster_->removeContact(bareJID);
+
+            CPPUNIT_ASSERT_EQUAL(Presence::Unavailable, oracle_->getAccountPresence(bareJID)->getType());
+            CPPUNIT_ASSERT_EQUAL(Presence::Unavailable, oracle_->getHighestPriorityPresence(bareJID)->getType());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), oracle_->getAllPresence(bareJID).size());
+        }
+
     private:
         Presence::ref createPresence(const JID &jid, int priority, Presence::Type type, const StatusShow::Type& statusShow) {
             Presence::ref presence = std::make_shared<Presence>();
@@ -238,7 +286,7 @@ class PresenceOracleTest : public CppUnit::TestFixture {
         PresenceOracle* oracle_;
         SubscriptionManager* subscriptionManager_;
         DummyStanzaChannel* stanzaChannel_;
-        XMPPRoster* xmppRoster_;
+        XMPPRosterImpl* xmppRoster_;
         std::vector<Presence::ref> changes;
         std::vector<SubscriptionRequestInfo> subscriptionRequests;
         JID user1;
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <Swiften/EventLoop/SimpleEventLoop.h>
+
+using namespace Swift;
+
+/*
+ * Measures how many events per second can be posted to a SimpleEventLoop by
+ * 1 to 16 concurrent producer threads while a single thread consumes them.
+ */
+
+static double runBenchmark(int producerCount, int eventsPerProducer) {
+    SimpleEventLoop eventLoop;
+    const int totalEvents = producerCount * eventsPerProducer;
+    int handledEvents = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int i = 0; i < producerCount; ++i) {
+        producers.push_back(std::thread([&]() {
+            for (int j = 0; j < eventsPerProducer; ++j) {
+                eventLoop.postEvent([&]() {
+                    if (++handledEvents == totalEvents) {
+                        eventLoop.stop();
+                    }
+                });
+            }
+        }));
+    }
+    eventLoop.run();
+    auto end = std::chrono::steady_clock::now();
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return totalEvents / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    int eventsPerProducer = 200000;
+    if (argc > 1) {
+        eventsPerProducer = std::atoi(argv[1]);
+    }
+
+    std::cout << "producers\tposts/sec" << std::endl;
+    for (int producerCount = 1; producerCount <= 16; producerCount *= 2) {
+        std::cout << producerCount << "\t" << static_cast<long long>(runBenchmark(producerCount, eventsPerProducer)) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+
+#include <Swiften/History/SQLiteHistoryStorage.h>
+
+using namespace Swift;
+
+/*
+ * Logs messages from a few busy MUCs and many one-to-one chats into a fresh
+ * history database, then runs the queries of the history window: the contact
+ * list, a day of every conversation, the last MUC timestamp, and keyword searches.
+ */
+
+int main(int argc, char* argv[]) {
+    int messageCount = 1000000;
+    if (argc > 1) {
+        messageCount = std::atoi(argv[1]);
+    }
+    const int contactCount = 200;
+    const int mucCount = 5;
+    const JID self("self@example.com/swift");
+    const boost::posix_time::ptime start(boost::gregorian::date(2017, 1, 1));
+
+    std::vector<JID> contacts;
+    for (int i = 0; i < contactCount; ++i) {
+        contacts.push_back(JID("contact" + std::to_string(i), "example.com", "resource"));
+    }
+    std::vector<JID> mucs;
+    for (int i = 0; i < mucCount; ++i) {
+        mucs.push_back(JID("room" + std::to_string(i), "conference.example.com"));
+    }
+
+    boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("history-%%%%-%%%%.db");
+    int found = 0;
+    {
+        SQLiteHistoryStorage storage(file);
+
+        auto addStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < messageCount; ++i) {
+            // One message every 10 seconds, spread over days; half of the traffic is MUC traffic
+            boost::posix_time::ptime time = start + boost::posix_time::seconds(i * 10);
+            if (i % 2 == 0) {
+                JID occupant(mucs[i % mucCount].getNode(), mucs[i % mucCount].getDomain(), "nick" + std::to_string(i % 50));
+                storage.addMessage(HistoryMessage("Message " + std::to_string(i) + " about topic" + std::to_string(i % 1000) + " in a busy room", occupant, self, HistoryMessage::Groupchat, time));
+            }
+            else if (i % 3 == 0) {
+                storage.addMessage(HistoryMessage("Message " + std::to_string(i) + " about topic" + std::to_string(i % 1000), self, contacts[i % contactCount], HistoryMessage::Chat, time));
+            }
+            else {
+                storage.addMessage(HistoryMessage("Message " + std::to_string(i) + " about topic" + std::to_string(i % 1000), contacts[i % contactCount], self, HistoryMessage::Chat, time));
+            }
+        }
+        auto addEnd = std::chrono::steady_clock::now();
+        storage.flush();
+        auto writeEnd = std::chrono::steady_clock::now();
+
+        ContactsMap contactsMap = storage.getContacts(self.toBare(), HistoryMessage::Chat, "");
+        auto contactsEnd = std::chrono::steady_clock::now();
+
+        boost::gregorian::date day = (start + boost::posix_time::seconds(messageCount * 5)).date();
+        for (const auto& contact : contacts) {
+            found += static_cast<int>(storage.getMessagesFromDate(self, contact.toBare(), HistoryMessage::Chat, day).size());
+        }
+        auto conversationsEnd = std::chrono::steady_clock::now();
+        for (const auto& muc : mucs) {
+            if (!storage.getLastTimeStampFromMUC(self, muc).is_not_a_date_time()) {
+                found++;
+            }
+        }
+        auto mucsEnd = std::chrono::steady_clock::now();
+
+        const int searches = 20;
+        for (int i = 0; i < searches; ++i) {
+            found += static_cast<int>(storage.getContacts(self.toBare(), HistoryMessage::Chat, "topic" + std::to_string(i * 37 % 1000)).size());
+        }
+        auto contactSearchesEnd = std::chrono::steady_clock::now();
+        for (int i = 0; i < searches; ++i) {
+            std::vector<HistoryMessage> page = storage.searchMessages(self, JID(), HistoryMessage::Groupchat, "topic" + std::to_string(i * 37 % 1000) + " busy", boost::posix_time::ptime(boost::posix_time::not_a_date_time), 50);
+            found += static_cast<int>(page.size());
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Adding " << messageCount << " messages: " << static_cast<long long>(messageCount / std::chrono::duration<double>(addEnd - addStart).count()) << " messages/sec (caller)" << std::endl;
+        std::cout << "Writing " << messageCount << " messages: " << static_cast<long long>(messageCount / std::chrono::duration<double>(writeEnd - addStart).count()) << " messages/sec" << std::endl;
+        std::cout << "Contacts (" << contactsMap.size() << "): " << std::chrono::duration_cast<std::chrono::milliseconds>(contactsEnd - writeEnd).count() << " ms" << std::endl;
+        std::cout << "One day of " << contactCount << " conversations: " << std::chrono::duration_cast<std::chrono::milliseconds>(conversationsEnd - contactsEnd).count() << " ms" << std::endl;
+        std::cout << "Last timestamp of " << mucCount << " MUCs: " << std::chrono::duration_cast<std::chrono::microseconds>(mucsEnd - conversationsEnd).count() << " us" << std::endl;
+        std::cout << "Contacts matching a keyword: " << std::chrono::duration_cast<std::chrono::milliseconds>(contactSearchesEnd - mucsEnd).count() / searches << " ms/search" << std::endl;
+        std::cout << "First page of messages matching a keyword: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - contactSearchesEnd).count() / searches << " ms/search" << std::endl;
+    }
+
+    boost::filesystem::remove(file);
+    boost::filesystem::remove(file.string() + "-wal");
+    boost::filesystem::remove(file.string() + "-shm");
+    return found > 0 ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <Swiften/Client/StanzaChannel.h>
+#include <Swiften/Elements/IBB.h>
+#include <Swiften/FileTransfer/ByteArrayReadBytestream.h>
+#include <Swiften/FileTransfer/ByteArrayWriteBytestream.h>
+#include <Swiften/FileTransfer/IBBReceiveSession.h>
+#include <Swiften/FileTransfer/IBBSendSession.h>
+#include <Swiften/Queries/IQRouter.h>
+
+using namespace Swift;
+
+/*
+ * Sends a file in-band from an IBBSendSession to an IBBReceiveSession over a
+ * simulated link with a given round trip time and bandwidth, and reports the
+ * throughput for different send window sizes. Time is simulated, so the
+ * results do not depend on the speed of the machine.
+ */
+
+namespace {
+    class SimulatedChannel;
+
+    class SimulatedLink {
+        public:
+            SimulatedLink(double roundTripTime, double bytesPerSecond) : now(0), roundTripTime(roundTripTime), bytesPerSecond(bytesPerSecond), linkFree(0) {
+            }
+
+            void send(SimulatedChannel* target, const JID& from, std::shared_ptr<IQ> iq, size_t size) {
+                // Stanzas queue up on the link, and arrive half a round trip after they are on the wire
+                linkFree = std::max(now, linkFree) + static_cast<double>(size) / bytesPerSecond;
+                deliveries.insert(std::make_pair(linkFree + roundTripTime / 2, Delivery(target, from, iq)));
+            }
+
+            bool deliverNext();
+
+            double now;
+
+        private:
+            struct Delivery {
+                Delivery(SimulatedChannel* target, const JID& from, std::shared_ptr<IQ> iq) : target(target), from(from), iq(iq) {}
+                SimulatedChannel* target;
+                JID from;
+                std::shared_ptr<IQ> iq;
+            };
+
+            double roundTripTime;
+            double bytesPerSecond;
+            double linkFree;
+            std::multimap<double, Delivery> deliveries;
+    };
+
+    class SimulatedChannel : public StanzaChannel {
+        public:
+            SimulatedChannel(SimulatedLink* link, const JID& jid) : link(link), jid(jid), peer(nullptr), idCounter(0) {
+            }
+
+            void setPeer(SimulatedChannel* peer) {
+                this->peer = peer;
+            }
+
+            virtual void sendIQ(std::shared_ptr<IQ> iq) {
+                size_t size = 200;
+                if (std::shared_ptr<IBB> ibb = iq->getPayload<IBB>()) {
+                    // Data is Base64 encoded on the wire
+                    size += ibb->getData().size() * 4 / 3;
+                }
+                link->send(peer, jid, iq, size);
+            }
+
+            virtual std::string getNewIQID() {
+                return "iq-" + std::to_string(idCounter++);
+            }
+
+            virtual void sendMessage(std::shared_ptr<Message>) {}
+            virtual void sendPresence(std::shared_ptr<Presence>) {}
+            virtual bool isAvailable() const { return true; }
+            virtual bool getStreamManagementEnabled() const { return false; }
+            virtual std::vector<Certificate::ref> getPeerCertificateChain() const { return std::vector<Certificate::ref>(); }
+
+        private:
+            SimulatedLink* link;
+            JID jid;
+            SimulatedChannel* peer;
+            int idCounter;
+    };
+
+    bool SimulatedLink::deliverNext() {
+        if (deliveries.empty()) {
+            return false;
+        }
+        auto delivery = deliveries.begin();
+        now = delivery->first;
+        SimulatedChannel* target = delivery->second.target;
+        std::shared_ptr<IQ> iq = delivery->second.iq;
+        iq->setFrom(delivery->second.from);
+        deliveries.erase(delivery);
+        target->onIQReceived(iq);
+        return true;
+    }
+
+    boost::optional<double> transfer(const std::vector<unsigned char>& data, double roundTripTime, double bytesPerSecond, unsigned int windowSize) {
+        JID sender("sender@example.com/benchmark");
+        JID receiver("receiver@example.com/benchmark");
+        SimulatedLink link(roundTripTime, bytesPerSecond);
+        SimulatedChannel senderChannel(&link, sender);
+        SimulatedChannel receiverChannel(&link, receiver);
+        senderChannel.setPeer(&receiverChannel);
+        receiverChannel.setPeer(&senderChannel);
+        IQRouter senderRouter(&senderChannel);
+        IQRouter receiverRouter(&receiverChannel);
+
+        std::shared_ptr<ByteArrayWriteBytestream> output = std::make_shared<ByteArrayWriteBytestream>();
+        IBBReceiveSession receiveSession("session", sender, receiver, data.size(), output, &receiverRouter);
+        IBBSendSession sendSession("session", sender, receiver, std::make_shared<ByteArrayReadBytestream>(data), &senderRouter);
+        sendSession.setBlockSize(4096);
+        sendSession.setWindowSize(windowSize);
+
+        bool succeeded = false;
+        double finishTime = 0;
+        sendSession.onFinished.connect([&](boost::optional<FileTransferError> error) {
+            succeeded = !error;
+            finishTime = link.now;
+        });
+
+        receiveSession.start();
+        sendSession.start();
+        while (link.deliverNext()) {
+        }
+
+        if (!succeeded || output->getData() != data) {
+            return boost::optional<double>();
+        }
+        return data.size() / finishTime;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t fileSize = 1024 * 1024;
+    if (argc > 1) {
+        fileSize = static_cast<size_t>(std::atol(argv[1]));
+    }
+    const double bytesPerSecond = 10 * 1024 * 1024;
+    const double roundTripTimes[] = {0.001, 0.01, 0.05, 0.1, 0.2};
+    const unsigned int windowSizes[] = {1, 2, 4, 8, 16, 32};
+
+    std::vector<unsigned char> data(fileSize);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 7);
+    }
+
+    std::cout << "Sending " << fileSize << " bytes in 4096 byte blocks over a " << bytesPerSecond / 1024 / 1024 << " MB/s link (KB/s)" << std::endl;
+    std::cout << "RTT (ms)";
+    for (unsigned int windowSize : windowSizes) {
+        std::cout << "\twindow " << windowSize;
+    }
+    std::cout << std::endl;
+    int result = 0;
+    for (double roundTripTime : roundTripTimes) {
+        std::cout << roundTripTime * 1000;
+        for (unsigned int windowSize : windowSizes) {
+            boost::optional<double> throughput = transfer(data, roundTripTime, bytesPerSecond, windowSize);
+            if (throughput) {
+                std::cout << "\t" << static_cast<long long>(*throughput / 1024);
+            }
+            else {
+                std::cout << "\tfailed";
+                result = 1;
+            }
+        }
+        std::cout << std::endl;
+    }
+    return result;
+}
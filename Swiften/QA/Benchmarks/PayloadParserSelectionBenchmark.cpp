@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Swiften/Parser/AttributeMap.h>
+#include <Swiften/Parser/PayloadParserFactory.h>
+#include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
+
+using namespace Swift;
+
+/*
+ * Measures how long it takes FullPayloadParserFactoryCollection to select the parser
+ * factory for the child elements of typical stanzas, including elements that are only
+ * handled by the default (raw XML) factory.
+ */
+
+int main(int argc, char* argv[]) {
+    int iterations = 1000000;
+    if (argc > 1) {
+        iterations = std::atoi(argv[1]);
+    }
+
+    const std::vector<std::pair<std::string, std::string> > elements = {
+        {"body", "jabber:client"},
+        {"active", "http://jabber.org/protocol/chatstates"},
+        {"request", "urn:xmpp:receipts"},
+        {"show", "jabber:client"},
+        {"priority", "jabber:client"},
+        {"c", "http://jabber.org/protocol/caps"},
+        {"x", "vcard-temp:x:update"},
+        {"delay", "urn:xmpp:delay"},
+        {"x", "http://jabber.org/protocol/muc#user"},
+        {"query", "jabber:iq:roster"},
+        {"query", "http://jabber.org/protocol/disco#info"},
+        {"pubsub", "http://jabber.org/protocol/pubsub"},
+        {"error", "jabber:client"},
+        {"unknown", "urn:example:unknown"},
+    };
+
+    FullPayloadParserFactoryCollection factories;
+    AttributeMap attributes;
+    size_t matches = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto& element : elements) {
+            if (factories.getPayloadParserFactory(element.first, element.second, attributes)) {
+                matches++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double lookups = static_cast<double>(iterations) * elements.size();
+    double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "Selected " << matches << " factories in " << static_cast<long long>(lookups) << " lookups" << std::endl;
+    std::cout << nanoseconds / lookups << " ns/lookup" << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <Swiften/Elements/CapsInfo.h>
+#include <Swiften/Elements/Delay.h>
+#include <Swiften/Elements/Presence.h>
+#include <Swiften/Elements/VCardUpdate.h>
+#include <Swiften/JID/JID.h>
+#include <Swiften/Serializer/PayloadSerializers/FullPayloadSerializerCollection.h>
+#include <Swiften/Serializer/XMPPSerializer.h>
+
+using namespace Swift;
+
+/*
+ * Measures how many presence stanzas per second XMPPSerializer serializes with
+ * FullPayloadSerializerCollection. Each presence carries the usual show, status,
+ * priority, caps, avatar and delay payloads, so the cost of selecting a payload
+ * serializer is paid six times per stanza.
+ */
+
+int main(int argc, char* argv[]) {
+    int iterations = 200000;
+    if (argc > 1) {
+        iterations = std::atoi(argv[1]);
+    }
+
+    std::vector<Presence::ref> presences;
+    for (int i = 0; i < 16; ++i) {
+        Presence::ref presence = Presence::create("Out for lunch");
+        presence->setFrom(JID("user" + std::to_string(i) + "@example.com/resource"));
+        presence->setTo(JID("bob@example.com"));
+        presence->setShow(StatusShow::Away);
+        presence->setPriority(i);
+        presence->addPayload(std::make_shared<CapsInfo>("http://swift.im", "QgayPKawpkPSDYmwT/WM94uAlu0="));
+        presence->addPayload(std::make_shared<VCardUpdate>("a3f549fa9705e7ead2905de0ee1d5bd1a4d9ba88"));
+        presence->addPayload(std::make_shared<Delay>(boost::posix_time::from_iso_string("20170101T120000")));
+        presences.push_back(presence);
+    }
+
+    FullPayloadSerializerCollection payloadSerializers;
+    XMPPSerializer serializer(&payloadSerializers, ClientStreamType, false);
+    size_t bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        bytes += serializer.serializeElement(presences[i % presences.size()]).size();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Serialized " << iterations << " presences (" << bytes / 1024 << " KiB)" << std::endl;
+    std::cout << static_cast<long long>(iterations / seconds) << " presences/sec" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Swiften/Client/DummyStanzaChannel.h>
+#include <Swiften/Elements/Presence.h>
+#include <Swiften/Presence/PresenceOracle.h>
+#include <Swiften/Roster/XMPPRosterImpl.h>
+
+using namespace Swift;
+
+/*
+ * Replays a login burst of presences through PresenceOracle. Like the roster UI,
+ * every presence change is followed by a lookup of the account and highest
+ * priority presence of the contact; afterwards, all contacts are queried again.
+ */
+
+int main(int argc, char* argv[]) {
+    int presenceCount = 100000;
+    if (argc > 1) {
+        presenceCount = std::atoi(argv[1]);
+    }
+    const int resourcesPerContact = 4;
+    const int contactCount = presenceCount / resourcesPerContact;
+    const StatusShow::Type shows[] = {StatusShow::Online, StatusShow::Away, StatusShow::DND, StatusShow::XA, StatusShow::FFC};
+
+    std::vector<Presence::ref> presences;
+    for (int i = 0; i < presenceCount; ++i) {
+        Presence::ref presence = std::make_shared<Presence>();
+        presence->setFrom(JID("contact" + std::to_string(i % contactCount), "example.com", "resource" + std::to_string(i / contactCount)));
+        presence->setPriority(i % 7);
+        presence->setShow(shows[i % 5]);
+        presences.push_back(presence);
+    }
+    std::vector<JID> contacts;
+    for (int i = 0; i < contactCount; ++i) {
+        contacts.push_back(JID("contact" + std::to_string(i), "example.com"));
+    }
+
+    DummyStanzaChannel stanzaChannel;
+    XMPPRosterImpl roster;
+    PresenceOracle oracle(&stanzaChannel, &roster);
+    int found = 0;
+    oracle.onPresenceChange.connect([&](Presence::ref presence) {
+        JID bareJID = presence->getFrom().toBare();
+        if (oracle.getAccountPresence(bareJID) && oracle.getHighestPriorityPresence(bareJID)) {
+            found++;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& presence : presences) {
+        stanzaChannel.onPresenceReceived(presence);
+    }
+    auto burstEnd = std::chrono::steady_clock::now();
+    const int rounds = 20;
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto& contact : contacts) {
+            if (oracle.getAccountPresence(contact)) {
+                found++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "Login burst of " << presenceCount << " presences (" << contactCount << " contacts): " << static_cast<long long>(presenceCount / std::chrono::duration<double>(burstEnd - start).count()) << " presences/sec" << std::endl;
+    std::cout << "Account presence lookups: " << static_cast<long long>(rounds * contactCount / std::chrono::duration<double>(end - burstEnd).count()) << " lookups/sec" << std::endl;
+    return found > 0 ? 0 : 1;
+}
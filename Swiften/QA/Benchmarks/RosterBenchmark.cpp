@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <Swiften/JID/JID.h>
+#include <Swiften/Roster/XMPPRosterImpl.h>
+
+using namespace Swift;
+
+/*
+ * Measures the heap memory used per contact of a large XMPPRosterImpl, and how
+ * fast its items are looked up by JID. Heap usage is tracked by replacing the
+ * global allocation functions.
+ */
+
+static std::atomic<long long> allocatedBytes(0);
+
+namespace {
+    const size_t allocationHeaderSize = alignof(std::max_align_t);
+}
+
+void* operator new(size_t size) {
+    void* memory = std::malloc(size + allocationHeaderSize);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(memory) = size;
+    allocatedBytes += static_cast<long long>(size);
+    return static_cast<char*>(memory) + allocationHeaderSize;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer) {
+        void* memory = static_cast<char*>(pointer) - allocationHeaderSize;
+        allocatedBytes -= static_cast<long long>(*static_cast<size_t*>(memory));
+        std::free(memory);
+    }
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+int main(int argc, char* argv[]) {
+    int contactCount = 50000;
+    if (argc > 1) {
+        contactCount = std::atoi(argv[1]);
+    }
+
+    std::vector<JID> jids;
+    for (int i = 0; i < contactCount; ++i) {
+        jids.push_back(JID("contact" + std::to_string(i), i % 10 == 0 ? "conference.example.com" : "users.example.com"));
+    }
+
+    long long bytesBefore = allocatedBytes;
+    std::vector<std::string> groups = {"Friends"};
+    XMPPRosterImpl roster;
+    for (const auto& jid : jids) {
+        roster.addContact(jid, "", groups, RosterItemPayload::Both);
+    }
+    long long rosterBytes = allocatedBytes - bytesBefore;
+
+    const int rounds = 20;
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto& jid : jids) {
+            if (roster.containsJID(jid)) {
+                found++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "sizeof(JID): " << sizeof(JID) << " bytes" << std::endl;
+    std::cout << "Roster of " << contactCount << " contacts: " << rosterBytes / contactCount << " heap bytes/contact" << std::endl;
+    std::cout << "Lookups: " << static_cast<long long>(found / seconds) << " lookups/sec" << std::endl;
+    return 0;
+}
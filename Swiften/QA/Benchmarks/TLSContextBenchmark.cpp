@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include <Swiften/TLS/PlatformTLSFactories.h>
+#include <Swiften/TLS/TLSContext.h>
+#include <Swiften/TLS/TLSContextFactory.h>
+#include <Swiften/TLS/TLSOptions.h>
+
+using namespace Swift;
+
+/*
+ * Measures the client-side setup cost of a TLS connection: creating a context
+ * with the platform TLS factory, and starting the handshake up to the point
+ * where the ClientHello is ready to be sent.
+ */
+
+int main(int argc, char* argv[]) {
+    int connectionCount = 200;
+    if (argc > 1) {
+        connectionCount = std::atoi(argv[1]);
+    }
+
+    PlatformTLSFactories factories;
+    TLSContextFactory* contextFactory = factories.getTLSContextFactory();
+    if (!contextFactory) {
+        std::cerr << "No TLS support" << std::endl;
+        return -1;
+    }
+
+    size_t clientHelloBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < connectionCount; ++i) {
+        std::unique_ptr<TLSContext> context(contextFactory->createTLSContext(TLSOptions()));
+        context->onDataForNetwork.connect([&](const SafeByteArray& data) { clientHelloBytes += data.size(); });
+        context->connect();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    std::cout << "Set up " << connectionCount << " TLS connections (" << clientHelloBytes / connectionCount << " byte ClientHello): " << microseconds / connectionCount << " us/connection" << std::endl;
+    return 0;
+}
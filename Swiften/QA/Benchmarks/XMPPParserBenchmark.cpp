@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/Elements/ProtocolHeader.h>
+#include <Swiften/Parser/PayloadParsers/FullPayloadParserFactoryCollection.h>
+#include <Swiften/Parser/PlatformXMLParserFactory.h>
+#include <Swiften/Parser/XMPPParser.h>
+#include <Swiften/Parser/XMPPParserClient.h>
+
+using namespace Swift;
+
+/*
+ * Measures how fast a stream of stanzas, arriving in socket-sized chunks, is parsed
+ * by XMPPParser. The data is fed once through the pointer+length entry point, and
+ * once converted to a std::string per chunk (as the stream stack used to do).
+ */
+
+namespace {
+    class CountingClient : public XMPPParserClient {
+        public:
+            CountingClient() : elements(0) {}
+
+            virtual void handleStreamStart(const ProtocolHeader&) {}
+            virtual void handleElement(std::shared_ptr<ToplevelElement>) { elements++; }
+            virtual void handleStreamEnd() {}
+
+            int elements;
+    };
+
+    SafeByteArray createStream(int stanzaCount) {
+        std::string stream = "<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' from='example.com' id='benchmark' version='1.0'>";
+        for (int i = 0; i < stanzaCount; ++i) {
+            std::string id = std::to_string(i);
+            switch (i % 3) {
+                case 0:
+                    stream += "<message from='alice@example.com/home' to='bob@example.com/work' type='chat' id='m" + id + "'><body>Message number " + id + " with a bit of text in it.</body><active xmlns='http://jabber.org/protocol/chatstates'/></message>";
+                    break;
+                case 1:
+                    stream += "<presence from='carol@example.com/phone' to='bob@example.com' id='p" + id + "'><show>away</show><status>Out for lunch</status><priority>5</priority><c xmlns='http://jabber.org/protocol/caps' hash='sha-1' node='http://swift.im' ver='QgayPKawpkPSDYmwT/WM94uAlu0='/></presence>";
+                    break;
+                default:
+                    stream += "<iq from='example.com' to='bob@example.com/work' type='result' id='i" + id + "'><query xmlns='jabber:iq:version'><name>Swift</name><version>4.0</version></query></iq>";
+                    break;
+            }
+        }
+        return createSafeByteArray(stream);
+    }
+
+    double runBenchmark(const SafeByteArray& stream, size_t chunkSize, bool convertToString, int& elements) {
+        FullPayloadParserFactoryCollection payloadParserFactories;
+        PlatformXMLParserFactory xmlParserFactory;
+        CountingClient client;
+        XMPPParser parser(&client, &payloadParserFactories, &xmlParserFactory);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < stream.size(); offset += chunkSize) {
+            SafeByteArray chunk(stream.begin() + offset, stream.begin() + std::min(offset + chunkSize, stream.size()));
+            bool result;
+            if (convertToString) {
+                result = parser.parse(byteArrayToString(ByteArray(chunk.begin(), chunk.end())));
+            }
+            else {
+                result = parser.parse(reinterpret_cast<const char*>(vecptr(chunk)), chunk.size());
+            }
+            if (!result) {
+                std::cerr << "Parse error" << std::endl;
+                std::exit(-1);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        elements = client.elements;
+        return stream.size() / std::chrono::duration<double>(end - start).count() / (1024 * 1024);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int stanzaCount = 200000;
+    if (argc > 1) {
+        stanzaCount = std::atoi(argv[1]);
+    }
+    SafeByteArray stream = createStream(stanzaCount);
+    const size_t chunkSize = 4096;
+
+    int elements = 0;
+    double stringThroughput = runBenchmark(stream, chunkSize, true, elements);
+    double directThroughput = runBenchmark(stream, chunkSize, false, elements);
+
+    std::cout << "Parsed " << elements << " stanzas (" << stream.size() / 1024 << " KiB) in " << chunkSize << " byte chunks" << std::endl;
+    std::cout << "std::string conversion: " << stringThroughput << " MB/s" << std::endl;
+    std::cout << "pointer+length:         " << directThroughput << " MB/s" << std::endl;
+    return 0;
+}
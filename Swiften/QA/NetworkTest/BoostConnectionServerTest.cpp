@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,12 +7,15 @@
 #include <memory>
 #include <string>
 
+#include <boost/bind.hpp>
+
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
 #include <Swiften/Base/sleep.h>
 #include <Swiften/EventLoop/DummyEventLoop.h>
 #include <Swiften/Network/BoostConnectionServer.h>
+#include <Swiften/Network/BoostIOServicePool.h>
 #include <Swiften/Network/BoostIOServiceThread.h>
 
 using namespace Swift;
@@ -26,6 +29,7 @@ class BoostConnectionServerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testIPv6Server);
         CPPUNIT_TEST(testIPv4IPv6DualStackServer);
         CPPUNIT_TEST(testIPv6DualStackServerPeerAddress);
+        CPPUNIT_TEST(testIOServicePoolServer);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -188,6 +192,28 @@ class BoostConnectionServerTest : public CppUnit::TestFixture {
             testling->stop();
         }
 
+        void testIOServicePoolServer() {
+            std::shared_ptr<BoostIOServicePool> ioServicePool = std::make_shared<BoostIOServicePool>(2);
+            BoostConnectionServer::ref testling = BoostConnectionServer::create(HostAddress::fromString("127.0.0.1").get(), 9999, ioServicePool, eventLoop_);
+            testling->onNewConnection.connect(boost::bind(&BoostConnectionServerTest::handleNewConnection, this, _1));
+            testling->start();
+
+            BoostConnection::ref clientTestling = BoostConnection::create(ioServicePool->getNextIOService(), eventLoop_);
+            clientTestling->onConnectFinished.connect(boost::bind(&BoostConnectionServerTest::handleConnectFinished, this, _1));
+            clientTestling->connect(HostAddressPort(HostAddress::fromString("127.0.0.1").get(), 9999));
+
+            while (!connectFinished_ || !receivedNewConnection_) {
+                Swift::sleep(10);
+                eventLoop_->processEvents();
+            }
+
+            CPPUNIT_ASSERT_EQUAL(true, receivedNewConnection_);
+            CPPUNIT_ASSERT(HostAddress::fromString("127.0.0.1").get() == remoteAddress_.get().getAddress());
+
+            testling->stop();
+            clientTestling->disconnect();
+        }
+
         void handleStopped_(boost::optional<BoostConnectionServer::Error> e) {
             stopped_ = true;
             stoppedError_ = e;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,8 +7,13 @@
 #include <memory>
 #include <string>
 
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 
+#include <QA/Checker/IO.h>
+
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
@@ -28,6 +33,10 @@ class BoostConnectionTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testDestructor_PendingEvents);
         CPPUNIT_TEST(testWrite);
         CPPUNIT_TEST(testWriteMultipleSimultaniouslyQueuesWrites);
+        CPPUNIT_TEST(testWrite_CoalescesWritesBelowThreshold);
+        CPPUNIT_TEST(testWrite_DoesNotCoalesceWritesAboveThreshold);
+        CPPUNIT_TEST(testWrite_SendsQueuedBuffersInSingleWrite);
+        CPPUNIT_TEST(testGetQueuedWriteBytes_ZeroAfterWrite);
 #ifdef TEST_IPV6
         CPPUNIT_TEST(testWrite_IPv6);
 #endif
@@ -40,6 +49,7 @@ class BoostConnectionTest : public CppUnit::TestFixture {
             boostIOService_ = std::make_shared<boost::asio::io_service>();
             disconnected_ = false;
             connectFinished_ = false;
+            dataWrittenCount_ = 0;
         }
 
         void tearDown() {
@@ -130,6 +140,7 @@ class BoostConnectionTest : public CppUnit::TestFixture {
             testling->write(createSafeByteArray("<stream:strea"));
             testling->write(createSafeByteArray("m"));
             testling->write(createSafeByteArray(">"));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(15), testling->getQueuedWriteBytes());
 
              // Check that we only did one write event, the others are queued
             /*int runHandlers = */boostIOService_->poll();
@@ -150,6 +161,114 @@ class BoostConnectionTest : public CppUnit::TestFixture {
             }
         }
 
+        void testWrite_CoalescesWritesBelowThreshold() {
+            BoostConnection::ref testling(connectToLocalServer());
+            testling->setWriteCoalescingThreshold(8);
+
+            testling->write(createSafeByteArray("<a>"));
+            testling->write(createSafeByteArray("<b/>"));
+            testling->write(createSafeByteArray("</a>"));
+
+            // The first write is in progress, the others are appended to a single queued buffer
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling->writeQueue_.size());
+            CPPUNIT_ASSERT_EQUAL(createSafeByteArray("<b/></a>"), *testling->writeQueue_[0].safeData);
+
+            waitForDataWritten(2);
+            CPPUNIT_ASSERT_EQUAL(createByteArray("<a><b/></a>"), readFromServer(11));
+            disconnect(testling);
+        }
+
+        void testWrite_DoesNotCoalesceWritesAboveThreshold() {
+            BoostConnection::ref testling(connectToLocalServer());
+            testling->setWriteCoalescingThreshold(4);
+
+            testling->write(createSafeByteArray("<a>"));
+            testling->write(createSafeByteArray("<b/>"));
+            testling->write(createSafeByteArray("<c/>"));
+            testling->write(createSafeByteArray("<message/>"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), testling->writeQueue_.size());
+
+            waitForDataWritten(2);
+            CPPUNIT_ASSERT_EQUAL(createByteArray("<a><b/><c/><message/>"), readFromServer(21));
+            disconnect(testling);
+        }
+
+        void testWrite_SendsQueuedBuffersInSingleWrite() {
+            BoostConnection::ref testling(connectToLocalServer());
+            testling->setWriteCoalescingThreshold(0);
+
+            testling->write(createSafeByteArray("<a>"));
+            testling->write(createSafeByteArray("<b/>"));
+            testling->writeBuffer(std::make_shared<ByteArray>(createByteArray("<c/>")));
+            testling->write(createSafeByteArray("</a>"));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), testling->writeQueue_.size());
+
+            // One write for the first buffer, and one gathering write for the queued ones
+            waitForDataWritten(2);
+            boostIOService_->poll();
+            eventLoop_->processEvents();
+            CPPUNIT_ASSERT_EQUAL(2, dataWrittenCount_);
+            CPPUNIT_ASSERT(testling->writeQueue_.empty());
+            CPPUNIT_ASSERT(testling->writesInFlight_.empty());
+            CPPUNIT_ASSERT_EQUAL(createByteArray("<a><b/><c/></a>"), readFromServer(15));
+            disconnect(testling);
+        }
+
+        void testGetQueuedWriteBytes_ZeroAfterWrite() {
+            BoostConnection::ref testling(connectToLocalServer());
+
+            testling->write(createSafeByteArray("<a>"));
+            testling->write(createSafeByteArray("<b/>"));
+            testling->writeBuffer(std::make_shared<ByteArray>(createByteArray("</a>")));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(11), testling->getQueuedWriteBytes());
+
+            waitForDataWritten(2);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling->getQueuedWriteBytes());
+            disconnect(testling);
+        }
+
+        BoostConnection::ref connectToLocalServer() {
+            using namespace boost::asio::ip;
+
+            acceptor_ = std::make_shared<tcp::acceptor>(*boostIOService_, tcp::endpoint(address_v4::loopback(), 0));
+            serverSocket_ = std::make_shared<tcp::socket>(*boostIOService_);
+            bool accepted = false;
+            acceptor_->async_accept(*serverSocket_, [&accepted](const boost::system::error_code&) { accepted = true; });
+
+            BoostConnection::ref testling(BoostConnection::create(boostIOService_, eventLoop_));
+            testling->onConnectFinished.connect(boost::bind(&BoostConnectionTest::handleConnectFinished, this));
+            testling->onDataWritten.connect(boost::bind(&BoostConnectionTest::handleDataWritten, this));
+            testling->onDisconnected.connect(boost::bind(&BoostConnectionTest::handleDisconnected, this));
+            testling->connect(HostAddressPort(HostAddress::fromString("127.0.0.1").get(), acceptor_->local_endpoint().port()));
+            while (!connectFinished_ || !accepted) {
+                boostIOService_->run_one();
+                eventLoop_->processEvents();
+            }
+            return testling;
+        }
+
+        void waitForDataWritten(int count) {
+            while (dataWrittenCount_ < count) {
+                boostIOService_->run_one();
+                eventLoop_->processEvents();
+            }
+        }
+
+        ByteArray readFromServer(size_t size) {
+            ByteArray result(size);
+            boost::asio::read(*serverSocket_, boost::asio::buffer(result));
+            return result;
+        }
+
+        void disconnect(BoostConnection::ref testling) {
+            testling->disconnect();
+            while (!disconnected_) {
+                boostIOService_->run_one();
+                eventLoop_->processEvents();
+            }
+        }
+
         void doWrite(BoostConnection* connection) {
             connection->write(createSafeByteArray("<stream:stream>"));
             connection->write(createSafeByteArray("\r\n\r\n")); // Temporarily, while we don't have an xmpp server running on ipv6
@@ -167,6 +286,10 @@ class BoostConnectionTest : public CppUnit::TestFixture {
             connectFinished_ = true;
         }
 
+        void handleDataWritten() {
+            dataWrittenCount_++;
+        }
+
     private:
         BoostIOServiceThread* boostIOServiceThread_;
         std::shared_ptr<boost::asio::io_service> boostIOService_;
@@ -174,6 +297,9 @@ class BoostConnectionTest : public CppUnit::TestFixture {
         ByteArray receivedData_;
         bool disconnected_;
         bool connectFinished_;
+        int dataWrittenCount_;
+        std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
+        std::shared_ptr<boost::asio::ip::tcp::socket> serverSocket_;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(BoostConnectionTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -18,6 +18,7 @@ class FileReadBytestreamTest : public CppUnit::TestFixture {
         CPPUNIT_TEST_SUITE(FileReadBytestreamTest);
         CPPUNIT_TEST(testRead);
         CPPUNIT_TEST(testRead_Twice);
+        CPPUNIT_TEST(testRead_ReusesReleasedBuffer);
         CPPUNIT_TEST(testIsFinished_NotFinished);
         CPPUNIT_TEST(testIsFinished_IsFinished);
         CPPUNIT_TEST_SUITE_END();
@@ -48,6 +49,18 @@ class FileReadBytestreamTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string("right (c) "), byteArrayToString(*result));
         }
 
+        void testRead_ReusesReleasedBuffer() {
+            std::shared_ptr<FileReadBytestream> testling(createTestling());
+
+            std::shared_ptr< std::vector<unsigned char> > result = testling->read(10);
+            const unsigned char* buffer = vecptr(*result);
+            result.reset();
+            result = testling->read(10);
+
+            CPPUNIT_ASSERT(buffer == vecptr(*result));
+            CPPUNIT_ASSERT_EQUAL(std::string("right (c) "), byteArrayToString(*result));
+        }
+
         void testIsFinished_NotFinished() {
             std::shared_ptr<FileReadBytestream> testling(createTestling());
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -17,7 +17,7 @@ namespace Swift {
 
 static void noop(IQHandler*) {}
 
-IQRouter::IQRouter(IQChannel* channel) : channel_(channel), queueRemoves_(false) {
+IQRouter::IQRouter(IQChannel* channel) : channel_(channel), addedHandlerCount_(0), responseHandlerCount_(0), queueRemoves_(false) {
     channel->onIQReceived.connect(boost::bind(&IQRouter::handleIQ, this, _1));
 }
 
@@ -32,14 +32,28 @@ bool IQRouter::isAvailable() {
 void IQRouter::handleIQ(std::shared_ptr<IQ> iq) {
     queueRemoves_ = true;
 
+    // Handlers may add response handlers (e.g. by sending a new request), so don't iterate over the map itself.
+    std::vector<OrderedHandler> responseHandlers;
+    if (iq->getType() == IQ::Result || iq->getType() == IQ::Error) {
+        auto i = responseHandlers_.find(iq->getID());
+        if (i != responseHandlers_.end()) {
+            responseHandlers = i->second;
+        }
+    }
+
+    // Go through the handlers in reverse order, to give precedence to the last added handler.
+    // The response handlers for this IQ are merged in by the order in which they were added.
     bool handled = false;
-    // Go through the handlers in reverse order, to give precedence to the last added handler
-    std::vector<std::shared_ptr<IQHandler> >::const_reverse_iterator i = handlers_.rbegin();
-    std::vector<std::shared_ptr<IQHandler> >::const_reverse_iterator rend = handlers_.rend();
-    for (; i != rend; ++i) {
-        handled |= (*i)->handleIQ(iq);
-        if (handled) {
-            break;
+    auto responseHandler = responseHandlers.crbegin();
+    auto handler = handlers_.crbegin();
+    while (!handled && (responseHandler != responseHandlers.crend() || handler != handlers_.crend())) {
+        if (handler == handlers_.crend() || (responseHandler != responseHandlers.crend() && responseHandler->first > handler->first)) {
+            handled = responseHandler->second->handleIQ(iq);
+            ++responseHandler;
+        }
+        else {
+            handled = handler->second->handleIQ(iq);
+            ++handler;
         }
     }
     if (!handled && (iq->getType() == IQ::Get || iq->getType() == IQ::Set) ) {
@@ -53,9 +67,13 @@ void IQRouter::handleIQ(std::shared_ptr<IQ> iq) {
 
 void IQRouter::processPendingRemoves() {
     for (auto&& handler : queuedRemoves_) {
-        erase(handlers_, handler);
+        eraseHandler(handler.get());
     }
     queuedRemoves_.clear();
+    for (auto&& idAndHandler : queuedResponseRemoves_) {
+        eraseResponseHandler(idAndHandler.first, idAndHandler.second);
+    }
+    queuedResponseRemoves_.clear();
 }
 
 void IQRouter::addHandler(IQHandler* handler) {
@@ -67,7 +85,7 @@ void IQRouter::removeHandler(IQHandler* handler) {
 }
 
 void IQRouter::addHandler(std::shared_ptr<IQHandler> handler) {
-    handlers_.push_back(handler);
+    handlers_.push_back(std::make_pair(addedHandlerCount_++, handler));
 }
 
 void IQRouter::removeHandler(std::shared_ptr<IQHandler> handler) {
@@ -75,7 +93,51 @@ void IQRouter::removeHandler(std::shared_ptr<IQHandler> handler) {
         queuedRemoves_.push_back(handler);
     }
     else {
-        erase(handlers_, handler);
+        eraseHandler(handler.get());
+    }
+}
+
+void IQRouter::eraseHandler(IQHandler* handler) {
+    eraseIf(handlers_, [&](const OrderedHandler& orderedHandler) { return orderedHandler.second.get() == handler; });
+}
+
+void IQRouter::addResponseHandler(const std::string& id, IQHandler* handler) {
+    addResponseHandler(id, std::shared_ptr<IQHandler>(handler, noop));
+}
+
+void IQRouter::removeResponseHandler(const std::string& id, IQHandler* handler) {
+    if (queueRemoves_) {
+        queuedResponseRemoves_.push_back(std::make_pair(id, handler));
+    }
+    else {
+        eraseResponseHandler(id, handler);
+    }
+}
+
+void IQRouter::addResponseHandler(const std::string& id, std::shared_ptr<IQHandler> handler) {
+    responseHandlers_[id].push_back(std::make_pair(addedHandlerCount_++, handler));
+    responseHandlerCount_++;
+}
+
+void IQRouter::removeResponseHandler(const std::string& id, std::shared_ptr<IQHandler> handler) {
+    removeResponseHandler(id, handler.get());
+}
+
+void IQRouter::eraseResponseHandler(const std::string& id, IQHandler* handler) {
+    auto i = responseHandlers_.find(id);
+    if (i == responseHandlers_.end()) {
+        return;
+    }
+    std::vector<OrderedHandler>& handlers = i->second;
+    for (auto j = handlers.begin(); j != handlers.end(); ++j) {
+        if (j->second.get() == handler) {
+            handlers.erase(j);
+            responseHandlerCount_--;
+            break;
+        }
+    }
+    if (handlers.empty()) {
+        responseHandlers_.erase(i);
     }
 }
 
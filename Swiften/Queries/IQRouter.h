@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,6 +8,8 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <Swiften/Base/API.h>
@@ -52,6 +54,28 @@ namespace Swift {
             void addHandler(std::shared_ptr<IQHandler> handler);
             void removeHandler(std::shared_ptr<IQHandler> handler);
 
+            /**
+             * Adds a handler for the response (result or error) to the IQ with the given ID.
+             *
+             * Response handlers are looked up by ID, so outstanding requests do not slow
+             * down the routing of other IQs. The handler still decides whether it accepts
+             * the response (e.g. by checking its sender). A response is offered to the
+             * response handlers for its ID and to the regular handlers together, the last
+             * added handler first, until one of them accepts it.
+             */
+            void addResponseHandler(const std::string& id, IQHandler* handler);
+            void removeResponseHandler(const std::string& id, IQHandler* handler);
+            void addResponseHandler(const std::string& id, std::shared_ptr<IQHandler> handler);
+            void removeResponseHandler(const std::string& id, std::shared_ptr<IQHandler> handler);
+
+            /**
+             * Returns the number of response handlers, i.e. the number of sent
+             * requests that are still waiting for a response.
+             */
+            size_t getPendingRequestCount() const {
+                return responseHandlerCount_;
+            }
+
             /**
              * Sends an IQ stanza.
              *
@@ -75,15 +99,24 @@ namespace Swift {
             }
 
         private:
+            // A handler, with the number of handlers that were added before it
+            typedef std::pair<size_t, std::shared_ptr<IQHandler> > OrderedHandler;
+
             void handleIQ(std::shared_ptr<IQ> iq);
             void processPendingRemoves();
+            void eraseHandler(IQHandler* handler);
+            void eraseResponseHandler(const std::string& id, IQHandler* handler);
 
         private:
             IQChannel* channel_;
             JID jid_;
             JID from_;
-            std::vector< std::shared_ptr<IQHandler> > handlers_;
+            std::vector<OrderedHandler> handlers_;
             std::vector< std::shared_ptr<IQHandler> > queuedRemoves_;
+            std::unordered_map<std::string, std::vector<OrderedHandler> > responseHandlers_;
+            size_t addedHandlerCount_;
+            size_t responseHandlerCount_;
+            std::vector< std::pair<std::string, IQHandler*> > queuedResponseRemoves_;
             bool queueRemoves_;
     };
 }
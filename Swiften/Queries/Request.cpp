@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -37,10 +37,10 @@ std::string Request::send() {
     iq->setID(id_);
 
     try {
-        router_->addHandler(shared_from_this());
+        router_->addResponseHandler(id_, shared_from_this());
     }
     catch (const std::exception&) {
-        router_->addHandler(this);
+        router_->addResponseHandler(id_, this);
     }
 
     router_->sendIQ(iq);
@@ -68,7 +68,7 @@ bool Request::handleIQ(std::shared_ptr<IQ> iq) {
                         handleResponse(std::shared_ptr<Payload>(), ErrorPayload::ref(new ErrorPayload(ErrorPayload::UndefinedCondition)));
                     }
                 }
-                router_->removeHandler(this);
+                router_->removeResponseHandler(id_, this);
                 handled = true;
             }
         }
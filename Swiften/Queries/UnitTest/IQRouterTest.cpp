@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -28,6 +28,13 @@ class IQRouterTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testSendIQ_WithFrom);
         CPPUNIT_TEST(testSendIQ_WithoutFrom);
         CPPUNIT_TEST(testHandleIQ_WithFrom);
+        CPPUNIT_TEST(testHandleIQ_ResponseHandler);
+        CPPUNIT_TEST(testHandleIQ_ResponseHandlerWithOtherID);
+        CPPUNIT_TEST(testHandleIQ_ResponseHandlersWithSameID);
+        CPPUNIT_TEST(testHandleIQ_ResponseHandlerNotCalledForRequests);
+        CPPUNIT_TEST(testHandleIQ_ResponseNotAcceptedByResponseHandler);
+        CPPUNIT_TEST(testHandleIQ_ResponseGoesToLastAddedHandlerFirst);
+        CPPUNIT_TEST(testRemoveResponseHandler);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -138,6 +145,102 @@ class IQRouterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(JID("foo@bar.com/baz"), channel_->iqs_[0]->getFrom());
         }
 
+        void testHandleIQ_ResponseHandler() {
+            IQRouter testling(channel_);
+            DummyIQHandler handler(true, &testling);
+            ResponseHandler responseHandler1(true, "id1", &testling);
+            ResponseHandler responseHandler2(true, "id2", &testling);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), testling.getPendingRequestCount());
+
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id1"));
+
+            CPPUNIT_ASSERT_EQUAL(1, responseHandler1.called);
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler2.called);
+            CPPUNIT_ASSERT_EQUAL(0, handler.called);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getPendingRequestCount());
+        }
+
+        void testHandleIQ_ResponseHandlersWithSameID() {
+            IQRouter testling(channel_);
+            ResponseHandler responseHandler1(true, "id1", &testling);
+            ResponseHandler responseHandler2(true, "id1", &testling);
+
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id1"));
+
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler1.called);
+            CPPUNIT_ASSERT_EQUAL(1, responseHandler2.called);
+        }
+
+        void testHandleIQ_ResponseHandlerWithOtherID() {
+            IQRouter testling(channel_);
+            DummyIQHandler handler(true, &testling);
+            ResponseHandler responseHandler(true, "id1", &testling);
+
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id2"));
+
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler.called);
+            CPPUNIT_ASSERT_EQUAL(1, handler.called);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getPendingRequestCount());
+        }
+
+        void testHandleIQ_ResponseHandlerNotCalledForRequests() {
+            IQRouter testling(channel_);
+            DummyIQHandler handler(true, &testling);
+            ResponseHandler responseHandler(true, "id1", &testling);
+            auto iq = std::make_shared<IQ>(IQ::Get);
+            iq->setID("id1");
+
+            channel_->onIQReceived(iq);
+
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler.called);
+            CPPUNIT_ASSERT_EQUAL(1, handler.called);
+        }
+
+        void testHandleIQ_ResponseNotAcceptedByResponseHandler() {
+            IQRouter testling(channel_);
+            DummyIQHandler handler(true, &testling);
+            ResponseHandler responseHandler(false, "id1", &testling);
+
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id1"));
+
+            CPPUNIT_ASSERT_EQUAL(1, responseHandler.called);
+            CPPUNIT_ASSERT_EQUAL(1, handler.called);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getPendingRequestCount());
+        }
+
+        void testHandleIQ_ResponseGoesToLastAddedHandlerFirst() {
+            IQRouter testling(channel_);
+            ResponseHandler responseHandler1(false, "id1", &testling);
+            DummyIQHandler handler1(false, &testling);
+            ResponseHandler responseHandler2(false, "id1", &testling);
+            DummyIQHandler handler2(true, &testling);
+
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id1"));
+
+            CPPUNIT_ASSERT_EQUAL(1, handler2.called);
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler2.called);
+            CPPUNIT_ASSERT_EQUAL(0, handler1.called);
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler1.called);
+
+            handler2.handle = false;
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id1"));
+
+            CPPUNIT_ASSERT_EQUAL(1, responseHandler2.called);
+            CPPUNIT_ASSERT_EQUAL(1, handler1.called);
+            CPPUNIT_ASSERT_EQUAL(1, responseHandler1.called);
+        }
+
+        void testRemoveResponseHandler() {
+            IQRouter testling(channel_);
+            ResponseHandler responseHandler(true, "id1", &testling);
+
+            testling.removeResponseHandler("id1", &responseHandler);
+            channel_->onIQReceived(IQ::createResult(JID("foo@bar.com"), "id1"));
+
+            CPPUNIT_ASSERT_EQUAL(0, responseHandler.called);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling.getPendingRequestCount());
+        }
+
     private:
         struct DummyIQHandler : public IQHandler {
             DummyIQHandler(bool handle, IQRouter* router) : handle(handle), router(router), called(0) {
@@ -172,6 +275,24 @@ class IQRouterTest : public CppUnit::TestFixture {
         };
 
 
+        struct ResponseHandler : public IQHandler {
+            ResponseHandler(bool handle, const std::string& id, IQRouter* router) : handle(handle), id(id), router(router), called(0) {
+                router->addResponseHandler(id, this);
+            }
+
+            virtual bool handleIQ(std::shared_ptr<IQ>) {
+                called++;
+                if (handle) {
+                    router->removeResponseHandler(id, this);
+                }
+                return handle;
+            }
+            bool handle;
+            std::string id;
+            IQRouter* router;
+            int called;
+        };
+
         DummyIQChannel* channel_;
 };
 
@@ -1,10 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/bind.hpp>
 
@@ -23,6 +26,7 @@ class XMPPRosterImplTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testJIDAdded);
         CPPUNIT_TEST(testJIDRemoved);
         CPPUNIT_TEST(testJIDUpdated);
+        CPPUNIT_TEST(testGetItems_SortedByJID);
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -59,6 +63,22 @@ class XMPPRosterImplTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT(groups2_ == roster_->getGroupsForJID(jid3_));
         }
 
+        void testGetItems_SortedByJID() {
+            std::vector<JID> jids;
+            for (int i = 0; i < 20; ++i) {
+                jids.push_back(JID("contact" + std::to_string((i * 7) % 20) + "@b.c"));
+                roster_->addContact(jids.back(), "", groups1_, RosterItemPayload::Both);
+            }
+
+            std::vector<XMPPRosterItem> items = roster_->getItems();
+
+            std::sort(jids.begin(), jids.end());
+            CPPUNIT_ASSERT_EQUAL(jids.size(), items.size());
+            for (size_t i = 0; i < jids.size(); ++i) {
+                CPPUNIT_ASSERT_EQUAL(jids[i], items[i].getJID());
+            }
+        }
+
         void testJIDRemoved() {
             roster_->addContact(jid1_, "NewName", groups1_, RosterItemPayload::Both);
             handler_->reset();
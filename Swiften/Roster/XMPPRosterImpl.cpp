@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Roster/XMPPRosterImpl.h>
 
+#include <algorithm>
+
 namespace Swift {
 
 XMPPRosterImpl::XMPPRosterImpl() {
@@ -17,7 +19,7 @@ XMPPRosterImpl::~XMPPRosterImpl() {
 
 void XMPPRosterImpl::addContact(const JID& jid, const std::string& name, const std::vector<std::string>& groups, RosterItemPayload::Subscription subscription) {
     JID bareJID(jid.toBare());
-    std::map<JID, XMPPRosterItem>::iterator i = entries_.find(bareJID);
+    std::unordered_map<JID, XMPPRosterItem>::iterator i = entries_.find(bareJID);
     if (i != entries_.end()) {
         std::string oldName = i->second.getName();
         std::vector<std::string> oldGroups = i->second.getGroups();
@@ -45,7 +47,7 @@ bool XMPPRosterImpl::containsJID(const JID& jid) {
 }
 
 std::string XMPPRosterImpl::getNameForJID(const JID& jid) const {
-    std::map<JID, XMPPRosterItem>::const_iterator i = entries_.find(jid.toBare());
+    std::unordered_map<JID, XMPPRosterItem>::const_iterator i = entries_.find(jid.toBare());
     if (i != entries_.end()) {
         return i->second.getName();
     }
@@ -55,7 +57,7 @@ std::string XMPPRosterImpl::getNameForJID(const JID& jid) const {
 }
 
 std::vector<std::string> XMPPRosterImpl::getGroupsForJID(const JID& jid) {
-    std::map<JID, XMPPRosterItem>::iterator i = entries_.find(jid.toBare());
+    std::unordered_map<JID, XMPPRosterItem>::iterator i = entries_.find(jid.toBare());
     if (i != entries_.end()) {
         return i->second.getGroups();
     }
@@ -65,7 +67,7 @@ std::vector<std::string> XMPPRosterImpl::getGroupsForJID(const JID& jid) {
 }
 
 RosterItemPayload::Subscription XMPPRosterImpl::getSubscriptionStateForJID(const JID& jid) {
-    std::map<JID, XMPPRosterItem>::iterator i = entries_.find(jid.toBare());
+    std::unordered_map<JID, XMPPRosterItem>::iterator i = entries_.find(jid.toBare());
     if (i != entries_.end()) {
         return i->second.getSubscription();
     }
@@ -76,14 +78,17 @@ RosterItemPayload::Subscription XMPPRosterImpl::getSubscriptionStateForJID(const
 
 std::vector<XMPPRosterItem> XMPPRosterImpl::getItems() const {
     std::vector<XMPPRosterItem> result;
+    result.reserve(entries_.size());
     for (const auto& entry : entries_) {
         result.push_back(entry.second);
     }
+    // Return the items in JID order, independent of the hash map layout
+    std::sort(result.begin(), result.end(), [](const XMPPRosterItem& a, const XMPPRosterItem& b) { return a.getJID() < b.getJID(); });
     return result;
 }
 
 boost::optional<XMPPRosterItem> XMPPRosterImpl::getItem(const JID& jid) const {
-    std::map<JID, XMPPRosterItem>::const_iterator i = entries_.find(jid.toBare());
+    std::unordered_map<JID, XMPPRosterItem>::const_iterator i = entries_.find(jid.toBare());
     if (i != entries_.end()) {
         return i->second;
     }
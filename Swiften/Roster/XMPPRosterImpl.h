@@ -1,13 +1,13 @@
 /*
- * Copyright (c) 2010-2015 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <map>
 #include <set>
+#include <unordered_map>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Roster/XMPPRoster.h>
@@ -32,7 +32,7 @@ namespace Swift {
             virtual std::set<std::string> getGroups() const;
 
         private:
-            typedef std::map<JID, XMPPRosterItem> RosterMap;
+            typedef std::unordered_map<JID, XMPPRosterItem> RosterMap;
             RosterMap entries_;
     };
 }
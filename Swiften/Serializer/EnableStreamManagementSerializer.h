@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -19,8 +19,13 @@ namespace Swift {
             EnableStreamManagementSerializer() : GenericElementSerializer<EnableStreamManagement>() {
             }
 
-            virtual SafeByteArray serialize(std::shared_ptr<ToplevelElement>) const {
-                return createSafeByteArray(XMLElement("enable", "urn:xmpp:sm:2").serialize());
+            virtual SafeByteArray serialize(std::shared_ptr<ToplevelElement> el) const {
+                std::shared_ptr<EnableStreamManagement> e(std::dynamic_pointer_cast<EnableStreamManagement>(el));
+                XMLElement element("enable", "urn:xmpp:sm:2");
+                if (e->getResumeSupported()) {
+                    element.setAttribute("resume", "true");
+                }
+                return createSafeByteArray(element.serialize());
             }
     };
 }
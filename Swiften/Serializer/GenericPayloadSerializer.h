@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,6 +23,18 @@ namespace Swift {
                 return !!std::dynamic_pointer_cast<PAYLOAD_TYPE>(element);
             }
 
+            virtual void serializeInto(std::shared_ptr<Payload> element, std::string& output) const {
+                serializePayloadInto(std::dynamic_pointer_cast<PAYLOAD_TYPE>(element), output);
+            }
+
             virtual std::string serializePayload(std::shared_ptr<PAYLOAD_TYPE>) const = 0;
+
+            /**
+             * Appends the serialized payload to \p output.
+             * Serializers can override this to avoid building an intermediate string.
+             */
+            virtual void serializePayloadInto(std::shared_ptr<PAYLOAD_TYPE> payload, std::string& output) const {
+                output += serializePayload(payload);
+            }
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,5 +20,11 @@ namespace Swift {
 
             virtual bool canSerialize(std::shared_ptr<Payload>) const = 0;
             virtual std::string serialize(std::shared_ptr<Payload>) const = 0;
+
+            /**
+             * Appends the serialized payload to \p output.
+             * The default implementation appends the result of serialize().
+             */
+            virtual void serializeInto(std::shared_ptr<Payload>, std::string& output) const;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,8 +7,7 @@
 #include <Swiften/Serializer/PayloadSerializerCollection.h>
 
 #include <algorithm>
-
-#include <boost/bind.hpp>
+#include <typeinfo>
 
 #include <Swiften/Serializer/PayloadSerializer.h>
 
@@ -22,17 +21,38 @@ PayloadSerializerCollection::~PayloadSerializerCollection() {
 
 void PayloadSerializerCollection::addSerializer(PayloadSerializer* serializer) {
     serializers_.push_back(serializer);
+    std::lock_guard<std::mutex> lock(serializersByTypeMutex_);
+    serializersByType_.clear();
 }
 
 void PayloadSerializerCollection::removeSerializer(PayloadSerializer* serializer) {
     serializers_.erase(std::remove(serializers_.begin(), serializers_.end(), serializer), serializers_.end());
+    std::lock_guard<std::mutex> lock(serializersByTypeMutex_);
+    serializersByType_.clear();
 }
 
 PayloadSerializer* PayloadSerializerCollection::getPayloadSerializer(std::shared_ptr<Payload> payload) const {
-    std::vector<PayloadSerializer*>::const_iterator i = std::find_if(
-            serializers_.begin(), serializers_.end(),
-            boost::bind(&PayloadSerializer::canSerialize, _1, payload));
-    return (i != serializers_.end() ? *i : nullptr);
+    if (!payload) {
+        return nullptr;
+    }
+    std::type_index type(typeid(*payload));
+    {
+        std::lock_guard<std::mutex> lock(serializersByTypeMutex_);
+        auto cached = serializersByType_.find(type);
+        if (cached != serializersByType_.end()) {
+            return cached->second;
+        }
+    }
+    PayloadSerializer* result = nullptr;
+    for (auto serializer : serializers_) {
+        if (serializer->canSerialize(payload)) {
+            result = serializer;
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(serializersByTypeMutex_);
+    serializersByType_[type] = result;
+    return result;
 }
 
 }
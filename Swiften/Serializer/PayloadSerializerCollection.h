@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,9 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 
 #include <Swiften/Base/API.h>
@@ -15,6 +18,13 @@
 namespace Swift {
     class PayloadSerializer;
 
+    /**
+     * A collection of payload serializers.
+     *
+     * The first added serializer that can serialize a payload is used. Serializers
+     * are looked up by the dynamic type of the payload, and the result is cached per
+     * type, so PayloadSerializer::canSerialize() must only depend on that type.
+     */
     class SWIFTEN_API PayloadSerializerCollection {
         public:
             PayloadSerializerCollection();
@@ -26,5 +36,7 @@ namespace Swift {
 
         private:
             std::vector<PayloadSerializer*> serializers_;
+            mutable std::mutex serializersByTypeMutex_;
+            mutable std::unordered_map<std::type_index, PayloadSerializer*> serializersByType_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -17,8 +17,15 @@ namespace Swift {
             BodySerializer() : GenericPayloadSerializer<Body>() {}
 
             virtual std::string serializePayload(std::shared_ptr<Body> body)  const {
-                XMLTextNode textNode(body->getText());
-                return "<body>" + textNode.serialize() + "</body>";
+                std::string result;
+                serializePayloadInto(body, result);
+                return result;
+            }
+
+            virtual void serializePayloadInto(std::shared_ptr<Body> body, std::string& output) const {
+                output += "<body>";
+                XMLTextNode::appendEscaped(output, body->getText());
+                output += "</body>";
             }
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,11 +16,17 @@ CapsInfoSerializer::CapsInfoSerializer() : GenericPayloadSerializer<CapsInfo>()
 }
 
 std::string CapsInfoSerializer::serializePayload(std::shared_ptr<CapsInfo> capsInfo)  const {
+    std::string result;
+    serializePayloadInto(capsInfo, result);
+    return result;
+}
+
+void CapsInfoSerializer::serializePayloadInto(std::shared_ptr<CapsInfo> capsInfo, std::string& output) const {
     XMLElement capsElement("c", "http://jabber.org/protocol/caps");
     capsElement.setAttribute("node", capsInfo->getNode());
     capsElement.setAttribute("hash", capsInfo->getHash());
     capsElement.setAttribute("ver", capsInfo->getVersion());
-    return capsElement.serialize();
+    capsElement.serializeInto(output);
 }
 
 }
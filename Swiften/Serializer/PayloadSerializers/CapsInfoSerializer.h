@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,5 +16,6 @@ namespace Swift {
             CapsInfoSerializer();
 
             virtual std::string serializePayload(std::shared_ptr<CapsInfo>)  const;
+            virtual void serializePayloadInto(std::shared_ptr<CapsInfo>, std::string& output) const;
     };
 }
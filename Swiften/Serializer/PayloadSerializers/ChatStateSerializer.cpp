@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -12,16 +12,21 @@ ChatStateSerializer::ChatStateSerializer() : GenericPayloadSerializer<ChatState>
 }
 
 std::string ChatStateSerializer::serializePayload(std::shared_ptr<ChatState> chatState)  const {
-    std::string result("<");
+    std::string result;
+    serializePayloadInto(chatState, result);
+    return result;
+}
+
+void ChatStateSerializer::serializePayloadInto(std::shared_ptr<ChatState> chatState, std::string& output) const {
+    output += '<';
     switch (chatState->getChatState()) {
-        case ChatState::Active: result += "active"; break;
-        case ChatState::Composing: result += "composing"; break;
-        case ChatState::Paused: result += "paused"; break;
-        case ChatState::Inactive: result += "inactive"; break;
-        case ChatState::Gone: result += "gone"; break;
+        case ChatState::Active: output += "active"; break;
+        case ChatState::Composing: output += "composing"; break;
+        case ChatState::Paused: output += "paused"; break;
+        case ChatState::Inactive: output += "inactive"; break;
+        case ChatState::Gone: output += "gone"; break;
     }
-    result += " xmlns=\"http://jabber.org/protocol/chatstates\"/>";
-    return result;
+    output += " xmlns=\"http://jabber.org/protocol/chatstates\"/>";
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -15,6 +15,7 @@ namespace Swift {
         public:
             ChatStateSerializer();
 
-            virtual std::string serializePayload(std::shared_ptr<ChatState> error)  const;
+            virtual std::string serializePayload(std::shared_ptr<ChatState>)  const;
+            virtual void serializePayloadInto(std::shared_ptr<ChatState>, std::string& output) const;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -20,12 +20,18 @@ DelaySerializer::DelaySerializer() : GenericPayloadSerializer<Delay>() {
 }
 
 std::string DelaySerializer::serializePayload(std::shared_ptr<Delay> delay)  const {
+    std::string result;
+    serializePayloadInto(delay, result);
+    return result;
+}
+
+void DelaySerializer::serializePayloadInto(std::shared_ptr<Delay> delay, std::string& output) const {
     XMLElement delayElement("delay", "urn:xmpp:delay");
     if (delay->getFrom() && delay->getFrom()->isValid()) {
         delayElement.setAttribute("from", delay->getFrom()->toString());
     }
     delayElement.setAttribute("stamp", dateTimeToString(delay->getStamp()));
-    return delayElement.serialize();
+    delayElement.serializeInto(output);
 }
 
 }
@@ -1,12 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <boost/lexical_cast.hpp>
+#include <string>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Elements/Priority.h>
@@ -18,7 +18,15 @@ namespace Swift {
             PrioritySerializer() : GenericPayloadSerializer<Priority>() {}
 
             virtual std::string serializePayload(std::shared_ptr<Priority> priority)  const {
-                return "<priority>" + boost::lexical_cast<std::string>(priority->getPriority()) + "</priority>";
+                std::string result;
+                serializePayloadInto(priority, result);
+                return result;
+            }
+
+            virtual void serializePayloadInto(std::shared_ptr<Priority> priority, std::string& output) const {
+                output += "<priority>";
+                output += std::to_string(priority->getPriority());
+                output += "</priority>";
             }
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,7 +11,6 @@
 #include <Swiften/Base/API.h>
 #include <Swiften/Elements/Status.h>
 #include <Swiften/Serializer/GenericPayloadSerializer.h>
-#include <Swiften/Serializer/XML/XMLElement.h>
 #include <Swiften/Serializer/XML/XMLTextNode.h>
 
 namespace Swift {
@@ -20,9 +19,15 @@ namespace Swift {
             StatusSerializer() : GenericPayloadSerializer<Status>() {}
 
             virtual std::string serializePayload(std::shared_ptr<Status> status)  const {
-                XMLElement element("status");
-                element.addNode(std::make_shared<XMLTextNode>(status->getText()));
-                return element.serialize();
+                std::string result;
+                serializePayloadInto(status, result);
+                return result;
+            }
+
+            virtual void serializePayloadInto(std::shared_ptr<Status> status, std::string& output) const {
+                output += "<status>";
+                XMLTextNode::appendEscaped(output, status->getText());
+                output += "</status>";
             }
     };
 }
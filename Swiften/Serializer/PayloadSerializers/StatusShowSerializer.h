@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,22 +16,25 @@ namespace Swift {
             StatusShowSerializer() : GenericPayloadSerializer<StatusShow>() {}
 
             virtual std::string serializePayload(std::shared_ptr<StatusShow> statusShow)  const {
+                std::string result;
+                serializePayloadInto(statusShow, result);
+                return result;
+            }
+
+            virtual void serializePayloadInto(std::shared_ptr<StatusShow> statusShow, std::string& output) const {
                 if (statusShow->getType () == StatusShow::Online || statusShow->getType() == StatusShow::None) {
-                    return "";
+                    return;
                 }
-                else {
-                    std::string result("<show>");
-                    switch (statusShow->getType()) {
-                        case StatusShow::Away: result += "away"; break;
-                        case StatusShow::XA: result += "xa"; break;
-                        case StatusShow::FFC: result += "chat"; break;
-                        case StatusShow::DND: result += "dnd"; break;
-                        case StatusShow::Online: assert(false); break;
-                        case StatusShow::None: assert(false); break;
-                    }
-                    result += "</show>";
-                    return result;
+                output += "<show>";
+                switch (statusShow->getType()) {
+                    case StatusShow::Away: output += "away"; break;
+                    case StatusShow::XA: output += "xa"; break;
+                    case StatusShow::FFC: output += "chat"; break;
+                    case StatusShow::DND: output += "dnd"; break;
+                    case StatusShow::Online: assert(false); break;
+                    case StatusShow::None: assert(false); break;
                 }
+                output += "</show>";
             }
     };
 }
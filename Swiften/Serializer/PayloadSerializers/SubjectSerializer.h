@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -17,8 +17,15 @@ namespace Swift {
             SubjectSerializer() : GenericPayloadSerializer<Subject>() {}
 
             virtual std::string serializePayload(std::shared_ptr<Subject> subject)  const {
-                XMLTextNode textNode(subject->getText());
-                return "<subject>" + textNode.serialize() + "</subject>";
+                std::string result;
+                serializePayloadInto(subject, result);
+                return result;
+            }
+
+            virtual void serializePayloadInto(std::shared_ptr<Subject> subject, std::string& output) const {
+                output += "<subject>";
+                XMLTextNode::appendEscaped(output, subject->getText());
+                output += "</subject>";
             }
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,7 +8,6 @@
 
 #include <memory>
 
-#include <Swiften/Serializer/XML/XMLElement.h>
 #include <Swiften/Serializer/XML/XMLTextNode.h>
 
 namespace Swift {
@@ -16,12 +15,16 @@ namespace Swift {
 VCardUpdateSerializer::VCardUpdateSerializer() : GenericPayloadSerializer<VCardUpdate>() {
 }
 
-std::string VCardUpdateSerializer::serializePayload(std::shared_ptr<VCardUpdate> vcardUpdate)    const {
-    XMLElement updateElement("x", "vcard-temp:x:update");
-    std::shared_ptr<XMLElement> photoElement(new XMLElement("photo"));
-    photoElement->addNode(std::make_shared<XMLTextNode>(vcardUpdate->getPhotoHash()));
-    updateElement.addNode(photoElement);
-    return updateElement.serialize();
+std::string VCardUpdateSerializer::serializePayload(std::shared_ptr<VCardUpdate> vcardUpdate)  const {
+    std::string result;
+    serializePayloadInto(vcardUpdate, result);
+    return result;
+}
+
+void VCardUpdateSerializer::serializePayloadInto(std::shared_ptr<VCardUpdate> vcardUpdate, std::string& output) const {
+    output += "<x xmlns=\"vcard-temp:x:update\"><photo>";
+    XMLTextNode::appendEscaped(output, vcardUpdate->getPhotoHash());
+    output += "</photo></x>";
 }
 
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,5 +16,6 @@ namespace Swift {
             VCardUpdateSerializer();
 
             virtual std::string serializePayload(std::shared_ptr<VCardUpdate>)  const;
+            virtual void serializePayloadInto(std::shared_ptr<VCardUpdate>, std::string& output) const;
     };
 }
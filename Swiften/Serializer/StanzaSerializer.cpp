@@ -1,12 +1,12 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/Serializer/StanzaSerializer.h>
 
-#include <sstream>
+#include <cassert>
 #include <typeinfo>
 
 #include <Swiften/Base/String.h>
@@ -15,10 +15,11 @@
 #include <Swiften/Serializer/PayloadSerializer.h>
 #include <Swiften/Serializer/PayloadSerializerCollection.h>
 #include <Swiften/Serializer/XML/XMLElement.h>
-#include <Swiften/Serializer/XML/XMLRawTextNode.h>
 
 namespace Swift {
 
+static const size_t initialBufferSize = 1024;
+
 StanzaSerializer::StanzaSerializer(const std::string& tag, PayloadSerializerCollection* payloadSerializers, const boost::optional<std::string>& explicitNS) : tag_(tag), payloadSerializers_(payloadSerializers), explicitDefaultNS_(explicitNS) {
 }
 
@@ -46,22 +47,38 @@ SafeByteArray StanzaSerializer::serialize(std::shared_ptr<ToplevelElement> eleme
     }
     setStanzaSpecificAttributes(stanza, stanzaElement);
 
-    std::string serializedPayloads;
-    for (const auto& payload : stanza->getPayloads()) {
-        PayloadSerializer* serializer = payloadSerializers_->getPayloadSerializer(payload);
-        if (serializer) {
-            serializedPayloads += serializer->serialize(payload);
+    std::string output;
+    output.reserve(initialBufferSize);
+    stanzaElement.serializeInto(output);
+
+    // The payload serializers append directly to the stanza buffer, after reopening the (empty) stanza element.
+    if (!stanza->getPayloads().empty()) {
+        assert(output.size() >= 2 && output.compare(output.size() - 2, 2, "/>") == 0);
+        output.resize(output.size() - 2);
+        output += '>';
+        size_t payloadsStart = output.size();
+        for (const auto& payload : stanza->getPayloads()) {
+            PayloadSerializer* serializer = payloadSerializers_->getPayloadSerializer(payload);
+            if (serializer) {
+                serializer->serializeInto(payload, output);
+            }
+            else {
+                SWIFT_LOG(warning) << "Could not find serializer for " << typeid(*(payload.get())).name() << std::endl;
+            }
+        }
+        String::sanitizeXMPPStringInPlace(output, payloadsStart);
+        if (output.size() == payloadsStart) {
+            output.resize(output.size() - 1);
+            output += "/>";
         }
         else {
-            SWIFT_LOG(warning) << "Could not find serializer for " << typeid(*(payload.get())).name() << std::endl;
+            output += "</";
+            output += tag_;
+            output += '>';
         }
     }
-    serializedPayloads = String::sanitizeXMPPString(serializedPayloads);
-    if (!serializedPayloads.empty()) {
-        stanzaElement.addNode(std::make_shared<XMLRawTextNode>(serializedPayloads));
-    }
 
-    return createSafeByteArray(stanzaElement.serialize());
+    return createSafeByteArray(output);
 }
 
 }
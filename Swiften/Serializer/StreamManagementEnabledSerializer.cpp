@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,5 +25,8 @@ SafeByteArray StreamManagementEnabledSerializer::serialize(std::shared_ptr<Tople
     if (e->getResumeSupported()) {
         element.setAttribute("resume", "true");
     }
+    if (!e->getLocation().empty()) {
+        element.setAttribute("location", e->getLocation());
+    }
     return createSafeByteArray(element.serialize());
 }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Elements/Body.h>
+#include <Swiften/Elements/Priority.h>
+#include <Swiften/Elements/Subject.h>
+#include <Swiften/Serializer/GenericPayloadSerializer.h>
+#include <Swiften/Serializer/PayloadSerializerCollection.h>
+
+using namespace Swift;
+
+class PayloadSerializerCollectionTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(PayloadSerializerCollectionTest);
+        CPPUNIT_TEST(testGetPayloadSerializer);
+        CPPUNIT_TEST(testGetPayloadSerializer_NoMatchingSerializer);
+        CPPUNIT_TEST(testGetPayloadSerializer_TwoMatchingSerializers);
+        CPPUNIT_TEST(testGetPayloadSerializer_CachedLookup);
+        CPPUNIT_TEST(testGetPayloadSerializer_AfterAddSerializer);
+        CPPUNIT_TEST(testGetPayloadSerializer_AfterRemoveSerializer);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testGetPayloadSerializer() {
+            PayloadSerializerCollection testling;
+            DummySerializer<Body> serializer1;
+            testling.addSerializer(&serializer1);
+            DummySerializer<Subject> serializer2;
+            testling.addSerializer(&serializer2);
+
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Body>()) == &serializer1);
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Subject>()) == &serializer2);
+        }
+
+        void testGetPayloadSerializer_NoMatchingSerializer() {
+            PayloadSerializerCollection testling;
+            DummySerializer<Body> serializer;
+            testling.addSerializer(&serializer);
+
+            CPPUNIT_ASSERT(!testling.getPayloadSerializer(std::make_shared<Priority>()));
+            CPPUNIT_ASSERT(!testling.getPayloadSerializer(std::shared_ptr<Payload>()));
+        }
+
+        void testGetPayloadSerializer_TwoMatchingSerializers() {
+            PayloadSerializerCollection testling;
+            DummySerializer<Body> serializer1;
+            testling.addSerializer(&serializer1);
+            DummySerializer<Body> serializer2;
+            testling.addSerializer(&serializer2);
+
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Body>()) == &serializer1);
+        }
+
+        void testGetPayloadSerializer_CachedLookup() {
+            PayloadSerializerCollection testling;
+            DummySerializer<Subject> serializer1;
+            testling.addSerializer(&serializer1);
+            DummySerializer<Body> serializer2;
+            testling.addSerializer(&serializer2);
+
+            testling.getPayloadSerializer(std::make_shared<Body>());
+            int canSerializeCalls = serializer1.canSerializeCalls + serializer2.canSerializeCalls;
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Body>()) == &serializer2);
+
+            CPPUNIT_ASSERT_EQUAL(canSerializeCalls, serializer1.canSerializeCalls + serializer2.canSerializeCalls);
+        }
+
+        void testGetPayloadSerializer_AfterAddSerializer() {
+            PayloadSerializerCollection testling;
+            CPPUNIT_ASSERT(!testling.getPayloadSerializer(std::make_shared<Body>()));
+
+            DummySerializer<Body> serializer;
+            testling.addSerializer(&serializer);
+
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Body>()) == &serializer);
+        }
+
+        void testGetPayloadSerializer_AfterRemoveSerializer() {
+            PayloadSerializerCollection testling;
+            DummySerializer<Body> serializer1;
+            testling.addSerializer(&serializer1);
+            DummySerializer<Body> serializer2;
+            testling.addSerializer(&serializer2);
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Body>()) == &serializer1);
+
+            testling.removeSerializer(&serializer1);
+
+            CPPUNIT_ASSERT(testling.getPayloadSerializer(std::make_shared<Body>()) == &serializer2);
+        }
+
+    private:
+        template<typename PAYLOAD_TYPE>
+        class DummySerializer : public GenericPayloadSerializer<PAYLOAD_TYPE> {
+            public:
+                DummySerializer() : canSerializeCalls(0) {}
+
+                virtual bool canSerialize(std::shared_ptr<Payload> payload) const {
+                    canSerializeCalls++;
+                    return GenericPayloadSerializer<PAYLOAD_TYPE>::canSerialize(payload);
+                }
+
+                virtual std::string serializePayload(std::shared_ptr<PAYLOAD_TYPE>) const {
+                    return "";
+                }
+
+                mutable int canSerializeCalls;
+        };
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PayloadSerializerCollectionTest);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -8,8 +8,12 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 
 #include <Swiften/Elements/AuthChallenge.h>
+#include <Swiften/Elements/Body.h>
+#include <Swiften/Elements/Message.h>
+#include <Swiften/Elements/Priority.h>
 #include <Swiften/Elements/ProtocolHeader.h>
 #include <Swiften/Serializer/PayloadSerializerCollection.h>
+#include <Swiften/Serializer/PayloadSerializers/BodySerializer.h>
 #include <Swiften/Serializer/XMPPSerializer.h>
 
 using namespace Swift;
@@ -19,11 +23,15 @@ class XMPPSerializerTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testSerializeHeader_Client);
         CPPUNIT_TEST(testSerializeHeader_Component);
         CPPUNIT_TEST(testSerializeHeader_Server);
+        CPPUNIT_TEST(testSerializeElement_StanzaWithoutPayloads);
+        CPPUNIT_TEST(testSerializeElement_StanzaWithPayloads);
+        CPPUNIT_TEST(testSerializeElement_StanzaWithOnlyUnserializablePayloads);
         CPPUNIT_TEST_SUITE_END();
 
     public:
         void setUp() {
             payloadSerializerCollection = new PayloadSerializerCollection();
+            payloadSerializerCollection->addSerializer(&bodySerializer);
         }
 
         void tearDown() {
@@ -63,6 +71,35 @@ class XMPPSerializerTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string("<?xml version=\"1.0\"?><stream:stream xmlns=\"jabber:server\" xmlns:stream=\"http://etherx.jabber.org/streams\" from=\"bla@foo.com\" to=\"foo.com\" id=\"myid\" version=\"0.99\">"), testling->serializeHeader(protocolHeader));
         }
 
+        void testSerializeElement_StanzaWithoutPayloads() {
+            std::shared_ptr<XMPPSerializer> testling(createSerializer(ClientStreamType));
+            auto message = std::make_shared<Message>();
+            message->setTo(JID("foo@bar.com"));
+            message->setID("id'1");
+
+            CPPUNIT_ASSERT_EQUAL(std::string("<message id=\"id&apos;1\" to=\"foo@bar.com\" type=\"chat\"/>"), safeByteArrayToString(testling->serializeElement(message)));
+        }
+
+        void testSerializeElement_StanzaWithPayloads() {
+            std::shared_ptr<XMPPSerializer> testling(createSerializer(ClientStreamType));
+            auto message = std::make_shared<Message>();
+            message->setTo(JID("foo@bar.com"));
+            message->setType(Message::Chat);
+            message->addPayload(std::make_shared<Body>("Hello <b>\x01world</b>"));
+            message->addPayload(std::make_shared<Body>("Bye"));
+
+            CPPUNIT_ASSERT_EQUAL(std::string("<message to=\"foo@bar.com\" type=\"chat\"><body>Hello &lt;b&gt;world&lt;/b&gt;</body><body>Bye</body></message>"), safeByteArrayToString(testling->serializeElement(message)));
+        }
+
+        void testSerializeElement_StanzaWithOnlyUnserializablePayloads() {
+            std::shared_ptr<XMPPSerializer> testling(createSerializer(ClientStreamType));
+            auto message = std::make_shared<Message>();
+            message->setTo(JID("foo@bar.com"));
+            message->addPayload(std::make_shared<Priority>(3));
+
+            CPPUNIT_ASSERT_EQUAL(std::string("<message to=\"foo@bar.com\" type=\"chat\"/>"), safeByteArrayToString(testling->serializeElement(message)));
+        }
+
     private:
         XMPPSerializer* createSerializer(StreamType type) {
             return new XMPPSerializer(payloadSerializerCollection, type, false);
@@ -70,6 +107,7 @@ class XMPPSerializerTest : public CppUnit::TestFixture {
 
     private:
         PayloadSerializerCollection* payloadSerializerCollection;
+        BodySerializer bodySerializer;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(XMPPSerializerTest);
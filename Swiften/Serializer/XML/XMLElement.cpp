@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -21,32 +21,39 @@ XMLElement::XMLElement(const std::string& tag, const std::string& xmlns, const s
 
 std::string XMLElement::serialize() {
     std::string result;
-    result += "<" + tag_;
+    serializeInto(result);
+    return result;
+}
+
+void XMLElement::serializeInto(std::string& output) {
+    output += '<';
+    output += tag_;
     for (const auto& p : attributes_) {
-        result += " " + p.first + "=\"" + p.second + "\"";
+        output += ' ';
+        output += p.first;
+        output += "=\"";
+        output += p.second;
+        output += '"';
     }
 
     if (!childNodes_.empty()) {
-        result += ">";
+        output += '>';
         for (auto& node : childNodes_) {
-            result += node->serialize();
+            node->serializeInto(output);
         }
-        result += "</" + tag_ + ">";
+        output += "</";
+        output += tag_;
+        output += '>';
     }
     else {
-        result += "/>";
+        output += "/>";
     }
-    return result;
 }
 
 void XMLElement::setAttribute(const std::string& attribute, const std::string& value) {
-    std::string escapedValue(value);
-    String::replaceAll(escapedValue, '&', "&amp;");
-    String::replaceAll(escapedValue, '<', "&lt;");
-    String::replaceAll(escapedValue, '>', "&gt;");
-    String::replaceAll(escapedValue, '\'', "&apos;");
-    String::replaceAll(escapedValue, '"', "&quot;");
-    attributes_[attribute] = escapedValue;
+    std::string& escapedValue = attributes_[attribute];
+    escapedValue.clear();
+    XMLTextNode::appendEscaped(escapedValue, value, true);
 }
 
 void XMLElement::addNode(std::shared_ptr<XMLNode> node) {
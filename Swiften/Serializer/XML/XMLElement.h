@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -25,6 +25,7 @@ namespace Swift {
             void addNode(std::shared_ptr<XMLNode> node);
 
             virtual std::string serialize();
+            virtual void serializeInto(std::string& output);
 
         private:
             std::string tag_;
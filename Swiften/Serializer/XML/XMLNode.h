@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,5 +16,10 @@ namespace Swift {
             virtual ~XMLNode();
 
             virtual std::string serialize() = 0;
+
+            /**
+             * Appends the serialized node to \p output.
+             */
+            virtual void serializeInto(std::string& output);
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2015 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Override.h>
 #include <Swiften/Serializer/XML/XMLNode.h>
 
 namespace Swift {
@@ -15,10 +16,14 @@ namespace Swift {
             XMLRawTextNode(const std::string& text) : text_(text) {
             }
 
-            std::string serialize() {
+            virtual std::string serialize() SWIFTEN_OVERRIDE {
                 return text_;
             }
 
+            virtual void serializeInto(std::string& output) SWIFTEN_OVERRIDE {
+                output += text_;
+            }
+
         private:
             std::string text_;
     };
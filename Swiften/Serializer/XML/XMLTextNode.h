@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include <Swiften/Base/API.h>
+#include <Swiften/Base/Override.h>
 #include <Swiften/Base/String.h>
 #include <Swiften/Serializer/XML/XMLNode.h>
 
@@ -17,16 +18,38 @@ namespace Swift {
         public:
             typedef std::shared_ptr<XMLTextNode> ref;
 
-            XMLTextNode(const std::string& text) : text_(text) {
-                String::replaceAll(text_, '&', "&amp;"); // Should come first
-                String::replaceAll(text_, '<', "&lt;");
-                String::replaceAll(text_, '>', "&gt;");
+            XMLTextNode(const std::string& text) {
+                text_.reserve(text.size());
+                appendEscaped(text_, text);
             }
 
-            std::string serialize() {
+            virtual std::string serialize() SWIFTEN_OVERRIDE {
                 return text_;
             }
 
+            virtual void serializeInto(std::string& output) SWIFTEN_OVERRIDE {
+                output += text_;
+            }
+
+            /**
+             * Appends \p text to \p output, escaping the characters that are special in XML character data.
+             * If \p escapeQuotes is true, quotes are escaped as well, so that the text can be used as an
+             * attribute value.
+             * Does not reserve space in \p output, so that repeated appends keep its geometric growth.
+             */
+            static void appendEscaped(std::string& output, const std::string& text, bool escapeQuotes = false) {
+                for (char c : text) {
+                    switch (c) {
+                        case '&': output += "&amp;"; break;
+                        case '<': output += "&lt;"; break;
+                        case '>': output += "&gt;"; break;
+                        case '\'': output += escapeQuotes ? "&apos;" : "'"; break;
+                        case '"': output += escapeQuotes ? "&quot;" : "\""; break;
+                        default: output += c; break;
+                    }
+                }
+            }
+
             static ref create(const std::string& text) {
                 return ref(new XMLTextNode(text));
             }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -10,6 +10,7 @@
 
 #include <boost/bind.hpp>
 
+#include <Swiften/Network/HostAddressPort.h>
 #include <Swiften/StreamStack/CompressionLayer.h>
 #include <Swiften/StreamStack/ConnectionLayer.h>
 #include <Swiften/StreamStack/StreamStack.h>
@@ -79,6 +80,7 @@ BasicSessionStream::~BasicSessionStream() {
 
 void BasicSessionStream::writeHeader(const ProtocolHeader& header) {
     assert(available);
+    serverName_ = header.getTo();
     xmppLayer->writeHeader(header);
 }
 
@@ -112,6 +114,8 @@ bool BasicSessionStream::supportsTLSEncryption() {
 void BasicSessionStream::addTLSEncryption() {
     assert(available);
     tlsLayer = new TLSLayer(tlsContextFactory, tlsOptions_);
+    HostAddressPort remoteAddress = connection->getRemoteAddress();
+    tlsLayer->getContext()->setServerIdentity(remoteAddress.getAddress().toString(), remoteAddress.getPort(), serverName_);
     if (hasTLSCertificate() && !tlsLayer->setClientCertificate(getTLSCertificate())) {
         onClosed(std::make_shared<SessionStreamError>(SessionStreamError::InvalidTLSCertificateError));
     }
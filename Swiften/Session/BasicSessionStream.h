@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Base/SafeByteArray.h>
@@ -90,6 +91,7 @@ namespace Swift {
             WhitespacePingLayer* whitespacePingLayer;
             StreamStack* streamStack;
             TLSOptions tlsOptions_;
+            std::string serverName_;
     };
 
 }
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace Swift {
+    /**
+     * Determines when \ref StanzaAckRequester asks the server to acknowledge
+     * the stanzas sent so far, and how many unacknowledged stanzas it keeps.
+     *
+     * An ack request covers all stanzas sent before it, so requesting less
+     * often saves packets for clients sending many stanzas, at the cost of
+     * later acknowledgements. A request is sent as soon as one of the enabled
+     * conditions holds.
+     */
+    struct StanzaAckRequestPolicy {
+        /**
+         * Request an ack after this many messages were sent without one.
+         * Other stanzas are acknowledged along with messages (IQs have their
+         * own responses). 0 disables this condition.
+         * Default: 1 (an ack request after every message)
+         */
+        unsigned int messagesPerRequest = 1;
+
+        /**
+         * Request an ack once this many bytes of stanzas were sent without one.
+         * 0 disables this condition.
+         * Default: 0
+         */
+        size_t bytesPerRequest = 0;
+
+        /**
+         * Request an ack when stanzas were sent without one for this long.
+         * Requires a timer factory. 0 disables this condition.
+         * Default: 0
+         */
+        int requestIntervalMilliseconds = 0;
+
+        /**
+         * The maximum number of unacknowledged stanzas to keep. When it is reached,
+         * an ack is requested and backpressure is signalled, until half of the
+         * stanzas are acknowledged. If the stream cannot be resumed, stanzas sent
+         * beyond the limit push the oldest ones out, which are then reported as
+         * dropped instead of acked. Resumable streams keep all of them, so they can
+         * be resent. 0 means unbounded.
+         * Default: 0
+         */
+        size_t maxUnackedStanzas = 0;
+    };
+}
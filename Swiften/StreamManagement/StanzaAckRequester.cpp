@@ -1,44 +1,154 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #include <Swiften/StreamManagement/StanzaAckRequester.h>
 
-#include <boost/numeric/conversion/cast.hpp>
+#include <algorithm>
+
+#include <boost/bind.hpp>
 
 #include <Swiften/Base/Log.h>
 #include <Swiften/Elements/Message.h>
+#include <Swiften/Network/Timer.h>
+#include <Swiften/Network/TimerFactory.h>
 
 namespace Swift {
 
-static const unsigned int MAX_HANDLED_STANZA_COUNT = boost::numeric_cast<unsigned int>((1ULL<<32) - 1);
-
-StanzaAckRequester::StanzaAckRequester() : lastHandledStanzasCount(0) {
+StanzaAckRequester::StanzaAckRequester(const StanzaAckRequestPolicy& policy, TimerFactory* timerFactory) : policy(policy), timerFactory(timerFactory), lastHandledStanzasCount(0), droppedStanzasCount(0), unrequestedStanzas(0), unrequestedMessages(0), unrequestedBytes(0), backpressureActive(false), resumable(false) {
+}
 
+StanzaAckRequester::~StanzaAckRequester() {
+    stopRequestTimer();
 }
 
-void StanzaAckRequester::handleStanzaSent(std::shared_ptr<Stanza> stanza) {
-    unackedStanzas.push_back(stanza);
+void StanzaAckRequester::handleStanzaSent(std::shared_ptr<Stanza> stanza, size_t size) {
+    UnackedStanza unackedStanza = { stanza, size, std::chrono::steady_clock::now() };
+    unackedStanzas.push_back(unackedStanza);
+    statistics.unackedBytes += size;
+    std::shared_ptr<Stanza> droppedStanza;
+    if (!resumable && policy.maxUnackedStanzas > 0 && unackedStanzas.size() > policy.maxUnackedStanzas) {
+        SWIFT_LOG(warning) << "Too many unacked stanzas, no longer tracking the oldest one" << std::endl;
+        droppedStanza = unackedStanzas.front().stanza;
+        statistics.unackedBytes -= unackedStanzas.front().size;
+        unackedStanzas.pop_front();
+        droppedStanzasCount++;
+        statistics.droppedStanzas++;
+    }
+    statistics.unackedStanzas = unackedStanzas.size();
+    statistics.peakUnackedStanzas = std::max(statistics.peakUnackedStanzas, statistics.unackedStanzas);
+
+    unrequestedStanzas++;
+    unrequestedBytes += size;
     if (std::dynamic_pointer_cast<Message>(stanza)) {
-        onRequestAck();
+        unrequestedMessages++;
+    }
+
+    bool backpressureStarted = false;
+    if (policy.maxUnackedStanzas > 0 && !backpressureActive && unackedStanzas.size() >= policy.maxUnackedStanzas) {
+        backpressureActive = true;
+        backpressureStarted = true;
+    }
+
+    if (backpressureStarted
+            || (policy.messagesPerRequest > 0 && unrequestedMessages >= policy.messagesPerRequest)
+            || (policy.bytesPerRequest > 0 && unrequestedBytes >= policy.bytesPerRequest)) {
+        requestAck();
+    }
+    else if (policy.requestIntervalMilliseconds > 0 && timerFactory && !requestTimer) {
+        requestTimer = timerFactory->createTimer(policy.requestIntervalMilliseconds);
+        requestTimer->onTick.connect(boost::bind(&StanzaAckRequester::handleRequestTimerTick, this));
+        requestTimer->start();
+    }
+
+    if (droppedStanza) {
+        onStanzaDropped(droppedStanza);
+    }
+    if (backpressureStarted) {
+        onBackpressureChanged(true);
     }
 }
 
 void StanzaAckRequester::handleAckReceived(unsigned int handledStanzasCount) {
-    unsigned int i = lastHandledStanzasCount;
-    while (i != handledStanzasCount) {
-        if (unackedStanzas.empty()) {
-            SWIFT_LOG(warning) << "Server acked more stanzas than we sent" << std::endl;
-            break;
-        }
-        std::shared_ptr<Stanza> ackedStanza = unackedStanzas.front();
+    // Stanza counts wrap around at 2^32 (as per the XEP), like unsigned int does
+    unsigned int acked = handledStanzasCount - lastHandledStanzasCount;
+    lastHandledStanzasCount = handledStanzasCount;
+
+    // Stanzas that were dropped from the queue were sent first
+    unsigned int ackedDropped = std::min(acked, droppedStanzasCount);
+    droppedStanzasCount -= ackedDropped;
+    acked -= ackedDropped;
+    if (acked > unackedStanzas.size()) {
+        SWIFT_LOG(warning) << "Server acked more stanzas than we sent" << std::endl;
+        acked = static_cast<unsigned int>(unackedStanzas.size());
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < acked; ++i) {
+        UnackedStanza ackedStanza = unackedStanzas.front();
         unackedStanzas.pop_front();
-        onStanzaAcked(ackedStanza);
-        i = (i == MAX_HANDLED_STANZA_COUNT ? 0 : i + 1);
+        statistics.unackedBytes -= ackedStanza.size;
+        statistics.unackedStanzas = unackedStanzas.size();
+        statistics.ackedStanzas++;
+        statistics.lastAckLatency = std::chrono::duration_cast<std::chrono::milliseconds>(now - ackedStanza.sendTime);
+        statistics.maxAckLatency = std::max(statistics.maxAckLatency, statistics.lastAckLatency);
+        onStanzaAcked(ackedStanza.stanza);
+    }
+
+    if (backpressureActive && unackedStanzas.size() <= policy.maxUnackedStanzas / 2) {
+        backpressureActive = false;
+        onBackpressureChanged(false);
+    }
+}
+
+void StanzaAckRequester::requestAckIfNeeded() {
+    if (unrequestedStanzas > 0) {
+        requestAck();
+    }
+}
+
+std::deque<std::shared_ptr<Stanza> > StanzaAckRequester::takeUnackedStanzas() {
+    std::deque<std::shared_ptr<Stanza> > result;
+    for (const auto& unackedStanza : unackedStanzas) {
+        result.push_back(unackedStanza.stanza);
+    }
+    unackedStanzas.clear();
+    droppedStanzasCount = 0;
+    unrequestedStanzas = 0;
+    unrequestedMessages = 0;
+    unrequestedBytes = 0;
+    statistics.unackedStanzas = 0;
+    statistics.unackedBytes = 0;
+    stopRequestTimer();
+    if (backpressureActive) {
+        backpressureActive = false;
+        onBackpressureChanged(false);
+    }
+    return result;
+}
+
+void StanzaAckRequester::requestAck() {
+    unrequestedStanzas = 0;
+    unrequestedMessages = 0;
+    unrequestedBytes = 0;
+    stopRequestTimer();
+    statistics.ackRequests++;
+    onRequestAck();
+}
+
+void StanzaAckRequester::handleRequestTimerTick() {
+    stopRequestTimer();
+    requestAckIfNeeded();
+}
+
+void StanzaAckRequester::stopRequestTimer() {
+    if (requestTimer) {
+        requestTimer->stop();
+        requestTimer->onTick.disconnect(boost::bind(&StanzaAckRequester::handleRequestTimerTick, this));
+        requestTimer.reset();
     }
-    lastHandledStanzasCount = handledStanzasCount;
 }
 
 }
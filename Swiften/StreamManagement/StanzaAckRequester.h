@@ -1,11 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <deque>
 #include <memory>
 
@@ -13,23 +15,109 @@
 
 #include <Swiften/Base/API.h>
 #include <Swiften/Elements/Stanza.h>
+#include <Swiften/StreamManagement/StanzaAckRequestPolicy.h>
 
 namespace Swift {
+    class Timer;
+    class TimerFactory;
+
     class SWIFTEN_API StanzaAckRequester {
         public:
-            StanzaAckRequester();
+            struct Statistics {
+                size_t unackedStanzas = 0;
+                size_t unackedBytes = 0;
+                size_t peakUnackedStanzas = 0;
+                uint64_t ackedStanzas = 0;
+                uint64_t droppedStanzas = 0;
+                uint64_t ackRequests = 0;
+                std::chrono::milliseconds lastAckLatency = std::chrono::milliseconds(0);
+                std::chrono::milliseconds maxAckLatency = std::chrono::milliseconds(0);
+            };
+
+            /**
+             * \p timerFactory is only needed for a policy with a request interval.
+             */
+            StanzaAckRequester(const StanzaAckRequestPolicy& policy = StanzaAckRequestPolicy(), TimerFactory* timerFactory = nullptr);
+            ~StanzaAckRequester();
 
-            void handleStanzaSent(std::shared_ptr<Stanza> stanza);
+            /**
+             * \p size is the serialized size of the stanza, if known.
+             */
+            void handleStanzaSent(std::shared_ptr<Stanza> stanza, size_t size = 0);
             void handleAckReceived(unsigned int handledStanzasCount);
 
+            /**
+             * Sends an ack request if stanzas were sent since the last one.
+             */
+            void requestAckIfNeeded();
+
+            /**
+             * Removes and returns all stanzas that were not acked yet, so they
+             * can be sent again after resuming the stream.
+             */
+            std::deque<std::shared_ptr<Stanza> > takeUnackedStanzas();
+
+            /**
+             * Sets whether the stream can be resumed. The unacked stanzas of a resumable
+             * stream are resent after resuming, so they are all kept, and the policy's
+             * maximum only signals backpressure. Otherwise, stanzas beyond the maximum
+             * are dropped and reported through \ref onStanzaDropped.
+             * Default: false
+             */
+            void setResumable(bool resumable) {
+                this->resumable = resumable;
+            }
+
+            bool isBackpressureActive() const {
+                return backpressureActive;
+            }
+
+            const Statistics& getStatistics() const {
+                return statistics;
+            }
+
         public:
             boost::signals2::signal<void ()> onRequestAck;
             boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaAcked;
 
+            /**
+             * Emitted for stanzas that are no longer tracked because there were too
+             * many unacked stanzas. They will not be reported as acked, so their
+             * delivery is unknown.
+             */
+            boost::signals2::signal<void (std::shared_ptr<Stanza>)> onStanzaDropped;
+
+            /**
+             * Emitted with true when the number of unacked stanzas reaches the policy's
+             * maximum, and with false when half of them are acked. Senders should
+             * pause while backpressure is active.
+             */
+            boost::signals2::signal<void (bool)> onBackpressureChanged;
+
+        private:
+            struct UnackedStanza {
+                std::shared_ptr<Stanza> stanza;
+                size_t size;
+                std::chrono::steady_clock::time_point sendTime;
+            };
+
+            void requestAck();
+            void handleRequestTimerTick();
+            void stopRequestTimer();
+
         private:
             friend class StanzaAckRequesterTest;
+            StanzaAckRequestPolicy policy;
+            TimerFactory* timerFactory;
+            std::shared_ptr<Timer> requestTimer;
             unsigned int lastHandledStanzasCount;
-            std::deque<std::shared_ptr<Stanza> > unackedStanzas;
+            unsigned int droppedStanzasCount;
+            unsigned int unrequestedStanzas;
+            unsigned int unrequestedMessages;
+            size_t unrequestedBytes;
+            bool backpressureActive;
+            bool resumable;
+            std::deque<UnackedStanza> unackedStanzas;
+            Statistics statistics;
     };
-
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -13,6 +13,7 @@
 #include <Swiften/Elements/IQ.h>
 #include <Swiften/Elements/Message.h>
 #include <Swiften/Elements/Presence.h>
+#include <Swiften/Network/DummyTimerFactory.h>
 #include <Swiften/StreamManagement/StanzaAckRequester.h>
 
 using namespace Swift;
@@ -29,11 +30,22 @@ class StanzaAckRequesterTest : public CppUnit::TestFixture {
         CPPUNIT_TEST(testHandleAckReceived_AcksMultipleStanzas);
         CPPUNIT_TEST(testHandleAckReceived_MultipleAcks);
         CPPUNIT_TEST(testHandleAckReceived_WrapAround);
+        CPPUNIT_TEST(testTakeUnackedStanzas);
+        CPPUNIT_TEST(testHandleStanzaSent_MessagesPerRequest);
+        CPPUNIT_TEST(testHandleStanzaSent_BytesPerRequest);
+        CPPUNIT_TEST(testHandleStanzaSent_RequestInterval);
+        CPPUNIT_TEST(testHandleStanzaSent_RequestIntervalCancelledByRequest);
+        CPPUNIT_TEST(testHandleStanzaSent_MaxUnackedStanzas);
+        CPPUNIT_TEST(testHandleStanzaSent_MaxUnackedStanzasWhenResumable);
+        CPPUNIT_TEST(testHandleAckReceived_AfterDroppedStanzas);
+        CPPUNIT_TEST(testHandleAckReceived_ReleasesBackpressure);
+        CPPUNIT_TEST(testGetStatistics);
         CPPUNIT_TEST_SUITE_END();
 
     public:
         void setUp() {
             acksRequested = 0;
+            timerFactory = std::unique_ptr<DummyTimerFactory>(new DummyTimerFactory());
         }
 
         void testHandleStanzaSent_MessageRequestsAck() {
@@ -122,6 +134,170 @@ class StanzaAckRequesterTest : public CppUnit::TestFixture {
             CPPUNIT_ASSERT_EQUAL(std::string("m2"), ackedStanzas[1]->getID());
         }
 
+        void testTakeUnackedStanzas() {
+            std::shared_ptr<StanzaAckRequester> testling(createRequester());
+            testling->handleStanzaSent(createMessage("m1"));
+            testling->handleStanzaSent(createIQ("iq1"));
+            testling->handleStanzaSent(createMessage("m2"));
+            testling->handleAckReceived(1);
+
+            std::deque<std::shared_ptr<Stanza> > unackedStanzas = testling->takeUnackedStanzas();
+
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(unackedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("iq1"), unackedStanzas[0]->getID());
+            CPPUNIT_ASSERT_EQUAL(std::string("m2"), unackedStanzas[1]->getID());
+            testling->handleAckReceived(3);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(ackedStanzas.size()));
+        }
+
+        void testHandleStanzaSent_MessagesPerRequest() {
+            StanzaAckRequestPolicy policy;
+            policy.messagesPerRequest = 3;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createMessage("m1"));
+            testling->handleStanzaSent(createIQ("iq1"));
+            testling->handleStanzaSent(createMessage("m2"));
+            CPPUNIT_ASSERT_EQUAL(0, acksRequested);
+
+            testling->handleStanzaSent(createMessage("m3"));
+            CPPUNIT_ASSERT_EQUAL(1, acksRequested);
+        }
+
+        void testHandleStanzaSent_BytesPerRequest() {
+            StanzaAckRequestPolicy policy;
+            policy.messagesPerRequest = 0;
+            policy.bytesPerRequest = 100;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createPresence("p1"), 60);
+            CPPUNIT_ASSERT_EQUAL(0, acksRequested);
+
+            testling->handleStanzaSent(createIQ("iq1"), 40);
+            CPPUNIT_ASSERT_EQUAL(1, acksRequested);
+        }
+
+        void testHandleStanzaSent_RequestInterval() {
+            StanzaAckRequestPolicy policy;
+            policy.messagesPerRequest = 10;
+            policy.requestIntervalMilliseconds = 1000;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createMessage("m1"));
+            testling->handleStanzaSent(createPresence("p1"));
+
+            timerFactory->setTime(999);
+            CPPUNIT_ASSERT_EQUAL(0, acksRequested);
+            timerFactory->setTime(1000);
+            CPPUNIT_ASSERT_EQUAL(1, acksRequested);
+            timerFactory->setTime(3000);
+            CPPUNIT_ASSERT_EQUAL(1, acksRequested);
+        }
+
+        void testHandleStanzaSent_RequestIntervalCancelledByRequest() {
+            StanzaAckRequestPolicy policy;
+            policy.messagesPerRequest = 2;
+            policy.requestIntervalMilliseconds = 1000;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createMessage("m1"));
+            testling->handleStanzaSent(createMessage("m2"));
+
+            timerFactory->setTime(1000);
+            CPPUNIT_ASSERT_EQUAL(1, acksRequested);
+        }
+
+        void testHandleStanzaSent_MaxUnackedStanzas() {
+            StanzaAckRequestPolicy policy;
+            policy.messagesPerRequest = 0;
+            policy.maxUnackedStanzas = 2;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createPresence("p1"));
+            CPPUNIT_ASSERT_EQUAL(0, acksRequested);
+
+            testling->handleStanzaSent(createPresence("p2"));
+            CPPUNIT_ASSERT_EQUAL(1, acksRequested);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(backpressureChanges.size()));
+            CPPUNIT_ASSERT(backpressureChanges[0]);
+            CPPUNIT_ASSERT(testling->isBackpressureActive());
+
+            testling->handleStanzaSent(createPresence("p3"));
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(droppedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("p1"), droppedStanzas[0]->getID());
+            std::deque<std::shared_ptr<Stanza> > unackedStanzas = testling->takeUnackedStanzas();
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(unackedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("p2"), unackedStanzas[0]->getID());
+            CPPUNIT_ASSERT_EQUAL(std::string("p3"), unackedStanzas[1]->getID());
+        }
+
+        void testHandleStanzaSent_MaxUnackedStanzasWhenResumable() {
+            StanzaAckRequestPolicy policy;
+            policy.messagesPerRequest = 0;
+            policy.maxUnackedStanzas = 2;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->setResumable(true);
+            testling->handleStanzaSent(createPresence("p1"));
+            testling->handleStanzaSent(createPresence("p2"));
+            testling->handleStanzaSent(createPresence("p3"));
+            CPPUNIT_ASSERT(testling->isBackpressureActive());
+            CPPUNIT_ASSERT(droppedStanzas.empty());
+
+            testling->handleAckReceived(1);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(ackedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("p1"), ackedStanzas[0]->getID());
+            std::deque<std::shared_ptr<Stanza> > unackedStanzas = testling->takeUnackedStanzas();
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(unackedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("p2"), unackedStanzas[0]->getID());
+            CPPUNIT_ASSERT_EQUAL(std::string("p3"), unackedStanzas[1]->getID());
+        }
+
+        void testHandleAckReceived_AfterDroppedStanzas() {
+            StanzaAckRequestPolicy policy;
+            policy.maxUnackedStanzas = 2;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createMessage("m1"));
+            testling->handleStanzaSent(createMessage("m2"));
+            testling->handleStanzaSent(createMessage("m3"));
+
+            testling->handleAckReceived(2);
+            CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(ackedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("m2"), ackedStanzas[0]->getID());
+
+            testling->handleAckReceived(3);
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(ackedStanzas.size()));
+            CPPUNIT_ASSERT_EQUAL(std::string("m3"), ackedStanzas[1]->getID());
+        }
+
+        void testHandleAckReceived_ReleasesBackpressure() {
+            StanzaAckRequestPolicy policy;
+            policy.maxUnackedStanzas = 4;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            for (int i = 0; i < 4; ++i) {
+                testling->handleStanzaSent(createMessage("m" + std::to_string(i)));
+            }
+
+            testling->handleAckReceived(1);
+            CPPUNIT_ASSERT(testling->isBackpressureActive());
+            testling->handleAckReceived(2);
+            CPPUNIT_ASSERT(!testling->isBackpressureActive());
+            CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(backpressureChanges.size()));
+            CPPUNIT_ASSERT(!backpressureChanges[1]);
+        }
+
+        void testGetStatistics() {
+            StanzaAckRequestPolicy policy;
+            policy.maxUnackedStanzas = 2;
+            std::shared_ptr<StanzaAckRequester> testling(createRequester(policy));
+            testling->handleStanzaSent(createMessage("m1"), 10);
+            testling->handleStanzaSent(createMessage("m2"), 20);
+            testling->handleStanzaSent(createMessage("m3"), 30);
+            testling->handleAckReceived(2);
+
+            StanzaAckRequester::Statistics statistics = testling->getStatistics();
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), statistics.unackedStanzas);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(30), statistics.unackedBytes);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), statistics.peakUnackedStanzas);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), statistics.ackedStanzas);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(1), statistics.droppedStanzas);
+            CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(3), statistics.ackRequests);
+        }
+
     private:
         Message::ref createMessage(const std::string& id) {
             Message::ref result(new Message());
@@ -141,10 +317,12 @@ class StanzaAckRequesterTest : public CppUnit::TestFixture {
             return result;
         }
 
-        StanzaAckRequester* createRequester() {
-            StanzaAckRequester* requester = new StanzaAckRequester();
+        StanzaAckRequester* createRequester(const StanzaAckRequestPolicy& policy = StanzaAckRequestPolicy()) {
+            StanzaAckRequester* requester = new StanzaAckRequester(policy, timerFactory.get());
             requester->onRequestAck.connect(boost::bind(&StanzaAckRequesterTest::handleRequestAck, this));
             requester->onStanzaAcked.connect(boost::bind(&StanzaAckRequesterTest::handleStanzaAcked, this, _1));
+            requester->onStanzaDropped.connect(boost::bind(&StanzaAckRequesterTest::handleStanzaDropped, this, _1));
+            requester->onBackpressureChanged.connect(boost::bind(&StanzaAckRequesterTest::handleBackpressureChanged, this, _1));
             return requester;
         }
 
@@ -156,9 +334,20 @@ class StanzaAckRequesterTest : public CppUnit::TestFixture {
             ackedStanzas.push_back(stanza);
         }
 
+        void handleStanzaDropped(std::shared_ptr<Stanza> stanza) {
+            droppedStanzas.push_back(stanza);
+        }
+
+        void handleBackpressureChanged(bool active) {
+            backpressureChanges.push_back(active);
+        }
+
     private:
         int acksRequested = 0;
         std::vector< std::shared_ptr<Stanza> > ackedStanzas;
+        std::vector< std::shared_ptr<Stanza> > droppedStanzas;
+        std::vector<bool> backpressureChanges;
+        std::unique_ptr<DummyTimerFactory> timerFactory;
 };
 
 }
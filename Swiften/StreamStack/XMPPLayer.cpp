@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -57,10 +57,7 @@ void XMPPLayer::writeDataInternal(const SafeByteArray& data) {
 void XMPPLayer::handleDataRead(const SafeByteArray& data) {
     onDataRead(data);
     inParser_ = true;
-    // FIXME: Converting to unsafe string. Should be ok, since we don't take passwords
-    // from the stream in clients. If servers start using this, and require safe storage,
-    // we need to fix this.
-    if (!xmppParser_->parse(byteArrayToString(ByteArray(data.begin(), data.end())))) {
+    if (!xmppParser_->parse(reinterpret_cast<const char*>(vecptr(data)), data.size())) {
         inParser_ = false;
         onError();
         return;
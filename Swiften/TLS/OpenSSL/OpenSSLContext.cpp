@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -23,6 +23,9 @@
 #include <Swiften/TLS/OpenSSL/OpenSSLCertificate.h>
 #include <Swiften/TLS/CertificateWithKey.h>
 #include <Swiften/TLS/PKCS12Certificate.h>
+#include <Swiften/TLS/TLSSessionCache.h>
+#include <Swiften/Base/Log.h>
+#include <Swiften/StringCodecs/Hexify.h>
 
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
@@ -36,13 +39,62 @@ static const int MAX_FINISHED_SIZE = 4096;
 static const int SSL_READ_BUFFERSIZE = 8192;
 
 static void freeX509Stack(STACK_OF(X509)* stack) {
-    sk_X509_free(stack);
+    sk_X509_pop_free(stack, X509_free);
 }
 
-OpenSSLContext::OpenSSLContext() : state_(Start), context_(0), handle_(0), readBIO_(0), writeBIO_(0) {
+// Cached sessions are stored as a sequence of length-prefixed DER items: the session,
+// followed by the peer certificate chain (which the serialized session does not keep).
+static void appendSessionItem(SafeByteArray& data, const ByteArray& item) {
+    size_t size = item.size();
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<unsigned char>((size >> shift) & 0xff));
+    }
+    data.insert(data.end(), item.begin(), item.end());
+}
+
+static bool readSessionItem(const SafeByteArray& data, size_t& position, ByteArray& item) {
+    if (data.size() - position < 4) {
+        return false;
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        size = (size << 8) | data[position++];
+    }
+    if (data.size() - position < size) {
+        return false;
+    }
+    item.assign(data.begin() + position, data.begin() + position + size);
+    position += size;
+    return true;
+}
+
+OpenSSLContext::OpenSSLContext(std::shared_ptr<SSL_CTX> context, TLSSessionCache* sessionCache) : state_(Start), context_(context), handle_(0), readBIO_(0), writeBIO_(0), sessionCache_(sessionCache), serverPort_(0), sessionResumed_(false) {
+    // Create the handle right away, so a client certificate can be set on it before connecting
+    if (context_) {
+        handle_ = SSL_new(context_.get());
+    }
+    if (handle_) {
+        SSL_set_ex_data(handle_, getContextIndex(), this);
+    }
+}
+
+OpenSSLContext::~OpenSSLContext() {
+    SSL_free(handle_);
+}
+
+std::shared_ptr<SSL_CTX> OpenSSLContext::createSSLContext() {
     ensureLibraryInitialized();
-    context_ = SSL_CTX_new(SSLv23_client_method());
-    SSL_CTX_set_options(context_, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+    SSL_CTX* contextPtr = SSL_CTX_new(SSLv23_client_method());
+    if (!contextPtr) {
+        return std::shared_ptr<SSL_CTX>();
+    }
+    std::shared_ptr<SSL_CTX> context(contextPtr, SSL_CTX_free);
+    SSL_CTX_set_options(context.get(), SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+
+    // Sessions are kept in the TLSSessionCache of each connection, keyed by server identity
+    // instead of by OpenSSL's session id.
+    SSL_CTX_set_session_cache_mode(context.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context.get(), &OpenSSLContext::handleNewSession);
 
     // TODO: implement CRL checking
     // TODO: download CRL (HTTP transport)
@@ -52,7 +104,7 @@ OpenSSLContext::OpenSSLContext() : state_(Start), context_(0), handle_(0), readB
     // TODO: handle OCSP stapling see https://www.rfc-editor.org/rfc/rfc4366.txt
     // Load system certs
 #if defined(SWIFTEN_PLATFORM_WINDOWS)
-    X509_STORE* store = SSL_CTX_get_cert_store(context_);
+    X509_STORE* store = SSL_CTX_get_cert_store(context.get());
     HCERTSTORE systemStore = CertOpenSystemStore(0, "ROOT");
     if (systemStore) {
         PCCERT_CONTEXT certContext = NULL;
@@ -68,7 +120,7 @@ OpenSSLContext::OpenSSLContext() : state_(Start), context_(0), handle_(0), readB
         }
     }
 #elif !defined(SWIFTEN_PLATFORM_MACOSX)
-    SSL_CTX_set_default_verify_paths(context_);
+    SSL_CTX_set_default_verify_paths(context.get());
 #elif defined(SWIFTEN_PLATFORM_MACOSX) && !defined(SWIFTEN_PLATFORM_IPHONE)
     // On Mac OS X 10.5 (OpenSSL < 0.9.8), OpenSSL does not automatically look in the system store.
     // On Mac OS X 10.6 (OpenSSL >= 0.9.8), OpenSSL *does* look in the system store to determine trust.
@@ -76,7 +128,7 @@ OpenSSLContext::OpenSSLContext() : state_(Start), context_(0), handle_(0), readB
     // the certificates first. See
     //        http://opensource.apple.com/source/OpenSSL098/OpenSSL098-27/src/crypto/x509/x509_vfy_apple.c
     // to understand why. We therefore add all certs from the system store ourselves.
-    X509_STORE* store = SSL_CTX_get_cert_store(context_);
+    X509_STORE* store = SSL_CTX_get_cert_store(context.get());
     CFArrayRef anchorCertificates;
     if (SecTrustCopyAnchorCertificates(&anchorCertificates) == 0) {
         for (int i = 0; i < CFArrayGetCount(anchorCertificates); ++i) {
@@ -96,11 +148,7 @@ OpenSSLContext::OpenSSLContext() : state_(Start), context_(0), handle_(0), readB
         CFRelease(anchorCertificates);
     }
 #endif
-}
-
-OpenSSLContext::~OpenSSLContext() {
-    SSL_free(handle_);
-    SSL_CTX_free(context_);
+    return context;
 }
 
 void OpenSSLContext::ensureLibraryInitialized() {
@@ -119,14 +167,104 @@ void OpenSSLContext::ensureLibraryInitialized() {
     }
 }
 
+int OpenSSLContext::getContextIndex() {
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+int OpenSSLContext::handleNewSession(SSL* ssl, SSL_SESSION* session) {
+    OpenSSLContext* context = static_cast<OpenSSLContext*>(SSL_get_ex_data(ssl, getContextIndex()));
+    if (context) {
+        context->storeSession(session);
+    }
+    // The session is not kept, so OpenSSL keeps ownership
+    return 0;
+}
+
+void OpenSSLContext::storeSession(SSL_SESSION* session) {
+    if (!sessionCache_ || sessionKey_.empty()) {
+        return;
+    }
+    int size = i2d_SSL_SESSION(session, nullptr);
+    if (size <= 0) {
+        return;
+    }
+    ByteArray sessionData(size);
+    unsigned char* p = vecptr(sessionData);
+    i2d_SSL_SESSION(session, &p);
+
+    SafeByteArray data;
+    appendSessionItem(data, sessionData);
+    for (const auto& certificate : getPeerCertificateChain()) {
+        appendSessionItem(data, certificate->toDER());
+    }
+    sessionCache_->storeSession(sessionKey_, data);
+}
+
+void OpenSSLContext::restoreSession() {
+    if (!sessionCache_ || sessionKey_.empty()) {
+        return;
+    }
+    boost::optional<SafeByteArray> data = sessionCache_->getSession(sessionKey_);
+    if (!data) {
+        return;
+    }
+    size_t position = 0;
+    ByteArray sessionData;
+    std::vector<Certificate::ref> peerCertificateChain;
+    bool valid = readSessionItem(*data, position, sessionData);
+    while (valid && position < data->size()) {
+        ByteArray certificateData;
+        valid = readSessionItem(*data, position, certificateData);
+        if (valid) {
+            std::shared_ptr<OpenSSLCertificate> certificate = std::make_shared<OpenSSLCertificate>(certificateData);
+            valid = certificate->getInternalX509() != nullptr;
+            peerCertificateChain.push_back(certificate);
+        }
+    }
+    // Without the chain, the server identity could not be checked after resuming
+    SSL_SESSION* session = nullptr;
+    if (valid && !peerCertificateChain.empty()) {
+        const unsigned char* p = vecptr(sessionData);
+        session = d2i_SSL_SESSION(nullptr, &p, sessionData.size());
+    }
+    if (!session) {
+        sessionCache_->removeSession(sessionKey_);
+        return;
+    }
+    SSL_set_session(handle_, session);
+    SSL_SESSION_free(session);
+    sessionPeerCertificateChain_ = peerCertificateChain;
+}
+
+void OpenSSLContext::setServerIdentity(const std::string& host, int port, const std::string& serverName) {
+    serverHost_ = host;
+    serverPort_ = port;
+    serverName_ = serverName;
+    updateSessionKey();
+}
+
+void OpenSSLContext::updateSessionKey() {
+    if (serverHost_.empty()) {
+        return;
+    }
+    sessionKey_ = TLSSessionCache::createKey(serverHost_, serverPort_, serverName_, clientCertificateIdentity_);
+}
+
 void OpenSSLContext::connect() {
-    handle_ = SSL_new(context_);
     if (handle_ == nullptr) {
         state_ = Error;
         onError(std::make_shared<TLSError>());
         return;
     }
 
+#ifdef SSL_set_tlsext_host_name
+    if (!serverName_.empty()) {
+        SSL_set_tlsext_host_name(handle_, const_cast<char*>(serverName_.c_str()));
+    }
+#endif
+    restoreSession();
+
     // Ownership of BIOs is ransferred
     readBIO_ = BIO_new(BIO_s_mem());
     writeBIO_ = BIO_new(BIO_s_mem());
@@ -142,6 +280,8 @@ void OpenSSLContext::doConnect() {
     switch (error) {
         case SSL_ERROR_NONE: {
             state_ = Connected;
+            sessionResumed_ = SSL_session_reused(handle_) != 0;
+            SWIFT_LOG(debug) << "TLS session " << (sessionResumed_ ? "resumed" : "negotiated") << std::endl;
             //std::cout << x->name << std::endl;
             //const char* comp = SSL_get_current_compression(handle_);
             //std::cout << "Compression: " << SSL_COMP_get_name(comp) << std::endl;
@@ -153,6 +293,10 @@ void OpenSSLContext::doConnect() {
             break;
         default:
             state_ = Error;
+            // Don't offer a session the server may have rejected again
+            if (sessionCache_ && !sessionKey_.empty()) {
+                sessionCache_->removeSession(sessionKey_);
+            }
             onError(std::make_shared<TLSError>());
     }
 }
@@ -209,7 +353,7 @@ void OpenSSLContext::sendPendingDataToApplication() {
 
 bool OpenSSLContext::setClientCertificate(CertificateWithKey::ref certificate) {
     std::shared_ptr<PKCS12Certificate> pkcs12Certificate = std::dynamic_pointer_cast<PKCS12Certificate>(certificate);
-    if (!pkcs12Certificate || pkcs12Certificate->isNull()) {
+    if (!handle_ || !pkcs12Certificate || pkcs12Certificate->isNull()) {
         return false;
     }
 
@@ -236,20 +380,39 @@ bool OpenSSLContext::setClientCertificate(CertificateWithKey::ref certificate) {
     std::shared_ptr<EVP_PKEY> privateKey(privateKeyPtr, EVP_PKEY_free);
     std::shared_ptr<STACK_OF(X509)> caCerts(caCertsPtr, freeX509Stack);
 
-    // Use the key & certificates
-    if (SSL_CTX_use_certificate(context_, cert.get()) != 1) {
+    // Use the key & certificates for this connection only, as the SSL_CTX may be shared
+    if (SSL_use_certificate(handle_, cert.get()) != 1) {
         return false;
     }
-    if (SSL_CTX_use_PrivateKey(context_, privateKey.get()) != 1) {
+    if (SSL_use_PrivateKey(handle_, privateKey.get()) != 1) {
         return false;
     }
+    // The chain gets its own references to the certificates, the stack frees ours
     for (int i = 0;  i < sk_X509_num(caCerts.get()); ++i) {
-        SSL_CTX_add_extra_chain_cert(context_, sk_X509_value(caCerts.get(), i));
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+        SSL_add1_chain_cert(handle_, sk_X509_value(caCerts.get(), i));
+#else
+        // Per-connection chains are not supported; OpenSSLContextFactory does not share contexts with these versions.
+        SSL_CTX_add_extra_chain_cert(context_.get(), X509_dup(sk_X509_value(caCerts.get(), i)));
+#endif
+    }
+
+    // Sessions are bound to the client certificate, so don't share them with connections using another one
+    unsigned char fingerprint[EVP_MAX_MD_SIZE];
+    unsigned int fingerprintSize = 0;
+    if (X509_digest(cert.get(), EVP_sha256(), fingerprint, &fingerprintSize) != 1) {
+        return false;
     }
+    clientCertificateIdentity_ = Hexify::hexify(createByteArray(fingerprint, fingerprintSize));
+    updateSessionKey();
     return true;
 }
 
 std::vector<Certificate::ref> OpenSSLContext::getPeerCertificateChain() const {
+    // Resumed sessions don't carry the chain, so return the one of the original handshake
+    if (handle_ && SSL_session_reused(handle_)) {
+        return sessionPeerCertificateChain_;
+    }
     std::vector<Certificate::ref> result;
     STACK_OF(X509)* chain = SSL_get_peer_cert_chain(handle_);
     for (int i = 0; i < sk_X509_num(chain); ++i) {
@@ -271,6 +434,10 @@ std::shared_ptr<CertificateVerificationError> OpenSSLContext::getPeerCertificate
     }
 }
 
+bool OpenSSLContext::isSessionResumed() const {
+    return sessionResumed_;
+}
+
 ByteArray OpenSSLContext::getFinishMessage() const {
     ByteArray data;
     data.resize(MAX_FINISHED_SIZE);
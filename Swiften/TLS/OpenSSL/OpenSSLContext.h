@@ -1,11 +1,15 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <boost/noncopyable.hpp>
 #include <boost/signals2.hpp>
 
@@ -16,12 +20,24 @@
 #include <Swiften/TLS/TLSContext.h>
 
 namespace Swift {
+    class TLSSessionCache;
 
     class OpenSSLContext : public TLSContext, boost::noncopyable {
         public:
-            OpenSSLContext();
+            /**
+             * Creates a connection using \p context, which may be shared with other connections.
+             * If \p sessionCache is set, sessions are stored in and resumed from it.
+             */
+            OpenSSLContext(std::shared_ptr<SSL_CTX> context, TLSSessionCache* sessionCache = nullptr);
             virtual ~OpenSSLContext();
 
+            /**
+             * Creates an SSL_CTX for client connections, with the system CA certificates
+             * loaded. This is expensive, so the result should be reused.
+             */
+            static std::shared_ptr<SSL_CTX> createSSLContext();
+
+            void setServerIdentity(const std::string& host, int port, const std::string& serverName);
             void connect();
             bool setClientCertificate(CertificateWithKey::ref cert);
 
@@ -32,11 +48,18 @@ namespace Swift {
             std::shared_ptr<CertificateVerificationError> getPeerCertificateVerificationError() const;
 
             virtual ByteArray getFinishMessage() const;
+            virtual bool isSessionResumed() const;
 
         private:
             static void ensureLibraryInitialized();
 
             static CertificateVerificationError::Type getVerificationErrorTypeForResult(int);
+            static int getContextIndex();
+            static int handleNewSession(SSL*, SSL_SESSION*);
+
+            void storeSession(SSL_SESSION* session);
+            void restoreSession();
+            void updateSessionKey();
 
             void doConnect();
             void sendPendingDataToNetwork();
@@ -46,9 +69,18 @@ namespace Swift {
             enum State { Start, Connecting, Connected, Error };
 
             State state_;
-            SSL_CTX* context_;
+            std::shared_ptr<SSL_CTX> context_;
             SSL* handle_;
             BIO* readBIO_;
             BIO* writeBIO_;
+            TLSSessionCache* sessionCache_;
+            std::string sessionKey_;
+            std::string serverHost_;
+            int serverPort_;
+            std::string serverName_;
+            std::string clientCertificateIdentity_;
+            bool sessionResumed_;
+            // The chain the server presented when the offered session was negotiated
+            std::vector<Certificate::ref> sessionPeerCertificateChain_;
     };
 }
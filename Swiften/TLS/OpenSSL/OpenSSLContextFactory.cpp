@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -16,7 +16,24 @@ bool OpenSSLContextFactory::canCreate() const {
 }
 
 TLSContext* OpenSSLContextFactory::createTLSContext(const TLSOptions&) {
-    return new OpenSSLContext();
+    return new OpenSSLContext(getSSLContext(), &sessionCache_);
+}
+
+std::shared_ptr<SSL_CTX> OpenSSLContextFactory::getSSLContext() {
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+    std::lock_guard<std::mutex> lock(contextMutex_);
+    if (!context_) {
+        context_ = OpenSSLContext::createSSLContext();
+    }
+    return context_;
+#else
+    // Client certificate chains can only be set on the SSL_CTX, so it cannot be shared.
+    return OpenSSLContext::createSSLContext();
+#endif
+}
+
+TLSSessionCache* OpenSSLContextFactory::getSessionCache() {
+    return &sessionCache_;
 }
 
 void OpenSSLContextFactory::setCheckCertificateRevocation(bool check) {
@@ -32,6 +49,4 @@ void OpenSSLContextFactory::setDisconnectOnCardRemoval(bool check) {
     }
 }
 
-
-
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,10 +7,26 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
+#include <mutex>
+
+#include <openssl/ssl.h>
 
 #include <Swiften/TLS/TLSContextFactory.h>
+#include <Swiften/TLS/TLSSessionCache.h>
 
 namespace Swift {
+    /**
+     * Creates OpenSSL based TLS contexts.
+     *
+     * All contexts created by a factory share a single SSL_CTX, so the system CA
+     * certificates are only loaded once. None of the \ref TLSOptions apply to
+     * OpenSSL, and client certificates are set per connection, so one SSL_CTX
+     * covers every configuration.
+     *
+     * Sessions of all contexts are kept in one \ref TLSSessionCache, so reconnecting
+     * to a server resumes the previous session.
+     */
     class OpenSSLContextFactory : public TLSContextFactory {
         public:
             bool canCreate() const;
@@ -19,5 +35,15 @@ namespace Swift {
             // Not supported
             virtual void setCheckCertificateRevocation(bool b);
             virtual void setDisconnectOnCardRemoval(bool b);
+
+            virtual TLSSessionCache* getSessionCache();
+
+        private:
+            std::shared_ptr<SSL_CTX> getSSLContext();
+
+        private:
+            std::mutex contextMutex_;
+            std::shared_ptr<SSL_CTX> context_;
+            TLSSessionCache sessionCache_;
     };
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -55,6 +55,10 @@ namespace Swift {
                 return password_;
             }
 
+            void setPassword(const SafeByteArray& password) {
+                password_ = password;
+            }
+
         private:
             ByteArray data_;
             SafeByteArray password_;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,13 @@ namespace Swift {
 TLSContext::~TLSContext() {
 }
 
+void TLSContext::setServerIdentity(const std::string&, int, const std::string&) {
+}
+
+bool TLSContext::isSessionResumed() const {
+    return false;
+}
+
 Certificate::ref TLSContext::getPeerCertificate() const {
     std::vector<Certificate::ref> chain = getPeerCertificateChain();
     return chain.empty() ? Certificate::ref() : chain[0];
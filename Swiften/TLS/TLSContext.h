@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include <boost/signals2.hpp>
 
@@ -23,6 +24,13 @@ namespace Swift {
         public:
             virtual ~TLSContext();
 
+            /**
+             * Identifies the server, for Server Name Indication and for resuming
+             * TLS sessions from the factory's \ref TLSSessionCache.
+             * Must be called before \ref connect(). An empty \p serverName disables SNI.
+             */
+            virtual void setServerIdentity(const std::string& host, int port, const std::string& serverName);
+
             virtual void connect() = 0;
 
             virtual bool setClientCertificate(CertificateWithKey::ref cert) = 0;
@@ -36,6 +44,12 @@ namespace Swift {
 
             virtual ByteArray getFinishMessage() const = 0;
 
+            /**
+             * Returns whether the handshake resumed a cached session, instead of
+             * doing a full handshake.
+             */
+            virtual bool isSessionResumed() const;
+
         public:
             boost::signals2::signal<void (const SafeByteArray&)> onDataForNetwork;
             boost::signals2::signal<void (const SafeByteArray&)> onDataForApplication;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,4 +11,8 @@ namespace Swift {
 TLSContextFactory::~TLSContextFactory() {
 }
 
+TLSSessionCache* TLSContextFactory::getSessionCache() {
+    return nullptr;
+}
+
 }
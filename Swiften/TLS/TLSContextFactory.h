@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2015 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
@@ -11,6 +11,7 @@
 
 namespace Swift {
     class TLSContext;
+    class TLSSessionCache;
 
     class SWIFTEN_API TLSContextFactory {
         public:
@@ -21,5 +22,11 @@ namespace Swift {
             virtual TLSContext* createTLSContext(const TLSOptions& tlsOptions) = 0;
             virtual void setCheckCertificateRevocation(bool b) = 0;
             virtual void setDisconnectOnCardRemoval(bool b) = 0;
+
+            /**
+             * Returns the cache of TLS sessions shared by the contexts of this factory,
+             * or nullptr if session resumption is not supported.
+             */
+            virtual TLSSessionCache* getSessionCache();
     };
 }
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <Swiften/TLS/TLSSessionCache.h>
+
+#include <cassert>
+
+#include <Swiften/TLS/TLSSessionStorage.h>
+
+namespace Swift {
+
+TLSSessionStorage::~TLSSessionStorage() {
+}
+
+TLSSessionCache::TLSSessionCache(size_t capacity) : capacity_(capacity), storage_(nullptr) {
+    assert(capacity_ > 0);
+}
+
+TLSSessionCache::~TLSSessionCache() {
+}
+
+std::string TLSSessionCache::createKey(const std::string& host, int port, const std::string& serverName, const std::string& clientIdentity) {
+    std::string key = host + ":" + std::to_string(port) + "/" + serverName;
+    if (!clientIdentity.empty()) {
+        key += "#" + clientIdentity;
+    }
+    return key;
+}
+
+boost::optional<SafeByteArray> TLSSessionCache::getSession(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto i = sessionsByKey_.find(key);
+    if (i != sessionsByKey_.end()) {
+        sessions_.splice(sessions_.begin(), sessions_, i->second);
+        return i->second->second;
+    }
+    if (storage_) {
+        boost::optional<SafeByteArray> session = storage_->loadSession(key);
+        if (session) {
+            insert(key, *session);
+        }
+        return session;
+    }
+    return boost::optional<SafeByteArray>();
+}
+
+void TLSSessionCache::storeSession(const std::string& key, const SafeByteArray& session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(key, session);
+    if (storage_) {
+        storage_->storeSession(key, session);
+    }
+}
+
+void TLSSessionCache::removeSession(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto i = sessionsByKey_.find(key);
+    if (i != sessionsByKey_.end()) {
+        sessions_.erase(i->second);
+        sessionsByKey_.erase(i);
+    }
+    if (storage_) {
+        storage_->removeSession(key);
+    }
+}
+
+void TLSSessionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessions_.clear();
+    sessionsByKey_.clear();
+}
+
+void TLSSessionCache::setStorage(TLSSessionStorage* storage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    storage_ = storage;
+}
+
+size_t TLSSessionCache::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.size();
+}
+
+void TLSSessionCache::insert(const std::string& key, const SafeByteArray& session) {
+    auto i = sessionsByKey_.find(key);
+    if (i != sessionsByKey_.end()) {
+        i->second->second = session;
+        sessions_.splice(sessions_.begin(), sessions_, i->second);
+        return;
+    }
+    if (sessions_.size() >= capacity_) {
+        sessionsByKey_.erase(sessions_.back().first);
+        sessions_.pop_back();
+    }
+    sessions_.push_front(std::make_pair(key, session));
+    sessionsByKey_[key] = sessions_.begin();
+}
+
+}
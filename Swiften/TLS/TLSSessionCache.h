@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/optional.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Base/SafeByteArray.h>
+
+namespace Swift {
+    class TLSSessionStorage;
+
+    /**
+     * A bounded in-memory cache of serialized TLS sessions, keyed by server identity
+     * (see \ref createKey). TLS contexts offer a cached session when connecting to
+     * the same server again, which lets the server resume it instead of doing a full
+     * handshake.
+     *
+     * The least recently used sessions are dropped when the cache is full. If a
+     * \ref TLSSessionStorage is set, new sessions are written through to it, and
+     * sessions missing from memory are looked up there.
+     *
+     * This class is thread-safe.
+     */
+    class SWIFTEN_API TLSSessionCache {
+        public:
+            TLSSessionCache(size_t capacity = 128);
+            ~TLSSessionCache();
+
+            /**
+             * Creates the key for sessions with a server. If the connection authenticates with a
+             * client certificate, \p clientIdentity should identify it (e.g. by its fingerprint),
+             * as sessions are bound to the certificate they were negotiated with.
+             */
+            static std::string createKey(const std::string& host, int port, const std::string& serverName, const std::string& clientIdentity = std::string());
+
+            boost::optional<SafeByteArray> getSession(const std::string& key);
+            void storeSession(const std::string& key, const SafeByteArray& session);
+            void removeSession(const std::string& key);
+            void clear();
+
+            /**
+             * Sets the storage to persist sessions in. The storage is not owned,
+             * and must outlive the cache (or be reset to nullptr).
+             */
+            void setStorage(TLSSessionStorage* storage);
+
+            size_t getSize() const;
+
+        private:
+            void insert(const std::string& key, const SafeByteArray& session);
+
+        private:
+            typedef std::list<std::pair<std::string, SafeByteArray> > SessionList;
+
+            mutable std::mutex mutex_;
+            size_t capacity_;
+            // Most recently used first
+            SessionList sessions_;
+            std::unordered_map<std::string, SessionList::iterator> sessionsByKey_;
+            TLSSessionStorage* storage_;
+    };
+}
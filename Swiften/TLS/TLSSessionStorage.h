@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/optional.hpp>
+
+#include <Swiften/Base/API.h>
+#include <Swiften/Base/SafeByteArray.h>
+
+namespace Swift {
+    /**
+     * Persistent storage for serialized TLS sessions, used by \ref TLSSessionCache
+     * to keep sessions across restarts of the application.
+     *
+     * Sessions contain key material, so implementations should store them as
+     * securely as other credentials.
+     */
+    class SWIFTEN_API TLSSessionStorage {
+        public:
+            virtual ~TLSSessionStorage();
+
+            virtual boost::optional<SafeByteArray> loadSession(const std::string& key) = 0;
+            virtual void storeSession(const std::string& key, const SafeByteArray& session) = 0;
+            virtual void removeSession(const std::string& key) = 0;
+    };
+}
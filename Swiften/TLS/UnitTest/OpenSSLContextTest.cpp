@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/pkcs12.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Base/ByteArray.h>
+#include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/TLS/OpenSSL/OpenSSLContext.h>
+#include <Swiften/TLS/PKCS12Certificate.h>
+#include <Swiften/TLS/TLSSessionCache.h>
+
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+
+using namespace Swift;
+
+class OpenSSLContextTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(OpenSSLContextTest);
+        CPPUNIT_TEST(testConnect_ResumesSession);
+        CPPUNIT_TEST(testConnect_ResumedSessionKeepsPeerCertificateChain);
+        CPPUNIT_TEST(testConnect_DoesNotResumeSessionOfOtherClientCertificate);
+        CPPUNIT_TEST(testConnect_DoesNotResumeSessionWithoutClientCertificate);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp() {
+            clientContext_ = OpenSSLContext::createSSLContext();
+            serverContext_ = std::shared_ptr<SSL_CTX>(SSL_CTX_new(SSLv23_server_method()), SSL_CTX_free);
+            std::shared_ptr<EVP_PKEY> serverKey = createKey();
+            std::shared_ptr<X509> serverCertificate = createCertificate(serverKey, "server");
+            SSL_CTX_use_certificate(serverContext_.get(), serverCertificate.get());
+            SSL_CTX_use_PrivateKey(serverContext_.get(), serverKey.get());
+            // Ask for a client certificate, but accept any
+            SSL_CTX_set_verify(serverContext_.get(), SSL_VERIFY_PEER, &acceptCertificate);
+            const unsigned char sessionContext[] = "OpenSSLContextTest";
+            SSL_CTX_set_session_id_context(serverContext_.get(), sessionContext, sizeof(sessionContext) - 1);
+            sessionCache_ = std::unique_ptr<TLSSessionCache>(new TLSSessionCache());
+            clientCertificate1_ = createClientCertificate("client1");
+            clientCertificate2_ = createClientCertificate("client2");
+        }
+
+        void tearDown() {
+            sessionCache_.reset();
+        }
+
+        void testConnect_ResumesSession() {
+            CPPUNIT_ASSERT(!connect(clientCertificate1_));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), sessionCache_->getSize());
+
+            CPPUNIT_ASSERT(connect(clientCertificate1_));
+        }
+
+        void testConnect_ResumedSessionKeepsPeerCertificateChain() {
+            std::vector<Certificate::ref> firstChain;
+            CPPUNIT_ASSERT(!connect(clientCertificate1_, &firstChain));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), firstChain.size());
+
+            std::vector<Certificate::ref> resumedChain;
+            CPPUNIT_ASSERT(connect(clientCertificate1_, &resumedChain));
+
+            CPPUNIT_ASSERT_EQUAL(firstChain.size(), resumedChain.size());
+            for (size_t i = 0; i < firstChain.size(); ++i) {
+                CPPUNIT_ASSERT(firstChain[i]->toDER() == resumedChain[i]->toDER());
+            }
+        }
+
+        void testConnect_DoesNotResumeSessionOfOtherClientCertificate() {
+            CPPUNIT_ASSERT(!connect(clientCertificate1_));
+
+            CPPUNIT_ASSERT(!connect(clientCertificate2_));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), sessionCache_->getSize());
+        }
+
+        void testConnect_DoesNotResumeSessionWithoutClientCertificate() {
+            CPPUNIT_ASSERT(!connect(clientCertificate1_));
+
+            CPPUNIT_ASSERT(!connect(std::shared_ptr<PKCS12Certificate>()));
+        }
+
+    private:
+        /**
+         * Connects a client using \p clientCertificate to the test server, and returns
+         * whether the session was resumed. The server certificate chain the client sees
+         * is stored in \p peerCertificateChain, if set.
+         */
+        bool connect(std::shared_ptr<PKCS12Certificate> clientCertificate, std::vector<Certificate::ref>* peerCertificateChain = nullptr) {
+            OpenSSLContext client(clientContext_, sessionCache_.get());
+            std::shared_ptr<SSL> server(SSL_new(serverContext_.get()), SSL_free);
+            BIO* serverReadBIO = BIO_new(BIO_s_mem());
+            BIO* serverWriteBIO = BIO_new(BIO_s_mem());
+            SSL_set_bio(server.get(), serverReadBIO, serverWriteBIO);
+            SSL_set_accept_state(server.get());
+
+            bool connected = false;
+            bool error = false;
+            client.onDataForNetwork.connect([&](const SafeByteArray& data) {
+                BIO_write(serverReadBIO, vecptr(data), static_cast<int>(data.size()));
+            });
+            client.onConnected.connect([&]() { connected = true; });
+            client.onError.connect([&](std::shared_ptr<TLSError>) { error = true; });
+
+            if (clientCertificate) {
+                CPPUNIT_ASSERT(client.setClientCertificate(clientCertificate));
+            }
+            client.setServerIdentity("10.0.0.1", 5223, "example.com");
+            client.connect();
+            for (int i = 0; i < 10 && !connected && !error; ++i) {
+                pumpServer(server.get(), serverWriteBIO, client);
+            }
+            CPPUNIT_ASSERT(connected);
+            CPPUNIT_ASSERT(!error);
+
+            // Completes the handshake on the server, which then sends the session tickets
+            client.handleDataFromApplication(createSafeByteArray("ping"));
+            pumpServer(server.get(), serverWriteBIO, client);
+            CPPUNIT_ASSERT(!error);
+
+            if (peerCertificateChain) {
+                *peerCertificateChain = client.getPeerCertificateChain();
+            }
+            return client.isSessionResumed();
+        }
+
+        void pumpServer(SSL* server, BIO* serverWriteBIO, OpenSSLContext& client) {
+            unsigned char buffer[1024];
+            if (!SSL_is_init_finished(server)) {
+                SSL_do_handshake(server);
+            }
+            else {
+                while (SSL_read(server, buffer, sizeof(buffer)) > 0) {
+                }
+            }
+            int size = BIO_pending(serverWriteBIO);
+            if (size > 0) {
+                SafeByteArray data(static_cast<size_t>(size));
+                BIO_read(serverWriteBIO, vecptr(data), size);
+                client.handleDataFromNetwork(data);
+            }
+        }
+
+        static int acceptCertificate(int, X509_STORE_CTX*) {
+            return 1;
+        }
+
+        static std::shared_ptr<EVP_PKEY> createKey() {
+            std::shared_ptr<EVP_PKEY_CTX> context(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), EVP_PKEY_CTX_free);
+            EVP_PKEY_keygen_init(context.get());
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(context.get(), NID_X9_62_prime256v1);
+            EVP_PKEY* key = nullptr;
+            EVP_PKEY_keygen(context.get(), &key);
+            CPPUNIT_ASSERT(key);
+            return std::shared_ptr<EVP_PKEY>(key, EVP_PKEY_free);
+        }
+
+        static std::shared_ptr<X509> createCertificate(std::shared_ptr<EVP_PKEY> key, const std::string& commonName) {
+            std::shared_ptr<X509> certificate(X509_new(), X509_free);
+            X509_set_version(certificate.get(), 2);
+            ASN1_INTEGER_set(X509_get_serialNumber(certificate.get()), 1);
+            X509_gmtime_adj(X509_get_notBefore(certificate.get()), 0);
+            X509_gmtime_adj(X509_get_notAfter(certificate.get()), 3600);
+            X509_set_pubkey(certificate.get(), key.get());
+            X509_NAME* name = X509_get_subject_name(certificate.get());
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>(commonName.c_str()), -1, -1, 0);
+            X509_set_issuer_name(certificate.get(), name);
+            CPPUNIT_ASSERT(X509_sign(certificate.get(), key.get(), EVP_sha256()) > 0);
+            return certificate;
+        }
+
+        static std::shared_ptr<PKCS12Certificate> createClientCertificate(const std::string& commonName) {
+            std::shared_ptr<EVP_PKEY> key = createKey();
+            std::shared_ptr<X509> certificate = createCertificate(key, commonName);
+            std::shared_ptr<PKCS12> pkcs12(PKCS12_create(const_cast<char*>("secret"), const_cast<char*>(commonName.c_str()), key.get(), certificate.get(), nullptr, 0, 0, 0, 0, 0), PKCS12_free);
+            CPPUNIT_ASSERT(pkcs12);
+            ByteArray data(static_cast<size_t>(i2d_PKCS12(pkcs12.get(), nullptr)));
+            unsigned char* p = vecptr(data);
+            i2d_PKCS12(pkcs12.get(), &p);
+            std::shared_ptr<PKCS12Certificate> result = std::make_shared<PKCS12Certificate>();
+            result->setData(data);
+            result->setPassword(createSafeByteArray("secret"));
+            return result;
+        }
+
+    private:
+        std::shared_ptr<SSL_CTX> clientContext_;
+        std::shared_ptr<SSL_CTX> serverContext_;
+        std::unique_ptr<TLSSessionCache> sessionCache_;
+        std::shared_ptr<PKCS12Certificate> clientCertificate1_;
+        std::shared_ptr<PKCS12Certificate> clientCertificate2_;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(OpenSSLContextTest);
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2017 Isode Limited.
+ * All rights reserved.
+ * See the COPYING file for more information.
+ */
+
+#include <map>
+#include <string>
+
+#include <QA/Checker/IO.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+
+#include <Swiften/Base/SafeByteArray.h>
+#include <Swiften/TLS/TLSSessionCache.h>
+#include <Swiften/TLS/TLSSessionStorage.h>
+
+using namespace Swift;
+
+class TLSSessionCacheTest : public CppUnit::TestFixture {
+        CPPUNIT_TEST_SUITE(TLSSessionCacheTest);
+        CPPUNIT_TEST(testCreateKey);
+        CPPUNIT_TEST(testGetSession);
+        CPPUNIT_TEST(testGetSession_Unknown);
+        CPPUNIT_TEST(testStoreSession_ReplacesSession);
+        CPPUNIT_TEST(testStoreSession_EvictsLeastRecentlyUsed);
+        CPPUNIT_TEST(testRemoveSession);
+        CPPUNIT_TEST(testStorage_StoresAndRemovesSessions);
+        CPPUNIT_TEST(testStorage_LoadsMissingSessions);
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void testCreateKey() {
+            CPPUNIT_ASSERT(TLSSessionCache::createKey("10.0.0.1", 5222, "example.com") != TLSSessionCache::createKey("10.0.0.1", 5223, "example.com"));
+            CPPUNIT_ASSERT(TLSSessionCache::createKey("10.0.0.1", 5222, "example.com") != TLSSessionCache::createKey("10.0.0.1", 5222, "example.org"));
+            CPPUNIT_ASSERT(TLSSessionCache::createKey("10.0.0.1", 5222, "example.com") != TLSSessionCache::createKey("10.0.0.2", 5222, "example.com"));
+            CPPUNIT_ASSERT(TLSSessionCache::createKey("10.0.0.1", 5222, "example.com") != TLSSessionCache::createKey("10.0.0.1", 5222, "example.com", "abcd"));
+            CPPUNIT_ASSERT(TLSSessionCache::createKey("10.0.0.1", 5222, "example.com", "abcd") != TLSSessionCache::createKey("10.0.0.1", 5222, "example.com", "abce"));
+            CPPUNIT_ASSERT_EQUAL(TLSSessionCache::createKey("10.0.0.1", 5222, "example.com"), TLSSessionCache::createKey("10.0.0.1", 5222, "example.com"));
+        }
+
+        void testGetSession() {
+            TLSSessionCache testling;
+            testling.storeSession("a", createSafeByteArray("session-a"));
+
+            boost::optional<SafeByteArray> session = testling.getSession("a");
+
+            CPPUNIT_ASSERT(session);
+            CPPUNIT_ASSERT_EQUAL(createSafeByteArray("session-a"), *session);
+        }
+
+        void testGetSession_Unknown() {
+            TLSSessionCache testling;
+            testling.storeSession("a", createSafeByteArray("session-a"));
+
+            CPPUNIT_ASSERT(!testling.getSession("b"));
+        }
+
+        void testStoreSession_ReplacesSession() {
+            TLSSessionCache testling;
+            testling.storeSession("a", createSafeByteArray("session-a"));
+            testling.storeSession("a", createSafeByteArray("session-a2"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getSize());
+            CPPUNIT_ASSERT_EQUAL(createSafeByteArray("session-a2"), *testling.getSession("a"));
+        }
+
+        void testStoreSession_EvictsLeastRecentlyUsed() {
+            TLSSessionCache testling(2);
+            testling.storeSession("a", createSafeByteArray("session-a"));
+            testling.storeSession("b", createSafeByteArray("session-b"));
+            testling.getSession("a");
+
+            testling.storeSession("c", createSafeByteArray("session-c"));
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), testling.getSize());
+            CPPUNIT_ASSERT(testling.getSession("a"));
+            CPPUNIT_ASSERT(!testling.getSession("b"));
+            CPPUNIT_ASSERT(testling.getSession("c"));
+        }
+
+        void testRemoveSession() {
+            TLSSessionCache testling;
+            testling.storeSession("a", createSafeByteArray("session-a"));
+
+            testling.removeSession("a");
+
+            CPPUNIT_ASSERT(!testling.getSession("a"));
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), testling.getSize());
+        }
+
+        void testStorage_StoresAndRemovesSessions() {
+            MemoryStorage storage;
+            TLSSessionCache testling;
+            testling.setStorage(&storage);
+
+            testling.storeSession("a", createSafeByteArray("session-a"));
+            testling.storeSession("b", createSafeByteArray("session-b"));
+            testling.removeSession("a");
+
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), storage.sessions.size());
+            CPPUNIT_ASSERT_EQUAL(createSafeByteArray("session-b"), storage.sessions["b"]);
+        }
+
+        void testStorage_LoadsMissingSessions() {
+            MemoryStorage storage;
+            storage.sessions["a"] = createSafeByteArray("session-a");
+            TLSSessionCache testling;
+            testling.setStorage(&storage);
+
+            boost::optional<SafeByteArray> session = testling.getSession("a");
+
+            CPPUNIT_ASSERT(session);
+            CPPUNIT_ASSERT_EQUAL(createSafeByteArray("session-a"), *session);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), testling.getSize());
+            CPPUNIT_ASSERT(!testling.getSession("b"));
+        }
+
+    private:
+        struct MemoryStorage : public TLSSessionStorage {
+            virtual boost::optional<SafeByteArray> loadSession(const std::string& key) {
+                std::map<std::string, SafeByteArray>::const_iterator i = sessions.find(key);
+                if (i == sessions.end()) {
+                    return boost::optional<SafeByteArray>();
+                }
+                return i->second;
+            }
+
+            virtual void storeSession(const std::string& key, const SafeByteArray& session) {
+                sessions[key] = session;
+            }
+
+            virtual void removeSession(const std::string& key) {
+                sessions.erase(key);
+            }
+
+            std::map<std::string, SafeByteArray> sessions;
+        };
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TLSSessionCacheTest);
@@ -6,7 +6,7 @@
 
 #pragma once
 
-#include <set>
+#include <unordered_set>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/signals2.hpp>
@@ -63,6 +63,6 @@ namespace Swift {
             JID ownJID;
             IQRouter* iqRouter;
             VCardStorage* storage;
-            std::set<JID> requestedVCards;
+            std::unordered_set<JID> requestedVCards;
     };
 }
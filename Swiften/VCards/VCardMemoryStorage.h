@@ -1,13 +1,13 @@
 /*
- * Copyright (c) 2010-2016 Isode Limited.
+ * Copyright (c) 2010-2017 Isode Limited.
  * All rights reserved.
  * See the COPYING file for more information.
  */
 
 #pragma once
 
-#include <map>
 #include <memory>
+#include <unordered_map>
 
 #include <Swiften/Base/API.h>
 #include <Swiften/JID/JID.h>
@@ -43,8 +43,8 @@ namespace Swift {
             }
 
         private:
-            typedef std::map<JID, VCard::ref> VCardMap;
-            typedef std::map<JID, boost::posix_time::ptime> VCardWriteTimeMap;
+            typedef std::unordered_map<JID, VCard::ref> VCardMap;
+            typedef std::unordered_map<JID, boost::posix_time::ptime> VCardWriteTimeMap;
             VCardMap vcards;
             VCardWriteTimeMap vcardWriteTimes;
     };